@@ -3,6 +3,8 @@
 #include "bool_array.h"
 #include "cell.h"
 
+#define BRANCH_STACK_SIZE 64  // Initial capacity of the stack of is_branch_over
+
 /**
  * @brief Structure for a game board
  */
@@ -13,6 +15,16 @@ struct game_s {
   cell origin;     /**< pointer to the cell at the (0,0) coordinates */
 };
 
+/**
+ * @brief Structure for a cell left to check by is_branch_over
+ */
+typedef struct branch_step_s {
+  cell branch_cell;           /**< the cell to check */
+  direction origin_direction; /**< the direction the branch comes from */
+  int x;                      /**< the x coordinate of the cell */
+  int y;                      /**< the y coordinate of the cell */
+} branch_step;
+
 //--------------------------------------------------------------------------------------
 //                                Static functions
 //                         These functions are primitives to use cell and game
@@ -446,6 +458,50 @@ direction get_current_direction(cgame board, uint16_t x, uint16_t y) {
   return get_current_direction_cell(current_cell);
 }
 
+void get_cells(cgame board, piece *pieces, direction *directions) {
+  if (!board) {
+    FPRINTF(stderr, "Error: get_cells, game pointer is NULL.\n");
+    return;
+  }
+
+  uint16_t width = get_game_width(board);
+  uint16_t height = get_game_height(board);
+  cell line_origin = get_game_origin(board);
+  for (uint16_t y = 0; y < height; y++) {
+    cell current_cell = line_origin;
+    for (uint16_t x = 0; x < width; x++) {
+      size_t index = x + (size_t)y * width;
+      if (pieces) pieces[index] = get_piece_cell(current_cell);
+      if (directions)
+        directions[index] = get_current_direction_cell(current_cell);
+      current_cell = get_right_cell(current_cell);
+    }
+    line_origin = get_top_cell(line_origin);
+  }
+}
+
+void set_current_directions(game board, const direction *directions) {
+  if (!board || !directions) {
+    FPRINTF(stderr,
+            "Error: set_current_directions, game or directions pointer is "
+            "NULL.\n");
+    return;
+  }
+
+  uint16_t width = get_game_width(board);
+  uint16_t height = get_game_height(board);
+  cell line_origin = get_game_origin(board);
+  for (uint16_t y = 0; y < height; y++) {
+    cell current_cell = line_origin;
+    for (uint16_t x = 0; x < width; x++) {
+      set_current_direction_cell(current_cell,
+                                 directions[x + (size_t)y * width]);
+      current_cell = get_right_cell(current_cell);
+    }
+    line_origin = get_top_cell(line_origin);
+  }
+}
+
 bool is_game_over(cgame board) {
   if (!board) {
     FPRINTF(stderr, "Error: is_game_over, game pointer is NULL.\n");
@@ -678,9 +734,10 @@ static void get_coordinates_from_direction(direction dir, int *delta_x,
 }
 
 /**
- * @brief Recursive function to check if a branch (a series of connected cells)
- *is well connected, ends by a LEAF and contain no loop (this function is used
- *in is_game_over)
+ * @brief Function to check if a branch (a series of connected cells) is well
+ *connected, ends by a LEAF and contain no loop (this function is used in
+ *is_game_over). The cells are visited depth first with a stack allocated on
+ *the heap, since a branch can be as long as the board is large
  *
  * @param board, const pointer to the game object in which the branch is located
  * @param branch_cell, the cell from where the branch start
@@ -689,41 +746,69 @@ static void get_coordinates_from_direction(direction dir, int *delta_x,
  *already been checked or not
  * @param x, the x coordinate of the branch cell
  * @param y, the y coordinate of the branch cell
- * @return true if the branch is well formed, false otherwise
+ * @return true if the branch is well formed, false otherwise or in case of
+ *error
  **/
 static bool is_branch_over(cgame board, cell branch_cell,
                            direction origin_direction, bool **checked_cells,
                            int x, int y) {
-  piece branch_piece = get_piece_cell(branch_cell);
-  direction branch_current_direction = get_current_direction_cell(branch_cell);
-
-  if (is_out_of_bounds_cell(branch_cell) ||
-      !is_edge(branch_piece, branch_current_direction, origin_direction)) {
-    // the branch is disconnected or doesn't end by a leaf
+  uint16_t width = get_game_width(board);
+  uint16_t height = get_game_height(board);
+  uint32_t capacity = BRANCH_STACK_SIZE, nb_steps = 0;
+  branch_step *stack = (branch_step *)malloc(capacity * sizeof(branch_step));
+  if (!stack) {
+    FPRINTF(stderr, "Error: is_branch_over, couldn't allocate the stack.\n");
     return false;
   }
+  stack[nb_steps++] = (branch_step){branch_cell, origin_direction, x, y};
 
-  if (checked_cells[x][y]) {  // If true, there is a loop
-    return false;
-  }
-  checked_cells[x][y] = true;
+  bool well_formed = true;
+  while (nb_steps > 0) {
+    branch_step step = stack[--nb_steps];
+    piece branch_piece = get_piece_cell(step.branch_cell);
+    direction branch_current_direction =
+        get_current_direction_cell(step.branch_cell);
 
-  uint16_t width = get_game_width(board);
-  uint16_t height = get_game_height(board);
-  int delta_x, delta_y;
+    if (is_out_of_bounds_cell(step.branch_cell) ||
+        !is_edge(branch_piece, branch_current_direction,
+                 step.origin_direction)) {
+      // the branch is disconnected or doesn't end by a leaf
+      well_formed = false;
+      break;
+    }
 
-  for (direction dir = N; dir < NB_DIR; dir++) {
-    if (dir != origin_direction &&
-        is_edge(branch_piece, branch_current_direction, dir)) {
-      get_coordinates_from_direction(dir, &delta_x, &delta_y);
-      cell next_branch_cell = translate_cell(branch_cell, delta_x, delta_y);
+    if (checked_cells[step.x][step.y]) {  // If true, there is a loop
+      well_formed = false;
+      break;
+    }
+    checked_cells[step.x][step.y] = true;
+
+    if (nb_steps + NB_DIR > capacity) {
+      branch_step *bigger =
+          (branch_step *)realloc(stack, 2 * capacity * sizeof(branch_step));
+      if (!bigger) {
+        FPRINTF(stderr, "Error: is_branch_over, couldn't grow the stack.\n");
+        well_formed = false;
+        break;
+      }
+      stack = bigger;
+      capacity *= 2;
+    }
 
-      if (!is_branch_over(board, next_branch_cell, opposite_direction(dir),
-                          checked_cells, (x + delta_x + width) % width,
-                          (y + delta_y + height) % height)) {
-        return false;
+    int delta_x, delta_y;
+    // Pushed in reverse order so that they are checked in the order of the
+    // directions
+    for (direction dir = NB_DIR; dir-- > N;) {
+      if (dir != step.origin_direction &&
+          is_edge(branch_piece, branch_current_direction, dir)) {
+        get_coordinates_from_direction(dir, &delta_x, &delta_y);
+        stack[nb_steps++] = (branch_step){
+            translate_cell(step.branch_cell, delta_x, delta_y),
+            opposite_direction(dir), (step.x + delta_x + width) % width,
+            (step.y + delta_y + height) % height};
       }
     }
   }
-  return true;
+  free(stack);
+  return well_formed;
 }
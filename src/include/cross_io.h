@@ -18,10 +18,13 @@
   sprintf_s(BUFFER, SIZE_OF_BUFFER, FORMAT, __VA_ARGS__)
 #define SCANF(...) scanf_s(__VA_ARGS__)
 #define FSCANF(...) fscanf_s(__VA_ARGS__)
+#define SSCANF(...) sscanf_s(__VA_ARGS__)
 #define FOPEN(STREAM, ...) fopen_s(&STREAM, __VA_ARGS__)
 #define FCLOSE(...) fclose(__VA_ARGS__)
 #define STRCAT(DEST, SOURCE, DEST_SIZE) strcat_s(DEST, DEST_SIZE, SOURCE)
 #define STRCPY(DEST, SOURCE, DEST_SIZE) strcpy_s(DEST, DEST_SIZE, SOURCE)
+#define FSEEK64(STREAM, OFFSET, ORIGIN) _fseeki64(STREAM, OFFSET, ORIGIN)
+#define FTELL64(STREAM) _ftelli64(STREAM)
 #else
 #define PRINTF(...) printf(__VA_ARGS__)
 #define FPRINTF(TARGET_FILE, ...) fprintf(TARGET_FILE, __VA_ARGS__)
@@ -29,10 +32,13 @@
   sprintf(BUFFER, FORMAT, __VA_ARGS__)
 #define SCANF(...) scanf(__VA_ARGS__)
 #define FSCANF(...) fscanf(__VA_ARGS__)
+#define SSCANF(...) sscanf(__VA_ARGS__)
 #define FOPEN(STREAM, ...) STREAM = fopen(__VA_ARGS__)
 #define FCLOSE(...) fclose(__VA_ARGS__)
 #define STRCAT(DEST, SOURCE, DEST_SIZE) strncat(DEST, SOURCE, DEST_SIZE)
 #define STRCPY(DEST, SOURCE, DEST_SIZE) strncpy(DEST, SOURCE, DEST_SIZE)
+#define FSEEK64(STREAM, OFFSET, ORIGIN) fseeko(STREAM, OFFSET, ORIGIN)
+#define FTELL64(STREAM) ftello(STREAM)
 #endif
 
 #endif  // __CROSS_IO_H__
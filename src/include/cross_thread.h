@@ -0,0 +1,81 @@
+#ifndef __CROSS_THREAD_H__
+#define __CROSS_THREAD_H__
+#include <stdint.h>
+
+/**
+ * @file cross_thread.h
+ *
+ * @brief This file provides macros expanding to the threading functions used in
+ *the project, the Win32 API on Windows and pthreads elsewhere.
+ *
+ **/
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef HANDLE THREAD;
+typedef SRWLOCK MUTEX;
+typedef CONDITION_VARIABLE COND;
+typedef volatile LONG ATOMIC_LONG;
+#define THREAD_FUNCTION(NAME, ARG) DWORD WINAPI NAME(LPVOID ARG)
+#define THREAD_RETURN return 0
+#define THREAD_CREATE(THREAD_VAR, FUNCTION, ARG) \
+  ((THREAD_VAR = CreateThread(NULL, 0, FUNCTION, ARG, 0, NULL)) != NULL)
+#define THREAD_JOIN(THREAD_VAR) \
+  (WaitForSingleObject(THREAD_VAR, INFINITE), CloseHandle(THREAD_VAR))
+#define MUTEX_INIT(LOCK) InitializeSRWLock(&(LOCK))
+#define MUTEX_DESTROY(LOCK) ((void)0)
+#define MUTEX_LOCK(LOCK) AcquireSRWLockExclusive(&(LOCK))
+#define MUTEX_UNLOCK(LOCK) ReleaseSRWLockExclusive(&(LOCK))
+#define COND_INIT(CONDITION) InitializeConditionVariable(&(CONDITION))
+#define COND_DESTROY(CONDITION) ((void)0)
+#define COND_WAIT(CONDITION, LOCK) \
+  SleepConditionVariableSRW(&(CONDITION), &(LOCK), INFINITE, 0)
+#define COND_BROADCAST(CONDITION) WakeAllConditionVariable(&(CONDITION))
+#define ATOMIC_LOAD(TARGET) InterlockedCompareExchange(TARGET, 0, 0)
+#define ATOMIC_STORE(TARGET, VALUE) InterlockedExchange(TARGET, VALUE)
+#define ATOMIC_ADD(TARGET, VALUE) InterlockedExchangeAdd(TARGET, VALUE)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t THREAD;
+typedef pthread_mutex_t MUTEX;
+typedef pthread_cond_t COND;
+typedef volatile long ATOMIC_LONG;
+#define THREAD_FUNCTION(NAME, ARG) void *NAME(void *ARG)
+#define THREAD_RETURN return NULL
+#define THREAD_CREATE(THREAD_VAR, FUNCTION, ARG) \
+  (pthread_create(&(THREAD_VAR), NULL, FUNCTION, ARG) == 0)
+#define THREAD_JOIN(THREAD_VAR) pthread_join(THREAD_VAR, NULL)
+#define MUTEX_INIT(LOCK) pthread_mutex_init(&(LOCK), NULL)
+#define MUTEX_DESTROY(LOCK) pthread_mutex_destroy(&(LOCK))
+#define MUTEX_LOCK(LOCK) pthread_mutex_lock(&(LOCK))
+#define MUTEX_UNLOCK(LOCK) pthread_mutex_unlock(&(LOCK))
+#define COND_INIT(CONDITION) pthread_cond_init(&(CONDITION), NULL)
+#define COND_DESTROY(CONDITION) pthread_cond_destroy(&(CONDITION))
+#define COND_WAIT(CONDITION, LOCK) pthread_cond_wait(&(CONDITION), &(LOCK))
+#define COND_BROADCAST(CONDITION) pthread_cond_broadcast(&(CONDITION))
+#define ATOMIC_LOAD(TARGET) __atomic_load_n(TARGET, __ATOMIC_SEQ_CST)
+#define ATOMIC_STORE(TARGET, VALUE) \
+  __atomic_store_n(TARGET, VALUE, __ATOMIC_SEQ_CST)
+#define ATOMIC_ADD(TARGET, VALUE) \
+  __atomic_fetch_add(TARGET, VALUE, __ATOMIC_SEQ_CST)
+#endif
+
+/**
+ * @brief Gets the number of processors available to the program
+ * @return the number of processors, at least 1
+ **/
+static inline uint16_t get_nb_cpus(void) {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  uint32_t nb_cpus = info.dwNumberOfProcessors;
+#else
+  long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (nb_cpus < 1) return 1;
+  if (nb_cpus > UINT16_MAX) return UINT16_MAX;
+  return (uint16_t)nb_cpus;
+}
+
+#endif  // __CROSS_THREAD_H__
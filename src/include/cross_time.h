@@ -0,0 +1,33 @@
+#ifndef __CROSS_TIME_H__
+#define __CROSS_TIME_H__
+#include <stdint.h>
+
+/**
+ * @file cross_time.h
+ *
+ * @brief This file provides a monotonic clock, read with the Win32 API on
+ *Windows and clock_gettime elsewhere.
+ *
+ **/
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * @brief Reads a clock that never goes backwards
+ * @return the number of milliseconds elapsed since an arbitrary point in time
+ **/
+static inline uint64_t get_milliseconds(void) {
+#if defined(_WIN32)
+  return (uint64_t)GetTickCount64();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+#endif
+}
+
+#endif  // __CROSS_TIME_H__
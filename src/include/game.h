@@ -277,6 +277,26 @@ piece get_piece(cgame board, uint16_t x, uint16_t y);
  **/
 direction get_current_direction(cgame board, uint16_t x, uint16_t y);
 
+/**
+ * @brief Gets the piece and the current orientation of every square in a single
+ *pass over the grid, which is much faster than calling get_piece and
+ *get_current_direction for each square
+ * @param board a constant pointer on the game we consider
+ * @param pieces where the pieces are written, indexed by x + y * width, NULL if
+ *they aren't needed
+ * @param directions where the orientations are written, indexed the same way,
+ *NULL if they aren't needed
+ **/
+void get_cells(cgame board, piece *pieces, direction *directions);
+
+/**
+ * @brief Sets the current orientation of every square in a single pass over
+ *the grid
+ * @param board the game we consider
+ * @param directions the new orientations, indexed by x + y * width
+ **/
+void set_current_directions(game board, const direction *directions);
+
 /**
  * @brief Tests if the game is over (that is the grid is filled according to the
  *requirements)
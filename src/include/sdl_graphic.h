@@ -43,7 +43,7 @@ typedef struct Env_t Env;
 #define BORDER 10
 #define BUTTON_BOTTOM_SPACE 100
 #define GAME_BUTTONS_GAP 10
-#define NB_BUTTONS 4
+#define NB_BUTTONS 5
 #define NB_SFX 2
 
 /* **************************************************************** */
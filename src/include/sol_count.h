@@ -0,0 +1,107 @@
+#ifndef __SOL_COUNT_H__
+#define __SOL_COUNT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @file sol_count.h
+ *
+ * @brief This file provides the solution counters of the solver.
+ *
+ * A counter either holds a 64-bit value and records when it overflows, or holds
+ *an arbitrary-precision value. The two kinds can't be mixed in an addition.
+ **/
+
+/**
+ * @brief Structure for a solution counter
+ **/
+typedef struct sol_count_s {
+  uint64_t value;    /**< the count, for a 64-bit counter */
+  bool overflow;     /**< whether a 64-bit counter exceeded UINT64_MAX */
+  bool big;          /**< whether the counter has arbitrary precision */
+  uint32_t *limbs;   /**< base 2^32 digits of an arbitrary-precision counter,
+                        least significant first */
+  uint32_t nb_limbs; /**< number of digits in limbs */
+} sol_count;
+
+/**
+ * @brief Initializes a counter to 0
+ * @param count the counter
+ * @param big whether the counter has arbitrary precision
+ **/
+void sol_count_init(sol_count *count, bool big);
+
+/**
+ * @brief Frees the memory of a counter, it can be initialized again afterwards
+ * @param count the counter
+ **/
+void sol_count_clear(sol_count *count);
+
+/**
+ * @brief Sets a counter back to 0, keeping its memory
+ * @param count the counter
+ **/
+void sol_count_reset(sol_count *count);
+
+/**
+ * @brief Adds a small value to a counter
+ * @param count the counter
+ * @param term the value to add
+ * @return false if an arbitrary-precision counter couldn't grow, true
+ *otherwise
+ **/
+bool sol_count_add_uint(sol_count *count, uint64_t term);
+
+/**
+ * @brief Adds a counter to another one of the same kind
+ * @param count the counter modified
+ * @param term the counter to add
+ * @return false if an arbitrary-precision counter couldn't grow, true
+ *otherwise
+ **/
+bool sol_count_add(sol_count *count, const sol_count *term);
+
+/**
+ * @brief Multiplies a counter by a small value
+ * @param count the counter
+ * @param factor the value to multiply by
+ * @return false if an arbitrary-precision counter couldn't grow, true
+ *otherwise
+ **/
+bool sol_count_mul_uint(sol_count *count, uint32_t factor);
+
+/**
+ * @brief Copies a counter into an initialized counter of the same kind
+ * @param dest the counter modified
+ * @param source the counter to copy
+ * @return false if an arbitrary-precision counter couldn't grow, true
+ *otherwise
+ **/
+bool sol_count_copy(sol_count *dest, const sol_count *source);
+
+/**
+ * @brief Gets the value of a counter as a 32-bit number
+ * @param count the counter
+ * @return the value, UINT32_MAX if it doesn't fit
+ **/
+uint32_t sol_count_to_uint32(const sol_count *count);
+
+/**
+ * @brief Gets the value of a counter as a 64-bit number
+ * @param count the counter
+ * @param value where the value is written
+ * @return false if the value doesn't fit in 64 bits, true otherwise
+ **/
+bool sol_count_to_uint64(const sol_count *count, uint64_t *value);
+
+/**
+ * @brief Writes the decimal value of a counter
+ * @param stream the stream to write to
+ * @param count the counter, a 64-bit counter must not have overflowed
+ * @return false in case of error, true otherwise
+ **/
+bool sol_count_fprint(FILE *stream, const sol_count *count);
+
+#endif  // __SOL_COUNT_H__
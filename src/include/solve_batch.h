@@ -0,0 +1,41 @@
+#ifndef __SOLVE_BATCH_H__
+#define __SOLVE_BATCH_H__
+
+#include "solver.h"
+
+/**
+ * @file solve_batch.h
+ *
+ * @brief This file provides the batch mode of the solver, which solves many
+ *saved puzzles in a single process.
+ *
+ * The puzzles are shared out between worker threads, each one keeping a single
+ *solver context for all the puzzles it solves. The results are written in a
+ *single file, one JSON object per line and per puzzle, in the order the
+ *puzzles are finished:
+ *{"file": ..., "status": "done"|"unfinished"|"error"|"out_of_memory",
+ *"solutions": <count>, "solution": <directions>, "nodes": ...,
+ *"time_ms": {...}}
+ *The solution is the first one found, given as the direction of every cell
+ *(0 for N to 3 for W) row by row, it is null in NB_SOL mode or when there is
+ *none.
+ **/
+
+/**
+ * @brief Solves every puzzle of a manifest or of a directory
+ * @param input a directory, whose files are all solved in the order of their
+ *names, or a manifest listing one file per line, empty lines and lines
+ *starting with # being ignored
+ * @param results_file the file the results are written in
+ * @param mode what has to be found for each puzzle
+ * @param options the settings of the solves: nb_threads is the number of
+ *puzzles solved at the same time (0 for one per processor), each one on a
+ *single thread, the time limit applies to each puzzle, the cache is shared by
+ *all the puzzles and no report is written
+ * @return false if a puzzle couldn't be solved within the limits or in case of
+ *error, true otherwise
+ **/
+bool batch_solve(const char *input, const char *results_file, solver_mode mode,
+                 const solver_options *options);
+
+#endif  // __SOLVE_BATCH_H__
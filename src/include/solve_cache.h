@@ -0,0 +1,86 @@
+#ifndef __SOLVE_CACHE_H__
+#define __SOLVE_CACHE_H__
+
+#include "game.h"
+
+/**
+ * @file solve_cache.h
+ *
+ * @brief This file provides an on-disk cache of the results of the solver.
+ *
+ * A cache is a directory holding two files. "data" is a log of records, each
+ *one giving the pieces, the size and the wrapping of a board with its number
+ *of solutions and one of its solutions when they are known. "index" is a hash
+ *table from a hash of the board to its latest record, which is memory-mapped so
+ *that a lookup missing the cache only reads a few slots of it.
+ *
+ * The files use the byte order of the machine. A record is only used if its
+ *board matches the one looked up, so a cache shared with another process
+ *writing to it at the same time may lose entries but never gives a wrong
+ *board.
+ **/
+
+/**
+ * @brief The name of the environment variable giving the cache of the
+ *interactive front ends
+ **/
+#define SOLVE_CACHE_ENV "NET_SOLVE_CACHE"
+
+/**
+ * @brief The structure pointer that stores an open cache
+ **/
+typedef struct solve_cache_s *solve_cache;
+
+/**
+ * @brief What a cache knows about a board
+ **/
+typedef struct cache_entry_s {
+  bool has_count;        /**< whether nb_solutions is known */
+  uint64_t nb_solutions; /**< the number of solutions of the board */
+  bool has_solution;     /**< whether solution holds a solution */
+  direction *solution;   /**< the direction of every cell of a solution,
+                            indexed by x + y * width, given by the caller */
+} cache_entry;
+
+/**
+ * @brief Opens a cache, the directory and its files are created if needed
+ * @param directory the directory of the cache
+ * @return the opened cache, NULL in case of error
+ **/
+solve_cache cache_open(const char *directory);
+
+/**
+ * @brief Opens the cache named by the SOLVE_CACHE_ENV environment variable
+ * @return the opened cache, NULL if the variable isn't set or in case of error
+ **/
+solve_cache cache_open_env(void);
+
+/**
+ * @brief Looks a board up in a cache. A cache can be used by several threads
+ *at the same time
+ * @param cache the cache
+ * @param board the board, only its pieces, size and wrapping are compared
+ * @param entry where what is known is written, its solution array must hold a
+ *direction per cell
+ * @return true if the board is in the cache, false otherwise
+ **/
+bool cache_lookup(solve_cache cache, cgame board, cache_entry *entry);
+
+/**
+ * @brief Adds what is known about a board to a cache, what the cache already
+ *knows about it is kept
+ * @param cache the cache
+ * @param board the board
+ * @param entry what is known, its solution array is only read if has_solution
+ *is set
+ * @return false in case of error, true otherwise
+ **/
+bool cache_store(solve_cache cache, cgame board, const cache_entry *entry);
+
+/**
+ * @brief Closes a cache and frees all its memory
+ * @param cache the cache to close
+ **/
+void cache_close(solve_cache cache);
+
+#endif  // __SOLVE_CACHE_H__
@@ -0,0 +1,83 @@
+#ifndef __SOLVE_CDCL_H__
+#define __SOLVE_CDCL_H__
+
+#include "game.h"
+#include "solve_prop.h"
+
+/**
+ * @file solve_cdcl.h
+ *
+ * @brief This file provides a conflict-driven clause-learning engine for the
+ *solver, meant for the hardest boards.
+ *
+ * The board is encoded as clauses over two kinds of variables: whether each
+ *cell takes each of its distinct orientations, and whether each pair of
+ *neighbouring cells is connected. The connections that are decided are kept in
+ *a union-find, and a loop or a network closed before it spans the board is
+ *turned into a clause forbidding it. Every conflict is analysed to learn a
+ *clause, the search then jumps back to the decision that clause concerns, and
+ *it restarts from time to time, branching on the variables involved in the
+ *most recent conflicts.
+ **/
+
+/**
+ * @brief The structure pointer that stores a clause-learning engine
+ **/
+typedef struct cdcl_engine_s *cdcl_engine;
+
+/**
+ * @brief Creates a clause-learning engine for a board
+ * @param board the game to solve, it is not modified by the engine
+ * @return the newly created engine, NULL in case of error
+ **/
+cdcl_engine cdcl_create(cgame board);
+
+/**
+ * @brief Enumerates the solutions of the board of an engine. Each solution
+ *found is forbidden by a new clause before the search goes on, so the
+ *solutions don't come in the order of the other engines. An engine can only
+ *be searched once
+ * @param engine the clause-learning engine
+ * @param on_solution the function called for each solution found
+ * @param data a pointer given to on_solution
+ * @return false in case of error, true if the search was stopped by
+ *on_solution or by its budget, or explored the whole search space
+ **/
+bool cdcl_search(cdcl_engine engine, prop_solution_callback on_solution,
+                 void *data);
+
+/**
+ * @brief Sets the budget of the search of an engine, which stops once it is
+ *spent, see cdcl_out_of_budget
+ * @param engine the clause-learning engine
+ * @param max_nodes the number of decisions the search may take, 0 for no limit
+ *(the default)
+ * @param max_milliseconds the time the search may take, 0 for no limit (the
+ *default). The clock is only read every few decisions
+ **/
+void cdcl_set_budget(cdcl_engine engine, uint64_t max_nodes,
+                     uint32_t max_milliseconds);
+
+/**
+ * @brief Tells whether the search of an engine was stopped by its budget, the
+ *solutions found until then were given to on_solution
+ * @param engine the clause-learning engine
+ * @return true if the budget ran out, false otherwise
+ **/
+bool cdcl_out_of_budget(cdcl_engine engine);
+
+/**
+ * @brief Gets the statistics of an engine: its decisions as nodes, the
+ *literals it propagated as propagations and its conflicts as backtracks
+ * @param engine the clause-learning engine
+ * @param stats where the counters are written, the others are left untouched
+ **/
+void cdcl_get_stats(cdcl_engine engine, solver_stats *stats);
+
+/**
+ * @brief Destroys a clause-learning engine and frees all its memory
+ * @param engine the engine to destroy
+ **/
+void cdcl_destroy(cdcl_engine engine);
+
+#endif  // __SOLVE_CDCL_H__
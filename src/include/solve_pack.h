@@ -0,0 +1,109 @@
+#ifndef __SOLVE_PACK_H__
+#define __SOLVE_PACK_H__
+
+#include "game.h"
+
+/**
+ * @file solve_pack.h
+ *
+ * @brief This file provides a compact file format for the solutions of a
+ *board, written by find_all instead of one save file per solution.
+ *
+ * A pack holds the board once, then its solutions in the order they were
+ *found. Every PACK_BLOCK_SIZE-th solution is stored in full, with 2 bits per
+ *cell, and the others as the cells changed since the previous solution. An
+ *index at the end of the file gives where each block of solutions starts, so a
+ *solution is read by decoding at most a block, and reading the solutions in
+ *order decodes each of them once.
+ *
+ * The file uses the byte order of the machine. A pack is only readable once
+ *its writer was closed.
+ **/
+
+/**
+ * @brief The number of solutions in a block of a pack
+ **/
+#define PACK_BLOCK_SIZE 64
+
+/**
+ * @brief The structure pointer that stores a pack being written
+ **/
+typedef struct pack_writer_s *pack_writer;
+
+/**
+ * @brief The structure pointer that stores a pack being read
+ **/
+typedef struct pack_reader_s *pack_reader;
+
+/**
+ * @brief Creates a pack, the file is overwritten if it exists
+ * @param path the file of the pack
+ * @param board the board whose solutions are packed, it is stored with its
+ *current directions
+ * @return the pack, NULL in case of error
+ **/
+pack_writer pack_create(const char *path, cgame board);
+
+/**
+ * @brief Adds a solution at the end of a pack
+ * @param writer the pack
+ * @param solution the solved board, it must have the size of the packed board
+ * @return false in case of error, true otherwise
+ **/
+bool pack_add(pack_writer writer, cgame solution);
+
+/**
+ * @brief Writes the index of a pack, closes it and frees all its memory
+ * @param writer the pack to close
+ * @return false if the pack couldn't be completed, true otherwise
+ **/
+bool pack_finish(pack_writer writer);
+
+/**
+ * @brief Opens a pack for reading
+ * @param path the file of the pack
+ * @return the pack, NULL if it can't be read
+ **/
+pack_reader pack_open(const char *path);
+
+/**
+ * @brief Gets the board of a pack, with the directions it was packed with
+ * @param reader the pack
+ * @return the board, owned by the pack
+ **/
+cgame pack_get_board(pack_reader reader);
+
+/**
+ * @brief Gets the number of solutions of a pack
+ * @param reader the pack
+ * @return the number of solutions
+ **/
+uint64_t pack_nb_solutions(pack_reader reader);
+
+/**
+ * @brief Reads a solution of a pack. Reading the solution following the last
+ *one read only decodes it, any other is found through the index
+ * @param reader the pack
+ * @param index the index of the solution, in [0; pack_nb_solutions(reader)[
+ * @param orientations where the direction of every cell is written, indexed by
+ *x + y * width
+ * @return false in case of error, true otherwise
+ **/
+bool pack_read(pack_reader reader, uint64_t index, direction *orientations);
+
+/**
+ * @brief Applies a solution of a pack to a board
+ * @param reader the pack
+ * @param index the index of the solution, in [0; pack_nb_solutions(reader)[
+ * @param board the game to modify, it must have the size of the packed board
+ * @return false in case of error, true otherwise
+ **/
+bool pack_load(pack_reader reader, uint64_t index, game board);
+
+/**
+ * @brief Closes a pack opened for reading and frees all its memory
+ * @param reader the pack to close
+ **/
+void pack_close(pack_reader reader);
+
+#endif  // __SOLVE_PACK_H__
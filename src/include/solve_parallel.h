@@ -0,0 +1,86 @@
+#ifndef __SOLVE_PARALLEL_H__
+#define __SOLVE_PARALLEL_H__
+
+#include "game.h"
+#include "solve_prop.h"
+#include "solver.h"
+
+/**
+ * @file solve_parallel.h
+ *
+ * @brief This file provides a multi-threaded search on top of the propagation
+ *engine.
+ *
+ * Each worker thread runs its own propagation engine. When some workers are
+ *idle, a busy one gives away the last untried orientation of its shallowest
+ *decision as a subproblem, which the idle ones steal. Subproblems are ordered
+ *by the path of decisions leading to them, so the results are the ones of the
+ *sequential search. Solutions are counted apart: the first decisions are
+ *split into subproblems, each worker counts some of them with the cache of its
+ *own engine and the partial counts are summed.
+ **/
+
+/**
+ * @brief Searches the solutions of a board with several threads
+ * @param board the game to solve, it is not modified
+ * @param nb_threads the number of worker threads, at least 1
+ * @param mode what the search has to find: in SOLVER_FIND_ONE mode on_solution
+ *is called with the solution the sequential search finds first, in
+ *SOLVER_FIND_ALL mode it is called for every solution in the order of the
+ *sequential search, and in SOLVER_NB_SOL mode it isn't called. The solutions
+ *are enumerated to be counted, parallel_count is much faster on boards with
+ *many solutions
+ * @param max_solutions the number of solutions kept in SOLVER_FIND_ALL mode, 0
+ *for all of them. Once that many are kept, the branches reached after the last
+ *of them are cut, so the memory of the search stays bounded
+ * @param max_bytes the memory the solutions kept may use, 0 for no limit. Once
+ *it is full the solutions kept bound the search as max_solutions does
+ * @param max_nodes the number of nodes the workers may explore together, 0 for
+ *no limit. They only check it every few nodes, so they may explore a few more
+ * @param max_milliseconds the time the search may take, 0 for no limit. It is
+ *checked as often as max_nodes
+ * @param on_solution the function called for the solutions found, once every
+ *thread is done
+ * @param data a pointer given to on_solution
+ * @param nb_solutions where the number of solutions found is written, the
+ *solutions given to on_solution in SOLVER_FIND_ONE and SOLVER_FIND_ALL modes
+ * @param stats where the counters of the workers are written summed up, NULL
+ *if they aren't needed
+ * @return SOLVER_DONE once the search is over, SOLVER_UNFINISHED if a budget
+ *ran out first (the solutions kept until then are given to on_solution, and
+ *the search can't be resumed), SOLVER_OUT_OF_MEMORY if the solutions outgrew
+ *max_bytes (the first ones that fit are still given to on_solution),
+ *SOLVER_ERROR in case of error
+ **/
+solver_status parallel_search(cgame board, uint16_t nb_threads,
+                              solver_mode mode, uint32_t max_solutions,
+                              uint64_t max_bytes, uint64_t max_nodes,
+                              uint32_t max_milliseconds,
+                              prop_solution_callback on_solution, void *data,
+                              uint64_t *nb_solutions, solver_stats *stats);
+
+/**
+ * @brief Counts the solutions of a board with several threads, splitting it
+ *into subproblems that the threads count with prop_count
+ * @param board the game to count the solutions of, it is not modified
+ * @param nb_threads the number of counting threads, at least 1
+ * @param big whether the count has arbitrary precision instead of 64 bits
+ * @param max_bytes the memory the caches of the threads may use together, 0
+ *for the default of prop_set_memory_limit on each thread
+ * @param max_nodes the number of nodes the threads may explore together, 0 for
+ *no limit
+ * @param max_milliseconds the time the count may take, 0 for no limit
+ * @param count an initialized counter of the same kind as big, the solutions
+ *are added to it
+ * @param stats where the counters of the threads are written summed up, NULL
+ *if they aren't needed
+ * @return SOLVER_DONE once the board is counted, SOLVER_UNFINISHED if a budget
+ *ran out first (count is then left untouched, and the count can't be
+ *resumed), SOLVER_ERROR in case of error
+ **/
+solver_status parallel_count(cgame board, uint16_t nb_threads, bool big,
+                             uint64_t max_bytes, uint64_t max_nodes,
+                             uint32_t max_milliseconds, sol_count *count,
+                             solver_stats *stats);
+
+#endif  // __SOLVE_PARALLEL_H__
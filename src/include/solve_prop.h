@@ -0,0 +1,200 @@
+#ifndef __SOLVE_PROP_H__
+#define __SOLVE_PROP_H__
+
+#include "game.h"
+#include "sol_count.h"
+#include "solver_stats.h"
+
+/**
+ * @file solve_prop.h
+ *
+ * @brief This file provides a constraint-propagation engine for the solver.
+ *
+ * Each cell of the board has a domain: a 4-bit mask of the orientations it can
+ *still take. Neighbouring cells must agree on the edge they share, this is
+ *enforced with a worklist until a fixed point is reached, and the engine only
+ *branches, on the smallest domain, when propagation stalls.
+ *
+ * The search is depth first: every domain change is recorded on a trail and
+ *undone down to the mark of a decision when backtracking, so the memory used
+ *stays proportional to the number of cells. The connections the domains commit
+ *to are kept in a union-find undone the same way, so a branch ends as soon as
+ *it closes a loop or finishes a network that doesn't span the board.
+ *
+ * A search can be run in steps of a few nodes, a node being a fixed point of
+ *the propagation: a new search starts unless the last step was paused. Counts
+ *don't enumerate the solutions, the subproblems met several times are cached
+ *and only explored once; once the cache is full the count stays exact but
+ *slower. To share a search between threads, prop_split gives away the last
+ *untried orientation of the shallowest decision, and comparing the paths of
+ *two subproblems in lexicographic order gives the order in which a sequential
+ *search reaches them.
+ **/
+
+/**
+ * @brief The structure pointer that stores a propagation engine
+ **/
+typedef struct prop_engine_s *prop_engine;
+
+/**
+ * @brief How a search stepped by prop_search_step or prop_count_step ended
+ **/
+typedef enum prop_status_e {
+  PROP_FINISHED = 0,
+  PROP_STOPPED = 1,
+  PROP_PAUSED = 2,
+  PROP_ERROR = 3
+} prop_status;
+
+/**
+ * @brief Function called by prop_search for each solution found
+ * @param orientations the direction of every cell, indexed by x + y * width
+ * @param data the pointer given to prop_search
+ * @return true to keep searching, false to stop the search
+ **/
+typedef bool (*prop_solution_callback)(const direction *orientations,
+                                       void *data);
+
+/**
+ * @brief Function called by prop_search before each decision
+ * @param engine the engine running the search
+ * @param data the pointer given to prop_set_node_callback
+ * @return true to explore the current branch, false to backtrack from it
+ **/
+typedef bool (*prop_node_callback)(prop_engine engine, void *data);
+
+/**
+ * @brief Creates a propagation engine for a board
+ * @param board the game to solve, it is not modified by the engine
+ * @return the newly created engine, NULL in case of error
+ **/
+prop_engine prop_create(cgame board);
+
+/**
+ * @brief Enumerates the solutions of the board of an engine
+ * @param engine the propagation engine
+ * @param on_solution the function called for each solution found
+ * @param data a pointer given to on_solution
+ * @return false if the search was stopped by on_solution or in case of error,
+ *true if the whole search space was explored
+ **/
+bool prop_search(prop_engine engine, prop_solution_callback on_solution,
+                 void *data);
+
+/**
+ * @brief Runs or resumes a search like prop_search for a limited number of
+ *nodes
+ * @param engine the propagation engine
+ * @param on_solution the function called for each solution found
+ * @param data a pointer given to on_solution
+ * @param max_nodes the number of nodes the step may explore, at least 1
+ * @return the status of the search after the step
+ **/
+prop_status prop_search_step(prop_engine engine,
+                             prop_solution_callback on_solution, void *data,
+                             uint64_t max_nodes);
+
+/**
+ * @brief Counts the solutions of the board of an engine
+ * @param engine the propagation engine
+ * @param big whether the count has arbitrary precision instead of 64 bits
+ * @param count where the count is written, it is initialized by the function
+ *and must be cleared by the caller
+ * @return false in case of error, true otherwise
+ **/
+bool prop_count(prop_engine engine, bool big, sol_count *count);
+
+/**
+ * @brief Runs or resumes a count like prop_count for a limited number of nodes
+ * @param engine the propagation engine
+ * @param big whether the count has arbitrary precision instead of 64 bits,
+ *only read when a new count is started
+ * @param count where the solutions are counted, it is initialized when a new
+ *count is started, the same counter must be given until the count is over and
+ *it must be cleared by the caller
+ * @param max_nodes the number of nodes the step may explore, at least 1
+ * @return the status of the count after the step, PROP_STOPPED isn't used
+ **/
+prop_status prop_count_step(prop_engine engine, bool big, sol_count *count,
+                            uint64_t max_nodes);
+
+/**
+ * @brief Propagates the domains of an engine to a fixed point without taking
+ *any decision
+ * @param engine the propagation engine
+ * @return false if the deduction shows that the board has no solution or in
+ *case of error, true otherwise
+ **/
+bool prop_deduce(prop_engine engine);
+
+/**
+ * @brief Sets the function called by prop_search before each decision
+ * @param engine the propagation engine
+ * @param on_node the function to call, NULL to call none
+ * @param data a pointer given to on_node
+ **/
+void prop_set_node_callback(prop_engine engine, prop_node_callback on_node,
+                            void *data);
+
+/**
+ * @brief Sets the memory the cache of the next counts may use
+ * @param engine the propagation engine
+ * @param max_bytes the number of bytes, 0 or more than 256 MiB for 256 MiB
+ *(the default)
+ **/
+void prop_set_memory_limit(prop_engine engine, uint64_t max_bytes);
+
+/**
+ * @brief Gets the orientations chosen by the decisions leading to the current
+ *branch
+ * @param engine the propagation engine, during a search
+ * @param path where the orientations are written, it must hold one per cell
+ * @return the number of orientations written
+ **/
+uint32_t prop_get_path(prop_engine engine, uint8_t *path);
+
+/**
+ * @brief Gives away a subproblem of the current search
+ * @param engine the propagation engine, during a search
+ * @param domains where the domains of the subproblem are written, it must hold
+ *one per cell
+ * @param path where the path of the subproblem is written, it must hold one
+ *orientation per cell
+ * @param path_length where the length of the path is written
+ * @return true if a subproblem was given away, false if no decision has an
+ *orientation left to try
+ **/
+bool prop_split(prop_engine engine, uint8_t *domains, uint8_t *path,
+                uint32_t *path_length);
+
+/**
+ * @brief Gets the current domains of an engine
+ * @param engine the propagation engine, not searching
+ * @param domains where the domains are written, it must hold one per cell
+ **/
+void prop_get_domains(prop_engine engine, uint8_t *domains);
+
+/**
+ * @brief Makes the next searches of an engine explore a subproblem
+ * @param engine the propagation engine, not searching
+ * @param domains the domains of the subproblem
+ * @param path the path of the subproblem
+ * @param path_length the length of the path
+ **/
+void prop_load(prop_engine engine, const uint8_t *domains, const uint8_t *path,
+               uint32_t path_length);
+
+/**
+ * @brief Gets the statistics of an engine since it was created
+ * @param engine the propagation engine
+ * @param stats where the counters are written, the others are left untouched
+ **/
+void prop_get_stats(prop_engine engine, solver_stats *stats);
+
+/**
+ * @brief Destroys a propagation engine and frees all its memory
+ * @param engine the engine to destroy
+ **/
+void prop_destroy(prop_engine engine);
+
+#endif  // __SOLVE_PROP_H__
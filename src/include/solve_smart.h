@@ -0,0 +1,181 @@
+#ifndef __SOLVE_SMART_H__
+#define __SOLVE_SMART_H__
+
+#include "game.h"
+#include "sol_count.h"
+#include "solver_stats.h"
+
+/**
+ * @file solve_smart.h
+ *
+ * @brief This file provides the original solving engine, which builds a tree
+ *of all the possibilities by propagating outward from a piece, (0,0) unless
+ *another order is chosen.
+ *
+ * Before any branching, deduction rules narrow the orientations every piece
+ *may take until none of them can remove another one, most generated boards
+ *being solved by them alone. Once the pieces left with a single orientation
+ *are fixed, the movable pieces left often split into regions that can't
+ *constrain each other. They are then given a tree each, and the solutions of
+ *the board are all the combinations of a solution of each region.
+ **/
+
+/**
+ * @brief The structure pointer that stores a smart engine
+ **/
+typedef struct smart_engine_s *smart_engine;
+
+/**
+ * @brief The deduction rules applied before branching, to be combined
+ * SMART_RULE_EDGES: a piece agrees with the connections its neighbours have
+ *in all their remaining orientations, or lack in all of them
+ * SMART_RULE_LEAVES: two leaves never connect to each other
+ * SMART_RULE_LOOPS: no orientation closes a loop with the connections already
+ *known
+ * SMART_RULE_ISOLATION: no orientation closes a network that doesn't hold
+ *every piece
+ **/
+typedef enum smart_rule_e {
+  SMART_RULE_EDGES = 1,
+  SMART_RULE_LEAVES = 2,
+  SMART_RULE_LOOPS = 4,
+  SMART_RULE_ISOLATION = 8
+} smart_rule;
+
+/**
+ * @brief All the deduction rules, the ones a new engine applies
+ **/
+#define SMART_RULES_ALL                                   \
+  (SMART_RULE_EDGES | SMART_RULE_LEAVES | SMART_RULE_LOOPS | \
+   SMART_RULE_ISOLATION)
+
+/**
+ * @brief The orders in which the search places the pieces
+ * SMART_ORDER_FIXED: from (0,0), the neighbours of a piece being visited in
+ *the order N, E, S, W
+ * SMART_ORDER_FEWEST: from the piece with the fewest orientations left, then
+ *to the neighbours with the fewest orientations left first
+ * SMART_ORDER_CONSTRAINED: to the neighbours with the most pieces already
+ *placed or unmovable around them first, the fewest orientations breaking ties
+ * SMART_ORDER_DEGREE: to the neighbours with the fewest orientations left per
+ *connection of their piece first
+ *
+ * The solutions found are the same whatever the order, only the order in
+ *which they are indexed and the work needed change.
+ **/
+typedef enum smart_order_e {
+  SMART_ORDER_FIXED = 0,
+  SMART_ORDER_FEWEST = 1,
+  SMART_ORDER_CONSTRAINED = 2,
+  SMART_ORDER_DEGREE = 3
+} smart_order;
+
+/**
+ * @brief Creates a smart engine working on a private copy of a board
+ * @param board the game to solve, it is not modified by the engine
+ * @return the newly created engine, NULL in case of error
+ **/
+smart_engine smart_create(cgame board);
+
+/**
+ * @brief Chooses the deduction rules the next solves apply
+ * @param smart the smart engine
+ * @param rules a combination of smart_rule values, 0 only fixing the pieces
+ *that look the same in every orientation
+ **/
+void smart_set_rules(smart_engine smart, uint32_t rules);
+
+/**
+ * @brief Chooses the order in which the next solves place the pieces
+ * @param smart the smart engine
+ * @param order the order, SMART_ORDER_FIXED by default
+ **/
+void smart_set_order(smart_engine smart, smart_order order);
+
+/**
+ * @brief Sets the memory the possibility trees of the next solves may hold
+ * @param smart the smart engine
+ * @param max_bytes the number of bytes, 0 for no limit (the default). A solve
+ *needing more gives up, see smart_out_of_memory
+ **/
+void smart_set_memory_limit(smart_engine smart, uint64_t max_bytes);
+
+/**
+ * @brief Sets the budget of the next solves, a solve spending it gives up, see
+ *smart_out_of_budget
+ * @param smart the smart engine
+ * @param max_nodes the number of possibilities searched a solve may take, 0 for
+ *no limit (the default)
+ * @param max_milliseconds the time a solve may take, 0 for no limit (the
+ *default). The clock is only read every few possibilities searched
+ **/
+void smart_set_budget(smart_engine smart, uint64_t max_nodes,
+                      uint32_t max_milliseconds);
+
+/**
+ * @brief Builds the tree of all the solutions of the board
+ * @param smart the smart engine
+ * @return true if at least one solution was found, false otherwise or if the
+ *trees needed more memory than allowed, or than could be allocated, or if the
+ *budget ran out
+ **/
+bool smart_solve(smart_engine smart);
+
+/**
+ * @brief Tells whether the last smart_solve gave up for lack of memory, its
+ *trees are then dropped and it found no solution
+ * @param smart the smart engine
+ * @return true if the trees ran out of memory, false otherwise
+ **/
+bool smart_out_of_memory(smart_engine smart);
+
+/**
+ * @brief Tells whether the last smart_solve gave up once its budget was spent,
+ *its trees are then dropped and it found no solution
+ * @param smart the smart engine
+ * @return true if the budget ran out, false otherwise
+ **/
+bool smart_out_of_budget(smart_engine smart);
+
+/**
+ * @brief Returns the number of solutions found by smart_solve
+ * @param smart the smart engine
+ * @return the product of the numbers of leaves of the trees of the regions,
+ *UINT32_MAX if it doesn't fit
+ **/
+uint32_t smart_nb_solutions(smart_engine smart);
+
+/**
+ * @brief Adds the exact number of solutions found by smart_solve to a counter
+ * @param smart the smart engine
+ * @param count the counter
+ * @return false if an arbitrary-precision counter couldn't grow or in case of
+ *error, true otherwise
+ **/
+bool smart_count_solutions(smart_engine smart, sol_count *count);
+
+/**
+ * @brief Applies one of the solutions found by smart_solve to a board
+ * @param smart the smart engine
+ * @param index the index of the solution, in [0; smart_nb_solutions(smart)[
+ * @param board the game to modify, it must have the size of the solved board
+ * @return true if the solution was applied, false in case of error
+ **/
+bool smart_load_solution(smart_engine smart, uint32_t index, game board);
+
+/**
+ * @brief Gets the statistics of the last smart_solve: its findPoss and
+ *propagate calls as nodes and propagations, the leaves it deleted as
+ *backtracks, the pieces setUnmovable fixed and the peak memory of its trees
+ * @param smart the smart engine
+ * @param stats where the counters are written, the times are left untouched
+ **/
+void smart_get_stats(smart_engine smart, solver_stats *stats);
+
+/**
+ * @brief Destroys a smart engine and frees all its memory
+ * @param smart the engine to destroy
+ **/
+void smart_destroy(smart_engine smart);
+
+#endif  // __SOLVE_SMART_H__
@@ -0,0 +1,59 @@
+#ifndef __SOLVE_TRANSFER_H__
+#define __SOLVE_TRANSFER_H__
+
+#include "game.h"
+#include "sol_count.h"
+#include "solver.h"
+#include "solver_stats.h"
+
+/**
+ * @file solve_transfer.h
+ *
+ * @brief This file provides a transfer-matrix counter for the solver, counting
+ *the solutions of narrow boards that don't wrap without finding them.
+ *
+ * The cells are placed one at a time, row after row across the narrow side of
+ *the board. A state of the count is made of the connections leaving the placed
+ *cells, one per column at most and one towards the next cell, and of which of
+ *them the placed pieces already link together. Each state keeps the number of
+ *ways the placed cells reach it, so the work grows exponentially with the
+ *narrow side only and boards with huge numbers of solutions are counted as
+ *fast as the others.
+ **/
+
+/**
+ * @brief The widest narrow side of a board the counter accepts
+ **/
+#define TRANSFER_MAX_WIDTH 12
+
+/**
+ * @brief Tells whether the counter accepts a board: it doesn't wrap and its
+ *width or its height is at most TRANSFER_MAX_WIDTH
+ * @param board the game to count the solutions of
+ * @return true if the board can be counted, false otherwise or if it is NULL
+ **/
+bool transfer_suits(cgame board);
+
+/**
+ * @brief Counts the solutions of a board row by row
+ * @param board the game to count the solutions of, it must suit the counter
+ * @param big whether the count has arbitrary precision instead of 64 bits
+ * @param max_bytes the memory the states may use, 0 for no limit
+ * @param max_nodes the number of states the count may expand, 0 for no limit
+ * @param max_milliseconds the time the count may take, 0 for no limit. The
+ *clock is only read after each cell, so the count may take a bit longer
+ * @param count where the count is written, it is initialized by the function
+ *and must be cleared by the caller
+ * @param stats where the states expanded are written as nodes, the states
+ *reached as propagations and the pieces that didn't fit as backtracks, NULL if
+ *not needed
+ * @return SOLVER_DONE once the board is counted, SOLVER_UNFINISHED if a budget
+ *ran out first, SOLVER_OUT_OF_MEMORY if the states outgrew max_bytes, and
+ *SOLVER_ERROR if the board doesn't suit the counter or in case of error. The
+ *count is only written with SOLVER_DONE
+ **/
+solver_status transfer_count(cgame board, bool big, uint64_t max_bytes,
+                             uint64_t max_nodes, uint32_t max_milliseconds,
+                             sol_count *count, solver_stats *stats);
+
+#endif  // __SOLVE_TRANSFER_H__
@@ -0,0 +1,437 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include "game.h"
+#include "sol_count.h"
+#include "solve_cache.h"
+#include "solver_stats.h"
+
+/**
+ * @file solver.h
+ *
+ * @brief This file provides a reentrant interface to the Net solver.
+ *
+ * All the working state of a solve is stored in a solver_ctx, so several
+ *contexts can be used at the same time (from different threads for example)
+ *without interfering with each other. solve_one, count_solutions and
+ *enumerate_solutions cover the common solves in a single call, and like the
+ *contexts they never touch the filesystem, unlike find_one, nb_sol and
+ *find_all which read and write files for net_solve.
+ *
+ * The smart engine builds a tree of every possibility from (0,0), the prop
+ *engine propagates orientation domains and branches on the smallest one, the
+ *cdcl engine learns a clause from each conflict and the transfer engine counts
+ *narrow boards row by row, see solve_transfer.h. The boards and modes the
+ *transfer engine can't handle, the smart trees outgrowing the memory limit
+ *and the solves with locked pieces are all left to the prop engine.
+ *
+ * Only the prop engine uses several threads, and the solutions found are the
+ *same whatever their number. A FIND_ALL stream without a limit stays on one
+ *thread, since the threads would have to keep the solutions until the end.
+ *In SOLVER_NB_SOL mode the prop engine counts without enumerating: the
+ *subproblems met several times are only explored once.
+ *
+ * solver_step runs a solve within a budget, after may_have_solution has
+ *screened the board. Only the prop engine on a single thread resumes where
+ *the last step stopped, the other engines and the threaded solves start over
+ *on the next step. The settings of a context must not change until its solve
+ *is over.
+ *
+ * The memory limit covers what grows with the solutions. Solutions that have
+ *to be kept but don't fit end the solve with SOLVER_OUT_OF_MEMORY, the ones
+ *kept so far can still be read. A solution callback avoids keeping them: on
+ *one prop thread the memory then only depends on the size of the board.
+ *
+ * Locked pieces keep their current direction. Solves with locks run on a
+ *single prop thread and skip the cache. find_hint gives a piece forced by
+ *deduction alone when there is one, otherwise a piece of the first solution
+ *found, and check_locks marks locked pieces on a conflict so that unlocking
+ *any of them lets the others fit in a solution.
+ **/
+
+/**
+ * @brief The structure pointer that stores the state of a solve
+ **/
+typedef struct solver_ctx_s *solver_ctx;
+
+/**
+ * @brief The available solving engines
+ **/
+typedef enum solver_engine_e {
+  SOLVER_ENGINE_SMART = 0,
+  SOLVER_ENGINE_PROP = 1,
+  SOLVER_ENGINE_CDCL = 2,
+  SOLVER_ENGINE_TRANSFER = 3
+} solver_engine;
+
+/**
+ * @brief What a solve has to find: every solution, the first one or their
+ *number
+ **/
+typedef enum solver_mode_e {
+  SOLVER_FIND_ALL = 0,
+  SOLVER_FIND_ONE = 1,
+  SOLVER_NB_SOL = 2
+} solver_mode;
+
+/**
+ * @brief The state a solve is left in by solver_step
+ **/
+typedef enum solver_status_e {
+  SOLVER_DONE = 0,
+  SOLVER_UNFINISHED = 1,
+  SOLVER_ERROR = 2,
+  SOLVER_OUT_OF_MEMORY = 3
+} solver_status;
+
+/**
+ * @brief What check_locks found out about the locked pieces of a board
+ **/
+typedef enum solver_locks_e {
+  SOLVER_LOCKS_SOLVABLE = 0,
+  SOLVER_LOCKS_CONFLICT = 1,
+  SOLVER_LOCKS_UNKNOWN = 2,
+  SOLVER_LOCKS_ERROR = 3
+} solver_locks;
+
+/**
+ * @brief Where find_one, nb_sol and find_all write the JSON report of a solve,
+ *SOLVER_REPORT_FILE writes it in <prefix>.json
+ **/
+typedef enum solver_report_e {
+  SOLVER_REPORT_NONE = 0,
+  SOLVER_REPORT_FILE = 1,
+  SOLVER_REPORT_STDERR = 2
+} solver_report;
+
+/**
+ * @brief The settings of a solve, as given to net_solve
+ **/
+typedef struct solver_options_s {
+  solver_engine engine; /**< the engine to solve with */
+  uint16_t nb_threads;  /**< the number of threads of the prop engine, 0 for
+                           one per processor */
+  bool big_count;       /**< whether counts have arbitrary precision */
+  uint32_t max_solutions; /**< number of solutions after which FIND_ALL stops,
+                             0 for no limit */
+  uint32_t time_limit;    /**< milliseconds after which find_one, nb_sol and
+                             find_all give up, 0 for no limit */
+  solver_report report;   /**< where the report of the solve is written */
+  const char *cache_dir;  /**< directory of the cache checked before solving,
+                             NULL for none */
+  bool packed;            /**< whether find_all writes its solutions in a
+                             single <prefix>.pack file, see solve_pack.h */
+  uint64_t max_memory;    /**< bytes the solve may use for its trees,
+                             caches and kept solutions, 0 for no limit */
+} solver_options;
+
+/**
+ * @brief A single move: the direction a piece has to be turned to
+ **/
+typedef struct solver_move_s {
+  uint16_t x;    /**< the column of the piece */
+  uint16_t y;    /**< the row of the piece */
+  direction dir; /**< the direction the piece has to take */
+} solver_move;
+
+/**
+ * @brief Function receiving the solutions of a solve as soon as they are found
+ * @param solution the solved board, only valid during the call
+ * @param index the index of the solution, starting from 0
+ * @param data the pointer given to solver_set_solution_callback
+ * @return true to keep searching, false to stop the search
+ **/
+typedef bool (*solver_solution_callback)(cgame solution, uint32_t index,
+                                         void *data);
+
+/**
+ * @brief Creates a solver context working on a private copy of a board
+ * @param board the game to solve, it is not modified by the solver
+ * @return the newly created context, NULL in case of error
+ **/
+solver_ctx solver_create(cgame board);
+
+/**
+ * @brief Makes a context solve another board, keeping its settings
+ * @param ctx the solver context
+ * @param board the game to solve next, it is not modified by the solver
+ * @return false in case of error, the context then keeps its board, true
+ *otherwise
+ **/
+bool solver_set_board(solver_ctx ctx, cgame board);
+
+/**
+ * @brief Sets the engine used by the next solves of a context
+ * @param ctx the solver context
+ * @param engine the engine to use, SOLVER_ENGINE_PROP by default
+ **/
+void solver_set_engine(solver_ctx ctx, solver_engine engine);
+
+/**
+ * @brief Sets what the next solves of a context have to find
+ * @param ctx the solver context
+ * @param mode the solving mode, SOLVER_FIND_ALL by default
+ **/
+void solver_set_mode(solver_ctx ctx, solver_mode mode);
+
+/**
+ * @brief Sets the number of threads used by the next prop solves of a context
+ * @param ctx the solver context
+ * @param nb_threads the number of threads, 1 by default, 0 for one per
+ *processor
+ **/
+void solver_set_threads(solver_ctx ctx, uint16_t nb_threads);
+
+/**
+ * @brief Sets the deduction rules of the next smart solves of a context
+ * @param ctx the solver context
+ * @param rules a combination of the smart_rule values of solve_smart.h,
+ *SMART_RULES_ALL by default
+ **/
+void solver_set_rules(solver_ctx ctx, uint32_t rules);
+
+/**
+ * @brief Sets the order in which the next smart solves of a context place the
+ *pieces
+ * @param ctx the solver context
+ * @param order a smart_order value of solve_smart.h, SMART_ORDER_FIXED by
+ *default
+ **/
+void solver_set_order(solver_ctx ctx, uint32_t order);
+
+/**
+ * @brief Sets the memory the next solves of a context may use for their trees,
+ *caches and kept solutions
+ * @param ctx the solver context
+ * @param max_bytes the number of bytes, 0 for no limit (the default)
+ **/
+void solver_set_memory_limit(solver_ctx ctx, uint64_t max_bytes);
+
+/**
+ * @brief Sets the kind of counter used by the next solves of a context
+ * @param ctx the solver context
+ * @param big true for an arbitrary-precision counter, false for a 64-bit
+ *counter (the default) that records when it overflows
+ **/
+void solver_set_big_count(solver_ctx ctx, bool big);
+
+/**
+ * @brief Sets the number of solutions after which the next solves of a context
+ *stop, in SOLVER_FIND_ALL mode
+ * @param ctx the solver context
+ * @param max_solutions the number of solutions, 0 for no limit (the default)
+ **/
+void solver_set_limit(solver_ctx ctx, uint32_t max_solutions);
+
+/**
+ * @brief Makes the next solves of a context give each solution to a function
+ *instead of keeping it
+ * @param ctx the solver context
+ * @param on_solution the function, NULL to keep the solutions in the context
+ *again
+ * @param data a pointer given to on_solution
+ * @return false in case of error, true otherwise
+ **/
+bool solver_set_solution_callback(solver_ctx ctx,
+                                  solver_solution_callback on_solution,
+                                  void *data);
+
+/**
+ * @brief Makes the next solves of a context read and fill a cache
+ * @param ctx the solver context
+ * @param cache the cache, it has to stay open while the context uses it, NULL
+ *for none (the default)
+ **/
+void solver_set_cache(solver_ctx ctx, solve_cache cache);
+
+/**
+ * @brief Makes the next solves of a context keep some pieces in their current
+ *direction
+ * @param ctx the solver context
+ * @param locked whether each piece is locked, indexed by x + y * width, NULL
+ *to lock none (the default). The locks are dropped by solver_set_board
+ * @return false in case of error, the locks are then left as they were, true
+ *otherwise
+ **/
+bool solver_set_locks(solver_ctx ctx, const bool *locked);
+
+/**
+ * @brief Sets every setting of the next solves of a context but the mode and
+ *the time limit
+ * @param ctx the solver context
+ * @param options the settings
+ **/
+void solver_set_options(solver_ctx ctx, const solver_options *options);
+
+/**
+ * @brief Searches the solutions of the board of a context
+ * @param ctx the solver context
+ * @return true if at least one solution was found, false otherwise or in case
+ *of error
+ **/
+bool solver_solve(solver_ctx ctx);
+
+/**
+ * @brief Runs or resumes the solve of a context within a budget
+ * @param ctx the solver context
+ * @param max_nodes the number of search nodes the step may explore, 0 for no
+ *limit
+ * @param max_milliseconds the time the step may take, 0 for no limit
+ * @return SOLVER_DONE if the solve is over, SOLVER_UNFINISHED if a budget ran
+ *out first (the solutions found so far can already be read),
+ *SOLVER_OUT_OF_MEMORY if the memory limit stopped it, SOLVER_ERROR in case of
+ *error
+ **/
+solver_status solver_step(solver_ctx ctx, uint64_t max_nodes,
+                          uint32_t max_milliseconds);
+
+/**
+ * @brief Returns the number of solutions found by solver_solve
+ * @param ctx the solver context
+ * @return the number of solutions (at most 1 in SOLVER_FIND_ONE mode), 0 if
+ *none were found or in case of error
+ **/
+uint32_t solver_nb_solutions(solver_ctx ctx);
+
+/**
+ * @brief Returns the exact number of solutions found by solver_solve
+ * @param ctx the solver context
+ * @return the count, owned by the context and valid until its next solve, NULL
+ *in case of error
+ **/
+const sol_count *solver_get_count(solver_ctx ctx);
+
+/**
+ * @brief Returns the statistics of the last solve of a context
+ * @param ctx the solver context
+ * @return the statistics, owned by the context and valid until its next solve,
+ *NULL in case of error
+ **/
+const solver_stats *solver_get_stats(solver_ctx ctx);
+
+/**
+ * @brief Applies one of the solutions found by solver_solve to a board
+ * @param ctx the solver context
+ * @param index the index of the solution, in [0; solver_nb_solutions(ctx)[,
+ *solutions are only kept in SOLVER_FIND_ALL and SOLVER_FIND_ONE modes, when no
+ *solution callback is set
+ * @param board the game to modify, it must have the size of the solved board
+ * @return true if the solution was applied, false in case of error
+ **/
+bool solver_load_solution(solver_ctx ctx, uint32_t index, game board);
+
+/**
+ * @brief Destroys a solver context and frees all its memory
+ * @param ctx the solver context to destroy
+ **/
+void solver_destroy(solver_ctx ctx);
+
+/**
+ * @brief Sets the default settings: the prop engine on one thread, no limit
+ * @param options the settings to initialize
+ **/
+void solver_options_init(solver_options *options);
+
+/**
+ * @brief Finds a single solution and writes it in a .sol file
+ * @param game_file the file of the game to solve
+ * @param prefix the prefix of the solution file
+ * @param options the settings of the solve and where its report goes
+ * @return false in case of error, true otherwise
+ **/
+bool find_one(char *game_file, char *prefix, const solver_options *options);
+
+/**
+ * @brief Finds how many solutions there are and writes it in a .nbsol file
+ * @param game_file the file of the game to solve
+ * @param prefix the prefix of the solution file
+ * @param options the settings of the solve and where its report goes
+ * @return false in case of error, true otherwise
+ **/
+bool nb_sol(char *game_file, char *prefix, const solver_options *options);
+
+/**
+ * @brief Finds all the solutions and writes them in .solN files, or in a .pack
+ *file with the packed option
+ * @param game_file the file of the game to solve
+ * @param prefix the prefix of the solution files
+ * @param options the settings of the solve and where its report goes
+ * @return false in case of error, true otherwise
+ **/
+bool find_all(char *game_file, char *prefix, const solver_options *options);
+
+/**
+ * @brief Finds one solution of a board in memory
+ * @param board the game to solve, it is not modified
+ * @param solution the game the solution is applied to, it must have the size
+ *of board and is left untouched if there is none
+ * @return true if a solution was applied, false if there is none or in case of
+ *error
+ **/
+bool solve_one(cgame board, game solution);
+
+/**
+ * @brief Counts the solutions of a board in memory
+ * @param board the game to solve, it is not modified
+ * @param big whether the count has arbitrary precision instead of 64 bits
+ * @param count where the count is written, it is initialized by the function
+ *and must be cleared by the caller
+ * @return false in case of error, true otherwise
+ **/
+bool count_solutions(cgame board, bool big, sol_count *count);
+
+/**
+ * @brief Gives every solution of a board to a function as soon as it is found
+ * @param board the game to solve, it is not modified
+ * @param on_solution the function, it stops the enumeration by returning false
+ * @param data a pointer given to on_solution
+ * @return false in case of error, true otherwise
+ **/
+bool enumerate_solutions(cgame board, solver_solution_callback on_solution,
+                         void *data);
+
+/**
+ * @brief Finds one solution and applies it to the given game
+ * @param board the game to solve, left untouched if no solution is found
+ * @return true if a solution was applied, false otherwise
+ **/
+bool find_one_sdl(game board);
+
+/**
+ * @brief Finds a move bringing a board closer to a solution
+ * @param board the game to give a hint for, it is not modified
+ * @param locked whether each piece is locked in its current direction,
+ *indexed by x + y * width, NULL if none is
+ * @param max_milliseconds the time the search may take, 0 for no limit
+ * @param move where the move is written
+ * @return true if a move was found, false if the board is already solved, has
+ *no solution, the budget ran out or in case of error
+ **/
+bool find_hint(cgame board, const bool *locked, uint32_t max_milliseconds,
+               solver_move *move);
+
+/**
+ * @brief Checks whether a board can still be solved without turning the
+ *locked pieces
+ * @param board the game to check, it is not modified
+ * @param locked whether each piece is locked in its current direction,
+ *indexed by x + y * width
+ * @param max_milliseconds the time the check may take, 0 for no limit
+ * @param conflicts where the locked pieces that can't all keep their direction
+ *are marked, indexed by x + y * width, NULL if not needed
+ * @return whether a solution keeps the locked pieces, SOLVER_LOCKS_UNKNOWN if
+ *the budget ran out first
+ **/
+solver_locks check_locks(cgame board, const bool *locked,
+                         uint32_t max_milliseconds, bool *conflicts);
+
+/**
+ * @brief Checks in a single pass over a board conditions every solvable board
+ *meets
+ * @param board the game to check, it is not modified
+ * @return false if the board surely has no solution, true if it may have one
+ *or in case of error other than a NULL board
+ **/
+bool may_have_solution(cgame board);
+
+#endif  // __SOLVER_H__
@@ -0,0 +1,33 @@
+#ifndef __SOLVER_STATS_H__
+#define __SOLVER_STATS_H__
+
+#include <stdint.h>
+
+/**
+ * @file solver_stats.h
+ *
+ * @brief This file provides the statistics kept on the work of a solve.
+ *
+ * Every engine fills the counters that make sense for it and leaves the others
+ *at 0: a node is a findPoss call for the smart engine and a decision for the
+ *prop and cdcl engines, a propagation is a propagate call, a domain narrowed
+ *or a literal propagated, and a backtrack is a possibility deleted, a domain
+ *emptied or a conflict.
+ **/
+
+/**
+ * @brief Structure for the statistics of a solve
+ **/
+typedef struct solver_stats_s {
+  uint64_t nb_nodes;        /**< branching points explored */
+  uint64_t nb_propagations; /**< deductions made */
+  uint64_t nb_backtracks;   /**< dead ends the search went back from */
+  uint64_t nb_fixed_cells;  /**< cells fixed by setUnmovable, smart engine
+                               only */
+  uint64_t peak_tree_bytes; /**< largest memory held by the possibility trees,
+                               smart engine only */
+  uint64_t setup_ms;        /**< time spent preparing the engine */
+  uint64_t search_ms;       /**< time spent searching */
+} solver_stats;
+
+#endif  // __SOLVER_STATS_H__
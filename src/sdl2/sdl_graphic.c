@@ -1,10 +1,16 @@
 #include "sdl_graphic.h"
 
+#include <string.h>
+
 #include "game_io.h"
+#include "solver.h"
 
 /* **************************************************************** */
 
 #define FONTSIZE 42
+#define SOLVE_SLICE 10  // Milliseconds solved between two cancellation checks
+#define HINT_TIME 100   // Milliseconds a hint may search for a solution
+#define LOCK_TIME 20    // Milliseconds a move may spend checking the locks
 
 #ifdef __ANDROID__
 #define FONT "font.ttf"
@@ -55,7 +61,13 @@
 /* **************************************************************** */
 
 void set_game_layout(SDL_Window* win, Env* env);
-bool find_one_sdl(game g);  // Defined in src/solve_smart.c
+void show_hint(Env* env);
+void start_solve(Env* env);
+void run_solve(Env* env, bool hint);
+void cancel_solve(Env* env);
+void update_solve(Env* env);
+void reset_locks(Env* env);
+void update_locks(Env* env);
 game change_game(void);
 bool sound_on;
 
@@ -63,8 +75,26 @@ int minimum(int a, int b) { return a < b ? a : b; }
 
 /* **************************************************************** */
 
+// The solve started by the "Solve" or the "Hint" button, it runs on its own
+// thread against a copy of the board so that the window keeps being rendered
+// meanwhile
+typedef struct Solve_t {
+  SDL_Thread* thread;
+  game board;              // the copy of the board, solved in place
+  bool* locked;            // the copy of the locks it keeps, NULL for none
+  bool hint;               // whether only the move of a hint is played
+  uint32_t nb_moves;       // the moves of the player when it started
+  SDL_atomic_t cancelled;  // set by the window to stop the solve
+  SDL_atomic_t finished;   // set by the solving thread before it returns
+  bool found;  // whether board holds a solution, read once finished
+} Solve;
+
 struct Env_t {
   game game;
+  Solve* solve;  // the solve running, NULL if there is none
+  uint32_t nb_moves;  // pieces the player turned, a solve older is stale
+  bool* locked;  // pieces the player committed to, indexed by x + y * width
+  bool* conflicts;  // locked pieces that no solution keeps all together
   SDL_Texture* pieces[NB_PIECE_TYPE];
   SDL_Texture* background;
   SDL_Texture* button;
@@ -82,6 +112,11 @@ Env* init(SDL_Window* win, SDL_Renderer* ren, game g) {
   Env* env = malloc(sizeof(struct Env_t));
 
   env->game = g;
+  env->solve = NULL;
+  env->nb_moves = 0;
+  env->locked = NULL;
+  env->conflicts = NULL;
+  reset_locks(env);
 
   env->win = false;
 
@@ -104,14 +139,15 @@ Env* init(SDL_Window* win, SDL_Renderer* ren, game g) {
   LOAD_TEXT(font, color, "You win", label_win);
   LOAD_TEXT(font, color, "New game", button_text[0]);
   LOAD_TEXT(font, color, "Shuffle", button_text[1]);
-  LOAD_TEXT(font, color, "Solve", button_text[2]);
+  LOAD_TEXT(font, color, "Hint", button_text[2]);
+  LOAD_TEXT(font, color, "Solve", button_text[3]);
 
 #ifdef __ANDROID__
   LOAD_TEXT(font, color, "Mute",
-            button_text[3]);  // Since saving makes the app crash, we'll make an
+            button_text[4]);  // Since saving makes the app crash, we'll make an
                               // exit button instead
 #else
-  LOAD_TEXT(font, color, "Save", button_text[3]);
+  LOAD_TEXT(font, color, "Save", button_text[4]);
 #endif
 
   TTF_CloseFont(font);
@@ -156,8 +192,15 @@ void render(SDL_Window* win, SDL_Renderer* ren, Env* env) {
       dir = get_current_direction(env->game, (uint16_t)x, (uint16_t)y);
       rect.x = env->pos_x + x * env->piece_size;
       rect.y = env->pos_y + (game_h - (y + 1)) * env->piece_size;
+      // Locked pieces are tinted, in red when they can't all be kept
+      uint32_t cell = (uint32_t)x + (uint32_t)y * (uint32_t)game_w;
+      if (env->conflicts && env->conflicts[cell])
+        SDL_SetTextureColorMod(env->pieces[board_piece], 255, 80, 80);
+      else if (env->locked && env->locked[cell])
+        SDL_SetTextureColorMod(env->pieces[board_piece], 140, 140, 255);
       SDL_RenderCopyEx(ren, env->pieces[board_piece], NULL, &rect,
                        (double)dir * 90, NULL, SDL_FLIP_NONE);
+      SDL_SetTextureColorMod(env->pieces[board_piece], 255, 255, 255);
     }
   }
 
@@ -216,20 +259,29 @@ bool process(SDL_Window* win, Env* env, SDL_Event* e) {
       if (cursor_x < BORDER || cursor_x > env->win_w - BORDER ||
           cursor_y > env->win_h - BORDER)
         return false;
-      if (cursor_x < env->win_w / 4) {
+      // Same layout as in render
+      int button_width = (env->win_w - 2 * BORDER) / NB_BUTTONS;
+      int button = minimum((cursor_x - BORDER) / button_width, NB_BUTTONS - 1);
+      if (button == 0) {
+        cancel_solve(env);
         game new_game = change_game();
         if (new_game != NULL) {
           delete_game(env->game);
           env->game = new_game;
           env->win = false;
+          reset_locks(env);
           set_game_layout(win, env);
         }
-      } else if (cursor_x < env->win_w / 2) {
+      } else if (button == 1) {
+        cancel_solve(env);
         shuffle_direction(env->game);
         env->win = false;
-      } else if (cursor_x < env->win_w - env->win_w / 4)
-        find_one_sdl(env->game);
-      else
+        reset_locks(env);
+      } else if (button == 2) {
+        show_hint(env);
+      } else if (button == 3) {
+        start_solve(env);
+      } else
 #ifdef __ANDROID__
           if (sound_on) {
         Mix_HaltMusic();
@@ -263,6 +315,20 @@ bool process(SDL_Window* win, Env* env, SDL_Event* e) {
         }
       }
 
+      uint32_t cell =
+          found_row ? (uint32_t)piece_x +
+                          (uint32_t)piece_y * (uint32_t)game_width(env->game)
+                    : 0;
+#ifndef __ANDROID__
+      // Ctrl + click locks a piece in its direction, or unlocks it
+      if (found_row && env->locked && (SDL_GetModState() & KMOD_CTRL)) {
+        env->locked[cell] = !env->locked[cell];
+        update_locks(env);
+        found_row = false;
+      }
+#endif
+      if (found_row && env->locked && env->locked[cell]) found_row = false;
+
       if (found_row) {
         int turn;
 #ifdef __ANDROID__
@@ -285,11 +351,13 @@ bool process(SDL_Window* win, Env* env, SDL_Event* e) {
 #endif
         if (sound_on) Mix_PlayChannel(-1, env->turn_sfx[rand() % NB_SFX], 0);
         rotate_piece(env->game, (uint16_t)piece_x, (uint16_t)piece_y, turn);
+        env->nb_moves++;
 
         env->win = false;
         if (is_game_over(env->game)) {
           env->win = true;
         }
+        update_locks(env);
       }
     }
   }
@@ -301,6 +369,7 @@ bool process(SDL_Window* win, Env* env, SDL_Event* e) {
 
 void clean(SDL_Window* win, SDL_Renderer* ren, Env* env) {
   if (!env) return;
+  cancel_solve(env);
   SDL_DestroyWindow(win);
   SDL_DestroyRenderer(ren);
   SDL_DestroyTexture(env->background);
@@ -312,6 +381,8 @@ void clean(SDL_Window* win, SDL_Renderer* ren, Env* env) {
   Mix_FreeMusic(env->music);
   for (int i = 0; i < NB_SFX; i++) Mix_FreeChunk(env->turn_sfx[i]);
 
+  free(env->locked);
+  free(env->conflicts);
   free(env);
 }
 
@@ -333,6 +404,157 @@ void set_game_layout(SDL_Window* win, Env* env) {
   env->pos_y = env->win_h / 2 - offset_y + BORDER;
 }
 
+/* **************************************************************** */
+
+void show_hint(Env* env) {
+  // A running solve is about to turn every piece anyway, a running hint to
+  // turn one
+  if (env->win || env->solve) return;
+  run_solve(env, true);
+}
+
+/* **************************************************************** */
+
+int solve_thread(void* data) {
+  Solve* solve = data;
+  if (solve->hint) {
+    // The locked pieces are never hinted, the hint comes from a solution
+    // keeping them. The search is short enough not to be cancelled
+    solver_move move;
+    solve->found = find_hint(solve->board, solve->locked, HINT_TIME, &move);
+    if (solve->found)
+      set_piece_current_direction(solve->board, move.x, move.y, move.dir);
+    SDL_AtomicSet(&solve->finished, 1);
+    return 0;
+  }
+  solver_ctx ctx = solver_create(solve->board);
+  if (ctx) {
+    solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+    solver_set_mode(ctx, SOLVER_FIND_ONE);
+    solver_set_locks(ctx, solve->locked);
+    solve_cache cache = cache_open_env();
+    solver_set_cache(ctx, cache);
+    // The solve is cut in slices so that a cancellation is seen quickly
+    solver_status status;
+    do {
+      status = solver_step(ctx, 0, SOLVE_SLICE);
+    } while (status == SOLVER_UNFINISHED && !SDL_AtomicGet(&solve->cancelled));
+    solve->found = status == SOLVER_DONE && solver_nb_solutions(ctx) > 0 &&
+                   solver_load_solution(ctx, 0, solve->board);
+    solver_destroy(ctx);
+    if (cache) cache_close(cache);
+  }
+  SDL_AtomicSet(&solve->finished, 1);
+  return 0;
+}
+
+void start_solve(Env* env) {
+  if (env->solve) return;  // The board is already being solved
+  run_solve(env, false);
+}
+
+void run_solve(Env* env, bool hint) {
+  Solve* solve = malloc(sizeof(Solve));
+  if (!solve) return;
+  solve->board = copy_game(env->game);
+  solve->hint = hint;
+  solve->nb_moves = env->nb_moves;
+  size_t nb_cells = (size_t)game_width(env->game) * game_height(env->game);
+  solve->locked = env->locked ? malloc(nb_cells * sizeof(bool)) : NULL;
+  if (solve->locked)
+    memcpy(solve->locked, env->locked, nb_cells * sizeof(bool));
+  solve->found = false;
+  SDL_AtomicSet(&solve->cancelled, 0);
+  SDL_AtomicSet(&solve->finished, 0);
+  bool copied = solve->board && (!env->locked || solve->locked);
+  solve->thread =
+      copied ? SDL_CreateThread(solve_thread, "solver", solve) : NULL;
+  if (!solve->thread) {
+    PRINT("Error: SDL_CreateThread (%s)\n", SDL_GetError());
+    if (solve->board) delete_game(solve->board);
+    free(solve->locked);
+    free(solve);
+    return;
+  }
+  env->solve = solve;
+}
+
+void cancel_solve(Env* env) {
+  if (!env->solve) return;
+  SDL_AtomicSet(&env->solve->cancelled, 1);
+  SDL_WaitThread(env->solve->thread, NULL);
+  delete_game(env->solve->board);
+  free(env->solve->locked);
+  free(env->solve);
+  env->solve = NULL;
+}
+
+void update_solve(Env* env) {
+  if (!env->solve || !SDL_AtomicGet(&env->solve->finished)) return;
+  SDL_WaitThread(env->solve->thread, NULL);
+  // A piece turned or locked while the solve was running may not fit its
+  // solution, which is then dropped
+  bool found = env->solve->found && env->solve->nb_moves == env->nb_moves;
+  uint16_t width = game_width(env->game);
+  for (uint16_t y = 0; found && env->locked && y < game_height(env->game);
+       y++) {
+    for (uint16_t x = 0; found && x < width; x++) {
+      if (!env->locked[x + y * width]) continue;
+      for (direction dir = N; found && dir < NB_DIR; dir++)
+        found = is_edge_coordinates(env->game, x, y, dir) ==
+                is_edge_coordinates(env->solve->board, x, y, dir);
+    }
+  }
+  if (found) {
+    if (env->solve->hint && sound_on)
+      Mix_PlayChannel(-1, env->turn_sfx[rand() % NB_SFX], 0);
+    // The whole solution is applied between two frames
+    for (uint16_t y = 0; y < game_height(env->game); y++) {
+      for (uint16_t x = 0; x < game_width(env->game); x++) {
+        set_piece_current_direction(
+            env->game, x, y, get_current_direction(env->solve->board, x, y));
+      }
+    }
+    env->win = is_game_over(env->game);
+    update_locks(env);
+  }
+  delete_game(env->solve->board);
+  free(env->solve->locked);
+  free(env->solve);
+  env->solve = NULL;
+}
+
+/* **************************************************************** */
+
+void reset_locks(Env* env) {
+  free(env->locked);
+  free(env->conflicts);
+  size_t nb_cells = (size_t)game_width(env->game) * game_height(env->game);
+  env->locked = calloc(nb_cells, sizeof(bool));
+  env->conflicts = calloc(nb_cells, sizeof(bool));
+  if (!env->locked || !env->conflicts) {
+    // Locking is only disabled, the game goes on without it
+    free(env->locked);
+    free(env->conflicts);
+    env->locked = NULL;
+    env->conflicts = NULL;
+  }
+}
+
+void update_locks(Env* env) {
+  if (!env->locked) return;
+  size_t nb_cells = (size_t)game_width(env->game) * game_height(env->game);
+  bool any_locked = false;
+  for (size_t cell = 0; cell < nb_cells && !any_locked; cell++)
+    any_locked = env->locked[cell];
+  // Checked after every move, the budget keeps the window responsive and an
+  // unknown answer marks nothing
+  if (!any_locked ||
+      check_locks(env->game, env->locked, LOCK_TIME, env->conflicts) !=
+          SOLVER_LOCKS_CONFLICT)
+    memset(env->conflicts, 0, nb_cells * sizeof(bool));
+}
+
 int open_graphic(game g) {
   /* initialize SDL2 and some extensions */
   if (SDL_Init(SDL_INIT_VIDEO) != 0)
@@ -371,6 +593,9 @@ int open_graphic(game g) {
       if (quit) break;
     }
 
+    /* apply the solution once the solving thread is done */
+    update_solve(env);
+
     /* background in gray */
     SDL_SetRenderDrawColor(ren, 0xA0, 0xA0, 0xA0, 0xFF);
     SDL_RenderClear(ren);
@@ -1,36 +1,7 @@
 #include "game.h"
 #include "game_io.h"
-
-//--------------------------------------------------------------------------------------
-//                                Structures
-typedef struct possibility_s *possibility;
-
-// this structure is used as a chained list to save different dispositions of
-// pieces.
-struct possibility_s {
-  uint32_t x;     // the coordinates of the corresponding cell in the game
-  uint32_t y;     //
-  direction dir;  // the direction to put this piece in in order to set the game
-                  // with the saved possibility
-  bool isLeaf;    // a boolean to indicate if this possibility is a leaf or not
-  uint32_t nbNextPos;  // the number of deriving possibilities from this cell (0
-                       // if it is a leaf)
-  uint32_t
-      *nbNextDerivPos;  // an array of the number of leaves we can access from
-                        // the deriving possibilities of this possibility
-  uint32_t totalNextDerivPos;  // the number of leaves we can access from this
-                               // possibility
-  possibility
-      *nextPos;  // an array of the deriving possibilities from this cell
-};
-
-//--------------------------------------------------------------------------------------
-//                                Game solving functions
-//                         These functions are solving the game accordingly to
-//                         the first argument given (FIND_ONE/NB_SOL/FIND_ALL)
-bool find_one(char *argv[]);
-bool nb_sol(char *argv[]);
-bool find_all(char *argv[]);
+#include "solve_batch.h"
+#include "solver.h"
 
 //--------------------------------------------------------------------------------------
 //                                Error handler functions
@@ -39,25 +10,70 @@ bool find_all(char *argv[]);
 //                         tests if the arguments are valid, as well as to show
 //                         how to use the solver
 static void usage(char *argv[]);
-static bool checkArgs(int argc, char *argv[]);
+static bool checkArgs(int argc, char *argv[], solver_mode *mode);
+static bool parseEngine(const char *name, solver_engine *engine);
+static bool parseThreads(const char *value, uint16_t *nb_threads);
+static bool parseLimit(const char *value, uint32_t *max_solutions);
+static bool parseTimeLimit(const char *value, uint32_t *time_limit);
+static bool parseMemory(const char *value, uint64_t *max_memory);
+static bool parseReport(const char *name, solver_report *report);
 
 //--------------------------------------------------------------------------------------
 //                                Main function
 
 int main(int argc, char *argv[]) {
-  if (!checkArgs(argc, argv)) usage(argv);
+  solver_options options;
+  solver_options_init(&options);
+  char **args = argv;  // args[1] is the mode, whatever options are given
+  bool batch = false;
+  while (argc > 2 && args[1][0] == '-') {
+    int nb_used = 2;  // Number of arguments used by the option
+    if (strcmp(args[1], "-e") == 0) {
+      if (!parseEngine(args[2], &options.engine)) usage(argv);
+    } else if (strcmp(args[1], "-t") == 0) {
+      if (!parseThreads(args[2], &options.nb_threads)) usage(argv);
+    } else if (strcmp(args[1], "-n") == 0) {
+      if (!parseLimit(args[2], &options.max_solutions)) usage(argv);
+    } else if (strcmp(args[1], "-d") == 0) {
+      if (!parseTimeLimit(args[2], &options.time_limit)) usage(argv);
+    } else if (strcmp(args[1], "-m") == 0) {
+      if (!parseMemory(args[2], &options.max_memory)) usage(argv);
+    } else if (strcmp(args[1], "-r") == 0) {
+      if (!parseReport(args[2], &options.report)) usage(argv);
+    } else if (strcmp(args[1], "-c") == 0) {
+      options.cache_dir = args[2];
+    } else if (strcmp(args[1], "-B") == 0) {
+      batch = true;
+      nb_used = 1;
+    } else if (strcmp(args[1], "-b") == 0) {
+      options.big_count = true;
+      nb_used = 1;
+    } else if (strcmp(args[1], "-p") == 0) {
+      options.packed = true;
+      nb_used = 1;
+    } else {
+      usage(argv);
+    }
+    args += nb_used;
+    argc -= nb_used;
+  }
+  solver_mode mode;
+  if (!checkArgs(argc, args, &mode)) usage(argv);
 
   bool status = true;
 
-  if (strcmp(argv[1], "FIND_ONE") == 0) status = find_one(argv);
-
-  if (strcmp(argv[1], "NB_SOL") == 0) status = nb_sol(argv);
-
-  if (strcmp(argv[1], "FIND_ALL") == 0) status = find_all(argv);
+  if (batch)
+    status = batch_solve(args[2], args[3], mode, &options);
+  else if (mode == SOLVER_FIND_ONE)
+    status = find_one(args[2], args[3], &options);
+  else if (mode == SOLVER_NB_SOL)
+    status = nb_sol(args[2], args[3], &options);
+  else
+    status = find_all(args[2], args[3], &options);
 
   if (!status) {  // This tests whether the called function worked properly or
                   // not
-    FPRINTF(stderr, "Error in %s!\n", argv[1]);
+    FPRINTF(stderr, "Error in %s!\n", args[1]);
     return EXIT_FAILURE;
   }
 
@@ -73,49 +89,171 @@ int main(int argc, char *argv[]) {
  **/
 static void usage(char *argv[]) {
   FPRINTF(stderr,
-          "%s FIND_ONE|NB_SOL|FIND_ALL <nom_fichier_pb> <prefix_fichier_sol>\n",
+          "%s [-e smart|prop|cdcl|transfer] [-t <nb_threads>] [-b] [-n "
+          "<max_solutions>] [-d <milliseconds>] [-m <megabytes>] [-r "
+          "file|stderr] [-c <cache_dir>] [-p] [-B] FIND_ONE|NB_SOL|FIND_ALL "
+          "<nom_fichier_pb> <prefix_fichier_sol>\n"
+          "The prop engine is used by default, so FIND_ALL numbers its "
+          "solutions in the order of prop, -e smart gives the order of the "
+          "former solver, cdcl learns from its conflicts on hard boards, "
+          "transfer counts NB_SOL row by row and is picked for "
+          "the boards that don't wrap and are at most 12 cells wide. -t 0 uses "
+          "one thread per processor, -b counts with arbitrary precision "
+          "instead of 64 bits, -n stops FIND_ALL after a number of solutions, "
+          "-d gives up after a time, -m caps the memory kept for the "
+          "solutions, the smart engine handing over to prop beyond it, -r "
+          "writes a JSON report of the solve in <prefix_fichier_sol>.json or "
+          "on stderr, -c reuses and adds to the results kept in a cache "
+          "directory, -p writes the solutions of FIND_ALL in the single file "
+          "<prefix_fichier_sol>.pack\n"
+          "With -B, <nom_fichier_pb> is a directory or a file listing one "
+          "puzzle per line, they are all solved on -t threads and their "
+          "results written in the file <prefix_fichier_sol>\n",
           argv[0]);
   exit(EXIT_FAILURE);
 }
 
 /**
- * @brief Checks how many arguments and their validity
+ * @brief Checks how many arguments there are and reads the mode, the files are
+ *only opened by the solve itself, which reports its errors
  *
  * @param argc, the number of argument
  * @param argv, an array of the arguments
- * @return true if there are the right number of arguments and if they are all
+ * @param mode, where the mode is stored
+ * @return true if there are the right number of arguments and if the mode is
  *valid
  **/
-static bool checkArgs(int argc, char *argv[]) {
+static bool checkArgs(int argc, char *argv[], solver_mode *mode) {
   if (argc != 4) return false;
 
-  bool arg1 = false, arg2 = true, arg3 = true;
+  // strcmp returns 0 if the two strings are the same
+  if (strcmp(argv[1], "FIND_ONE") == 0)
+    *mode = SOLVER_FIND_ONE;
+  else if (strcmp(argv[1], "NB_SOL") == 0)
+    *mode = SOLVER_NB_SOL;
+  else if (strcmp(argv[1], "FIND_ALL") == 0)
+    *mode = SOLVER_FIND_ALL;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * @brief Reads the name of a solving engine
+ *
+ * @param name, the name given after -e
+ * @param engine, where the engine is stored
+ * @return true if the name is a known engine
+ **/
+static bool parseEngine(const char *name, solver_engine *engine) {
+  if (strcmp(name, "smart") == 0) {
+    *engine = SOLVER_ENGINE_SMART;
+    return true;
+  }
+  if (strcmp(name, "prop") == 0) {
+    *engine = SOLVER_ENGINE_PROP;
+    return true;
+  }
+  if (strcmp(name, "cdcl") == 0) {
+    *engine = SOLVER_ENGINE_CDCL;
+    return true;
+  }
+  if (strcmp(name, "transfer") == 0) {
+    *engine = SOLVER_ENGINE_TRANSFER;
+    return true;
+  }
+  FPRINTF(stderr, "Unknown engine %s!\n", name);
+  return false;
+}
+
+/**
+ * @brief Reads the number of solutions after which FIND_ALL stops
+ *
+ * @param value, the number given after -n
+ * @param max_solutions, where the number is stored
+ * @return true if the value is a valid number of solutions
+ **/
+static bool parseLimit(const char *value, uint32_t *max_solutions) {
+  char *end;
+  unsigned long number = strtoul(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || number > UINT32_MAX) {
+    FPRINTF(stderr, "Invalid number of solutions %s!\n", value);
+    return false;
+  }
+  *max_solutions = (uint32_t)number;
+  return true;
+}
+
+/**
+ * @brief Reads the time after which the solver gives up
+ *
+ * @param value, the number of milliseconds given after -d
+ * @param time_limit, where the time is stored
+ * @return true if the value is a valid time
+ **/
+static bool parseTimeLimit(const char *value, uint32_t *time_limit) {
+  char *end;
+  unsigned long number = strtoul(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || number > UINT32_MAX) {
+    FPRINTF(stderr, "Invalid time limit %s!\n", value);
+    return false;
+  }
+  *time_limit = (uint32_t)number;
+  return true;
+}
 
-  if (strcmp(argv[1], "FIND_ONE") == 0 || strcmp(argv[1], "NB_SOL") == 0 ||
-      strcmp(argv[1], "FIND_ALL") ==
-          0) {  // strcmp returns 0 if the two strings are the same
-    arg1 = true;
+/**
+ * @brief Reads the memory the solve may use
+ *
+ * @param value, the number of megabytes given after -m
+ * @param max_memory, where the number of bytes is stored
+ * @return true if the value is a valid size
+ **/
+static bool parseMemory(const char *value, uint64_t *max_memory) {
+  char *end;
+  unsigned long long number = strtoull(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || number > UINT64_MAX >> 20) {
+    FPRINTF(stderr, "Invalid memory limit %s!\n", value);
+    return false;
   }
+  *max_memory = (uint64_t)number << 20;
+  return true;
+}
 
-  FILE *input_stream;
-  FOPEN(input_stream, argv[2],
-        "r");  // tests whether or not the file to solve is accessible
-  if (!input_stream) {
-    FPRINTF(stderr, "Couldn't open the requested file!\n");
-    arg2 = false;
-  } else
-    FCLOSE(input_stream);
-
-  FILE *output_stream;
-  FOPEN(output_stream, argv[3],
-        "w");  // tests if the name of the output file is valid
-  if (!output_stream) {
-    FPRINTF(stderr, "Couldn't create the new file!\n");
-    arg3 = false;
-  } else {
-    FCLOSE(output_stream);
-    remove(argv[3]);
+/**
+ * @brief Reads where the report of the solve is written
+ *
+ * @param name, the destination given after -r
+ * @param report, where the destination is stored
+ * @return true if the name is a known destination
+ **/
+static bool parseReport(const char *name, solver_report *report) {
+  if (strcmp(name, "file") == 0) {
+    *report = SOLVER_REPORT_FILE;
+    return true;
+  }
+  if (strcmp(name, "stderr") == 0) {
+    *report = SOLVER_REPORT_STDERR;
+    return true;
   }
+  FPRINTF(stderr, "Unknown report destination %s!\n", name);
+  return false;
+}
 
-  return arg1 && arg2 && arg3;
+/**
+ * @brief Reads the number of threads of the solver
+ *
+ * @param value, the number given after -t
+ * @param nb_threads, where the number of threads is stored
+ * @return true if the value is a valid number of threads
+ **/
+static bool parseThreads(const char *value, uint16_t *nb_threads) {
+  char *end;
+  unsigned long number = strtoul(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || number > UINT16_MAX) {
+    FPRINTF(stderr, "Invalid number of threads %s!\n", value);
+    return false;
+  }
+  *nb_threads = (uint16_t)number;
+  return true;
 }
@@ -0,0 +1,218 @@
+#include "sol_count.h"
+
+#include <stdlib.h>
+
+#include "cross_io.h"
+
+#define LIMB_BITS 32
+#define DECIMAL_CHUNK 1000000000U  // Largest power of 10 that fits in a limb
+#define DECIMAL_CHUNK_DIGITS 9
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static bool reserve_limbs(sol_count *count, uint32_t nb_limbs);
+static bool add_limbs(sol_count *count, const uint32_t *limbs,
+                      uint32_t nb_limbs);
+
+//--------------------------------------------------------------------------------------
+//                                Counter functions bodies
+
+void sol_count_init(sol_count *count, bool big) {
+  count->value = 0;
+  count->overflow = false;
+  count->big = big;
+  count->limbs = NULL;
+  count->nb_limbs = 0;
+}
+
+void sol_count_clear(sol_count *count) {
+  free(count->limbs);
+  sol_count_init(count, count->big);
+}
+
+void sol_count_reset(sol_count *count) {
+  count->value = 0;
+  count->overflow = false;
+  if (count->nb_limbs)
+    memset(count->limbs, 0, count->nb_limbs * sizeof(uint32_t));
+}
+
+bool sol_count_add_uint(sol_count *count, uint64_t term) {
+  if (!count->big) {
+    if (count->value > UINT64_MAX - term) count->overflow = true;
+    count->value += term;
+    return true;
+  }
+  uint32_t limbs[2] = {(uint32_t)term, (uint32_t)(term >> LIMB_BITS)};
+  return add_limbs(count, limbs, limbs[1] ? 2 : 1);
+}
+
+bool sol_count_add(sol_count *count, const sol_count *term) {
+  if (count->big != term->big) {
+    FPRINTF(stderr, "Error: sol_count_add, counters of different kinds.\n");
+    return false;
+  }
+  if (!count->big) {
+    count->overflow = count->overflow || term->overflow;
+    return sol_count_add_uint(count, term->value);
+  }
+  return add_limbs(count, term->limbs, term->nb_limbs);
+}
+
+bool sol_count_mul_uint(sol_count *count, uint32_t factor) {
+  if (!count->big) {
+    if (factor && count->value > UINT64_MAX / factor) count->overflow = true;
+    count->value *= factor;
+    return true;
+  }
+  uint64_t carry = 0;
+  for (uint32_t i = 0; i < count->nb_limbs; i++) {
+    uint64_t product = (uint64_t)count->limbs[i] * factor + carry;
+    count->limbs[i] = (uint32_t)product;
+    carry = product >> LIMB_BITS;
+  }
+  if (carry) {
+    if (!reserve_limbs(count, count->nb_limbs + 1)) return false;
+    count->limbs[count->nb_limbs - 1] = (uint32_t)carry;
+  }
+  return true;
+}
+
+bool sol_count_copy(sol_count *dest, const sol_count *source) {
+  if (dest->big != source->big) {
+    FPRINTF(stderr, "Error: sol_count_copy, counters of different kinds.\n");
+    return false;
+  }
+  dest->value = source->value;
+  dest->overflow = source->overflow;
+  if (!source->big) return true;
+  if (!reserve_limbs(dest, source->nb_limbs)) return false;
+  if (source->nb_limbs)
+    memcpy(dest->limbs, source->limbs, source->nb_limbs * sizeof(uint32_t));
+  dest->nb_limbs = source->nb_limbs;
+  return true;
+}
+
+uint32_t sol_count_to_uint32(const sol_count *count) {
+  if (!count->big) {
+    if (count->overflow || count->value > UINT32_MAX) return UINT32_MAX;
+    return (uint32_t)count->value;
+  }
+  for (uint32_t i = 1; i < count->nb_limbs; i++) {
+    if (count->limbs[i]) return UINT32_MAX;
+  }
+  return count->nb_limbs ? count->limbs[0] : 0;
+}
+
+bool sol_count_to_uint64(const sol_count *count, uint64_t *value) {
+  if (!count->big) {
+    *value = count->value;
+    return !count->overflow;
+  }
+  for (uint32_t i = 2; i < count->nb_limbs; i++) {
+    if (count->limbs[i]) return false;
+  }
+  *value = 0;
+  if (count->nb_limbs > 1) *value = (uint64_t)count->limbs[1] << LIMB_BITS;
+  if (count->nb_limbs > 0) *value |= count->limbs[0];
+  return true;
+}
+
+bool sol_count_fprint(FILE *stream, const sol_count *count) {
+  if (!count->big) {
+    if (count->overflow) {
+      FPRINTF(stderr, "Error: sol_count_fprint, the count overflowed.\n");
+      return false;
+    }
+    FPRINTF(stream, "%llu", (unsigned long long)count->value);
+    return true;
+  }
+  if (count->nb_limbs == 0) {
+    FPRINTF(stream, "0");
+    return true;
+  }
+
+  // The value is cut in chunks of 9 decimal digits, least significant first
+  uint32_t *quotient = (uint32_t *)malloc(count->nb_limbs * sizeof(uint32_t));
+  uint32_t *chunks =
+      (uint32_t *)malloc((count->nb_limbs * 2 + 1) * sizeof(uint32_t));
+  if (!quotient || !chunks) {
+    FPRINTF(stderr, "Error: sol_count_fprint, can't allocate the digits.\n");
+    free(quotient);
+    free(chunks);
+    return false;
+  }
+  memcpy(quotient, count->limbs, count->nb_limbs * sizeof(uint32_t));
+  uint32_t nb_limbs = count->nb_limbs;
+  uint32_t nb_chunks = 0;
+  while (nb_limbs > 0) {
+    uint64_t remainder = 0;
+    for (uint32_t i = nb_limbs; i > 0; i--) {
+      uint64_t current = (remainder << LIMB_BITS) | quotient[i - 1];
+      quotient[i - 1] = (uint32_t)(current / DECIMAL_CHUNK);
+      remainder = current % DECIMAL_CHUNK;
+    }
+    chunks[nb_chunks++] = (uint32_t)remainder;
+    while (nb_limbs > 0 && quotient[nb_limbs - 1] == 0) nb_limbs--;
+  }
+  FPRINTF(stream, "%u", chunks[nb_chunks - 1]);
+  for (uint32_t i = nb_chunks - 1; i > 0; i--)
+    FPRINTF(stream, "%0*u", DECIMAL_CHUNK_DIGITS, chunks[i - 1]);
+  free(quotient);
+  free(chunks);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Makes an arbitrary-precision counter hold at least a number of digits,
+ * the new digits are 0
+ *
+ * @param count, the counter
+ * @param nb_limbs, the number of digits
+ * @return false if the counter couldn't grow, true otherwise
+ */
+static bool reserve_limbs(sol_count *count, uint32_t nb_limbs) {
+  if (nb_limbs <= count->nb_limbs) return true;
+  uint32_t *limbs =
+      (uint32_t *)realloc(count->limbs, nb_limbs * sizeof(uint32_t));
+  if (!limbs) {
+    FPRINTF(stderr, "Error: reserve_limbs, can't grow the counter.\n");
+    return false;
+  }
+  memset(limbs + count->nb_limbs, 0,
+         (nb_limbs - count->nb_limbs) * sizeof(uint32_t));
+  count->limbs = limbs;
+  count->nb_limbs = nb_limbs;
+  return true;
+}
+
+/**
+ * @brief Adds digits to an arbitrary-precision counter
+ *
+ * @param count, the counter
+ * @param limbs, the digits to add, least significant first
+ * @param nb_limbs, the number of digits to add
+ * @return false if the counter couldn't grow, true otherwise
+ */
+static bool add_limbs(sol_count *count, const uint32_t *limbs,
+                      uint32_t nb_limbs) {
+  while (nb_limbs > 0 && limbs[nb_limbs - 1] == 0) nb_limbs--;
+  if (!reserve_limbs(count, nb_limbs)) return false;
+  uint64_t carry = 0;
+  uint32_t i = 0;
+  for (; i < nb_limbs || (carry && i < count->nb_limbs); i++) {
+    uint64_t sum = (uint64_t)count->limbs[i] + (i < nb_limbs ? limbs[i] : 0) +
+                   carry;
+    count->limbs[i] = (uint32_t)sum;
+    carry = sum >> LIMB_BITS;
+  }
+  if (carry) {
+    if (!reserve_limbs(count, count->nb_limbs + 1)) return false;
+    count->limbs[count->nb_limbs - 1] = (uint32_t)carry;
+  }
+  return true;
+}
@@ -0,0 +1,459 @@
+#include "solve_batch.h"
+
+#include "cross_thread.h"
+#include "cross_time.h"
+#include "game_io.h"
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Longest line read from a manifest, the file names included
+#define MANIFEST_LINE_SIZE 4096
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+typedef struct batch_s *batch;
+
+/**
+ * @brief Structure for a worker thread of the batch
+ */
+typedef struct batch_worker_s {
+  batch owner;    /**< the batch the worker belongs to */
+  THREAD thread;  /**< the thread running the worker */
+  solver_ctx ctx; /**< context reused for every puzzle, NULL before the first
+                     one */
+} batch_worker;
+
+/**
+ * @brief Structure for the shared state of the workers
+ */
+struct batch_s {
+  char **files;                  /**< the puzzles to solve */
+  uint32_t nb_files;             /**< number of puzzles */
+  ATOMIC_LONG next_file;         /**< index of the next puzzle to take */
+  ATOMIC_LONG nb_failed;         /**< number of puzzles left unsolved */
+  solver_mode mode;              /**< what has to be found */
+  const solver_options *options; /**< the settings of the solves */
+  solve_cache cache;             /**< cache shared by the workers, NULL for
+                                    none */
+  MUTEX lock;                    /**< protects the results file */
+  FILE *results;                 /**< the results file */
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static bool is_directory(const char *path);
+static bool add_file(char ***files, uint32_t *nb_files, uint32_t *capacity,
+                     const char *directory, const char *name);
+static bool list_directory(const char *path, char ***files,
+                           uint32_t *nb_files);
+static bool read_manifest(const char *path, char ***files, uint32_t *nb_files);
+static void free_files(char **files, uint32_t nb_files);
+static int compare_files(const void *file, const void *other_file);
+static THREAD_FUNCTION(run_batch_worker, arg);
+static bool solve_puzzle(batch_worker *self, char *file);
+static char *get_directions(solver_ctx ctx, game board);
+static void write_result(batch shared, const char *file, solver_status status,
+                         solver_ctx ctx, const char *directions,
+                         uint64_t load_ms);
+static void fprint_json_string(FILE *stream, const char *string);
+
+//--------------------------------------------------------------------------------------
+//                                Batch function body
+
+bool batch_solve(const char *input, const char *results_file, solver_mode mode,
+                 const solver_options *options) {
+  if (!input || !results_file || !options) {
+    FPRINTF(stderr,
+            "Error: batch_solve, input, results file or options pointer is "
+            "NULL.\n");
+    return false;
+  }
+
+  struct batch_s shared;
+  shared.files = NULL;
+  shared.nb_files = 0;
+  bool listed = is_directory(input)
+                    ? list_directory(input, &shared.files, &shared.nb_files)
+                    : read_manifest(input, &shared.files, &shared.nb_files);
+  if (!listed) return false;
+
+  FOPEN(shared.results, results_file, "w");
+  if (!shared.results) {
+    FPRINTF(stderr, "Error: batch_solve, couldn't create the results file.\n");
+    free_files(shared.files, shared.nb_files);
+    return false;
+  }
+  shared.next_file = 0;
+  shared.nb_failed = 0;
+  shared.mode = mode;
+  shared.options = options;
+  shared.cache = NULL;
+  if (options->cache_dir) {
+    shared.cache = cache_open(options->cache_dir);
+    if (!shared.cache)
+      FPRINTF(stderr, "Error: the cache can't be used, solving without it.\n");
+  }
+  MUTEX_INIT(shared.lock);
+
+  uint32_t nb_workers = options->nb_threads ? options->nb_threads
+                                            : get_nb_cpus();
+  if (nb_workers > shared.nb_files) nb_workers = shared.nb_files;
+  batch_worker *workers =
+      (batch_worker *)calloc(nb_workers ? nb_workers : 1, sizeof(batch_worker));
+  bool status = workers != NULL;
+  if (!status) FPRINTF(stderr, "Error: batch_solve, can't allocate workers.\n");
+
+  uint32_t nb_started = 0;
+  for (; status && nb_started < nb_workers; nb_started++) {
+    workers[nb_started].owner = &shared;
+    if (!THREAD_CREATE(workers[nb_started].thread, run_batch_worker,
+                       &workers[nb_started])) {
+      // The started workers take the puzzles left
+      FPRINTF(stderr, "Error: batch_solve, can't start a thread.\n");
+      status = nb_started > 0;
+      break;
+    }
+  }
+  for (uint32_t i = 0; i < nb_started; i++) {
+    THREAD_JOIN(workers[i].thread);
+    if (workers[i].ctx) solver_destroy(workers[i].ctx);
+  }
+
+  free(workers);
+  if (shared.cache) cache_close(shared.cache);
+  MUTEX_DESTROY(shared.lock);
+  status = FCLOSE(shared.results) == 0 && status;
+  free_files(shared.files, shared.nb_files);
+  return status && ATOMIC_LOAD(&shared.nb_failed) == 0;
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Tells whether a path is a directory
+ *
+ * @param path, the path
+ * @return true if the path exists and is a directory
+ */
+static bool is_directory(const char *path) {
+#if defined(_WIN32)
+  DWORD attributes = GetFileAttributesA(path);
+  return attributes != INVALID_FILE_ATTRIBUTES &&
+         (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat info;
+  return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+/**
+ * @brief Adds a file to a growing list of puzzles
+ *
+ * @param files, the list, reallocated when it is full
+ * @param nb_files, the number of files in the list
+ * @param capacity, the number of files the list can hold
+ * @param directory, the directory of the file, NULL if name is a whole path
+ * @param name, the name of the file
+ * @return false in case of error, true otherwise
+ */
+static bool add_file(char ***files, uint32_t *nb_files, uint32_t *capacity,
+                     const char *directory, const char *name) {
+  if (*nb_files == *capacity) {
+    uint32_t new_capacity = *capacity ? 2 * *capacity : 64;
+    char **new_files =
+        (char **)realloc(*files, new_capacity * sizeof(char *));
+    if (!new_files) {
+      FPRINTF(stderr, "Error: add_file, can't list more puzzles.\n");
+      return false;
+    }
+    *files = new_files;
+    *capacity = new_capacity;
+  }
+  size_t directory_length = directory ? strlen(directory) + 1 : 0;
+  size_t name_length = strlen(name);
+  char *file = (char *)malloc(directory_length + name_length + 1);
+  if (!file) {
+    FPRINTF(stderr, "Error: add_file, can't allocate a file name.\n");
+    return false;
+  }
+  if (directory) {
+    memcpy(file, directory, directory_length - 1);
+    file[directory_length - 1] = '/';
+  }
+  memcpy(file + directory_length, name, name_length + 1);
+  (*files)[(*nb_files)++] = file;
+  return true;
+}
+
+/**
+ * @brief Lists the files of a directory, hidden files and subdirectories left
+ * out, sorted by name
+ *
+ * @param path, the directory
+ * @param files, where the allocated list is written
+ * @param nb_files, where the number of files is written
+ * @return false in case of error, true otherwise
+ */
+static bool list_directory(const char *path, char ***files,
+                           uint32_t *nb_files) {
+  uint32_t capacity = 0;
+  bool status = true;
+#if defined(_WIN32)
+  char pattern[MANIFEST_LINE_SIZE];
+  SPRINTF(pattern, MANIFEST_LINE_SIZE, "%s/*", path);
+  WIN32_FIND_DATAA entry;
+  HANDLE directory = FindFirstFileA(pattern, &entry);
+  if (directory == INVALID_HANDLE_VALUE) {
+    FPRINTF(stderr, "Error: list_directory, couldn't open %s.\n", path);
+    return false;
+  }
+  do {
+    if (entry.cFileName[0] != '.' &&
+        !(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+      status = add_file(files, nb_files, &capacity, path, entry.cFileName);
+  } while (status && FindNextFileA(directory, &entry));
+  FindClose(directory);
+#else
+  DIR *directory = opendir(path);
+  if (!directory) {
+    FPRINTF(stderr, "Error: list_directory, couldn't open %s.\n", path);
+    return false;
+  }
+  struct dirent *entry;
+  while (status && (entry = readdir(directory)) != NULL) {
+    if (entry->d_name[0] == '.') continue;
+    status = add_file(files, nb_files, &capacity, path, entry->d_name);
+    if (status && is_directory((*files)[*nb_files - 1]))
+      free((*files)[--*nb_files]);
+  }
+  closedir(directory);
+#endif
+  if (!status) {
+    free_files(*files, *nb_files);
+    return false;
+  }
+  if (*nb_files > 1) qsort(*files, *nb_files, sizeof(char *), compare_files);
+  return true;
+}
+
+/**
+ * @brief Lists the files named by a manifest, one per line
+ *
+ * @param path, the manifest
+ * @param files, where the allocated list is written
+ * @param nb_files, where the number of files is written
+ * @return false in case of error, true otherwise
+ */
+static bool read_manifest(const char *path, char ***files, uint32_t *nb_files) {
+  FILE *manifest;
+  FOPEN(manifest, path, "r");
+  if (!manifest) {
+    FPRINTF(stderr, "Error: read_manifest, couldn't open %s.\n", path);
+    return false;
+  }
+  uint32_t capacity = 0;
+  bool status = true;
+  char line[MANIFEST_LINE_SIZE];
+  while (status && fgets(line, MANIFEST_LINE_SIZE, manifest)) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' ||
+                          line[length - 1] == '\r' || line[length - 1] == ' '))
+      line[--length] = '\0';
+    if (length == 0 || line[0] == '#') continue;
+    status = add_file(files, nb_files, &capacity, NULL, line);
+  }
+  FCLOSE(manifest);
+  if (!status) free_files(*files, *nb_files);
+  return status;
+}
+
+/**
+ * @brief Frees a list of puzzles
+ *
+ * @param files, the list
+ * @param nb_files, the number of files in the list
+ */
+static void free_files(char **files, uint32_t nb_files) {
+  for (uint32_t i = 0; i < nb_files; i++) free(files[i]);
+  free(files);
+}
+
+/**
+ * @brief Compares two file names for qsort
+ *
+ * @param file, pointer to the first name
+ * @param other_file, pointer to the second name
+ * @return the order of the names
+ */
+static int compare_files(const void *file, const void *other_file) {
+  return strcmp(*(char *const *)file, *(char *const *)other_file);
+}
+
+/**
+ * @brief Main function of a worker, solves puzzles until there are none left
+ *
+ * @param arg, the worker
+ */
+static THREAD_FUNCTION(run_batch_worker, arg) {
+  batch_worker *self = (batch_worker *)arg;
+  batch shared = self->owner;
+  long index;
+  while ((index = ATOMIC_ADD(&shared->next_file, 1)) <
+         (long)shared->nb_files) {
+    if (!solve_puzzle(self, shared->files[index]))
+      ATOMIC_ADD(&shared->nb_failed, 1);
+  }
+  THREAD_RETURN;
+}
+
+/**
+ * @brief Solves a puzzle with the context of a worker and writes its result
+ *
+ * @param self, the worker
+ * @param file, the file of the puzzle
+ * @return true if the puzzle was solved, false otherwise
+ */
+static bool solve_puzzle(batch_worker *self, char *file) {
+  batch shared = self->owner;
+  uint64_t start = get_milliseconds();
+  game board = load_game(file);
+  uint64_t load_ms = get_milliseconds() - start;
+  bool ready = board != NULL;
+  if (ready && self->ctx) {
+    ready = solver_set_board(self->ctx, board);
+  } else if (ready) {
+    self->ctx = solver_create(board);
+    ready = self->ctx != NULL;
+    if (ready) {
+      // The workers already use every thread requested
+      solver_set_options(self->ctx, shared->options);
+      solver_set_threads(self->ctx, 1);
+      solver_set_mode(self->ctx, shared->mode);
+      solver_set_cache(self->ctx, shared->cache);
+    }
+  }
+  if (!ready) {
+    write_result(shared, file, SOLVER_ERROR, NULL, NULL, load_ms);
+    if (board) delete_game(board);
+    return false;
+  }
+
+  solver_status status =
+      solver_step(self->ctx, 0, shared->options->time_limit);
+  char *directions = NULL;
+  if (status == SOLVER_DONE && shared->mode != SOLVER_NB_SOL &&
+      solver_nb_solutions(self->ctx) > 0) {
+    directions = get_directions(self->ctx, board);
+    if (!directions) status = SOLVER_ERROR;
+  }
+  write_result(shared, file, status, self->ctx, directions, load_ms);
+  free(directions);
+  delete_game(board);
+  return status == SOLVER_DONE;
+}
+
+/**
+ * @brief Gives the first solution of a solve as a string of directions
+ *
+ * @param ctx, the solver context, after the solve
+ * @param board, a board of the size of the solved one, the solution is applied
+ * to it
+ * @return the allocated string, NULL in case of error
+ */
+static char *get_directions(solver_ctx ctx, game board) {
+  uint16_t width = game_width(board);
+  uint16_t height = game_height(board);
+  size_t nb_cells = (size_t)width * height;
+  char *directions = (char *)malloc(nb_cells + 1);
+  direction *cells = (direction *)malloc((nb_cells + 1) * sizeof(direction));
+  if (!directions || !cells) {
+    FPRINTF(stderr, "Error: get_directions, can't allocate the solution.\n");
+    free(directions);
+    free(cells);
+    return NULL;
+  }
+  if (!solver_load_solution(ctx, 0, board)) {
+    free(directions);
+    free(cells);
+    return NULL;
+  }
+  get_cells(board, NULL, cells);
+  for (size_t i = 0; i < nb_cells; i++) directions[i] = (char)('0' + cells[i]);
+  directions[nb_cells] = '\0';
+  free(cells);
+  return directions;
+}
+
+/**
+ * @brief Writes the result of a puzzle as a line of the results file
+ *
+ * @param shared, the batch
+ * @param file, the file of the puzzle
+ * @param status, how the solve ended
+ * @param ctx, the solver context, NULL if the puzzle couldn't be loaded
+ * @param directions, the solution found, NULL if there is none
+ * @param load_ms, the time spent loading the puzzle
+ */
+static void write_result(batch shared, const char *file, solver_status status,
+                         solver_ctx ctx, const char *directions,
+                         uint64_t load_ms) {
+  const char *const status_names[] = {"done", "unfinished", "error",
+                                      "out_of_memory"};
+  solver_stats stats;
+  memset(&stats, 0, sizeof(solver_stats));
+  if (ctx) stats = *solver_get_stats(ctx);
+
+  MUTEX_LOCK(shared->lock);
+  FILE *stream = shared->results;
+  FPRINTF(stream, "{\"file\": ");
+  fprint_json_string(stream, file);
+  FPRINTF(stream, ", \"status\": \"%s\", \"solutions\": ",
+          status_names[status]);
+  // A finished count is exact, otherwise the solutions found so far are given
+  const sol_count *count = ctx ? solver_get_count(ctx) : NULL;
+  if (!ctx)
+    FPRINTF(stream, "null");
+  else if (status != SOLVER_DONE)
+    FPRINTF(stream, "%u", solver_nb_solutions(ctx));
+  else if (!count->big && count->overflow)
+    FPRINTF(stream, "null");
+  else
+    sol_count_fprint(stream, count);
+  if (directions)
+    FPRINTF(stream, ", \"solution\": \"%s\"", directions);
+  else
+    FPRINTF(stream, ", \"solution\": null");
+  FPRINTF(stream,
+          ", \"nodes\": %llu, \"time_ms\": {\"load\": %llu, \"setup\": %llu, "
+          "\"search\": %llu, \"total\": %llu}}\n",
+          (unsigned long long)stats.nb_nodes, (unsigned long long)load_ms,
+          (unsigned long long)stats.setup_ms,
+          (unsigned long long)stats.search_ms,
+          (unsigned long long)(load_ms + stats.setup_ms + stats.search_ms));
+  MUTEX_UNLOCK(shared->lock);
+}
+
+/**
+ * @brief Writes a string as a JSON string, quotes included
+ *
+ * @param stream, where the string is written
+ * @param string, the string
+ */
+static void fprint_json_string(FILE *stream, const char *string) {
+  fputc('"', stream);
+  for (const char *c = string; *c; c++) {
+    if (*c == '"' || *c == '\\')
+      FPRINTF(stream, "\\%c", *c);
+    else if ((unsigned char)*c < 0x20)
+      FPRINTF(stream, "\\u%04x", (unsigned)*c);
+    else
+      fputc(*c, stream);
+  }
+  fputc('"', stream);
+}
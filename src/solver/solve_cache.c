@@ -0,0 +1,702 @@
+#include "solve_cache.h"
+
+#include <stdlib.h>
+
+#include "cross_thread.h"
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define INDEX_MAGIC "NETCACHE"
+#define INDEX_VERSION 1
+#define INITIAL_SLOTS 1024  // Has to be a power of 2
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+#define RECORD_COUNT 1     // The record holds the number of solutions
+#define RECORD_SOLUTION 2  // The record holds a solution
+#define ENV_VALUE_SIZE 4096
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for the beginning of the index file
+ */
+typedef struct index_header_s {
+  char magic[8];       /**< INDEX_MAGIC, without its terminating 0 */
+  uint32_t version;    /**< INDEX_VERSION */
+  uint32_t padding;    /**< unused */
+  uint64_t nb_slots;   /**< number of slots following the header */
+  uint64_t nb_entries; /**< number of slots in use */
+} index_header;
+
+/**
+ * @brief Structure for a slot of the index, pointing to a record
+ */
+typedef struct index_slot_s {
+  uint64_t hash;   /**< hash of the board of the record */
+  uint64_t offset; /**< position of the record in the data file plus 1, 0 for
+                      an empty slot */
+} index_slot;
+
+/**
+ * @brief Structure for the beginning of a record, it is followed by a piece
+ * per cell and, if RECORD_SOLUTION is set, by a direction per cell
+ */
+typedef struct record_header_s {
+  uint64_t hash;         /**< hash of the board */
+  uint64_t nb_solutions; /**< number of solutions if RECORD_COUNT is set */
+  uint16_t width;        /**< width of the board */
+  uint16_t height;       /**< height of the board */
+  uint8_t wrapping;      /**< whether the board wraps around its edges */
+  uint8_t flags;         /**< RECORD_COUNT and RECORD_SOLUTION */
+  uint8_t padding[2];    /**< unused */
+} record_header;
+
+/**
+ * @brief Structure for what identifies a board in the cache
+ */
+typedef struct cache_key_s {
+  uint64_t hash;    /**< hash of everything else */
+  uint16_t width;   /**< width of the board */
+  uint16_t height;  /**< height of the board */
+  bool wrapping;    /**< whether the board wraps around its edges */
+  size_t nb_cells;  /**< number of cells of the board */
+  int8_t *pieces;   /**< piece of every cell, indexed by x + y * width */
+  uint8_t *scratch; /**< buffer of a byte per cell to read records */
+} cache_key;
+
+/**
+ * @brief Structure for an open cache
+ */
+struct solve_cache_s {
+  MUTEX lock;            /**< protects everything else within the process, the
+                            lock of the index file across the processes */
+  FILE *data;            /**< the data file, records are appended to it */
+  uint64_t nb_slots;     /**< number of slots of the mapped index */
+  index_header *header;  /**< the mapped index, NULL if it isn't mapped */
+  index_slot *slots;     /**< the slots following the header */
+  size_t map_size;       /**< size of the mapping */
+#if defined(_WIN32)
+  HANDLE index_file;     /**< the index file */
+  HANDLE mapping;        /**< the mapping of the index file */
+#else
+  int index_file;        /**< the index file */
+#endif
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static bool make_directory(const char *path);
+static char *join_path(const char *directory, const char *name);
+static bool open_index(solve_cache cache, const char *path);
+static void close_index(solve_cache cache);
+static bool lock_files(solve_cache cache);
+static void unlock_files(solve_cache cache);
+static bool resize_index(solve_cache cache, uint64_t nb_slots);
+static bool map_index(solve_cache cache, size_t size);
+static void unmap_index(solve_cache cache);
+static bool load_index(solve_cache cache);
+static bool follow_index(solve_cache cache);
+static bool grow_index(solve_cache cache);
+static bool make_key(cgame board, cache_key *key);
+static void free_key(cache_key *key);
+static index_slot *find_slot(solve_cache cache, const cache_key *key,
+                             record_header *record);
+static bool read_record(solve_cache cache, uint64_t offset,
+                        const cache_key *key, record_header *record);
+static bool read_solution(solve_cache cache, const cache_key *key,
+                          direction *solution);
+
+//--------------------------------------------------------------------------------------
+//                                Cache functions bodies
+
+solve_cache cache_open(const char *directory) {
+  if (!directory) {
+    FPRINTF(stderr, "Error: cache_open, directory pointer is NULL.\n");
+    return NULL;
+  }
+  if (!make_directory(directory)) {
+    FPRINTF(stderr, "Error: cache_open, couldn't create %s.\n", directory);
+    return NULL;
+  }
+  solve_cache cache = (solve_cache)calloc(1, sizeof(struct solve_cache_s));
+  char *data_path = join_path(directory, "data");
+  char *index_path = join_path(directory, "index");
+  if (!cache || !data_path || !index_path) {
+    FPRINTF(stderr, "Error: cache_open, can't allocate the cache.\n");
+    free(cache);
+    free(data_path);
+    free(index_path);
+    return NULL;
+  }
+
+#if defined(_WIN32)
+  cache->index_file = INVALID_HANDLE_VALUE;
+#else
+  cache->index_file = -1;
+#endif
+  FOPEN(cache->data, data_path, "a+b");
+  bool status = cache->data != NULL && open_index(cache, index_path) &&
+                lock_files(cache);
+  if (status) {
+    status = load_index(cache);
+    unlock_files(cache);
+  }
+  if (!status) {
+    FPRINTF(stderr, "Error: cache_open, couldn't open the files of %s.\n",
+            directory);
+    if (cache->data) FCLOSE(cache->data);
+    close_index(cache);
+    free(cache);
+    cache = NULL;
+  } else {
+    MUTEX_INIT(cache->lock);
+  }
+  free(data_path);
+  free(index_path);
+  return cache;
+}
+
+solve_cache cache_open_env(void) {
+  char directory[ENV_VALUE_SIZE];
+#if defined(_WIN32)
+  DWORD length =
+      GetEnvironmentVariableA(SOLVE_CACHE_ENV, directory, ENV_VALUE_SIZE);
+  if (length == 0 || length >= ENV_VALUE_SIZE) return NULL;
+#else
+  const char *value = getenv(SOLVE_CACHE_ENV);
+  if (!value || strlen(value) >= ENV_VALUE_SIZE) return NULL;
+  STRCPY(directory, value, ENV_VALUE_SIZE);
+#endif
+  if (directory[0] == '\0') return NULL;
+  return cache_open(directory);
+}
+
+bool cache_lookup(solve_cache cache, cgame board, cache_entry *entry) {
+  if (!cache || !board || !entry) {
+    FPRINTF(stderr,
+            "Error: cache_lookup, cache, game or entry pointer is NULL.\n");
+    return false;
+  }
+  cache_key key;
+  if (!make_key(board, &key)) return false;
+
+  MUTEX_LOCK(cache->lock);
+  bool locked = lock_files(cache);
+  record_header record;
+  index_slot *slot = locked && follow_index(cache)
+                         ? find_slot(cache, &key, &record)
+                         : NULL;
+  bool found = slot && slot->offset;
+  if (found) {
+    entry->has_count = record.flags & RECORD_COUNT;
+    entry->nb_solutions = entry->has_count ? record.nb_solutions : 0;
+    entry->has_solution = (record.flags & RECORD_SOLUTION) &&
+                          read_solution(cache, &key, entry->solution);
+  }
+  if (locked) unlock_files(cache);
+  MUTEX_UNLOCK(cache->lock);
+
+  free_key(&key);
+  return found;
+}
+
+bool cache_store(solve_cache cache, cgame board, const cache_entry *entry) {
+  if (!cache || !board || !entry) {
+    FPRINTF(stderr,
+            "Error: cache_store, cache, game or entry pointer is NULL.\n");
+    return false;
+  }
+  cache_key key;
+  if (!make_key(board, &key)) return false;
+
+  // Another process may append a record or grow the index from the lookup
+  // until the index points to the new record
+  MUTEX_LOCK(cache->lock);
+  bool locked = lock_files(cache);
+  record_header record;
+  index_slot *slot = locked && follow_index(cache)
+                         ? find_slot(cache, &key, &record)
+                         : NULL;
+  bool status = slot != NULL;
+  uint8_t flags = 0;
+  if (entry->has_count) flags |= RECORD_COUNT;
+  if (entry->has_solution) flags |= RECORD_SOLUTION;
+  bool known = status && slot->offset;
+
+  // What the cache already knows is kept, the record is only rewritten if it
+  // learns something
+  uint8_t *solution = NULL;
+  if (known && (record.flags | flags) == record.flags) {
+    unlock_files(cache);
+    MUTEX_UNLOCK(cache->lock);
+    free_key(&key);
+    return true;
+  }
+  if (entry->has_solution) {
+    for (size_t i = 0; i < key.nb_cells; i++)
+      key.scratch[i] = (uint8_t)entry->solution[i];
+    solution = key.scratch;
+  } else if (known && (record.flags & RECORD_SOLUTION)) {
+    // The solution follows the pieces that find_slot just read
+    status = fread(key.scratch, 1, key.nb_cells, cache->data) == key.nb_cells;
+    solution = key.scratch;
+  }
+  record_header new_record;
+  memset(&new_record, 0, sizeof(record_header));
+  new_record.hash = key.hash;
+  new_record.width = key.width;
+  new_record.height = key.height;
+  new_record.wrapping = key.wrapping;
+  new_record.flags = flags | (known ? record.flags : 0);
+  new_record.nb_solutions = entry->has_count ? entry->nb_solutions
+                            : known          ? record.nb_solutions
+                                             : 0;
+
+  // The record is complete on disk before the index points to it
+  int64_t offset = -1;
+  if (status && FSEEK64(cache->data, 0, SEEK_END) == 0)
+    offset = FTELL64(cache->data);
+  status = offset >= 0 &&
+           fwrite(&new_record, sizeof(record_header), 1, cache->data) == 1 &&
+           fwrite(key.pieces, 1, key.nb_cells, cache->data) == key.nb_cells &&
+           (!solution ||
+            fwrite(solution, 1, key.nb_cells, cache->data) == key.nb_cells) &&
+           fflush(cache->data) == 0;
+  if (status) {
+    slot->hash = key.hash;
+    slot->offset = (uint64_t)offset + 1;
+    if (!known) {
+      cache->header->nb_entries++;
+      if (cache->header->nb_entries * 2 > cache->nb_slots)
+        status = grow_index(cache);
+    }
+  }
+  if (locked) unlock_files(cache);
+  MUTEX_UNLOCK(cache->lock);
+
+  if (!status)
+    FPRINTF(stderr, "Error: cache_store, couldn't write to the cache.\n");
+  free_key(&key);
+  return status;
+}
+
+void cache_close(solve_cache cache) {
+  if (!cache) {
+    FPRINTF(stderr, "Error: cache_close, cache pointer is NULL.\n");
+    return;
+  }
+  close_index(cache);
+  FCLOSE(cache->data);
+  MUTEX_DESTROY(cache->lock);
+  free(cache);
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Creates a directory if it doesn't exist
+ *
+ * @param path, the directory
+ * @return true if the directory exists
+ */
+static bool make_directory(const char *path) {
+#if defined(_WIN32)
+  return CreateDirectoryA(path, NULL) ||
+         GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+  return mkdir(path, 0777) == 0 || errno == EEXIST;
+#endif
+}
+
+/**
+ * @brief Builds the path of a file of a directory
+ *
+ * @param directory, the directory
+ * @param name, the name of the file
+ * @return the allocated path, NULL in case of error
+ */
+static char *join_path(const char *directory, const char *name) {
+  size_t directory_length = strlen(directory);
+  size_t name_length = strlen(name);
+  char *path = (char *)malloc(directory_length + name_length + 2);
+  if (!path) return NULL;
+  memcpy(path, directory, directory_length);
+  path[directory_length] = '/';
+  memcpy(path + directory_length + 1, name, name_length + 1);
+  return path;
+}
+
+/**
+ * @brief Opens the index file of a cache, creating it if needed
+ *
+ * @param cache, the cache
+ * @param path, the index file
+ * @return false in case of error, true otherwise
+ */
+static bool open_index(solve_cache cache, const char *path) {
+#if defined(_WIN32)
+  cache->mapping = NULL;
+  cache->index_file =
+      CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+                  FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS,
+                  FILE_ATTRIBUTE_NORMAL, NULL);
+  return cache->index_file != INVALID_HANDLE_VALUE;
+#else
+  cache->index_file = open(path, O_RDWR | O_CREAT, 0666);
+  return cache->index_file >= 0;
+#endif
+}
+
+/**
+ * @brief Unmaps and closes the index file of a cache
+ *
+ * @param cache, the cache
+ */
+static void close_index(solve_cache cache) {
+  unmap_index(cache);
+#if defined(_WIN32)
+  if (cache->index_file != INVALID_HANDLE_VALUE)
+    CloseHandle(cache->index_file);
+#else
+  if (cache->index_file >= 0) close(cache->index_file);
+#endif
+}
+
+/**
+ * @brief Takes the lock of the index file of a cache, which every process
+ * holds while it reads or changes the files of the cache. It is only advisory,
+ * the files stay readable by the processes that don't take it
+ *
+ * @param cache, the cache, its index file is open
+ * @return false in case of error, true otherwise
+ */
+static bool lock_files(solve_cache cache) {
+#if defined(_WIN32)
+  // The byte locked lies far beyond the end of the file, so that the lock
+  // doesn't stand in the way of the accesses of the other processes
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(OVERLAPPED));
+  overlapped.OffsetHigh = MAXDWORD;
+  bool status = LockFileEx(cache->index_file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0,
+                           &overlapped);
+#else
+  int result;
+  do {
+    result = flock(cache->index_file, LOCK_EX);
+  } while (result != 0 && errno == EINTR);
+  bool status = result == 0;
+#endif
+  if (!status)
+    FPRINTF(stderr, "Error: lock_files, couldn't lock the index file.\n");
+  return status;
+}
+
+/**
+ * @brief Releases the lock of the index file of a cache
+ *
+ * @param cache, the cache, it holds the lock
+ */
+static void unlock_files(solve_cache cache) {
+#if defined(_WIN32)
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(OVERLAPPED));
+  overlapped.OffsetHigh = MAXDWORD;
+  UnlockFileEx(cache->index_file, 0, 1, 0, &overlapped);
+#else
+  flock(cache->index_file, LOCK_UN);
+#endif
+}
+
+/**
+ * @brief Sets the size of the index file of a cache to a number of slots, the
+ * index has to be unmapped
+ *
+ * @param cache, the cache
+ * @param nb_slots, the number of slots
+ * @return false in case of error, true otherwise
+ */
+static bool resize_index(solve_cache cache, uint64_t nb_slots) {
+  uint64_t size = sizeof(index_header) + nb_slots * sizeof(index_slot);
+#if defined(_WIN32)
+  LARGE_INTEGER position;
+  position.QuadPart = (LONGLONG)size;
+  return SetFilePointerEx(cache->index_file, position, NULL, FILE_BEGIN) &&
+         SetEndOfFile(cache->index_file);
+#else
+  return ftruncate(cache->index_file, (off_t)size) == 0;
+#endif
+}
+
+/**
+ * @brief Maps the beginning of the index file of a cache
+ *
+ * @param cache, the cache
+ * @param size, the number of bytes to map
+ * @return false in case of error, true otherwise
+ */
+static bool map_index(solve_cache cache, size_t size) {
+#if defined(_WIN32)
+  cache->mapping = CreateFileMappingA(cache->index_file, NULL, PAGE_READWRITE,
+                                      0, 0, NULL);
+  if (!cache->mapping) return false;
+  cache->header = (index_header *)MapViewOfFile(
+      cache->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (!cache->header) {
+    CloseHandle(cache->mapping);
+    cache->mapping = NULL;
+    return false;
+  }
+#else
+  void *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       cache->index_file, 0);
+  if (address == MAP_FAILED) return false;
+  cache->header = (index_header *)address;
+#endif
+  cache->map_size = size;
+  cache->slots = (index_slot *)(cache->header + 1);
+  return true;
+}
+
+/**
+ * @brief Unmaps the index file of a cache, if it is mapped
+ *
+ * @param cache, the cache
+ */
+static void unmap_index(solve_cache cache) {
+  if (!cache->header) return;
+#if defined(_WIN32)
+  UnmapViewOfFile(cache->header);
+  CloseHandle(cache->mapping);
+  cache->mapping = NULL;
+#else
+  munmap(cache->header, cache->map_size);
+#endif
+  cache->header = NULL;
+  cache->slots = NULL;
+}
+
+/**
+ * @brief Maps the index file of a cache, it is reset if it is empty or isn't
+ * a valid index
+ *
+ * @param cache, the cache, its index isn't mapped and the lock of its index
+ * file is held
+ * @return false in case of error, true otherwise
+ */
+static bool load_index(solve_cache cache) {
+#if defined(_WIN32)
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(cache->index_file, &file_size)) return false;
+  uint64_t size = (uint64_t)file_size.QuadPart;
+#else
+  struct stat info;
+  if (fstat(cache->index_file, &info) != 0) return false;
+  uint64_t size = (uint64_t)info.st_size;
+#endif
+  if (size >= sizeof(index_header) && map_index(cache, (size_t)size)) {
+    index_header *header = cache->header;
+    if (memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == INDEX_VERSION && header->nb_slots &&
+        !(header->nb_slots & (header->nb_slots - 1)) &&
+        size == sizeof(index_header) + header->nb_slots * sizeof(index_slot)) {
+      cache->nb_slots = header->nb_slots;
+      return true;
+    }
+    unmap_index(cache);
+  }
+
+  // The slots of a new index are zeroed by the resize
+  if (!resize_index(cache, 0) || !resize_index(cache, INITIAL_SLOTS) ||
+      !map_index(cache,
+                 sizeof(index_header) + INITIAL_SLOTS * sizeof(index_slot)))
+    return false;
+  memcpy(cache->header->magic, INDEX_MAGIC, sizeof(cache->header->magic));
+  cache->header->version = INDEX_VERSION;
+  cache->header->nb_slots = INITIAL_SLOTS;
+  cache->header->nb_entries = 0;
+  cache->nb_slots = INITIAL_SLOTS;
+  return true;
+}
+
+/**
+ * @brief Maps the index of a cache again if another process has grown it
+ *
+ * @param cache, the cache, its lock and the lock of its index file are held
+ * @return false if the index is no longer mapped, true otherwise
+ */
+static bool follow_index(solve_cache cache) {
+  if (cache->header && cache->header->nb_slots == cache->nb_slots) return true;
+  unmap_index(cache);
+  if (!load_index(cache)) {
+    FPRINTF(stderr, "Error: follow_index, couldn't map the index again.\n");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Doubles the number of slots of the index of a cache
+ *
+ * @param cache, the cache, its lock and the lock of its index file are held
+ * @return false in case of error, true otherwise
+ */
+static bool grow_index(solve_cache cache) {
+  uint64_t nb_slots = cache->nb_slots;
+  index_slot *old_slots =
+      (index_slot *)malloc((size_t)nb_slots * sizeof(index_slot));
+  if (!old_slots) return false;
+  memcpy(old_slots, cache->slots, (size_t)nb_slots * sizeof(index_slot));
+  uint64_t nb_entries = cache->header->nb_entries;
+
+  // Growing the file zeroes the new slots, the old ones are cleared by hand
+  unmap_index(cache);
+  uint64_t new_nb_slots = 2 * nb_slots;
+  if (!resize_index(cache, new_nb_slots) ||
+      !map_index(cache, sizeof(index_header) +
+                            (size_t)new_nb_slots * sizeof(index_slot))) {
+    free(old_slots);
+    return false;
+  }
+  memset(cache->slots, 0, (size_t)nb_slots * sizeof(index_slot));
+  cache->header->nb_slots = new_nb_slots;
+  cache->header->nb_entries = nb_entries;
+  cache->nb_slots = new_nb_slots;
+  for (uint64_t i = 0; i < nb_slots; i++) {
+    if (!old_slots[i].offset) continue;
+    uint64_t position = old_slots[i].hash & (new_nb_slots - 1);
+    while (cache->slots[position].offset)
+      position = (position + 1) & (new_nb_slots - 1);
+    cache->slots[position] = old_slots[i];
+  }
+  free(old_slots);
+  return true;
+}
+
+/**
+ * @brief Reads what identifies a board in the cache
+ *
+ * @param board, the board
+ * @param key, where the key is written, it has to be freed with free_key
+ * @return false in case of error, true otherwise
+ */
+static bool make_key(cgame board, cache_key *key) {
+  key->width = game_width(board);
+  key->height = game_height(board);
+  key->wrapping = is_wrapping(board);
+  key->nb_cells = (size_t)key->width * key->height;
+  key->pieces = (int8_t *)malloc(key->nb_cells ? key->nb_cells : 1);
+  key->scratch = (uint8_t *)malloc(key->nb_cells ? key->nb_cells : 1);
+  if (!key->pieces || !key->scratch) {
+    FPRINTF(stderr, "Error: make_key, can't allocate the key.\n");
+    free_key(key);
+    return false;
+  }
+
+  // FNV-1a over the size, the wrapping and the pieces
+  uint8_t bytes[5] = {(uint8_t)key->width, (uint8_t)(key->width >> 8),
+                      (uint8_t)key->height, (uint8_t)(key->height >> 8),
+                      (uint8_t)key->wrapping};
+  uint64_t hash = FNV_OFFSET;
+  for (uint8_t i = 0; i < 5; i++) hash = (hash ^ bytes[i]) * FNV_PRIME;
+  piece *pieces = (piece *)malloc(key->nb_cells * sizeof(piece) + 1);
+  if (!pieces) {
+    FPRINTF(stderr, "Error: make_key, can't allocate the key.\n");
+    free_key(key);
+    return false;
+  }
+  get_cells(board, pieces, NULL);
+  for (size_t i = 0; i < key->nb_cells; i++) {
+    key->pieces[i] = (int8_t)pieces[i];
+    hash = (hash ^ (uint8_t)key->pieces[i]) * FNV_PRIME;
+  }
+  free(pieces);
+  key->hash = hash;
+  return true;
+}
+
+/**
+ * @brief Frees the buffers of a key
+ *
+ * @param key, the key
+ */
+static void free_key(cache_key *key) {
+  free(key->pieces);
+  free(key->scratch);
+  key->pieces = NULL;
+  key->scratch = NULL;
+}
+
+/**
+ * @brief Finds the slot of a board in the index of a cache, or the slot where
+ * it has to be added
+ *
+ * @param cache, the cache, its lock is held and its index is mapped
+ * @param key, the key of the board
+ * @param record, where the header of the record of the board is written if it
+ * is found, the data file is then positioned after its pieces
+ * @return the slot, its offset is 0 if the board isn't in the cache
+ */
+static index_slot *find_slot(solve_cache cache, const cache_key *key,
+                             record_header *record) {
+  uint64_t mask = cache->nb_slots - 1;
+  uint64_t position = key->hash & mask;
+  while (cache->slots[position].offset) {
+    index_slot *slot = &cache->slots[position];
+    if (slot->hash == key->hash &&
+        read_record(cache, slot->offset - 1, key, record))
+      return slot;
+    position = (position + 1) & mask;
+  }
+  return &cache->slots[position];
+}
+
+/**
+ * @brief Reads a record and checks that it is the one of a board
+ *
+ * @param cache, the cache, its lock is held
+ * @param offset, the position of the record in the data file
+ * @param key, the key of the board
+ * @param record, where the header of the record is written
+ * @return true if the record is the one of the board
+ */
+static bool read_record(solve_cache cache, uint64_t offset,
+                        const cache_key *key, record_header *record) {
+  if (offset > INT64_MAX ||
+      FSEEK64(cache->data, (int64_t)offset, SEEK_SET) != 0 ||
+      fread(record, sizeof(record_header), 1, cache->data) != 1)
+    return false;
+  if (record->hash != key->hash || record->width != key->width ||
+      record->height != key->height || record->wrapping != key->wrapping)
+    return false;
+  return fread(key->scratch, 1, key->nb_cells, cache->data) == key->nb_cells &&
+         memcmp(key->scratch, key->pieces, key->nb_cells) == 0;
+}
+
+/**
+ * @brief Reads the solution following the pieces of the record just read
+ *
+ * @param cache, the cache, its lock is held
+ * @param key, the key of the board of the record
+ * @param solution, where the direction of every cell is written
+ * @return false if the solution couldn't be read, true otherwise
+ */
+static bool read_solution(solve_cache cache, const cache_key *key,
+                          direction *solution) {
+  if (fread(key->scratch, 1, key->nb_cells, cache->data) != key->nb_cells)
+    return false;
+  for (size_t i = 0; i < key->nb_cells; i++) {
+    if (key->scratch[i] >= NB_DIR) return false;
+    solution[i] = (direction)key->scratch[i];
+  }
+  return true;
+}
@@ -0,0 +1,1234 @@
+#include "solve_cdcl.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "cross_time.h"
+
+#define NO_EDGE UINT32_MAX
+#define NO_VAR UINT32_MAX
+#define NO_CLAUSE UINT32_MAX
+#define VALUE_FALSE 0
+#define VALUE_TRUE 1
+#define VALUE_UNDEF 2
+// A literal is a variable and a sign: 2 * var for the variable being true,
+// 2 * var + 1 for it being false
+#define MAKE_LIT(var, negated) (2 * (var) + (uint32_t)(negated))
+#define LIT_VAR(lit) ((lit) >> 1)
+#define NEG_LIT(lit) ((lit) ^ 1)
+// The clauses of the board have at most an edge and every orientation of a cell
+#define MAX_BOARD_CLAUSE_SIZE (1 + NB_DIR)
+#define MIN_CAPACITY 16
+#define RESTART_CONFLICTS 100  // Conflicts before the first restart
+#define VAR_DECAY 0.95
+#define CLAUSE_DECAY 0.999
+#define VAR_ACTIVITY_LIMIT 1e100
+#define CLAUSE_ACTIVITY_LIMIT 1e20
+#define MIN_LEARNTS 2000  // Learnt clauses kept before the first reduction
+#define LEARNTS_GROWTH 1.1
+#define CLOCK_DECISIONS 16  // Decisions between two readings of the clock
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for a clause, whose literals are stored in the literal arena
+ * of the engine. The literals watched are the first two
+ */
+typedef struct clause_s {
+  uint32_t start;  /**< index of the first literal in the arena */
+  uint32_t size;   /**< number of literals */
+  double activity; /**< how often the clause took part in recent conflicts */
+  bool learnt;     /**< whether the clause can be deleted */
+} clause;
+
+/**
+ * @brief Structure for the clauses watching a literal
+ */
+typedef struct watch_list_s {
+  uint32_t *clauses; /**< indices of the clauses */
+  uint32_t size;     /**< number of clauses */
+  uint32_t capacity; /**< number of clauses allocated */
+} watch_list;
+
+/**
+ * @brief Structure for the change an edge made to the connection union-find,
+ * undone when backtracking
+ */
+typedef struct edge_undo_s {
+  uint32_t root_a; /**< root of the first cell of the edge */
+  uint32_t root_b; /**< root of the second cell of the edge */
+  uint32_t open_a; /**< open count of root_a before the change */
+  uint32_t open_b; /**< open count of root_b before the change */
+  uint32_t child;  /**< the root merged into the other one, NO_VAR if none */
+} edge_undo;
+
+/**
+ * @brief Structure for a clause-learning engine
+ */
+struct cdcl_engine_s {
+  uint32_t nb_cells; /**< number of cells of the board */
+  uint32_t nb_edges; /**< number of edges, which are the first variables */
+  uint32_t nb_vars;  /**< number of variables, edges then orientations */
+  uint32_t (*cell_edges)[NB_DIR]; /**< edge of each cell in each direction,
+                                     NO_EDGE if off the board */
+  uint32_t (*edge_cells)[2];      /**< the two cells of each edge */
+  uint32_t *first_var;     /**< first orientation variable of each cell, the
+                              last cell is followed by nb_vars */
+  direction *var_dirs;     /**< orientation of each orientation variable */
+  uint8_t *var_masks;      /**< mask of the directions connected by each
+                              orientation variable */
+  direction *orientations; /**< the last solution found */
+
+  clause *clauses;          /**< the clauses, the board's then learnt ones */
+  uint32_t nb_clauses;      /**< number of clauses */
+  uint32_t clause_capacity; /**< number of clauses allocated */
+  uint32_t *lits;           /**< arena of the literals of the clauses */
+  uint32_t nb_lits;         /**< number of literals in the arena */
+  uint32_t lit_capacity;    /**< number of literals allocated */
+  watch_list *watches;      /**< clauses watching each literal */
+  uint32_t nb_learnts;      /**< number of learnt clauses */
+  double max_learnts;       /**< learnt clauses kept before a reduction */
+
+  uint8_t *values;        /**< value of each variable */
+  uint32_t *levels;       /**< decision level of each assigned variable */
+  uint32_t *reasons;      /**< clause implying each assigned variable,
+                             NO_CLAUSE for decisions and level 0 */
+  uint32_t *trail;        /**< the literals assigned, in order */
+  uint32_t trail_size;    /**< number of literals on the trail */
+  uint32_t queue_head;    /**< index of the next literal to propagate */
+  uint32_t *level_starts; /**< trail size when each level was decided */
+  uint32_t level;         /**< current decision level */
+
+  double *activity;        /**< branching score of each variable */
+  double var_increment;    /**< activity added to a variable in a conflict */
+  double clause_increment; /**< activity added to a clause in a conflict */
+  uint32_t *heap;          /**< max-heap of the orientation variables by
+                              activity */
+  uint32_t heap_size;      /**< number of variables in the heap */
+  uint32_t *heap_index;    /**< index of each variable in the heap, NO_VAR if
+                              not in it */
+
+  bool *seen;       /**< scratch mark of each variable */
+  uint32_t *buffer; /**< scratch clause of up to nb_vars + 1 literals */
+
+  uint32_t *parent;  /**< union-find of the cells over the true edges
+                        propagated, a root is its own parent */
+  uint32_t *size;    /**< number of cells of the component of each root */
+  uint32_t *nb_open; /**< number of edges of the component of each root not
+                        propagated yet */
+  edge_undo *undo;   /**< change of the union-find made by each edge */
+  uint32_t *cells;   /**< scratch queue of cells */
+  uint32_t *via;     /**< edge through which a walk reached each cell */
+  uint32_t *marks;   /**< walk that last reached each cell */
+  uint32_t mark;     /**< number of the current walk */
+
+  uint64_t nb_decisions;    /**< decisions taken */
+  uint64_t nb_propagations; /**< literals propagated */
+  uint64_t nb_conflicts;    /**< conflicts analysed or solutions blocked */
+
+  uint64_t max_decisions;    /**< decisions the search may take, 0 for no
+                                limit */
+  uint32_t max_milliseconds; /**< time the search may take, 0 for no limit */
+
+  bool unsat;         /**< whether the board was found without solution */
+  bool searched;      /**< whether the engine was searched already */
+  bool error;         /**< whether an allocation failed during the search */
+  bool out_of_budget; /**< whether the search ran out of budget */
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static void *reserve(void *array, uint32_t *capacity, uint32_t needed,
+                     size_t item_size);
+static bool init_variables(cdcl_engine engine, cgame board);
+static bool init_clauses(cdcl_engine engine);
+static uint8_t lit_value(cdcl_engine engine, uint32_t lit);
+static bool add_watch(cdcl_engine engine, uint32_t lit, uint32_t index);
+static uint32_t add_clause(cdcl_engine engine, const uint32_t *lits,
+                           uint32_t size, bool learnt);
+static bool add_board_clause(cdcl_engine engine, const uint32_t *lits,
+                             uint32_t size);
+static void enqueue(cdcl_engine engine, uint32_t lit, uint32_t reason);
+static uint32_t find_root(cdcl_engine engine, uint32_t cell);
+static uint32_t add_conflict(cdcl_engine engine, uint32_t *lits,
+                             uint32_t size);
+static uint32_t loop_conflict(cdcl_engine engine, uint32_t edge);
+static uint32_t closed_conflict(cdcl_engine engine, uint32_t root,
+                                uint32_t trigger);
+static uint32_t assign_edge(cdcl_engine engine, uint32_t edge, bool connected);
+static void unassign_edge(cdcl_engine engine, uint32_t edge);
+static uint32_t propagate(cdcl_engine engine);
+static void heap_up(cdcl_engine engine, uint32_t index);
+static void heap_down(cdcl_engine engine, uint32_t index);
+static void heap_insert(cdcl_engine engine, uint32_t var);
+static uint32_t heap_pop(cdcl_engine engine);
+static void bump_var(cdcl_engine engine, uint32_t var);
+static void bump_clause(cdcl_engine engine, uint32_t index);
+static void cancel_until(cdcl_engine engine, uint32_t level);
+static uint32_t analyze(cdcl_engine engine, uint32_t conflict,
+                        uint32_t *backjump_level);
+static bool learn(cdcl_engine engine, uint32_t size);
+static uint32_t block_solution(cdcl_engine engine);
+static int compare_activity(const void *a, const void *b);
+static bool reduce_learnts(cdcl_engine engine);
+static uint32_t luby(uint32_t index);
+static uint32_t choose_branching_var(cdcl_engine engine);
+
+//--------------------------------------------------------------------------------------
+//                                Engine functions bodies
+
+cdcl_engine cdcl_create(cgame board) {
+  if (!board) {
+    FPRINTF(stderr, "Error: cdcl_create, game pointer is NULL.\n");
+    return NULL;
+  }
+
+  cdcl_engine engine = (cdcl_engine)calloc(1, sizeof(struct cdcl_engine_s));
+  if (!engine) {
+    FPRINTF(stderr, "Error: cdcl_create, can't allocate engine.\n");
+    return NULL;
+  }
+  if (!init_variables(engine, board)) {
+    FPRINTF(stderr, "Error: cdcl_create, can't allocate engine state.\n");
+    cdcl_destroy(engine);
+    return NULL;
+  }
+  if (!engine->unsat && !init_clauses(engine)) {
+    FPRINTF(stderr, "Error: cdcl_create, can't allocate clauses.\n");
+    cdcl_destroy(engine);
+    return NULL;
+  }
+  return engine;
+}
+
+bool cdcl_search(cdcl_engine engine, prop_solution_callback on_solution,
+                 void *data) {
+  if (!engine || !on_solution) {
+    FPRINTF(stderr,
+            "Error: cdcl_search, engine or solution callback is NULL.\n");
+    return false;
+  }
+  if (engine->searched) {
+    FPRINTF(stderr, "Error: cdcl_search, engine was already searched.\n");
+    return false;
+  }
+  engine->searched = true;
+  if (engine->unsat) return true;
+
+  uint64_t start = get_milliseconds();
+  uint32_t nb_restarts = 0;
+  uint32_t conflicts_left = RESTART_CONFLICTS * luby(nb_restarts);
+  while (true) {
+    uint32_t conflict = propagate(engine);
+    if (engine->error) break;
+
+    if (conflict == NO_CLAUSE) {
+      if (conflicts_left == 0 && engine->level > 0) {
+        cancel_until(engine, 0);
+        nb_restarts++;
+        conflicts_left = RESTART_CONFLICTS * luby(nb_restarts);
+        if (engine->nb_learnts >= engine->max_learnts &&
+            !reduce_learnts(engine))
+          break;
+        continue;
+      }
+
+      uint32_t var = choose_branching_var(engine);
+      if (var != NO_VAR) {
+        if ((engine->max_decisions &&
+             engine->nb_decisions >= engine->max_decisions) ||
+            (engine->max_milliseconds &&
+             engine->nb_decisions % CLOCK_DECISIONS == 0 &&
+             get_milliseconds() - start >= engine->max_milliseconds)) {
+          engine->out_of_budget = true;
+          return true;
+        }
+        engine->nb_decisions++;
+        engine->level_starts[engine->level++] = engine->trail_size;
+        enqueue(engine, MAKE_LIT(var, false), NO_CLAUSE);
+        continue;
+      }
+
+      // Every cell has an orientation, and the connections span the board
+      // without loop
+      for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+        for (var = engine->first_var[cell]; var < engine->first_var[cell + 1];
+             var++) {
+          if (engine->values[var] == VALUE_TRUE) {
+            engine->orientations[cell] =
+                engine->var_dirs[var - engine->nb_edges];
+            break;
+          }
+        }
+      }
+      if (!on_solution(engine->orientations, data)) return true;
+      if (engine->level == 0) return true;  // Nothing was decided
+      conflict = block_solution(engine);
+      if (conflict == NO_CLAUSE) break;
+    }
+
+    if (engine->level == 0) return true;  // No other solution
+    engine->nb_conflicts++;
+    if (conflicts_left > 0) conflicts_left--;
+    uint32_t backjump_level;
+    uint32_t size = analyze(engine, conflict, &backjump_level);
+    cancel_until(engine, backjump_level);
+    if (!learn(engine, size)) break;
+    engine->var_increment /= VAR_DECAY;
+    engine->clause_increment /= CLAUSE_DECAY;
+  }
+  FPRINTF(stderr, "Error: cdcl_search, can't allocate clauses.\n");
+  return false;
+}
+
+void cdcl_set_budget(cdcl_engine engine, uint64_t max_nodes,
+                     uint32_t max_milliseconds) {
+  if (!engine) {
+    FPRINTF(stderr, "Error: cdcl_set_budget, engine pointer is NULL.\n");
+    return;
+  }
+  engine->max_decisions = max_nodes;
+  engine->max_milliseconds = max_milliseconds;
+}
+
+bool cdcl_out_of_budget(cdcl_engine engine) {
+  if (!engine) {
+    FPRINTF(stderr, "Error: cdcl_out_of_budget, engine pointer is NULL.\n");
+    return false;
+  }
+  return engine->out_of_budget;
+}
+
+void cdcl_get_stats(cdcl_engine engine, solver_stats *stats) {
+  if (!engine || !stats) {
+    FPRINTF(stderr,
+            "Error: cdcl_get_stats, engine or stats pointer is NULL.\n");
+    return;
+  }
+  stats->nb_nodes = engine->nb_decisions;
+  stats->nb_propagations = engine->nb_propagations;
+  stats->nb_backtracks = engine->nb_conflicts;
+}
+
+void cdcl_destroy(cdcl_engine engine) {
+  if (!engine) return;
+  if (engine->watches) {
+    for (uint32_t lit = 0; lit < 2 * engine->nb_vars; lit++)
+      free(engine->watches[lit].clauses);
+  }
+  free(engine->cell_edges);
+  free(engine->edge_cells);
+  free(engine->first_var);
+  free(engine->var_dirs);
+  free(engine->var_masks);
+  free(engine->orientations);
+  free(engine->clauses);
+  free(engine->lits);
+  free(engine->watches);
+  free(engine->values);
+  free(engine->levels);
+  free(engine->reasons);
+  free(engine->trail);
+  free(engine->level_starts);
+  free(engine->activity);
+  free(engine->heap);
+  free(engine->heap_index);
+  free(engine->seen);
+  free(engine->buffer);
+  free(engine->parent);
+  free(engine->size);
+  free(engine->nb_open);
+  free(engine->undo);
+  free(engine->cells);
+  free(engine->via);
+  free(engine->marks);
+  free(engine);
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Grows an array to hold at least a number of items
+ * @param array the array, NULL if not allocated yet
+ * @param capacity the number of items allocated, updated when growing
+ * @param needed the number of items the array must hold
+ * @param item_size the size of an item
+ * @return the array, moved if it grew, NULL if it couldn't grow
+ */
+static void *reserve(void *array, uint32_t *capacity, uint32_t needed,
+                     size_t item_size) {
+  if (needed <= *capacity) return array;
+  uint32_t new_capacity = *capacity < MIN_CAPACITY ? MIN_CAPACITY : *capacity;
+  while (new_capacity < needed) {
+    if (new_capacity > UINT32_MAX / 2) return NULL;
+    new_capacity *= 2;
+  }
+  void *new_array = realloc(array, (size_t)new_capacity * item_size);
+  if (!new_array) return NULL;
+  *capacity = new_capacity;
+  return new_array;
+}
+
+/**
+ * @brief Numbers the edges and the orientations of the board and allocates the
+ * state of the search
+ * @param engine the engine, whose board is found unsat if a cell can't take any
+ * orientation
+ * @param board the game to solve
+ * @return false in case of error, true otherwise
+ */
+static bool init_variables(cdcl_engine engine, cgame board) {
+  uint16_t width = game_width(board);
+  uint16_t height = game_height(board);
+  uint32_t nb_cells = (uint32_t)width * height;
+  engine->nb_cells = nb_cells;
+  engine->cell_edges = malloc(nb_cells * sizeof(*engine->cell_edges));
+  engine->edge_cells = malloc(2 * nb_cells * sizeof(*engine->edge_cells));
+  engine->first_var = (uint32_t *)malloc((nb_cells + 1) * sizeof(uint32_t));
+  engine->var_dirs = (direction *)malloc(NB_DIR * nb_cells * sizeof(direction));
+  engine->var_masks = (uint8_t *)malloc(NB_DIR * nb_cells * sizeof(uint8_t));
+  engine->orientations = (direction *)malloc(nb_cells * sizeof(direction));
+  if (!engine->cell_edges || !engine->edge_cells || !engine->first_var ||
+      !engine->var_dirs || !engine->var_masks || !engine->orientations)
+    return false;
+
+  // Each cell owns the edges to its north and east neighbours
+  const int32_t delta_x[NB_DIR] = {0, 1, 0, -1};
+  const int32_t delta_y[NB_DIR] = {1, 0, -1, 0};
+  bool wrapping = is_wrapping(board);
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    for (direction dir = N; dir < NB_DIR; dir++)
+      engine->cell_edges[cell][dir] = NO_EDGE;
+  }
+  uint32_t nb_edges = 0;
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      uint32_t cell = x + (uint32_t)y * width;
+      for (direction dir = N; dir <= E; dir++) {
+        int32_t next_x = x + delta_x[dir];
+        int32_t next_y = y + delta_y[dir];
+        if (wrapping) {
+          next_x %= width;
+          next_y %= height;
+        }
+        if (next_x >= width || next_y >= height) continue;
+        uint32_t next = (uint32_t)next_x + (uint32_t)next_y * width;
+        engine->cell_edges[cell][dir] = nb_edges;
+        engine->cell_edges[next][(dir + 2) % NB_DIR] = nb_edges;
+        engine->edge_cells[nb_edges][0] = cell;
+        engine->edge_cells[nb_edges][1] = next;
+        nb_edges++;
+      }
+    }
+  }
+  engine->nb_edges = nb_edges;
+
+  // Orientations giving the same connections are the same for the search, the
+  // current one is kept among them
+  uint32_t nb_vars = nb_edges;
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      uint32_t cell = x + (uint32_t)y * width;
+      piece cell_piece = get_piece(board, x, y);
+      direction current = get_current_direction(board, x, y);
+      uint8_t masks[NB_DIR];
+      uint8_t nb_masks = 0;
+      engine->first_var[cell] = nb_vars;
+      for (uint8_t i = 0; i < NB_DIR; i++) {
+        direction orientation = (direction)((current + i) % NB_DIR);
+        uint8_t mask = 0;
+        bool on_board = true;
+        for (direction dir = N; dir < NB_DIR; dir++) {
+          if (!is_edge(cell_piece, orientation, dir)) continue;
+          mask |= (uint8_t)(1 << dir);
+          if (engine->cell_edges[cell][dir] == NO_EDGE) on_board = false;
+        }
+        bool known = false;
+        for (uint8_t j = 0; j < nb_masks; j++) known |= masks[j] == mask;
+        if (!on_board || known) continue;
+        masks[nb_masks++] = mask;
+        engine->var_dirs[nb_vars - nb_edges] = orientation;
+        engine->var_masks[nb_vars++ - nb_edges] = mask;
+      }
+      if (nb_masks == 0) engine->unsat = true;
+    }
+  }
+  engine->first_var[nb_cells] = nb_vars;
+  engine->nb_vars = nb_vars;
+
+  engine->watches = (watch_list *)calloc(2 * nb_vars, sizeof(watch_list));
+  engine->values = (uint8_t *)malloc(nb_vars * sizeof(uint8_t));
+  engine->levels = (uint32_t *)malloc(nb_vars * sizeof(uint32_t));
+  engine->reasons = (uint32_t *)malloc(nb_vars * sizeof(uint32_t));
+  engine->trail = (uint32_t *)malloc(nb_vars * sizeof(uint32_t));
+  engine->level_starts = (uint32_t *)malloc(nb_vars * sizeof(uint32_t));
+  engine->activity = (double *)calloc(nb_vars, sizeof(double));
+  engine->heap = (uint32_t *)malloc(nb_vars * sizeof(uint32_t));
+  engine->heap_index = (uint32_t *)malloc(nb_vars * sizeof(uint32_t));
+  engine->seen = (bool *)calloc(nb_vars, sizeof(bool));
+  engine->buffer = (uint32_t *)malloc((nb_vars + 1) * sizeof(uint32_t));
+  engine->parent = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->size = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->nb_open = (uint32_t *)calloc(nb_cells, sizeof(uint32_t));
+  engine->undo = (edge_undo *)malloc(nb_edges * sizeof(edge_undo));
+  engine->cells = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->via = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->marks = (uint32_t *)calloc(nb_cells, sizeof(uint32_t));
+  if (!engine->watches || !engine->values || !engine->levels ||
+      !engine->reasons || !engine->trail || !engine->level_starts ||
+      !engine->activity || !engine->heap || !engine->heap_index ||
+      !engine->seen || !engine->buffer || !engine->parent || !engine->size ||
+      !engine->nb_open || !engine->undo || !engine->cells || !engine->via ||
+      !engine->marks)
+    return false;
+
+  memset(engine->values, VALUE_UNDEF, nb_vars * sizeof(uint8_t));
+  for (uint32_t var = 0; var < nb_vars; var++) {
+    engine->reasons[var] = NO_CLAUSE;
+    engine->heap_index[var] = NO_VAR;
+  }
+  for (uint32_t var = nb_edges; var < nb_vars; var++) heap_insert(engine, var);
+  engine->var_increment = 1;
+  engine->clause_increment = 1;
+
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    engine->parent[cell] = cell;
+    engine->size[cell] = 1;
+  }
+  for (uint32_t edge = 0; edge < nb_edges; edge++) {
+    engine->nb_open[engine->edge_cells[edge][0]]++;
+    engine->nb_open[engine->edge_cells[edge][1]]++;
+  }
+  return true;
+}
+
+/**
+ * @brief Adds the clauses of the board: each cell takes exactly one of its
+ * orientations, and an edge is connected if and only if the orientation of each
+ * of its cells connects it
+ * @param engine the engine
+ * @return false in case of error, true otherwise
+ */
+static bool init_clauses(cdcl_engine engine) {
+  uint32_t lits[MAX_BOARD_CLAUSE_SIZE];
+  for (uint32_t cell = 0; cell < engine->nb_cells && !engine->unsat; cell++) {
+    uint32_t first = engine->first_var[cell];
+    uint32_t last = engine->first_var[cell + 1];
+    uint32_t size = 0;
+    for (uint32_t var = first; var < last; var++)
+      lits[size++] = MAKE_LIT(var, false);
+    if (!add_board_clause(engine, lits, size)) return false;
+    for (uint32_t var = first; var < last; var++) {
+      for (uint32_t other = var + 1; other < last; other++) {
+        lits[0] = MAKE_LIT(var, true);
+        lits[1] = MAKE_LIT(other, true);
+        if (!add_board_clause(engine, lits, 2)) return false;
+      }
+    }
+
+    for (direction dir = N; dir < NB_DIR; dir++) {
+      uint32_t edge = engine->cell_edges[cell][dir];
+      if (edge == NO_EDGE) continue;
+      uint32_t with_size = 1;
+      uint32_t without_size = 1;
+      uint32_t without[MAX_BOARD_CLAUSE_SIZE];
+      lits[0] = MAKE_LIT(edge, true);
+      without[0] = MAKE_LIT(edge, false);
+      for (uint32_t var = first; var < last; var++) {
+        bool connected = engine->var_masks[var - engine->nb_edges] & (1 << dir);
+        uint32_t implied[2] = {MAKE_LIT(var, true),
+                               MAKE_LIT(edge, !connected)};
+        if (!add_board_clause(engine, implied, 2)) return false;
+        if (connected)
+          lits[with_size++] = MAKE_LIT(var, false);
+        else
+          without[without_size++] = MAKE_LIT(var, false);
+      }
+      if (!add_board_clause(engine, lits, with_size)) return false;
+      if (!add_board_clause(engine, without, without_size)) return false;
+    }
+  }
+  engine->max_learnts = engine->nb_clauses / 3.0;
+  if (engine->max_learnts < MIN_LEARNTS) engine->max_learnts = MIN_LEARNTS;
+  return true;
+}
+
+/**
+ * @brief Gets the value of a literal
+ * @param engine the engine
+ * @param lit the literal
+ * @return VALUE_TRUE, VALUE_FALSE or VALUE_UNDEF if its variable isn't assigned
+ */
+static uint8_t lit_value(cdcl_engine engine, uint32_t lit) {
+  uint8_t value = engine->values[LIT_VAR(lit)];
+  return value == VALUE_UNDEF ? value : (uint8_t)(value ^ (lit & 1));
+}
+
+/**
+ * @brief Makes a clause watch a literal, so it's visited when the literal
+ * becomes false
+ * @param engine the engine
+ * @param lit the literal
+ * @param index the clause
+ * @return false in case of error, true otherwise
+ */
+static bool add_watch(cdcl_engine engine, uint32_t lit, uint32_t index) {
+  watch_list *list = &engine->watches[lit];
+  uint32_t *clauses = (uint32_t *)reserve(list->clauses, &list->capacity,
+                                          list->size + 1, sizeof(uint32_t));
+  if (!clauses) return false;
+  list->clauses = clauses;
+  list->clauses[list->size++] = index;
+  return true;
+}
+
+/**
+ * @brief Adds a clause watching its first two literals
+ * @param engine the engine, whose error flag is set in case of error
+ * @param lits the literals of the clause
+ * @param size the number of literals
+ * @param learnt whether the clause can be deleted
+ * @return the index of the clause, NO_CLAUSE in case of error
+ */
+static uint32_t add_clause(cdcl_engine engine, const uint32_t *lits,
+                           uint32_t size, bool learnt) {
+  clause *clauses =
+      (clause *)reserve(engine->clauses, &engine->clause_capacity,
+                        engine->nb_clauses + 1, sizeof(clause));
+  if (clauses) engine->clauses = clauses;
+  uint32_t *arena = NULL;
+  if (clauses && engine->nb_lits <= UINT32_MAX - size)
+    arena = (uint32_t *)reserve(engine->lits, &engine->lit_capacity,
+                                engine->nb_lits + size, sizeof(uint32_t));
+  if (!arena) {
+    engine->error = true;
+    return NO_CLAUSE;
+  }
+  engine->lits = arena;
+
+  uint32_t index = engine->nb_clauses++;
+  engine->clauses[index].start = engine->nb_lits;
+  engine->clauses[index].size = size;
+  engine->clauses[index].activity = 0;
+  engine->clauses[index].learnt = learnt;
+  memcpy(engine->lits + engine->nb_lits, lits, size * sizeof(uint32_t));
+  engine->nb_lits += size;
+  if (learnt) engine->nb_learnts++;
+  if (size >= 2 && (!add_watch(engine, lits[0], index) ||
+                    !add_watch(engine, lits[1], index))) {
+    engine->error = true;
+    return NO_CLAUSE;
+  }
+  return index;
+}
+
+/**
+ * @brief Adds a clause of the board before the search, assigning it at level 0
+ * if it has a single literal
+ * @param engine the engine, whose board is found unsat if the clause can't be
+ * satisfied
+ * @param lits the literals of the clause
+ * @param size the number of literals
+ * @return false in case of error, true otherwise
+ */
+static bool add_board_clause(cdcl_engine engine, const uint32_t *lits,
+                             uint32_t size) {
+  if (size == 0) {
+    engine->unsat = true;
+    return true;
+  }
+  if (size == 1) {
+    uint8_t value = lit_value(engine, lits[0]);
+    if (value == VALUE_FALSE)
+      engine->unsat = true;
+    else if (value == VALUE_UNDEF)
+      enqueue(engine, lits[0], NO_CLAUSE);
+    return true;
+  }
+  return add_clause(engine, lits, size, false) != NO_CLAUSE;
+}
+
+/**
+ * @brief Assigns a literal at the current level
+ * @param engine the engine
+ * @param lit the literal made true
+ * @param reason the clause implying it, NO_CLAUSE for a decision
+ */
+static void enqueue(cdcl_engine engine, uint32_t lit, uint32_t reason) {
+  uint32_t var = LIT_VAR(lit);
+  assert(engine->values[var] == VALUE_UNDEF);
+  engine->values[var] = (lit & 1) ? VALUE_FALSE : VALUE_TRUE;
+  engine->levels[var] = engine->level;
+  engine->reasons[var] = reason;
+  engine->trail[engine->trail_size++] = lit;
+}
+
+/**
+ * @brief Finds the root of the component of a cell, without compressing paths
+ * so that merges can be undone
+ * @param engine the engine
+ * @param cell the cell
+ * @return the root of its component
+ */
+static uint32_t find_root(cdcl_engine engine, uint32_t cell) {
+  while (engine->parent[cell] != cell) cell = engine->parent[cell];
+  return cell;
+}
+
+/**
+ * @brief Learns a clause whose literals are all false, watching its two
+ * literals of highest level
+ * @param engine the engine
+ * @param lits the literals of the clause, reordered
+ * @param size the number of literals
+ * @return the index of the clause, NO_CLAUSE in case of error
+ */
+static uint32_t add_conflict(cdcl_engine engine, uint32_t *lits,
+                             uint32_t size) {
+  for (uint32_t watched = 0; watched < 2 && watched < size; watched++) {
+    uint32_t best = watched;
+    for (uint32_t i = watched + 1; i < size; i++) {
+      if (engine->levels[LIT_VAR(lits[i])] >
+          engine->levels[LIT_VAR(lits[best])])
+        best = i;
+    }
+    uint32_t lit = lits[watched];
+    lits[watched] = lits[best];
+    lits[best] = lit;
+  }
+  return add_clause(engine, lits, size, true);
+}
+
+/**
+ * @brief Builds the clause forbidding the loop closed by an edge: the edge and
+ * a path of connected edges between its cells can't be all connected
+ * @param engine the engine
+ * @param edge the connected edge whose cells were already in one component
+ * @return the index of the clause, NO_CLAUSE in case of error
+ */
+static uint32_t loop_conflict(cdcl_engine engine, uint32_t edge) {
+  uint32_t from = engine->edge_cells[edge][0];
+  uint32_t to = engine->edge_cells[edge][1];
+  engine->mark++;
+  engine->marks[from] = engine->mark;
+  engine->cells[0] = from;
+  uint32_t head = 0;
+  uint32_t tail = 1;
+  while (head < tail && engine->marks[to] != engine->mark) {
+    uint32_t cell = engine->cells[head++];
+    for (direction dir = N; dir < NB_DIR; dir++) {
+      uint32_t next_edge = engine->cell_edges[cell][dir];
+      if (next_edge == NO_EDGE || next_edge == edge ||
+          engine->values[next_edge] != VALUE_TRUE)
+        continue;
+      uint32_t next = engine->edge_cells[next_edge][0] == cell
+                          ? engine->edge_cells[next_edge][1]
+                          : engine->edge_cells[next_edge][0];
+      if (engine->marks[next] == engine->mark) continue;
+      engine->marks[next] = engine->mark;
+      engine->via[next] = next_edge;
+      engine->cells[tail++] = next;
+    }
+  }
+  assert(engine->marks[to] == engine->mark);
+
+  uint32_t size = 0;
+  engine->buffer[size++] = MAKE_LIT(edge, true);
+  for (uint32_t cell = to; cell != from;) {
+    uint32_t path_edge = engine->via[cell];
+    engine->buffer[size++] = MAKE_LIT(path_edge, true);
+    cell = engine->edge_cells[path_edge][0] == cell
+               ? engine->edge_cells[path_edge][1]
+               : engine->edge_cells[path_edge][0];
+  }
+  return add_conflict(engine, engine->buffer, size);
+}
+
+/**
+ * @brief Builds the clause forbidding a component that can't grow and doesn't
+ * span the board: one of the edges leaving it must be connected
+ * @param engine the engine
+ * @param root the root of the closed component
+ * @param trigger the false literal of the edge that closed the component, added
+ * so that the clause has a literal of the current level
+ * @return the index of the clause, NO_CLAUSE in case of error
+ */
+static uint32_t closed_conflict(cdcl_engine engine, uint32_t root,
+                                uint32_t trigger) {
+  // Every edge of a closed component is propagated, so its connected edges
+  // don't lead out of it
+  engine->mark++;
+  engine->marks[root] = engine->mark;
+  engine->cells[0] = root;
+  uint32_t tail = 1;
+  for (uint32_t head = 0; head < tail; head++) {
+    uint32_t cell = engine->cells[head];
+    for (direction dir = N; dir < NB_DIR; dir++) {
+      uint32_t edge = engine->cell_edges[cell][dir];
+      if (edge == NO_EDGE || engine->values[edge] != VALUE_TRUE) continue;
+      uint32_t next = engine->edge_cells[edge][0] == cell
+                          ? engine->edge_cells[edge][1]
+                          : engine->edge_cells[edge][0];
+      if (engine->marks[next] == engine->mark) continue;
+      engine->marks[next] = engine->mark;
+      engine->cells[tail++] = next;
+    }
+  }
+
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < tail; i++) {
+    uint32_t cell = engine->cells[i];
+    for (direction dir = N; dir < NB_DIR; dir++) {
+      uint32_t edge = engine->cell_edges[cell][dir];
+      if (edge == NO_EDGE) continue;
+      uint32_t next = engine->edge_cells[edge][0] == cell
+                          ? engine->edge_cells[edge][1]
+                          : engine->edge_cells[edge][0];
+      if (engine->marks[next] != engine->mark)
+        engine->buffer[size++] = MAKE_LIT(edge, false);
+    }
+  }
+  // A disconnected trigger leaving the component is in the clause already
+  uint32_t *ends = engine->edge_cells[LIT_VAR(trigger)];
+  if ((trigger & 1) || (engine->marks[ends[0]] == engine->mark &&
+                        engine->marks[ends[1]] == engine->mark))
+    engine->buffer[size++] = trigger;
+  return add_conflict(engine, engine->buffer, size);
+}
+
+/**
+ * @brief Updates the connection union-find with a propagated edge
+ * @param engine the engine
+ * @param edge the edge
+ * @param connected whether the edge is connected
+ * @return the index of a clause violated by the connections, NO_CLAUSE if
+ * there is none or in case of error
+ */
+static uint32_t assign_edge(cdcl_engine engine, uint32_t edge,
+                            bool connected) {
+  uint32_t root_a = find_root(engine, engine->edge_cells[edge][0]);
+  uint32_t root_b = find_root(engine, engine->edge_cells[edge][1]);
+  edge_undo *undo = &engine->undo[edge];
+  undo->root_a = root_a;
+  undo->root_b = root_b;
+  undo->open_a = engine->nb_open[root_a];
+  undo->open_b = engine->nb_open[root_b];
+  undo->child = NO_VAR;
+  engine->nb_open[root_a]--;
+  engine->nb_open[root_b]--;
+
+  uint32_t nb_cells = engine->nb_cells;
+  if (connected) {
+    if (root_a == root_b) return loop_conflict(engine, edge);
+    if (engine->size[root_a] < engine->size[root_b]) {
+      uint32_t root = root_a;
+      root_a = root_b;
+      root_b = root;
+    }
+    engine->parent[root_b] = root_a;
+    engine->size[root_a] += engine->size[root_b];
+    engine->nb_open[root_a] += engine->nb_open[root_b];
+    undo->child = root_b;
+    if (engine->nb_open[root_a] == 0 && engine->size[root_a] < nb_cells)
+      return closed_conflict(engine, root_a, MAKE_LIT(edge, true));
+  } else {
+    if (engine->nb_open[root_a] == 0 && engine->size[root_a] < nb_cells)
+      return closed_conflict(engine, root_a, MAKE_LIT(edge, false));
+    if (engine->nb_open[root_b] == 0 && engine->size[root_b] < nb_cells)
+      return closed_conflict(engine, root_b, MAKE_LIT(edge, false));
+  }
+  return NO_CLAUSE;
+}
+
+/**
+ * @brief Undoes the change an edge made to the connection union-find, edges
+ * being undone in the reverse order
+ * @param engine the engine
+ * @param edge the edge
+ */
+static void unassign_edge(cdcl_engine engine, uint32_t edge) {
+  edge_undo *undo = &engine->undo[edge];
+  if (undo->child != NO_VAR) {
+    uint32_t child = undo->child;
+    uint32_t root = engine->parent[child];
+    engine->size[root] -= engine->size[child];
+    engine->parent[child] = child;
+  }
+  engine->nb_open[undo->root_a] = undo->open_a;
+  engine->nb_open[undo->root_b] = undo->open_b;
+}
+
+/**
+ * @brief Propagates the literals of the trail not propagated yet through the
+ * clauses and the connections
+ * @param engine the engine, whose error flag is set in case of error
+ * @return the index of a clause whose literals are all false, NO_CLAUSE if
+ * there is none
+ */
+static uint32_t propagate(cdcl_engine engine) {
+  while (engine->queue_head < engine->trail_size) {
+    uint32_t lit = engine->trail[engine->queue_head++];
+    engine->nb_propagations++;
+    if (LIT_VAR(lit) < engine->nb_edges) {
+      uint32_t conflict = assign_edge(engine, LIT_VAR(lit), !(lit & 1));
+      if (conflict != NO_CLAUSE || engine->error) return conflict;
+    }
+
+    uint32_t false_lit = NEG_LIT(lit);
+    watch_list *list = &engine->watches[false_lit];
+    uint32_t kept = 0;
+    uint32_t i = 0;
+    while (i < list->size) {
+      uint32_t index = list->clauses[i++];
+      uint32_t *lits = engine->lits + engine->clauses[index].start;
+      uint32_t size = engine->clauses[index].size;
+      if (lits[0] == false_lit) {
+        lits[0] = lits[1];
+        lits[1] = false_lit;
+      }
+      if (lit_value(engine, lits[0]) == VALUE_TRUE) {
+        list->clauses[kept++] = index;
+        continue;
+      }
+
+      // Look for another literal to watch
+      bool moved = false;
+      for (uint32_t k = 2; k < size && !moved; k++) {
+        if (lit_value(engine, lits[k]) == VALUE_FALSE) continue;
+        lits[1] = lits[k];
+        lits[k] = false_lit;
+        if (!add_watch(engine, lits[1], index)) engine->error = true;
+        moved = true;
+      }
+      if (moved) continue;
+
+      list->clauses[kept++] = index;
+      if (lit_value(engine, lits[0]) == VALUE_FALSE) {
+        while (i < list->size) list->clauses[kept++] = list->clauses[i++];
+        list->size = kept;
+        return index;
+      }
+      enqueue(engine, lits[0], index);
+    }
+    list->size = kept;
+    if (engine->error) return NO_CLAUSE;
+  }
+  return NO_CLAUSE;
+}
+
+/**
+ * @brief Moves a variable of the heap up to its place
+ * @param engine the engine
+ * @param index the index of the variable in the heap
+ */
+static void heap_up(cdcl_engine engine, uint32_t index) {
+  uint32_t var = engine->heap[index];
+  while (index > 0) {
+    uint32_t parent = (index - 1) / 2;
+    if (engine->activity[engine->heap[parent]] >= engine->activity[var]) break;
+    engine->heap[index] = engine->heap[parent];
+    engine->heap_index[engine->heap[index]] = index;
+    index = parent;
+  }
+  engine->heap[index] = var;
+  engine->heap_index[var] = index;
+}
+
+/**
+ * @brief Moves a variable of the heap down to its place
+ * @param engine the engine
+ * @param index the index of the variable in the heap
+ */
+static void heap_down(cdcl_engine engine, uint32_t index) {
+  uint32_t var = engine->heap[index];
+  while (2 * index + 1 < engine->heap_size) {
+    uint32_t child = 2 * index + 1;
+    if (child + 1 < engine->heap_size &&
+        engine->activity[engine->heap[child + 1]] >
+            engine->activity[engine->heap[child]])
+      child++;
+    if (engine->activity[engine->heap[child]] <= engine->activity[var]) break;
+    engine->heap[index] = engine->heap[child];
+    engine->heap_index[engine->heap[index]] = index;
+    index = child;
+  }
+  engine->heap[index] = var;
+  engine->heap_index[var] = index;
+}
+
+/**
+ * @brief Inserts a variable in the heap if it isn't in it
+ * @param engine the engine
+ * @param var the variable
+ */
+static void heap_insert(cdcl_engine engine, uint32_t var) {
+  if (engine->heap_index[var] != NO_VAR) return;
+  engine->heap[engine->heap_size] = var;
+  engine->heap_index[var] = engine->heap_size;
+  heap_up(engine, engine->heap_size++);
+}
+
+/**
+ * @brief Removes the variable of highest activity from the heap
+ * @param engine the engine, whose heap isn't empty
+ * @return the variable
+ */
+static uint32_t heap_pop(cdcl_engine engine) {
+  uint32_t var = engine->heap[0];
+  engine->heap_index[var] = NO_VAR;
+  engine->heap_size--;
+  if (engine->heap_size > 0) {
+    engine->heap[0] = engine->heap[engine->heap_size];
+    engine->heap_index[engine->heap[0]] = 0;
+    heap_down(engine, 0);
+  }
+  return var;
+}
+
+/**
+ * @brief Raises the activity of a variable taking part in a conflict
+ * @param engine the engine
+ * @param var the variable
+ */
+static void bump_var(cdcl_engine engine, uint32_t var) {
+  engine->activity[var] += engine->var_increment;
+  if (engine->activity[var] > VAR_ACTIVITY_LIMIT) {
+    for (uint32_t other = 0; other < engine->nb_vars; other++)
+      engine->activity[other] /= VAR_ACTIVITY_LIMIT;
+    engine->var_increment /= VAR_ACTIVITY_LIMIT;
+  }
+  if (engine->heap_index[var] != NO_VAR)
+    heap_up(engine, engine->heap_index[var]);
+}
+
+/**
+ * @brief Raises the activity of a learnt clause taking part in a conflict
+ * @param engine the engine
+ * @param index the clause
+ */
+static void bump_clause(cdcl_engine engine, uint32_t index) {
+  engine->clauses[index].activity += engine->clause_increment;
+  if (engine->clauses[index].activity > CLAUSE_ACTIVITY_LIMIT) {
+    for (uint32_t other = 0; other < engine->nb_clauses; other++)
+      engine->clauses[other].activity /= CLAUSE_ACTIVITY_LIMIT;
+    engine->clause_increment /= CLAUSE_ACTIVITY_LIMIT;
+  }
+}
+
+/**
+ * @brief Unassigns every variable above a decision level
+ * @param engine the engine
+ * @param level the level to go back to
+ */
+static void cancel_until(cdcl_engine engine, uint32_t level) {
+  if (engine->level <= level) return;
+  uint32_t start = engine->level_starts[level];
+  for (uint32_t i = engine->trail_size; i-- > start;) {
+    uint32_t var = LIT_VAR(engine->trail[i]);
+    if (var < engine->nb_edges) {
+      if (i < engine->queue_head) unassign_edge(engine, var);
+    } else {
+      heap_insert(engine, var);
+    }
+    engine->values[var] = VALUE_UNDEF;
+    engine->reasons[var] = NO_CLAUSE;
+  }
+  engine->trail_size = start;
+  engine->queue_head = start;
+  engine->level = level;
+}
+
+/**
+ * @brief Analyses a conflict to learn the clause made of the first literal of
+ * the current level implying it and of the literals of lower levels involved
+ * @param engine the engine, at a level above 0
+ * @param conflict the clause whose literals are all false
+ * @param backjump_level where the level at which the learnt clause asserts its
+ * first literal is written
+ * @return the size of the learnt clause, written in the buffer with the
+ * asserted literal first and a literal of the backjump level second
+ */
+static uint32_t analyze(cdcl_engine engine, uint32_t conflict,
+                        uint32_t *backjump_level) {
+  uint32_t size = 1;  // The asserted literal is written last
+  uint32_t nb_pending = 0;
+  uint32_t index = engine->trail_size;
+  uint32_t lit = 0;
+  bool first = true;
+  do {
+    assert(conflict != NO_CLAUSE);
+    if (engine->clauses[conflict].learnt) bump_clause(engine, conflict);
+    const uint32_t *lits = engine->lits + engine->clauses[conflict].start;
+    uint32_t clause_size = engine->clauses[conflict].size;
+    // The first literal of a reason is the one it implied
+    for (uint32_t k = first ? 0 : 1; k < clause_size; k++) {
+      uint32_t var = LIT_VAR(lits[k]);
+      if (engine->seen[var] || engine->levels[var] == 0) continue;
+      engine->seen[var] = true;
+      bump_var(engine, var);
+      if (engine->levels[var] >= engine->level)
+        nb_pending++;
+      else
+        engine->buffer[size++] = lits[k];
+    }
+    first = false;
+
+    do {
+      index--;
+    } while (!engine->seen[LIT_VAR(engine->trail[index])]);
+    lit = engine->trail[index];
+    conflict = engine->reasons[LIT_VAR(lit)];
+    engine->seen[LIT_VAR(lit)] = false;
+    nb_pending--;
+  } while (nb_pending > 0);
+  engine->buffer[0] = NEG_LIT(lit);
+
+  *backjump_level = 0;
+  for (uint32_t i = 1; i < size; i++) {
+    uint32_t var = LIT_VAR(engine->buffer[i]);
+    engine->seen[var] = false;
+    if (engine->levels[var] > *backjump_level) {
+      *backjump_level = engine->levels[var];
+      uint32_t other = engine->buffer[1];
+      engine->buffer[1] = engine->buffer[i];
+      engine->buffer[i] = other;
+    }
+  }
+  return size;
+}
+
+/**
+ * @brief Adds the clause learnt from a conflict after backjumping and asserts
+ * its first literal
+ * @param engine the engine, at the backjump level of the clause
+ * @param size the size of the clause in the buffer
+ * @return false in case of error, true otherwise
+ */
+static bool learn(cdcl_engine engine, uint32_t size) {
+  if (size == 1) {
+    enqueue(engine, engine->buffer[0], NO_CLAUSE);
+    return true;
+  }
+  uint32_t index = add_clause(engine, engine->buffer, size, true);
+  if (index == NO_CLAUSE) return false;
+  bump_clause(engine, index);
+  enqueue(engine, engine->buffer[0], index);
+  return true;
+}
+
+/**
+ * @brief Adds the clause forbidding the decisions leading to the current
+ * solution, so the search goes on with the other ones
+ * @param engine the engine, at a level above 0
+ * @return the index of the clause, whose literals are all false, NO_CLAUSE in
+ * case of error
+ */
+static uint32_t block_solution(cdcl_engine engine) {
+  uint32_t size = 0;
+  for (uint32_t level = engine->level; level > 0; level--)
+    engine->buffer[size++] =
+        NEG_LIT(engine->trail[engine->level_starts[level - 1]]);
+  return add_clause(engine, engine->buffer, size, false);
+}
+
+/**
+ * @brief Compares two clause activities for qsort
+ */
+static int compare_activity(const void *a, const void *b) {
+  double activity_a = *(const double *)a;
+  double activity_b = *(const double *)b;
+  return (activity_a > activity_b) - (activity_a < activity_b);
+}
+
+/**
+ * @brief Deletes the least active half of the learnt clauses but the binary
+ * ones, and packs the remaining clauses
+ * @param engine the engine, at level 0 with every literal propagated
+ * @return false in case of error, true otherwise
+ */
+static bool reduce_learnts(cdcl_engine engine) {
+  assert(engine->level == 0 && engine->queue_head == engine->trail_size);
+  double *activities = (double *)malloc(engine->nb_learnts * sizeof(double));
+  if (!activities) return false;
+  uint32_t nb_learnts = 0;
+  for (uint32_t index = 0; index < engine->nb_clauses; index++) {
+    if (engine->clauses[index].learnt)
+      activities[nb_learnts++] = engine->clauses[index].activity;
+  }
+  qsort(activities, nb_learnts, sizeof(double), compare_activity);
+  double median = activities[nb_learnts / 2];
+  free(activities);
+
+  uint32_t nb_deleted = 0;
+  uint32_t nb_clauses = 0;
+  uint32_t nb_lits = 0;
+  for (uint32_t index = 0; index < engine->nb_clauses; index++) {
+    clause kept = engine->clauses[index];
+    if (kept.learnt && kept.size > 2 && kept.activity <= median &&
+        nb_deleted < nb_learnts / 2) {
+      nb_deleted++;
+      continue;
+    }
+    memmove(engine->lits + nb_lits, engine->lits + kept.start,
+            kept.size * sizeof(uint32_t));
+    kept.start = nb_lits;
+    nb_lits += kept.size;
+    engine->clauses[nb_clauses++] = kept;
+  }
+  engine->nb_clauses = nb_clauses;
+  engine->nb_lits = nb_lits;
+  engine->nb_learnts -= nb_deleted;
+  engine->max_learnts *= LEARNTS_GROWTH;
+
+  // Level 0 is never analysed, so its reasons can be forgotten
+  for (uint32_t i = 0; i < engine->trail_size; i++)
+    engine->reasons[LIT_VAR(engine->trail[i])] = NO_CLAUSE;
+  for (uint32_t lit = 0; lit < 2 * engine->nb_vars; lit++)
+    engine->watches[lit].size = 0;
+  for (uint32_t index = 0; index < nb_clauses; index++) {
+    const uint32_t *lits = engine->lits + engine->clauses[index].start;
+    if (engine->clauses[index].size >= 2 &&
+        (!add_watch(engine, lits[0], index) ||
+         !add_watch(engine, lits[1], index)))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Gets a term of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... which
+ * scales the intervals between restarts
+ * @param index the index of the term, from 0
+ * @return the term
+ */
+static uint32_t luby(uint32_t index) {
+  uint32_t size = 1;
+  uint32_t exponent = 0;
+  while (size < index + 1) {
+    exponent++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != index) {
+    size = (size - 1) / 2;
+    exponent--;
+    index %= size;
+  }
+  return exponent < 20 ? (uint32_t)1 << exponent : (uint32_t)1 << 20;
+}
+
+/**
+ * @brief Chooses the unassigned orientation of highest activity, it is decided
+ * true
+ * @param engine the engine
+ * @return the variable of the orientation, NO_VAR if every one is assigned
+ */
+static uint32_t choose_branching_var(cdcl_engine engine) {
+  while (engine->heap_size > 0) {
+    uint32_t var = heap_pop(engine);
+    if (engine->values[var] == VALUE_UNDEF) return var;
+  }
+  return NO_VAR;
+}
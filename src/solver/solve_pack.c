@@ -0,0 +1,487 @@
+#include "solve_pack.h"
+
+#include <stdlib.h>
+
+#define PACK_MAGIC "NETSOLPK"
+#define PACK_VERSION 1
+#define FULL_RECORD 0   // Tag of a solution stored with 2 bits per cell
+#define MAX_VARINT 10   // Bytes of the longest varint of 64 bits
+#define INITIAL_BLOCKS 64
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for the beginning of a pack, it is followed by the piece
+ * and the direction of every cell of the board, then by the solutions and by
+ * the offset of each block of solutions
+ */
+typedef struct pack_header_s {
+  char magic[8];         /**< PACK_MAGIC, without its terminating 0 */
+  uint32_t version;      /**< PACK_VERSION */
+  uint32_t block_size;   /**< number of solutions in a block */
+  uint16_t width;        /**< width of the board */
+  uint16_t height;       /**< height of the board */
+  uint8_t wrapping;      /**< whether the board wraps around its edges */
+  uint8_t padding[3];    /**< unused */
+  uint64_t nb_solutions; /**< number of solutions in the pack */
+  uint64_t index_offset; /**< position of the offsets of the blocks, 0 while
+                            the pack is written */
+} pack_header;
+
+/**
+ * @brief Structure for a pack being written
+ */
+struct pack_writer_s {
+  FILE *file;              /**< the file of the pack */
+  pack_header header;      /**< the header, written again when closing */
+  size_t nb_cells;         /**< number of cells of the board */
+  direction *previous;     /**< the last solution added */
+  direction *current;      /**< the solution being added */
+  uint8_t *record;         /**< buffer of the record being added */
+  size_t full_size;        /**< bytes of a solution stored in full */
+  uint64_t *blocks;        /**< offset of each block of solutions */
+  uint64_t capacity;       /**< number of offsets blocks can hold */
+  bool failed;             /**< whether a write failed */
+};
+
+/**
+ * @brief Structure for a pack being read
+ */
+struct pack_reader_s {
+  FILE *file;          /**< the file of the pack */
+  pack_header header;  /**< the header of the pack */
+  size_t nb_cells;     /**< number of cells of the board */
+  game board;          /**< the board of the pack */
+  uint64_t *blocks;    /**< offset of each block of solutions */
+  uint64_t nb_blocks;  /**< number of blocks */
+  direction *current;  /**< the last solution decoded */
+  uint64_t next;       /**< index of the solution the file is positioned at */
+  uint8_t *record;     /**< buffer of a solution stored in full */
+  size_t full_size;    /**< bytes of a solution stored in full */
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static size_t write_varint(uint8_t *buffer, uint64_t value);
+static bool read_varint(FILE *file, uint64_t *value);
+static size_t encode_record(pack_writer writer, bool full);
+static bool decode_record(pack_reader reader);
+static void free_writer(pack_writer writer);
+
+//--------------------------------------------------------------------------------------
+//                                Pack functions bodies
+
+pack_writer pack_create(const char *path, cgame board) {
+  if (!path || !board) {
+    FPRINTF(stderr, "Error: pack_create, path or game pointer is NULL.\n");
+    return NULL;
+  }
+  pack_writer writer = (pack_writer)calloc(1, sizeof(struct pack_writer_s));
+  if (!writer) {
+    FPRINTF(stderr, "Error: pack_create, can't allocate the pack.\n");
+    return NULL;
+  }
+  memcpy(writer->header.magic, PACK_MAGIC, sizeof(writer->header.magic));
+  writer->header.version = PACK_VERSION;
+  writer->header.block_size = PACK_BLOCK_SIZE;
+  writer->header.width = game_width(board);
+  writer->header.height = game_height(board);
+  writer->header.wrapping = is_wrapping(board);
+  writer->nb_cells = (size_t)writer->header.width * writer->header.height;
+  writer->full_size = (writer->nb_cells + 3) / 4;
+  writer->capacity = INITIAL_BLOCKS;
+  size_t nb_cells = writer->nb_cells;
+  piece *pieces = (piece *)malloc(nb_cells * sizeof(piece));
+  writer->previous = (direction *)malloc(nb_cells * sizeof(direction));
+  writer->current = (direction *)malloc(nb_cells * sizeof(direction));
+  // A record never outgrows a full solution, its tag included
+  writer->record = (uint8_t *)malloc(writer->full_size + 2 * MAX_VARINT);
+  writer->blocks = (uint64_t *)malloc(writer->capacity * sizeof(uint64_t));
+  if (!pieces || !writer->previous || !writer->current || !writer->record ||
+      !writer->blocks) {
+    FPRINTF(stderr, "Error: pack_create, can't allocate the pack.\n");
+    free(pieces);
+    free_writer(writer);
+    return NULL;
+  }
+
+  FOPEN(writer->file, path, "w+b");
+  if (!writer->file) {
+    FPRINTF(stderr, "Error: pack_create, couldn't create %s.\n", path);
+    free(pieces);
+    free_writer(writer);
+    return NULL;
+  }
+  get_cells(board, pieces, writer->previous);
+  bool status =
+      fwrite(&writer->header, sizeof(pack_header), 1, writer->file) == 1;
+  for (size_t i = 0; status && i < nb_cells; i++) {
+    status = fputc((int8_t)pieces[i], writer->file) != EOF &&
+             fputc((uint8_t)writer->previous[i], writer->file) != EOF;
+  }
+  free(pieces);
+  if (!status) {
+    FPRINTF(stderr, "Error: pack_create, couldn't write %s.\n", path);
+    FCLOSE(writer->file);
+    free_writer(writer);
+    return NULL;
+  }
+  return writer;
+}
+
+bool pack_add(pack_writer writer, cgame solution) {
+  if (!writer || !solution) {
+    FPRINTF(stderr, "Error: pack_add, pack or game pointer is NULL.\n");
+    return false;
+  }
+  if (game_width(solution) != writer->header.width ||
+      game_height(solution) != writer->header.height) {
+    FPRINTF(stderr, "Error: pack_add, the solution doesn't fit the pack.\n");
+    return false;
+  }
+  if (writer->failed) return false;
+  get_cells(solution, NULL, writer->current);
+
+  // The first solution of a block starts it again from scratch
+  uint64_t index = writer->header.nb_solutions;
+  bool full = index % writer->header.block_size == 0;
+  if (full) {
+    uint64_t block = index / writer->header.block_size;
+    if (block == writer->capacity) {
+      uint64_t *blocks = (uint64_t *)realloc(
+          writer->blocks, 2 * writer->capacity * sizeof(uint64_t));
+      if (!blocks) {
+        FPRINTF(stderr, "Error: pack_add, can't allocate the index.\n");
+        writer->failed = true;
+        return false;
+      }
+      writer->blocks = blocks;
+      writer->capacity *= 2;
+    }
+    int64_t offset = FTELL64(writer->file);
+    if (offset < 0) {
+      writer->failed = true;
+      return false;
+    }
+    writer->blocks[block] = (uint64_t)offset;
+  }
+  size_t size = encode_record(writer, full);
+  if (fwrite(writer->record, 1, size, writer->file) != size) {
+    FPRINTF(stderr, "Error: pack_add, couldn't write the solution.\n");
+    writer->failed = true;
+    return false;
+  }
+  direction *swap = writer->previous;
+  writer->previous = writer->current;
+  writer->current = swap;
+  writer->header.nb_solutions++;
+  return true;
+}
+
+bool pack_finish(pack_writer writer) {
+  if (!writer) {
+    FPRINTF(stderr, "Error: pack_finish, pack pointer is NULL.\n");
+    return false;
+  }
+  uint64_t nb_blocks =
+      (writer->header.nb_solutions + writer->header.block_size - 1) /
+      writer->header.block_size;
+  int64_t offset = FTELL64(writer->file);
+  bool status = !writer->failed && offset >= 0;
+  if (status) {
+    writer->header.index_offset = (uint64_t)offset;
+    status = fwrite(writer->blocks, sizeof(uint64_t), nb_blocks,
+                    writer->file) == nb_blocks &&
+             FSEEK64(writer->file, 0, SEEK_SET) == 0 &&
+             fwrite(&writer->header, sizeof(pack_header), 1, writer->file) ==
+                 1;
+  }
+  if (FCLOSE(writer->file) != 0) status = false;
+  if (!status)
+    FPRINTF(stderr, "Error: pack_finish, couldn't write the pack.\n");
+  free_writer(writer);
+  return status;
+}
+
+pack_reader pack_open(const char *path) {
+  if (!path) {
+    FPRINTF(stderr, "Error: pack_open, path pointer is NULL.\n");
+    return NULL;
+  }
+  pack_reader reader = (pack_reader)calloc(1, sizeof(struct pack_reader_s));
+  if (!reader) {
+    FPRINTF(stderr, "Error: pack_open, can't allocate the pack.\n");
+    return NULL;
+  }
+  FOPEN(reader->file, path, "rb");
+  bool status = reader->file != NULL &&
+                fread(&reader->header, sizeof(pack_header), 1,
+                      reader->file) == 1 &&
+                memcmp(reader->header.magic, PACK_MAGIC,
+                       sizeof(reader->header.magic)) == 0 &&
+                reader->header.version == PACK_VERSION &&
+                reader->header.block_size > 0 &&
+                reader->header.index_offset > 0 &&
+                reader->header.index_offset <= INT64_MAX;
+  piece *pieces = NULL;
+  if (status) {
+    reader->nb_cells = (size_t)reader->header.width * reader->header.height;
+    reader->full_size = (reader->nb_cells + 3) / 4;
+    reader->nb_blocks =
+        (reader->header.nb_solutions + reader->header.block_size - 1) /
+        reader->header.block_size;
+    pieces = (piece *)malloc(reader->nb_cells * sizeof(piece));
+    reader->current = (direction *)malloc(reader->nb_cells * sizeof(direction));
+    reader->record = (uint8_t *)malloc(reader->full_size);
+    reader->blocks = (uint64_t *)malloc(
+        (reader->nb_blocks ? reader->nb_blocks : 1) * sizeof(uint64_t));
+    status = pieces && reader->current && reader->record && reader->blocks;
+  }
+  for (size_t i = 0; status && i < reader->nb_cells; i++) {
+    int cell_piece = fgetc(reader->file);
+    int cell_dir = fgetc(reader->file);
+    status = cell_piece != EOF && (int8_t)cell_piece >= EMPTY &&
+             (int8_t)cell_piece < NB_PIECE_TYPE && cell_dir != EOF &&
+             cell_dir < NB_DIR;
+    if (status) {
+      pieces[i] = (piece)(int8_t)cell_piece;
+      reader->current[i] = (direction)cell_dir;
+    }
+  }
+  if (status) {
+    reader->board =
+        new_game_ext(reader->header.width, reader->header.height, pieces,
+                     reader->current, reader->header.wrapping);
+    status = reader->board &&
+             FSEEK64(reader->file, (int64_t)reader->header.index_offset,
+                     SEEK_SET) == 0 &&
+             fread(reader->blocks, sizeof(uint64_t), reader->nb_blocks,
+                   reader->file) == reader->nb_blocks;
+  }
+  free(pieces);
+  if (!status) {
+    FPRINTF(stderr, "Error: pack_open, couldn't read the pack %s.\n", path);
+    pack_close(reader);
+    return NULL;
+  }
+  // The next read seeks its block
+  reader->next = UINT64_MAX;
+  return reader;
+}
+
+cgame pack_get_board(pack_reader reader) {
+  if (!reader) {
+    FPRINTF(stderr, "Error: pack_get_board, pack pointer is NULL.\n");
+    return NULL;
+  }
+  return reader->board;
+}
+
+uint64_t pack_nb_solutions(pack_reader reader) {
+  if (!reader) {
+    FPRINTF(stderr, "Error: pack_nb_solutions, pack pointer is NULL.\n");
+    return 0;
+  }
+  return reader->header.nb_solutions;
+}
+
+bool pack_read(pack_reader reader, uint64_t index, direction *orientations) {
+  if (!reader || !orientations) {
+    FPRINTF(stderr,
+            "Error: pack_read, pack or orientations pointer is NULL.\n");
+    return false;
+  }
+  if (index >= reader->header.nb_solutions) {
+    FPRINTF(stderr, "Error: pack_read, solution %llu is out of the pack.\n",
+            (unsigned long long)index);
+    return false;
+  }
+  // A solution behind the file position, or in a later block, is decoded from
+  // the start of its block
+  uint64_t block = index / reader->header.block_size;
+  if (index < reader->next ||
+      block > reader->next / reader->header.block_size) {
+    if (reader->blocks[block] > INT64_MAX ||
+        FSEEK64(reader->file, (int64_t)reader->blocks[block], SEEK_SET) != 0) {
+      reader->next = UINT64_MAX;
+      return false;
+    }
+    reader->next = block * reader->header.block_size;
+  }
+  while (reader->next <= index) {
+    if (!decode_record(reader)) {
+      FPRINTF(stderr, "Error: pack_read, solution %llu is corrupted.\n",
+              (unsigned long long)reader->next);
+      reader->next = UINT64_MAX;
+      return false;
+    }
+    reader->next++;
+  }
+  memcpy(orientations, reader->current, reader->nb_cells * sizeof(direction));
+  return true;
+}
+
+bool pack_load(pack_reader reader, uint64_t index, game board) {
+  if (!reader || !board) {
+    FPRINTF(stderr, "Error: pack_load, pack or game pointer is NULL.\n");
+    return false;
+  }
+  if (game_width(board) != reader->header.width ||
+      game_height(board) != reader->header.height) {
+    FPRINTF(stderr, "Error: pack_load, the board doesn't fit the pack.\n");
+    return false;
+  }
+  direction *orientations =
+      (direction *)malloc(reader->nb_cells * sizeof(direction));
+  if (!orientations) {
+    FPRINTF(stderr, "Error: pack_load, can't allocate the solution.\n");
+    return false;
+  }
+  bool status = pack_read(reader, index, orientations);
+  if (status) set_current_directions(board, orientations);
+  free(orientations);
+  return status;
+}
+
+void pack_close(pack_reader reader) {
+  if (!reader) {
+    FPRINTF(stderr, "Error: pack_close, pack pointer is NULL.\n");
+    return;
+  }
+  if (reader->file) FCLOSE(reader->file);
+  if (reader->board) delete_game(reader->board);
+  free(reader->blocks);
+  free(reader->current);
+  free(reader->record);
+  free(reader);
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Writes a number with 7 bits per byte, the last byte having its high
+ * bit cleared
+ *
+ * @param buffer, where the bytes are written, it must hold MAX_VARINT bytes
+ * @param value, the number to write
+ * @return the number of bytes written
+ */
+static size_t write_varint(uint8_t *buffer, uint64_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  buffer[size++] = (uint8_t)value;
+  return size;
+}
+
+/**
+ * @brief Reads a number written by write_varint
+ *
+ * @param file, the file positioned at the number
+ * @param value, where the number is written
+ * @return false if the number couldn't be read, true otherwise
+ */
+static bool read_varint(FILE *file, uint64_t *value) {
+  *value = 0;
+  for (uint32_t shift = 0; shift < 7 * MAX_VARINT; shift += 7) {
+    int byte = fgetc(file);
+    if (byte == EOF) return false;
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Encodes the solution being added in the record buffer. A solution
+ * stored in full is tagged FULL_RECORD and followed by 2 bits per cell, the
+ * others are tagged with their number of changed cells plus one, each change
+ * giving the number of cells skipped since the previous one and the new
+ * direction
+ *
+ * @param writer, the pack, current holds the solution being added
+ * @param full, whether the solution has to be stored in full
+ * @return the size of the record
+ */
+static size_t encode_record(pack_writer writer, bool full) {
+  uint8_t *record = writer->record;
+  if (!full) {
+    // The changes are written after room for their tag, and given up as soon
+    // as they outgrow a solution stored in full
+    uint8_t *changes = record + MAX_VARINT;
+    size_t size = 0;
+    uint64_t nb_changes = 0;
+    size_t last = 0;
+    for (size_t cell = 0; cell < writer->nb_cells && !full; cell++) {
+      if (writer->current[cell] == writer->previous[cell]) continue;
+      uint64_t skipped = cell - last;
+      size += write_varint(changes + size,
+                           (skipped << 2) | (uint64_t)writer->current[cell]);
+      last = cell + 1;
+      nb_changes++;
+      full = size > writer->full_size;
+    }
+    if (!full) {
+      size_t tag_size = write_varint(record, nb_changes + 1);
+      memmove(record + tag_size, changes, size);
+      return tag_size + size;
+    }
+  }
+  record[0] = FULL_RECORD;
+  memset(record + 1, 0, writer->full_size);
+  for (size_t cell = 0; cell < writer->nb_cells; cell++) {
+    record[1 + cell / 4] |=
+        (uint8_t)((uint8_t)writer->current[cell] << (2 * (cell % 4)));
+  }
+  return 1 + writer->full_size;
+}
+
+/**
+ * @brief Decodes the record the file is positioned at into the current
+ * solution of a pack
+ *
+ * @param reader, the pack, current holds the previous solution unless the
+ * record is stored in full
+ * @return false if the record is corrupted, true otherwise
+ */
+static bool decode_record(pack_reader reader) {
+  uint64_t tag;
+  if (!read_varint(reader->file, &tag)) return false;
+  if (tag == FULL_RECORD) {
+    if (fread(reader->record, 1, reader->full_size, reader->file) !=
+        reader->full_size)
+      return false;
+    for (size_t cell = 0; cell < reader->nb_cells; cell++) {
+      reader->current[cell] =
+          (direction)((reader->record[cell / 4] >> (2 * (cell % 4))) & 3);
+    }
+    return true;
+  }
+  uint64_t cell = 0;
+  for (uint64_t i = 0; i < tag - 1; i++) {
+    uint64_t change;
+    if (!read_varint(reader->file, &change)) return false;
+    cell += change >> 2;
+    if (cell >= reader->nb_cells) return false;
+    reader->current[cell++] = (direction)(change & 3);
+  }
+  return true;
+}
+
+/**
+ * @brief Frees the memory of a pack being written, its file is left alone
+ *
+ * @param writer, the pack
+ */
+static void free_writer(pack_writer writer) {
+  free(writer->previous);
+  free(writer->current);
+  free(writer->record);
+  free(writer->blocks);
+  free(writer);
+}
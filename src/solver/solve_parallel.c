@@ -0,0 +1,960 @@
+#include "solve_parallel.h"
+
+#include "cross_thread.h"
+#include "cross_time.h"
+
+#define CLOCK_NODES 16  // Nodes of a worker between two checks of the budget
+#define COUNT_SLICE 1024  // Nodes of a count between two checks of the budget
+#define COUNT_TASKS 8     // Subproblems of a count per thread, at least
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for a subproblem waiting for a worker
+ */
+typedef struct task_s {
+  uint8_t *domains;     /**< domains of the subproblem */
+  uint8_t *path;        /**< path of the decisions leading to the subproblem */
+  uint32_t path_length; /**< number of orientations in the path */
+} task;
+
+/**
+ * @brief Structure for a solution kept until every worker is done
+ */
+typedef struct found_solution_s {
+  uint8_t *path;            /**< path of the decisions leading to it */
+  uint32_t path_length;     /**< number of orientations in the path */
+  direction *orientations;  /**< the direction of every cell */
+} found_solution;
+
+typedef struct pool_s *pool;
+
+/**
+ * @brief Structure for a worker thread
+ */
+typedef struct worker_s {
+  pool owner;          /**< the pool the worker belongs to */
+  THREAD thread;       /**< the thread running the worker */
+  prop_engine engine;  /**< the engine of the worker */
+  task **deque;        /**< circular deque of the subproblems given away by the
+                          worker, it pops the back and thieves the front */
+  uint32_t deque_head; /**< index of the front of the deque */
+  uint32_t deque_size; /**< number of subproblems in the deque */
+  uint32_t deque_capacity; /**< number of subproblems the deque can hold */
+  uint64_t nb_solutions;   /**< number of solutions found by the worker */
+  uint32_t nb_unchecked;   /**< nodes explored since the budget was checked */
+  uint8_t *path;           /**< scratch path of the current branch */
+  uint8_t *bound_path;     /**< copy of the bound path of the pool */
+  uint32_t bound_length;   /**< length of the copied bound path */
+  long bound_version;      /**< version of the copied bound path */
+} worker;
+
+/**
+ * @brief Structure for the shared state of the workers
+ */
+struct pool_s {
+  MUTEX lock;          /**< protects the deques and the kept solutions */
+  COND wake;           /**< signaled when a subproblem is given away or when
+                          the search is over */
+  worker *workers;     /**< the workers */
+  uint16_t nb_workers; /**< number of workers */
+  uint32_t nb_cells;   /**< number of cells of the board */
+  solver_mode mode;    /**< what the search has to find */
+  ATOMIC_LONG nb_idle;  /**< number of workers waiting for a subproblem */
+  ATOMIC_LONG nb_tasks; /**< number of subproblems in the deques */
+  bool done;            /**< whether every worker ran out of work */
+  ATOMIC_LONG failed;   /**< whether a worker couldn't allocate memory */
+  ATOMIC_LONG stopped;  /**< whether the workers have to stop early */
+  uint64_t max_nodes;        /**< nodes the search may explore, 0 for no
+                                limit */
+  uint32_t max_milliseconds; /**< time the search may take, 0 for no limit */
+  uint64_t start;            /**< when the search started */
+  ATOMIC_LONG nb_nodes;      /**< nodes checked against the budget */
+  ATOMIC_LONG out_of_budget; /**< whether the budget ran out */
+  found_solution *kept; /**< the solutions kept, a heap with the one reached
+                           last on top when their number is limited */
+  uint32_t nb_kept;       /**< number of solutions kept */
+  uint32_t kept_capacity; /**< number of solutions kept can hold */
+  uint32_t max_kept;      /**< number of solutions kept at most, 0 for all */
+  uint64_t kept_bytes;    /**< memory used by the solutions kept */
+  uint64_t max_bytes;     /**< memory the solutions kept may use, 0 for no
+                             limit */
+  bool out_of_memory;     /**< whether the solutions outgrew max_bytes */
+  ATOMIC_LONG bound_version; /**< incremented when the bound changes, 0 while
+                                fewer than max_kept solutions are kept */
+  uint8_t *bound_path;   /**< path of the solution reached last once max_kept
+                            are kept, the branches after it are cut */
+  uint32_t bound_length; /**< length of the bound path */
+};
+
+typedef struct count_pool_s *count_pool;
+
+/**
+ * @brief Structure for a worker thread of a count
+ */
+typedef struct counter_s {
+  count_pool owner;   /**< the pool the counter belongs to */
+  THREAD thread;      /**< the thread running the counter */
+  prop_engine engine; /**< the engine of the counter */
+  sol_count count;    /**< sum of the counts of the subproblems it took */
+} counter;
+
+/**
+ * @brief Structure for the shared state of the counters
+ */
+struct count_pool_s {
+  counter *counters;   /**< the counters */
+  uint16_t nb_counters; /**< number of counters */
+  uint32_t nb_cells;   /**< number of cells of the board */
+  bool big;            /**< whether the counts have arbitrary precision */
+  uint8_t *tasks;      /**< domains of the subproblems, one block of nb_cells
+                          per subproblem */
+  uint32_t nb_tasks;   /**< number of subproblems */
+  ATOMIC_LONG next_task; /**< index of the next subproblem to count */
+  ATOMIC_LONG failed;    /**< whether a count failed */
+  uint64_t max_nodes;    /**< nodes the count may explore, 0 for no limit */
+  uint32_t max_milliseconds; /**< time the count may take, 0 for no limit */
+  uint64_t start;            /**< when the count started */
+  ATOMIC_LONG nb_nodes;      /**< nodes checked against the budget */
+  ATOMIC_LONG out_of_budget; /**< whether the budget ran out */
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static task *create_task(uint32_t nb_cells);
+static void delete_task(task *subproblem);
+static bool push_task(worker *self, task *subproblem);
+static task *pop_task(worker *self, bool front);
+static task *take_task(worker *self);
+static int compare_paths(const uint8_t *path, uint32_t length,
+                         const uint8_t *other_path, uint32_t other_length);
+static int compare_found(const void *solution, const void *other_solution);
+static void sift_down(found_solution *heap, uint32_t size, uint32_t index);
+static void bound_kept(pool shared);
+static bool keep_solution(pool shared, const uint8_t *path, uint32_t length,
+                          const direction *orientations);
+static bool is_before_bound(worker *self, const uint8_t *path,
+                            uint32_t length);
+static bool worker_on_node(prop_engine engine, void *data);
+static bool worker_on_solution(const direction *orientations, void *data);
+static THREAD_FUNCTION(run_worker, arg);
+static bool init_pool(pool shared, cgame board, uint16_t nb_threads,
+                      solver_mode mode, uint32_t max_solutions,
+                      uint64_t max_bytes, uint64_t max_nodes,
+                      uint32_t max_milliseconds);
+static void free_pool(pool shared);
+static void report_solutions(pool shared, prop_solution_callback on_solution,
+                             void *data);
+static bool split_count(count_pool shared, prop_engine engine);
+static uint32_t smallest_domain(const uint8_t *domains, uint32_t nb_cells);
+static THREAD_FUNCTION(run_counter, arg);
+
+//--------------------------------------------------------------------------------------
+//                                Parallel search function body
+
+solver_status parallel_search(cgame board, uint16_t nb_threads,
+                              solver_mode mode, uint32_t max_solutions,
+                              uint64_t max_bytes, uint64_t max_nodes,
+                              uint32_t max_milliseconds,
+                              prop_solution_callback on_solution, void *data,
+                              uint64_t *nb_solutions, solver_stats *stats) {
+  if (!board || !on_solution || !nb_solutions || nb_threads == 0) {
+    FPRINTF(stderr,
+            "Error: parallel_search, game, callback or count pointer is NULL, "
+            "or no thread was requested.\n");
+    return SOLVER_ERROR;
+  }
+
+  struct pool_s shared;
+  if (!init_pool(&shared, board, nb_threads, mode, max_solutions, max_bytes,
+                 max_nodes, max_milliseconds)) {
+    free_pool(&shared);
+    return SOLVER_ERROR;
+  }
+
+  // The whole board is the first subproblem
+  task *root = create_task(shared.nb_cells);
+  if (!root) {
+    free_pool(&shared);
+    return SOLVER_ERROR;
+  }
+  prop_get_domains(shared.workers[0].engine, root->domains);
+  if (!push_task(&shared.workers[0], root)) {
+    delete_task(root);
+    free_pool(&shared);
+    return SOLVER_ERROR;
+  }
+
+  uint16_t nb_started = 0;
+  for (; nb_started < nb_threads; nb_started++) {
+    worker *self = &shared.workers[nb_started];
+    if (!THREAD_CREATE(self->thread, run_worker, self)) {
+      FPRINTF(stderr, "Error: parallel_search, can't start a thread.\n");
+      break;
+    }
+  }
+  if (nb_started < nb_threads) {
+    // The started workers are stopped before everything is freed
+    MUTEX_LOCK(shared.lock);
+    shared.done = true;
+    ATOMIC_STORE(&shared.failed, 1);
+    COND_BROADCAST(shared.wake);
+    MUTEX_UNLOCK(shared.lock);
+  }
+  for (uint16_t i = 0; i < nb_started; i++)
+    THREAD_JOIN(shared.workers[i].thread);
+
+  solver_status status = SOLVER_DONE;
+  if (ATOMIC_LOAD(&shared.failed))
+    status = SOLVER_ERROR;
+  else if (ATOMIC_LOAD(&shared.out_of_budget))
+    status = SOLVER_UNFINISHED;
+  else if (shared.out_of_memory)
+    status = SOLVER_OUT_OF_MEMORY;
+  *nb_solutions = 0;
+  if (status != SOLVER_ERROR && mode == SOLVER_NB_SOL) {
+    for (uint16_t i = 0; i < nb_threads; i++)
+      *nb_solutions += shared.workers[i].nb_solutions;
+  } else if (status != SOLVER_ERROR) {
+    *nb_solutions = shared.nb_kept;
+    report_solutions(&shared, on_solution, data);
+  }
+  if (stats) {
+    stats->nb_nodes = stats->nb_propagations = stats->nb_backtracks = 0;
+    for (uint16_t i = 0; i < nb_threads; i++) {
+      solver_stats worker_stats;
+      prop_get_stats(shared.workers[i].engine, &worker_stats);
+      stats->nb_nodes += worker_stats.nb_nodes;
+      stats->nb_propagations += worker_stats.nb_propagations;
+      stats->nb_backtracks += worker_stats.nb_backtracks;
+    }
+  }
+  free_pool(&shared);
+  return status;
+}
+
+solver_status parallel_count(cgame board, uint16_t nb_threads, bool big,
+                             uint64_t max_bytes, uint64_t max_nodes,
+                             uint32_t max_milliseconds, sol_count *count,
+                             solver_stats *stats) {
+  if (!board || !count || nb_threads == 0) {
+    FPRINTF(stderr,
+            "Error: parallel_count, game or count pointer is NULL, or no "
+            "thread was requested.\n");
+    return SOLVER_ERROR;
+  }
+
+  struct count_pool_s shared;
+  memset(&shared, 0, sizeof(struct count_pool_s));
+  shared.nb_cells = (uint32_t)game_width(board) * game_height(board);
+  shared.big = big;
+  shared.max_nodes = max_nodes;
+  shared.max_milliseconds = max_milliseconds;
+  shared.start = get_milliseconds();
+  // The engines are created here since the game library isn't meant to be
+  // used by several threads at once
+  shared.counters = (counter *)calloc(nb_threads, sizeof(counter));
+  // Each counter has its share of the memory of the caches
+  uint64_t share = max_bytes / nb_threads ? max_bytes / nb_threads : 1;
+  bool ready = shared.counters != NULL;
+  for (uint16_t i = 0; ready && i < nb_threads; i++) {
+    counter *self = &shared.counters[i];
+    self->owner = &shared;
+    self->engine = prop_create(board);
+    sol_count_init(&self->count, big);
+    shared.nb_counters++;
+    ready = self->engine != NULL;
+    if (ready && max_bytes) prop_set_memory_limit(self->engine, share);
+  }
+  if (!ready)
+    FPRINTF(stderr, "Error: parallel_count, can't allocate a counter.\n");
+  ready = ready && split_count(&shared, shared.counters[0].engine);
+
+  uint16_t nb_started = 0;
+  for (; ready && nb_started < nb_threads; nb_started++) {
+    counter *self = &shared.counters[nb_started];
+    if (!THREAD_CREATE(self->thread, run_counter, self)) {
+      FPRINTF(stderr, "Error: parallel_count, can't start a thread.\n");
+      // The started counters stop before their next subproblem
+      ATOMIC_STORE(&shared.failed, 1);
+      break;
+    }
+  }
+  for (uint16_t i = 0; i < nb_started; i++)
+    THREAD_JOIN(shared.counters[i].thread);
+
+  solver_status status = SOLVER_DONE;
+  if (!ready || ATOMIC_LOAD(&shared.failed))
+    status = SOLVER_ERROR;
+  else if (ATOMIC_LOAD(&shared.out_of_budget))
+    status = SOLVER_UNFINISHED;
+  for (uint16_t i = 0; status == SOLVER_DONE && i < nb_threads; i++) {
+    if (!sol_count_add(count, &shared.counters[i].count)) status = SOLVER_ERROR;
+  }
+  if (stats)
+    stats->nb_nodes = stats->nb_propagations = stats->nb_backtracks = 0;
+  for (uint16_t i = 0; i < shared.nb_counters; i++) {
+    counter *self = &shared.counters[i];
+    if (stats && self->engine) {
+      solver_stats counter_stats;
+      prop_get_stats(self->engine, &counter_stats);
+      stats->nb_nodes += counter_stats.nb_nodes;
+      stats->nb_propagations += counter_stats.nb_propagations;
+      stats->nb_backtracks += counter_stats.nb_backtracks;
+    }
+    if (self->engine) prop_destroy(self->engine);
+    sol_count_clear(&self->count);
+  }
+  free(shared.counters);
+  free(shared.tasks);
+  return status;
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Allocates a subproblem
+ *
+ * @param nb_cells, the number of cells of the board
+ * @return the subproblem, NULL if it couldn't be allocated
+ */
+static task *create_task(uint32_t nb_cells) {
+  task *subproblem = (task *)malloc(sizeof(task));
+  if (!subproblem) return NULL;
+  // The domains and the path share a single block
+  subproblem->domains = (uint8_t *)malloc(2 * (size_t)nb_cells);
+  if (!subproblem->domains) {
+    free(subproblem);
+    return NULL;
+  }
+  subproblem->path = subproblem->domains + nb_cells;
+  subproblem->path_length = 0;
+  return subproblem;
+}
+
+/**
+ * @brief Frees a subproblem
+ *
+ * @param subproblem, the subproblem to free
+ */
+static void delete_task(task *subproblem) {
+  free(subproblem->domains);
+  free(subproblem);
+}
+
+/**
+ * @brief Adds a subproblem at the back of the deque of a worker, the pool lock
+ * must be held
+ *
+ * @param self, the worker
+ * @param subproblem, the subproblem
+ * @return false if the deque couldn't grow, true otherwise
+ */
+static bool push_task(worker *self, task *subproblem) {
+  if (self->deque_size == self->deque_capacity) {
+    uint32_t new_capacity =
+        self->deque_capacity ? 2 * self->deque_capacity : 8;
+    task **new_deque = (task **)malloc(new_capacity * sizeof(task *));
+    if (!new_deque) return false;
+    for (uint32_t i = 0; i < self->deque_size; i++)
+      new_deque[i] =
+          self->deque[(self->deque_head + i) % self->deque_capacity];
+    free(self->deque);
+    self->deque = new_deque;
+    self->deque_head = 0;
+    self->deque_capacity = new_capacity;
+  }
+  self->deque[(self->deque_head + self->deque_size) % self->deque_capacity] =
+      subproblem;
+  self->deque_size++;
+  ATOMIC_ADD(&self->owner->nb_tasks, 1);
+  return true;
+}
+
+/**
+ * @brief Removes a subproblem from the deque of a worker, the pool lock must
+ * be held
+ *
+ * @param self, the worker
+ * @param front, true to take the oldest subproblem, false the newest
+ * @return the subproblem, NULL if the deque is empty
+ */
+static task *pop_task(worker *self, bool front) {
+  if (self->deque_size == 0) return NULL;
+  task *subproblem;
+  if (front) {
+    subproblem = self->deque[self->deque_head];
+    self->deque_head = (self->deque_head + 1) % self->deque_capacity;
+  } else {
+    subproblem = self->deque[(self->deque_head + self->deque_size - 1) %
+                             self->deque_capacity];
+  }
+  self->deque_size--;
+  ATOMIC_ADD(&self->owner->nb_tasks, -1);
+  return subproblem;
+}
+
+/**
+ * @brief Gets the next subproblem of a worker: the newest of its own deque, or
+ * else the oldest of another deque, waiting for one if every deque is empty
+ *
+ * @param self, the worker
+ * @return the subproblem, NULL when every worker ran out of work
+ */
+static task *take_task(worker *self) {
+  pool shared = self->owner;
+  uint16_t index = (uint16_t)(self - shared->workers);
+  MUTEX_LOCK(shared->lock);
+  for (;;) {
+    if (shared->done) {
+      MUTEX_UNLOCK(shared->lock);
+      return NULL;
+    }
+    task *subproblem = pop_task(self, false);
+    for (uint16_t i = 1; !subproblem && i < shared->nb_workers; i++)
+      subproblem =
+          pop_task(&shared->workers[(index + i) % shared->nb_workers], true);
+    if (subproblem) {
+      MUTEX_UNLOCK(shared->lock);
+      return subproblem;
+    }
+
+    // Subproblems are only given away by busy workers
+    if (ATOMIC_ADD(&shared->nb_idle, 1) + 1 == shared->nb_workers) {
+      shared->done = true;
+      COND_BROADCAST(shared->wake);
+      MUTEX_UNLOCK(shared->lock);
+      return NULL;
+    }
+    COND_WAIT(shared->wake, shared->lock);
+    ATOMIC_ADD(&shared->nb_idle, -1);
+  }
+}
+
+/**
+ * @brief Compares two paths in the order of a sequential search
+ *
+ * @param path, the first path
+ * @param length, the length of the first path
+ * @param other_path, the second path
+ * @param other_length, the length of the second path
+ * @return a negative value if the first path is reached first, a positive
+ * value if the second is, 0 if one is a prefix of the other
+ */
+static int compare_paths(const uint8_t *path, uint32_t length,
+                         const uint8_t *other_path, uint32_t other_length) {
+  uint32_t common = length < other_length ? length : other_length;
+  for (uint32_t i = 0; i < common; i++) {
+    if (path[i] != other_path[i]) return path[i] < other_path[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Compares two solutions in the order of a sequential search, for qsort
+ *
+ * @param solution, the first found_solution
+ * @param other_solution, the second found_solution
+ * @return the comparison of their paths
+ */
+static int compare_found(const void *solution, const void *other_solution) {
+  const found_solution *first = (const found_solution *)solution;
+  const found_solution *second = (const found_solution *)other_solution;
+  return compare_paths(first->path, first->path_length, second->path,
+                       second->path_length);
+}
+
+/**
+ * @brief Moves a solution down a heap until the solutions below it are reached
+ * before it
+ *
+ * @param heap, the solutions, the one reached last on top
+ * @param size, the number of solutions in the heap
+ * @param index, the index of the solution to move
+ */
+static void sift_down(found_solution *heap, uint32_t size, uint32_t index) {
+  for (;;) {
+    uint32_t last = index;
+    uint32_t left = 2 * index + 1;
+    if (left < size && compare_found(&heap[left], &heap[last]) > 0) last = left;
+    if (left + 1 < size && compare_found(&heap[left + 1], &heap[last]) > 0)
+      last = left + 1;
+    if (last == index) return;
+    found_solution swapped = heap[index];
+    heap[index] = heap[last];
+    heap[last] = swapped;
+    index = last;
+  }
+}
+
+/**
+ * @brief Limits the solutions kept to the ones already kept once they fill the
+ * memory of the pool, the pool lock must be held. The solutions reached before
+ * the last of them still replace it, so the first ones of the sequential
+ * search are kept in the end
+ *
+ * @param shared, the pool, it keeps at least one solution
+ */
+static void bound_kept(pool shared) {
+  shared->max_kept = shared->nb_kept;
+  for (uint32_t i = shared->nb_kept / 2; i-- > 0;)
+    sift_down(shared->kept, shared->nb_kept, i);
+  memcpy(shared->bound_path, shared->kept[0].path,
+         shared->kept[0].path_length);
+  shared->bound_length = shared->kept[0].path_length;
+  ATOMIC_ADD(&shared->bound_version, 1);
+}
+
+/**
+ * @brief Keeps a solution found by a worker, the pool lock must be held. Once
+ * max_kept solutions are kept, a solution reached before the last of them
+ * replaces it and the others are dropped
+ *
+ * @param shared, the pool
+ * @param path, the path of the decisions leading to the solution
+ * @param length, the length of the path
+ * @param orientations, the direction of every cell of the solution
+ * @return false if the solution wasn't kept, true otherwise
+ */
+static bool keep_solution(pool shared, const uint8_t *path, uint32_t length,
+                          const direction *orientations) {
+  size_t solution_size = shared->nb_cells * sizeof(direction);
+  uint64_t solution_bytes = sizeof(found_solution) + length + solution_size;
+  if (shared->max_bytes && !shared->out_of_memory &&
+      shared->kept_bytes + solution_bytes > shared->max_bytes) {
+    FPRINTF(stderr, "Error: parallel_search, can't keep more solutions.\n");
+    shared->out_of_memory = true;
+    if (shared->nb_kept == 0) {
+      ATOMIC_STORE(&shared->stopped, 1);
+      return false;
+    }
+    bound_kept(shared);
+  }
+  bool full = shared->max_kept && shared->nb_kept == shared->max_kept;
+  if (full && compare_paths(path, length, shared->kept[0].path,
+                            shared->kept[0].path_length) > 0)
+    return false;
+  if (!full && shared->nb_kept == shared->kept_capacity) {
+    uint32_t new_capacity =
+        shared->kept_capacity ? 2 * shared->kept_capacity : 8;
+    if (shared->max_kept && new_capacity > shared->max_kept)
+      new_capacity = shared->max_kept;
+    found_solution *new_kept = (found_solution *)realloc(
+        shared->kept, new_capacity * sizeof(found_solution));
+    if (!new_kept) {
+      ATOMIC_STORE(&shared->failed, 1);
+      return false;
+    }
+    shared->kept = new_kept;
+    shared->kept_capacity = new_capacity;
+  }
+
+  found_solution solution;
+  solution.path = (uint8_t *)malloc(length ? length : 1);
+  solution.orientations = (direction *)malloc(solution_size);
+  if (!solution.path || !solution.orientations) {
+    free(solution.path);
+    free(solution.orientations);
+    ATOMIC_STORE(&shared->failed, 1);
+    return false;
+  }
+  memcpy(solution.path, path, length);
+  solution.path_length = length;
+  memcpy(solution.orientations, orientations, solution_size);
+
+  found_solution *heap = shared->kept;
+  shared->kept_bytes += solution_bytes;
+  if (full) {
+    shared->kept_bytes -= sizeof(found_solution) + heap[0].path_length;
+    shared->kept_bytes -= solution_size;
+    free(heap[0].path);
+    free(heap[0].orientations);
+    heap[0] = solution;
+    sift_down(heap, shared->nb_kept, 0);
+  } else {
+    uint32_t index = shared->nb_kept++;
+    heap[index] = solution;
+    // Without a limit the solutions are only sorted once the search is over
+    while (shared->max_kept && index > 0 &&
+           compare_found(&heap[(index - 1) / 2], &heap[index]) < 0) {
+      found_solution parent = heap[(index - 1) / 2];
+      heap[(index - 1) / 2] = heap[index];
+      heap[index] = parent;
+      index = (index - 1) / 2;
+    }
+    if (shared->nb_kept != shared->max_kept) return true;
+  }
+  memcpy(shared->bound_path, heap[0].path, heap[0].path_length);
+  shared->bound_length = heap[0].path_length;
+  ATOMIC_ADD(&shared->bound_version, 1);
+  return true;
+}
+
+/**
+ * @brief Checks whether a branch can still hold a solution reached before the
+ * last one kept, once the pool keeps as many solutions as it may
+ *
+ * @param self, the worker exploring the branch
+ * @param path, the path of the branch
+ * @param length, the length of the path
+ * @return true if the branch has to be explored
+ */
+static bool is_before_bound(worker *self, const uint8_t *path,
+                            uint32_t length) {
+  pool shared = self->owner;
+  long version = ATOMIC_LOAD(&shared->bound_version);
+  if (version == 0) return true;  // Any solution can still be kept
+  if (version != self->bound_version) {
+    MUTEX_LOCK(shared->lock);
+    memcpy(self->bound_path, shared->bound_path, shared->bound_length);
+    self->bound_length = shared->bound_length;
+    self->bound_version = ATOMIC_LOAD(&shared->bound_version);
+    MUTEX_UNLOCK(shared->lock);
+  }
+  return compare_paths(path, length, self->bound_path, self->bound_length) <=
+         0;
+}
+
+/**
+ * @brief Node callback of the workers: stops them once the budget runs out,
+ * cuts the branches reached after the last solution kept, and gives work away
+ * while some workers are idle
+ *
+ * @param engine, the engine of the worker
+ * @param data, the worker
+ * @return false if the branch has to be cut, true otherwise
+ */
+static bool worker_on_node(prop_engine engine, void *data) {
+  worker *self = (worker *)data;
+  pool shared = self->owner;
+  if ((shared->max_nodes || shared->max_milliseconds) &&
+      ++self->nb_unchecked == CLOCK_NODES) {
+    self->nb_unchecked = 0;
+    uint64_t nb_nodes =
+        (uint64_t)ATOMIC_ADD(&shared->nb_nodes, CLOCK_NODES) + CLOCK_NODES;
+    if ((shared->max_nodes && nb_nodes >= shared->max_nodes) ||
+        (shared->max_milliseconds &&
+         get_milliseconds() - shared->start >= shared->max_milliseconds)) {
+      ATOMIC_STORE(&shared->out_of_budget, 1);
+      ATOMIC_STORE(&shared->stopped, 1);
+      return false;
+    }
+  }
+  if (shared->max_kept) {
+    uint32_t length = prop_get_path(engine, self->path);
+    if (!is_before_bound(self, self->path, length)) return false;
+  }
+
+  if (ATOMIC_LOAD(&shared->nb_idle) > ATOMIC_LOAD(&shared->nb_tasks)) {
+    task *subproblem = create_task(shared->nb_cells);
+    if (!subproblem) return true;  // The branch is explored by this worker
+    if (!prop_split(engine, subproblem->domains, subproblem->path,
+                    &subproblem->path_length)) {
+      delete_task(subproblem);
+      return true;
+    }
+    MUTEX_LOCK(shared->lock);
+    if (!push_task(self, subproblem)) {
+      // The subproblem was removed from the engine, it can't be dropped
+      ATOMIC_STORE(&shared->failed, 1);
+      shared->done = true;
+      delete_task(subproblem);
+    }
+    COND_BROADCAST(shared->wake);
+    MUTEX_UNLOCK(shared->lock);
+  }
+  return !ATOMIC_LOAD(&shared->failed) && !ATOMIC_LOAD(&shared->stopped);
+}
+
+/**
+ * @brief Solution callback of the workers: counts the solution and keeps it if
+ * the mode of the pool needs it
+ *
+ * @param orientations, the direction of every cell of the solution
+ * @param data, the worker
+ * @return false when the current subproblem can be dropped, true otherwise
+ */
+static bool worker_on_solution(const direction *orientations, void *data) {
+  worker *self = (worker *)data;
+  pool shared = self->owner;
+  self->nb_solutions++;
+  if (shared->mode == SOLVER_NB_SOL) return true;
+
+  uint32_t length = prop_get_path(self->engine, self->path);
+  MUTEX_LOCK(shared->lock);
+  bool kept = keep_solution(shared, self->path, length, orientations);
+  MUTEX_UNLOCK(shared->lock);
+  // Later solutions of the same subproblem are reached after this one
+  return kept && shared->mode != SOLVER_FIND_ONE;
+}
+
+/**
+ * @brief Main function of the worker threads: explores subproblems until every
+ * worker runs out of work
+ *
+ * @param arg, the worker
+ */
+static THREAD_FUNCTION(run_worker, arg) {
+  worker *self = (worker *)arg;
+  pool shared = self->owner;
+  task *subproblem;
+  while ((subproblem = take_task(self)) != NULL) {
+    if (shared->max_kept &&
+        !is_before_bound(self, subproblem->path, subproblem->path_length)) {
+      delete_task(subproblem);
+      continue;
+    }
+    prop_load(self->engine, subproblem->domains, subproblem->path,
+              subproblem->path_length);
+    delete_task(subproblem);
+    prop_search(self->engine, worker_on_solution, self);
+    if (ATOMIC_LOAD(&shared->failed) || ATOMIC_LOAD(&shared->stopped)) {
+      MUTEX_LOCK(shared->lock);
+      shared->done = true;
+      COND_BROADCAST(shared->wake);
+      MUTEX_UNLOCK(shared->lock);
+    }
+  }
+  THREAD_RETURN;
+}
+
+/**
+ * @brief Creates the workers and the shared state of a search, the engines are
+ * created here since the game library isn't meant to be used by several
+ * threads at once
+ *
+ * @param shared, the pool to initialize
+ * @param board, the board to solve
+ * @param nb_threads, the number of workers
+ * @param mode, what the search has to find
+ * @param max_solutions, the number of solutions kept in SOLVER_FIND_ALL mode,
+ * 0 for all of them
+ * @param max_bytes, the memory the solutions kept may use, 0 for no limit
+ * @param max_nodes, the nodes the search may explore, 0 for no limit
+ * @param max_milliseconds, the time the search may take, 0 for no limit
+ * @return false in case of error, true otherwise
+ */
+static bool init_pool(pool shared, cgame board, uint16_t nb_threads,
+                      solver_mode mode, uint32_t max_solutions,
+                      uint64_t max_bytes, uint64_t max_nodes,
+                      uint32_t max_milliseconds) {
+  MUTEX_INIT(shared->lock);
+  COND_INIT(shared->wake);
+  shared->nb_workers = nb_threads;
+  shared->nb_cells = (uint32_t)game_width(board) * game_height(board);
+  shared->mode = mode;
+  shared->nb_idle = 0;
+  shared->nb_tasks = 0;
+  shared->done = false;
+  shared->failed = 0;
+  shared->stopped = 0;
+  shared->max_nodes = max_nodes;
+  shared->max_milliseconds = max_milliseconds;
+  shared->start = get_milliseconds();
+  shared->nb_nodes = 0;
+  shared->out_of_budget = 0;
+  shared->kept = NULL;
+  shared->nb_kept = 0;
+  shared->kept_capacity = 0;
+  shared->max_kept = mode == SOLVER_FIND_ONE ? 1 : max_solutions;
+  shared->kept_bytes = 0;
+  shared->max_bytes = max_bytes;
+  shared->out_of_memory = false;
+  shared->bound_version = 0;
+  shared->bound_length = 0;
+  shared->bound_path = (uint8_t *)malloc(shared->nb_cells);
+  shared->workers = (worker *)calloc(nb_threads, sizeof(worker));
+  if (!shared->bound_path || !shared->workers) {
+    FPRINTF(stderr, "Error: parallel_search, can't allocate the pool.\n");
+    return false;
+  }
+
+  for (uint16_t i = 0; i < nb_threads; i++) {
+    worker *self = &shared->workers[i];
+    self->owner = shared;
+    self->engine = prop_create(board);
+    self->path = (uint8_t *)malloc(shared->nb_cells);
+    self->bound_path = (uint8_t *)malloc(shared->nb_cells);
+    if (!self->engine || !self->path || !self->bound_path) {
+      FPRINTF(stderr, "Error: parallel_search, can't allocate a worker.\n");
+      return false;
+    }
+    prop_set_node_callback(self->engine, worker_on_node, self);
+  }
+  return true;
+}
+
+/**
+ * @brief Frees the workers and the shared state of a search
+ *
+ * @param shared, the pool to free
+ */
+static void free_pool(pool shared) {
+  if (shared->workers) {
+    for (uint16_t i = 0; i < shared->nb_workers; i++) {
+      worker *self = &shared->workers[i];
+      if (self->engine) prop_destroy(self->engine);
+      while (self->deque_size > 0) delete_task(pop_task(self, true));
+      free(self->deque);
+      free(self->path);
+      free(self->bound_path);
+    }
+    free(shared->workers);
+  }
+  for (uint32_t i = 0; i < shared->nb_kept; i++) {
+    free(shared->kept[i].path);
+    free(shared->kept[i].orientations);
+  }
+  free(shared->kept);
+  free(shared->bound_path);
+  COND_DESTROY(shared->wake);
+  MUTEX_DESTROY(shared->lock);
+}
+
+/**
+ * @brief Gives the solutions kept by the workers to the caller, in the order
+ * of a sequential search
+ *
+ * @param shared, the pool, every worker is done
+ * @param on_solution, the function called for each solution
+ * @param data, the pointer given to on_solution
+ */
+static void report_solutions(pool shared, prop_solution_callback on_solution,
+                             void *data) {
+  if (shared->nb_kept == 0) return;
+  qsort(shared->kept, shared->nb_kept, sizeof(found_solution), compare_found);
+  for (uint32_t i = 0; i < shared->nb_kept; i++) {
+    if (!on_solution(shared->kept[i].orientations, data)) break;
+  }
+}
+
+/**
+ * @brief Splits a board into the subproblems of a count: the smallest domain
+ *of each subproblem is split into its orientations, one level after the
+ *other, until there are COUNT_TASKS subproblems per counter. The subproblems
+ *the propagation rules out are dropped, the others cover the solutions of the
+ *board once each
+ *
+ * @param shared, the pool, its tasks are written
+ * @param engine, an engine of the board, not searching
+ * @return false in case of error, true otherwise
+ */
+static bool split_count(count_pool shared, prop_engine engine) {
+  uint32_t nb_cells = shared->nb_cells;
+  uint32_t target = (uint32_t)shared->nb_counters * COUNT_TASKS;
+  // A level at most multiplies the subproblems by the number of orientations
+  uint8_t *tasks = (uint8_t *)malloc((size_t)target * NB_DIR * nb_cells);
+  uint8_t *next = (uint8_t *)malloc((size_t)target * NB_DIR * nb_cells);
+  if (!tasks || !next) {
+    FPRINTF(stderr, "Error: parallel_count, can't allocate the subproblems.\n");
+    free(tasks);
+    free(next);
+    return false;
+  }
+  uint32_t nb_tasks = prop_deduce(engine) ? 1 : 0;
+  if (nb_tasks) prop_get_domains(engine, tasks);
+
+  bool split = true;
+  while (split && nb_tasks > 0 && nb_tasks < target) {
+    split = false;
+    uint32_t nb_next = 0;
+    for (uint32_t i = 0; i < nb_tasks; i++) {
+      const uint8_t *domains = tasks + (size_t)i * nb_cells;
+      uint32_t cell = smallest_domain(domains, nb_cells);
+      if (cell == nb_cells) {
+        // Every cell is decided, the subproblem is kept as it is
+        memcpy(next + (size_t)nb_next++ * nb_cells, domains, nb_cells);
+        continue;
+      }
+      split = true;
+      for (uint8_t dir = 0; dir < NB_DIR; dir++) {
+        if (!(domains[cell] & (1 << dir))) continue;
+        uint8_t *branch = next + (size_t)nb_next * nb_cells;
+        memcpy(branch, domains, nb_cells);
+        branch[cell] = (uint8_t)(1 << dir);
+        prop_load(engine, branch, NULL, 0);
+        if (prop_deduce(engine)) {
+          prop_get_domains(engine, branch);
+          nb_next++;
+        }
+      }
+    }
+    uint8_t *swapped = tasks;
+    tasks = next;
+    next = swapped;
+    nb_tasks = nb_next;
+  }
+  free(next);
+  shared->tasks = tasks;
+  shared->nb_tasks = nb_tasks;
+  return true;
+}
+
+/**
+ * @brief Finds the undecided cell with the fewest orientations left
+ *
+ * @param domains, the domains of the cells
+ * @param nb_cells, the number of cells
+ * @return the cell, nb_cells if every cell is decided
+ */
+static uint32_t smallest_domain(const uint8_t *domains, uint32_t nb_cells) {
+  uint32_t best = nb_cells;
+  uint8_t best_size = NB_DIR + 1;
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    uint8_t size = 0;
+    for (uint8_t dir = 0; dir < NB_DIR; dir++)
+      size += (domains[cell] >> dir) & 1;
+    if (size > 1 && size < best_size) {
+      best = cell;
+      best_size = size;
+      if (size == 2) break;  // No domain left to split is smaller
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Main function of the counting threads: counts subproblems until they
+ *are all taken or the budget runs out
+ *
+ * @param arg, the counter
+ */
+static THREAD_FUNCTION(run_counter, arg) {
+  counter *self = (counter *)arg;
+  count_pool shared = self->owner;
+  bool budget = shared->max_nodes || shared->max_milliseconds;
+  for (;;) {
+    if (ATOMIC_LOAD(&shared->failed) || ATOMIC_LOAD(&shared->out_of_budget))
+      break;
+    long index = ATOMIC_ADD(&shared->next_task, 1);
+    if (index < 0 || (uint32_t)index >= shared->nb_tasks) break;
+    prop_load(self->engine, shared->tasks + (size_t)index * shared->nb_cells,
+              NULL, 0);
+    sol_count partial;
+    prop_status status;
+    do {
+      solver_stats before, after;
+      prop_get_stats(self->engine, &before);
+      status = prop_count_step(self->engine, shared->big, &partial,
+                               budget ? COUNT_SLICE : UINT64_MAX);
+      if (!budget) break;
+      prop_get_stats(self->engine, &after);
+      long nb_nodes = (long)(after.nb_nodes - before.nb_nodes);
+      uint64_t total =
+          (uint64_t)(ATOMIC_ADD(&shared->nb_nodes, nb_nodes) + nb_nodes);
+      if ((shared->max_nodes && total >= shared->max_nodes) ||
+          (shared->max_milliseconds &&
+           get_milliseconds() - shared->start >= shared->max_milliseconds))
+        ATOMIC_STORE(&shared->out_of_budget, 1);
+    } while (status == PROP_PAUSED && !ATOMIC_LOAD(&shared->out_of_budget) &&
+             !ATOMIC_LOAD(&shared->failed));
+    if (status == PROP_ERROR ||
+        (status == PROP_FINISHED && !sol_count_add(&self->count, &partial)))
+      ATOMIC_STORE(&shared->failed, 1);
+    sol_count_clear(&partial);
+  }
+  THREAD_RETURN;
+}
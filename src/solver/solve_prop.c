@@ -0,0 +1,1246 @@
+#include "solve_prop.h"
+
+#include <assert.h>
+
+#define NB_DOMAINS 16  // Number of subsets of the four orientations
+#define FULL_DOMAIN 0xF
+#define NO_NEIGHBOUR UINT32_MAX
+#define NB_PIECE_INDEX (NB_PIECE_TYPE + 1)  // EMPTY is stored at index 0
+// A domain loses at least one orientation per change, so a cell is at most on
+// the trail once per orientation
+#define TRAIL_ENTRIES_PER_CELL NB_DIR
+// Counting keys: a run of decided cells, then undecided cells alone in their
+// component or sharing it with other undecided cells
+#define KEY_DECIDED_RUN 0x00
+#define KEY_GROUPED 0x10
+#define VARINT_MAX_BYTES 5
+#define COUNT_CACHE_MAX_BYTES ((size_t)256 << 20)
+#define COUNT_CACHE_MIN_BUCKETS 1024
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for a domain change, undone when backtracking
+ */
+typedef struct trail_entry_s {
+  uint32_t cell;      /**< the cell whose domain changed */
+  uint8_t old_domain; /**< the domain of the cell before the change */
+  uint32_t nb_links;  /**< size of the link trail before the change */
+} trail_entry;
+
+/**
+ * @brief Structure for a change of the connection union-find, undone when
+ * backtracking
+ */
+typedef struct link_entry_s {
+  uint32_t cell; /**< the root merged into its parent, or the cell closed */
+  bool merged;   /**< whether two components were merged or a cell closed */
+} link_entry;
+
+/**
+ * @brief Structure for a branching decision of the search
+ */
+typedef struct decision_s {
+  uint32_t cell;      /**< the cell branched on */
+  uint8_t chosen;     /**< orientation of the cell being explored */
+  uint8_t remaining;  /**< orientations of the cell not tried yet */
+  uint32_t mark;      /**< size of the trail before the decision */
+} decision;
+
+/**
+ * @brief Structure for the number of solutions of a subproblem, kept by the
+ * counting search
+ */
+typedef struct count_entry_s {
+  struct count_entry_s *next; /**< next entry of the same bucket */
+  uint64_t hash;              /**< hash of the key */
+  sol_count count;            /**< number of solutions of the subproblem */
+  bool done;                  /**< whether the count is complete */
+  uint32_t length;            /**< number of bytes of the key */
+  uint8_t key[];              /**< canonical description of the subproblem */
+} count_entry;
+
+/**
+ * @brief Structure for the cache of the counting search
+ */
+typedef struct count_cache_s {
+  count_entry **buckets; /**< chained hash table of the entries */
+  uint32_t nb_buckets;   /**< number of buckets, a power of 2 */
+  uint32_t nb_entries;   /**< number of entries */
+  size_t nb_bytes;       /**< memory used by the entries */
+  size_t max_bytes;      /**< memory the entries may use */
+} count_cache;
+
+/**
+ * @brief Structure for a decision of the counting search
+ */
+typedef struct count_frame_s {
+  count_entry *entry; /**< cache entry of the subproblem, NULL if not cached */
+  sol_count subtotal; /**< solutions counted below the decision so far */
+} count_frame;
+
+/**
+ * @brief Structure for the state of a count, kept between its steps
+ */
+typedef struct count_state_s {
+  count_frame *frames; /**< one counting frame per cell */
+  count_cache cache;   /**< the counting cache */
+  uint32_t *labels;    /**< scratch array of one label per cell */
+  uint8_t *key;        /**< scratch key of (1 + VARINT_MAX_BYTES) bytes per
+                          cell */
+} count_state;
+
+/**
+ * @brief Structure for a propagation engine
+ */
+struct prop_engine_s {
+  uint16_t width;    /**< width of the board */
+  uint16_t height;   /**< height of the board */
+  uint32_t nb_cells; /**< number of cells of the board */
+  uint8_t *pieces;   /**< piece index (piece + 1) of each cell */
+  uint32_t (*neighbours)[NB_DIR]; /**< neighbour of each cell in each direction,
+                                     NO_NEIGHBOUR if off the board */
+  uint8_t *domains; /**< mask of the orientations each cell can still take */
+
+  uint8_t edges[NB_PIECE_INDEX][NB_DIR]; /**< mask of the connected directions
+                                            of a piece in an orientation */
+  uint8_t with_edge[NB_PIECE_INDEX][NB_DIR]; /**< mask of the orientations of a
+                                                piece pointing to a direction */
+  uint8_t may[NB_PIECE_INDEX][NB_DOMAINS];  /**< mask of the directions that may
+                                               be connected for a domain */
+  uint8_t must[NB_PIECE_INDEX][NB_DOMAINS]; /**< mask of the directions that
+                                               must be connected for a domain */
+
+  uint32_t *queue;     /**< circular worklist of the cells to revise */
+  bool *queued;        /**< whether a cell is in the worklist */
+  uint32_t queue_head; /**< index of the next cell to revise */
+  uint32_t queue_size; /**< number of cells in the worklist */
+
+  trail_entry *trail;   /**< every domain change since the search started */
+  uint32_t trail_size;  /**< number of changes on the trail */
+  decision *decisions;  /**< stack of the decisions of the current branch */
+  uint32_t depth;       /**< number of decisions on the stack */
+  uint8_t *prefix;        /**< orientations chosen to reach the loaded state */
+  uint32_t prefix_length; /**< number of orientations in the prefix */
+
+  bool searching;         /**< whether a paused search can be resumed */
+  count_state *counting;  /**< state of a paused count, NULL otherwise */
+  size_t count_bytes;     /**< memory the cache of a count may use */
+
+  prop_node_callback on_node; /**< function called before each decision */
+  void *node_data;            /**< pointer given to on_node */
+
+  uint32_t *parent;   /**< union-find of the cells over the committed
+                         connections, a root is its own parent */
+  uint32_t *size;     /**< number of cells of the component of each root */
+  uint32_t *nb_open;  /**< number of cells of the component of each root whose
+                         connections aren't all known yet */
+  link_entry *links;  /**< every union-find change since the search started */
+  uint32_t nb_links;  /**< number of changes on the link trail */
+  direction *orientations; /**< the last solution found */
+
+  uint64_t nb_nodes;        /**< decisions taken since the engine was created */
+  uint64_t nb_propagations; /**< domains narrowed */
+  uint64_t nb_backtracks;   /**< dead ends met */
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static void init_tables(prop_engine engine);
+static uint8_t get_canonical_domain(piece cell_piece, direction current);
+static uint32_t get_single_orientation(uint8_t domain);
+static uint8_t count_orientations(uint8_t domain);
+static void enqueue_cell(prop_engine engine, uint32_t cell);
+static bool restrict_domain(prop_engine engine, uint32_t cell, uint8_t mask);
+static bool propagate(prop_engine engine);
+static uint32_t find_root(prop_engine engine, uint32_t cell);
+static bool is_open(prop_engine engine, uint32_t cell, uint8_t domain);
+static bool merge_components(prop_engine engine, uint32_t cell,
+                             uint32_t next);
+static bool commit_links(prop_engine engine, uint32_t cell,
+                         uint8_t old_domain);
+static void undo_links(prop_engine engine, uint32_t nb_links);
+static bool init_links(prop_engine engine);
+static uint32_t choose_branching_cell(prop_engine engine);
+static void undo_to_mark(prop_engine engine, uint32_t mark);
+static bool next_branch(prop_engine engine);
+static bool start_search(prop_engine engine);
+static prop_status search(prop_engine engine,
+                          prop_solution_callback on_solution, void *data,
+                          uint64_t max_nodes);
+static uint32_t choose_counting_cell(prop_engine engine);
+static uint32_t write_varint(uint8_t *key, uint32_t value);
+static uint32_t build_key(prop_engine engine, uint32_t *labels, uint8_t *key);
+static uint64_t hash_key(const uint8_t *key, uint32_t length);
+static count_entry *find_entry(count_cache *cache, const uint8_t *key,
+                               uint32_t length, uint64_t hash);
+static count_entry *insert_entry(count_cache *cache, const uint8_t *key,
+                                 uint32_t length, uint64_t hash, bool big);
+static void free_cache(count_cache *cache);
+static count_state *create_count_state(prop_engine engine, bool big);
+static void free_count_state(prop_engine engine);
+static bool count_next_branch(prop_engine engine, count_frame *frames,
+                              sol_count *count, bool *failed);
+static prop_status count_search(prop_engine engine, count_state *state,
+                                sol_count *count, uint64_t max_nodes);
+
+//--------------------------------------------------------------------------------------
+//                                Engine functions bodies
+
+prop_engine prop_create(cgame board) {
+  if (!board) {
+    FPRINTF(stderr, "Error: prop_create, game pointer is NULL.\n");
+    return NULL;
+  }
+
+  prop_engine engine = (prop_engine)calloc(1, sizeof(struct prop_engine_s));
+  if (!engine) {
+    FPRINTF(stderr, "Error: prop_create, can't allocate engine.\n");
+    return NULL;
+  }
+
+  engine->width = game_width(board);
+  engine->height = game_height(board);
+  engine->nb_cells = (uint32_t)engine->width * engine->height;
+  engine->count_bytes = COUNT_CACHE_MAX_BYTES;
+  uint32_t nb_cells = engine->nb_cells;
+  engine->pieces = (uint8_t *)malloc(nb_cells * sizeof(uint8_t));
+  engine->neighbours = malloc(nb_cells * sizeof(*engine->neighbours));
+  engine->domains = (uint8_t *)malloc(nb_cells * sizeof(uint8_t));
+  engine->queue = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->queued = (bool *)calloc(nb_cells, sizeof(bool));
+  engine->trail = (trail_entry *)malloc(TRAIL_ENTRIES_PER_CELL * nb_cells *
+                                       sizeof(trail_entry));
+  engine->decisions = (decision *)malloc(nb_cells * sizeof(decision));
+  engine->prefix = (uint8_t *)malloc(nb_cells * sizeof(uint8_t));
+  engine->parent = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->size = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  engine->nb_open = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  // A link is either a merge, at most one per cell but the first, or the
+  // closing of a cell
+  engine->links = (link_entry *)malloc(2 * nb_cells * sizeof(link_entry));
+  engine->orientations = (direction *)malloc(nb_cells * sizeof(direction));
+  if (!engine->pieces || !engine->neighbours || !engine->domains ||
+      !engine->queue || !engine->queued || !engine->trail ||
+      !engine->decisions || !engine->prefix || !engine->parent ||
+      !engine->size || !engine->nb_open || !engine->links ||
+      !engine->orientations) {
+    FPRINTF(stderr, "Error: prop_create, can't allocate engine state.\n");
+    prop_destroy(engine);
+    return NULL;
+  }
+
+  init_tables(engine);
+  // The pieces are read in bulk, reading them one at a time walks the board
+  piece *cell_pieces = (piece *)malloc(nb_cells * sizeof(piece));
+  direction *cell_dirs = (direction *)malloc(nb_cells * sizeof(direction));
+  if (!cell_pieces || !cell_dirs) {
+    FPRINTF(stderr, "Error: prop_create, can't allocate engine state.\n");
+    free(cell_pieces);
+    free(cell_dirs);
+    prop_destroy(engine);
+    return NULL;
+  }
+  get_cells(board, cell_pieces, cell_dirs);
+
+  const int32_t delta_x[NB_DIR] = {0, 1, 0, -1};
+  const int32_t delta_y[NB_DIR] = {1, 0, -1, 0};
+  bool wrapping = is_wrapping(board);
+  int32_t width = engine->width;
+  int32_t height = engine->height;
+  for (uint16_t y = 0; y < engine->height; y++) {
+    for (uint16_t x = 0; x < engine->width; x++) {
+      uint32_t cell = x + (uint32_t)y * engine->width;
+      piece cell_piece = cell_pieces[cell];
+      engine->pieces[cell] = (uint8_t)(cell_piece + 1);
+      uint8_t domain = get_canonical_domain(cell_piece, cell_dirs[cell]);
+
+      for (direction dir = N; dir < NB_DIR; dir++) {
+        int32_t next_x = x + delta_x[dir];
+        int32_t next_y = y + delta_y[dir];
+        if (wrapping) {
+          next_x = (next_x + width) % width;
+          next_y = (next_y + height) % height;
+        }
+        if (next_x < 0 || width <= next_x || next_y < 0 || height <= next_y) {
+          engine->neighbours[cell][dir] = NO_NEIGHBOUR;
+          // Nothing can be connected off the board
+          domain &= (uint8_t)~engine->with_edge[engine->pieces[cell]][dir];
+        } else {
+          engine->neighbours[cell][dir] =
+              (uint32_t)next_x + (uint32_t)next_y * engine->width;
+        }
+      }
+      engine->domains[cell] = domain;
+    }
+  }
+  free(cell_pieces);
+  free(cell_dirs);
+  return engine;
+}
+
+bool prop_search(prop_engine engine, prop_solution_callback on_solution,
+                 void *data) {
+  if (!engine || !on_solution) {
+    FPRINTF(stderr,
+            "Error: prop_search, engine or solution callback is NULL.\n");
+    return false;
+  }
+  engine->searching = false;
+  return prop_search_step(engine, on_solution, data, UINT64_MAX) ==
+         PROP_FINISHED;
+}
+
+prop_status prop_search_step(prop_engine engine,
+                             prop_solution_callback on_solution, void *data,
+                             uint64_t max_nodes) {
+  if (!engine || !on_solution) {
+    FPRINTF(stderr,
+            "Error: prop_search_step, engine or solution callback is NULL.\n");
+    return PROP_ERROR;
+  }
+  if (!engine->searching) {
+    if (engine->counting) free_count_state(engine);
+    if (!start_search(engine)) return PROP_FINISHED;  // No solution at all
+    engine->searching = true;
+  }
+  prop_status status = search(engine, on_solution, data, max_nodes);
+  engine->searching = status == PROP_PAUSED;
+  return status;
+}
+
+bool prop_count(prop_engine engine, bool big, sol_count *count) {
+  if (!engine || !count) {
+    FPRINTF(stderr, "Error: prop_count, engine or count pointer is NULL.\n");
+    return false;
+  }
+  if (engine->counting) free_count_state(engine);
+  return prop_count_step(engine, big, count, UINT64_MAX) == PROP_FINISHED;
+}
+
+prop_status prop_count_step(prop_engine engine, bool big, sol_count *count,
+                            uint64_t max_nodes) {
+  if (!engine || !count) {
+    FPRINTF(stderr,
+            "Error: prop_count_step, engine or count pointer is NULL.\n");
+    return PROP_ERROR;
+  }
+  if (!engine->counting) {
+    engine->searching = false;
+    sol_count_init(count, big);
+    if (!start_search(engine)) return PROP_FINISHED;
+    engine->counting = create_count_state(engine, big);
+    if (!engine->counting) return PROP_ERROR;
+  }
+  prop_status status = count_search(engine, engine->counting, count, max_nodes);
+  if (status != PROP_PAUSED) free_count_state(engine);
+  return status;
+}
+
+bool prop_deduce(prop_engine engine) {
+  if (!engine) {
+    FPRINTF(stderr, "Error: prop_deduce, engine pointer is NULL.\n");
+    return false;
+  }
+  if (engine->counting) free_count_state(engine);
+  engine->searching = false;
+  return start_search(engine) && propagate(engine);
+}
+
+void prop_set_node_callback(prop_engine engine, prop_node_callback on_node,
+                            void *data) {
+  if (!engine) {
+    FPRINTF(stderr, "Error: prop_set_node_callback, engine pointer is NULL.\n");
+    return;
+  }
+  engine->on_node = on_node;
+  engine->node_data = data;
+}
+
+void prop_set_memory_limit(prop_engine engine, uint64_t max_bytes) {
+  if (!engine) {
+    FPRINTF(stderr, "Error: prop_set_memory_limit, engine pointer is NULL.\n");
+    return;
+  }
+  engine->count_bytes = max_bytes && max_bytes < COUNT_CACHE_MAX_BYTES
+                            ? (size_t)max_bytes
+                            : COUNT_CACHE_MAX_BYTES;
+}
+
+uint32_t prop_get_path(prop_engine engine, uint8_t *path) {
+  if (!engine || !path) {
+    FPRINTF(stderr, "Error: prop_get_path, engine or path pointer is NULL.\n");
+    return 0;
+  }
+  memcpy(path, engine->prefix, engine->prefix_length);
+  for (uint32_t level = 0; level < engine->depth; level++)
+    path[engine->prefix_length + level] = engine->decisions[level].chosen;
+  return engine->prefix_length + engine->depth;
+}
+
+bool prop_split(prop_engine engine, uint8_t *domains, uint8_t *path,
+                uint32_t *path_length) {
+  if (!engine || !domains || !path || !path_length) {
+    FPRINTF(stderr, "Error: prop_split, engine or task pointer is NULL.\n");
+    return false;
+  }
+  uint32_t level = 0;
+  while (level < engine->depth && !engine->decisions[level].remaining) level++;
+  if (level == engine->depth) return false;
+
+  // The last orientation left is given away, so the search keeps the earlier
+  // ones and the two parts stay in the order of a sequential search
+  decision *split = &engine->decisions[level];
+  uint8_t orientation = 0;
+  while (split->remaining >> (orientation + 1)) orientation++;
+  split->remaining &= (uint8_t)~(1 << orientation);
+
+  memcpy(domains, engine->domains, engine->nb_cells);
+  for (uint32_t entry = engine->trail_size; entry > split->mark; entry--)
+    domains[engine->trail[entry - 1].cell] =
+        engine->trail[entry - 1].old_domain;
+  domains[split->cell] = (uint8_t)(1 << orientation);
+
+  memcpy(path, engine->prefix, engine->prefix_length);
+  for (uint32_t i = 0; i < level; i++)
+    path[engine->prefix_length + i] = engine->decisions[i].chosen;
+  path[engine->prefix_length + level] = orientation;
+  *path_length = engine->prefix_length + level + 1;
+  return true;
+}
+
+void prop_get_domains(prop_engine engine, uint8_t *domains) {
+  if (!engine || !domains) {
+    FPRINTF(stderr,
+            "Error: prop_get_domains, engine or domains pointer is NULL.\n");
+    return;
+  }
+  memcpy(domains, engine->domains, engine->nb_cells);
+}
+
+void prop_load(prop_engine engine, const uint8_t *domains, const uint8_t *path,
+               uint32_t path_length) {
+  if (!engine || !domains || (!path && path_length)) {
+    FPRINTF(stderr, "Error: prop_load, engine or task pointer is NULL.\n");
+    return;
+  }
+  if (engine->counting) free_count_state(engine);
+  engine->searching = false;
+  memcpy(engine->domains, domains, engine->nb_cells);
+  if (path_length) memcpy(engine->prefix, path, path_length);
+  engine->prefix_length = path_length;
+  engine->trail_size = 0;
+  engine->depth = 0;
+}
+
+void prop_get_stats(prop_engine engine, solver_stats *stats) {
+  if (!engine || !stats) {
+    FPRINTF(stderr,
+            "Error: prop_get_stats, engine or stats pointer is NULL.\n");
+    return;
+  }
+  stats->nb_nodes = engine->nb_nodes;
+  stats->nb_propagations = engine->nb_propagations;
+  stats->nb_backtracks = engine->nb_backtracks;
+}
+
+void prop_destroy(prop_engine engine) {
+  if (!engine) {
+    FPRINTF(stderr, "Error: prop_destroy, engine pointer is NULL.\n");
+    return;
+  }
+  if (engine->counting) free_count_state(engine);
+  free(engine->pieces);
+  free(engine->neighbours);
+  free(engine->domains);
+  free(engine->queue);
+  free(engine->queued);
+  free(engine->trail);
+  free(engine->decisions);
+  free(engine->prefix);
+  free(engine->parent);
+  free(engine->size);
+  free(engine->nb_open);
+  free(engine->links);
+  free(engine->orientations);
+  free(engine);
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Fills the lookup tables of the connections of every piece and domain
+ *
+ * @param engine, the engine whose tables are filled
+ */
+static void init_tables(prop_engine engine) {
+  for (uint8_t index = 0; index < NB_PIECE_INDEX; index++) {
+    piece table_piece = (piece)(index - 1);
+    for (direction orientation = N; orientation < NB_DIR; orientation++) {
+      engine->edges[index][orientation] = 0;
+      engine->with_edge[index][orientation] = 0;
+    }
+    for (direction orientation = N; orientation < NB_DIR; orientation++) {
+      for (direction dir = N; dir < NB_DIR; dir++) {
+        if (is_edge(table_piece, orientation, dir)) {
+          engine->edges[index][orientation] |= (uint8_t)(1 << dir);
+          engine->with_edge[index][dir] |= (uint8_t)(1 << orientation);
+        }
+      }
+    }
+    for (uint8_t domain = 0; domain < NB_DOMAINS; domain++) {
+      uint8_t may = 0, must = FULL_DOMAIN;
+      for (direction orientation = N; orientation < NB_DIR; orientation++) {
+        if (domain & (1 << orientation)) {
+          may |= engine->edges[index][orientation];
+          must &= engine->edges[index][orientation];
+        }
+      }
+      engine->may[index][domain] = may;
+      engine->must[index][domain] = domain ? must : 0;
+    }
+  }
+}
+
+/**
+ * @brief Gets the orientations a piece can take, keeping only one orientation
+ * per distinct set of connections
+ *
+ * @param cell_piece, the piece
+ * @param current, the current direction of the piece
+ * @return the mask of the orientations to explore
+ */
+static uint8_t get_canonical_domain(piece cell_piece, direction current) {
+  switch (cell_piece) {
+    case SEGMENT:
+      return (uint8_t)((1 << N) | (1 << E));
+    case CROSS:
+    case EMPTY:
+      // Every orientation is the same, the current one is kept
+      return (uint8_t)(1 << current);
+    default:
+      return FULL_DOMAIN;
+  }
+}
+
+/**
+ * @brief Gets the orientation of a domain holding a single one
+ *
+ * @param domain, a non empty domain
+ * @return the lowest orientation of the domain
+ */
+static uint32_t get_single_orientation(uint8_t domain) {
+  uint32_t orientation = 0;
+  while (!(domain & (1 << orientation))) orientation++;
+  return orientation;
+}
+
+/**
+ * @brief Counts the orientations of a domain
+ *
+ * @param domain, the domain
+ * @return the number of orientations in the domain
+ */
+static uint8_t count_orientations(uint8_t domain) {
+  uint8_t count = 0;
+  for (; domain; domain &= (uint8_t)(domain - 1)) count++;
+  return count;
+}
+
+/**
+ * @brief Adds a cell to the worklist if it isn't already in it
+ *
+ * @param engine, the engine
+ * @param cell, the cell to revise
+ */
+static void enqueue_cell(prop_engine engine, uint32_t cell) {
+  if (engine->queued[cell]) return;
+  engine->queued[cell] = true;
+  engine->queue[(engine->queue_head + engine->queue_size) % engine->nb_cells] =
+      cell;
+  engine->queue_size++;
+}
+
+/**
+ * @brief Removes from the domain of a cell the orientations outside of a mask
+ *
+ * @param engine, the engine
+ * @param cell, the cell to restrict
+ * @param mask, the orientations the cell is allowed to keep
+ * @return false if the domain of the cell became empty or the connections it
+ * commits to can't be part of a solution, true otherwise
+ */
+static bool restrict_domain(prop_engine engine, uint32_t cell, uint8_t mask) {
+  uint8_t old_domain = engine->domains[cell];
+  uint8_t domain = old_domain & mask;
+  if (domain == old_domain) return true;
+  assert(engine->trail_size < TRAIL_ENTRIES_PER_CELL * engine->nb_cells);
+  engine->trail[engine->trail_size].cell = cell;
+  engine->trail[engine->trail_size].old_domain = old_domain;
+  engine->trail[engine->trail_size].nb_links = engine->nb_links;
+  engine->trail_size++;
+  engine->nb_propagations++;
+  engine->domains[cell] = domain;
+  if (domain == 0 || !commit_links(engine, cell, old_domain)) return false;
+  enqueue_cell(engine, cell);
+  return true;
+}
+
+/**
+ * @brief Makes every pair of neighbours agree on the edge they share, until the
+ * worklist is empty
+ *
+ * @param engine, the engine
+ * @return false if a domain became empty, true otherwise
+ */
+static bool propagate(prop_engine engine) {
+  bool consistent = true;
+  while (engine->queue_size > 0) {
+    uint32_t cell = engine->queue[engine->queue_head];
+    engine->queue_head = (engine->queue_head + 1) % engine->nb_cells;
+    engine->queue_size--;
+    engine->queued[cell] = false;
+    if (!consistent) continue;  // Only empty the worklist
+
+    uint8_t piece_index = engine->pieces[cell];
+    uint8_t may = engine->may[piece_index][engine->domains[cell]];
+    uint8_t must = engine->must[piece_index][engine->domains[cell]];
+    for (direction dir = N; dir < NB_DIR && consistent; dir++) {
+      uint32_t next = engine->neighbours[cell][dir];
+      if (next == NO_NEIGHBOUR) continue;
+      direction back = opposite_direction(dir);
+      uint8_t connected = engine->with_edge[engine->pieces[next]][back];
+      if (must & (1 << dir)) {
+        consistent = restrict_domain(engine, next, connected);
+      } else if (!(may & (1 << dir))) {
+        consistent = restrict_domain(engine, next, (uint8_t)~connected);
+      }
+    }
+  }
+  engine->queue_head = 0;
+  return consistent;
+}
+
+/**
+ * @brief Gets the root of a cell in the connection union-find. The paths
+ * aren't compressed so that merges can be undone, union by size keeps them
+ * short
+ *
+ * @param engine, the engine
+ * @param cell, the cell
+ * @return the root of the component of the cell
+ */
+static uint32_t find_root(prop_engine engine, uint32_t cell) {
+  while (engine->parent[cell] != cell) cell = engine->parent[cell];
+  return cell;
+}
+
+/**
+ * @brief Tells whether some connections of a cell aren't known yet
+ *
+ * @param engine, the engine
+ * @param cell, the cell
+ * @param domain, a domain of the cell
+ * @return true if the orientations of the domain don't all have the same
+ * connections, false otherwise
+ */
+static bool is_open(prop_engine engine, uint32_t cell, uint8_t domain) {
+  uint8_t piece_index = engine->pieces[cell];
+  return engine->may[piece_index][domain] != engine->must[piece_index][domain];
+}
+
+/**
+ * @brief Merges the components of two cells connected to each other
+ *
+ * @param engine, the engine
+ * @param cell, a cell
+ * @param next, a neighbour of the cell
+ * @return false if the cells already were in the same component, so the
+ * connection closes a loop, true otherwise
+ */
+static bool merge_components(prop_engine engine, uint32_t cell,
+                             uint32_t next) {
+  uint32_t root = find_root(engine, cell);
+  uint32_t next_root = find_root(engine, next);
+  if (root == next_root) return false;
+  if (engine->size[root] < engine->size[next_root]) {
+    uint32_t swap = root;
+    root = next_root;
+    next_root = swap;
+  }
+  engine->parent[next_root] = root;
+  engine->size[root] += engine->size[next_root];
+  engine->nb_open[root] += engine->nb_open[next_root];
+  engine->links[engine->nb_links].cell = next_root;
+  engine->links[engine->nb_links].merged = true;
+  engine->nb_links++;
+  return true;
+}
+
+/**
+ * @brief Records in the union-find the connections a domain change commits to:
+ * they must not close a loop, and a component that can't be extended anymore
+ * must be the whole board
+ *
+ * @param engine, the engine
+ * @param cell, the cell whose domain was restricted
+ * @param old_domain, the domain of the cell before the change
+ * @return false if the domains can't lead to a solution, true otherwise
+ */
+static bool commit_links(prop_engine engine, uint32_t cell,
+                         uint8_t old_domain) {
+  uint8_t piece_index = engine->pieces[cell];
+  uint8_t domain = engine->domains[cell];
+  uint8_t added = engine->must[piece_index][domain] &
+                  (uint8_t)~engine->must[piece_index][old_domain];
+  for (direction dir = N; dir < NB_DIR; dir++) {
+    if (!(added & (1 << dir))) continue;
+    uint32_t next = engine->neighbours[cell][dir];
+    uint8_t next_must =
+        engine->must[engine->pieces[next]][engine->domains[next]];
+    // A connection is merged once, by the first of its two cells to commit
+    if (next_must & (1 << opposite_direction(dir))) continue;
+    if (!merge_components(engine, cell, next)) return false;
+  }
+
+  uint32_t root = find_root(engine, cell);
+  if (is_open(engine, cell, old_domain) && !is_open(engine, cell, domain)) {
+    engine->nb_open[root]--;
+    engine->links[engine->nb_links].cell = cell;
+    engine->links[engine->nb_links].merged = false;
+    engine->nb_links++;
+  }
+  // A finished component must span the whole board
+  return engine->nb_open[root] > 0 || engine->size[root] == engine->nb_cells;
+}
+
+/**
+ * @brief Undoes the union-find changes down to a size of the link trail
+ *
+ * @param engine, the engine
+ * @param nb_links, the size of the link trail to go back to
+ */
+static void undo_links(prop_engine engine, uint32_t nb_links) {
+  while (engine->nb_links > nb_links) {
+    engine->nb_links--;
+    link_entry *entry = &engine->links[engine->nb_links];
+    if (!entry->merged) {
+      engine->nb_open[find_root(engine, entry->cell)]++;
+      continue;
+    }
+    uint32_t root = engine->parent[entry->cell];
+    engine->size[root] -= engine->size[entry->cell];
+    engine->nb_open[root] -= engine->nb_open[entry->cell];
+    engine->parent[entry->cell] = entry->cell;
+  }
+}
+
+/**
+ * @brief Builds the union-find of the connections the domains commit to
+ *
+ * @param engine, the engine
+ * @return false if the domains can't lead to a solution, true otherwise
+ */
+static bool init_links(prop_engine engine) {
+  engine->nb_links = 0;
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+    engine->parent[cell] = cell;
+    engine->size[cell] = 1;
+    engine->nb_open[cell] = is_open(engine, cell, engine->domains[cell]);
+  }
+
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+    uint8_t must = engine->must[engine->pieces[cell]][engine->domains[cell]];
+    for (direction dir = N; dir < NB_DIR; dir++) {
+      if (!(must & (1 << dir))) continue;
+      uint32_t next = engine->neighbours[cell][dir];
+      uint8_t next_must =
+          engine->must[engine->pieces[next]][engine->domains[next]];
+      // A connection both cells commit to is merged from its N or E end
+      if (dir > E && (next_must & (1 << opposite_direction(dir)))) continue;
+      if (!merge_components(engine, cell, next)) return false;
+    }
+  }
+
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+    if (engine->parent[cell] == cell && engine->nb_open[cell] == 0 &&
+        engine->size[cell] < engine->nb_cells)
+      return false;
+  }
+  // The search never undoes the initial merges
+  engine->nb_links = 0;
+  return true;
+}
+
+/**
+ * @brief Chooses the cell to branch on: the one with the smallest domain
+ *
+ * @param engine, the engine
+ * @return the cell, or NO_NEIGHBOUR if every cell has a single orientation
+ */
+static uint32_t choose_branching_cell(prop_engine engine) {
+  uint32_t best_cell = NO_NEIGHBOUR;
+  uint8_t best_count = NB_DIR + 1;
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+    uint8_t count = count_orientations(engine->domains[cell]);
+    if (1 < count && count < best_count) {
+      best_cell = cell;
+      best_count = count;
+      if (count == 2) break;  // No domain can be smaller
+    }
+  }
+  return best_cell;
+}
+
+/**
+ * @brief Restores the domains changed since a mark of the trail
+ *
+ * @param engine, the engine
+ * @param mark, the size the trail had when the mark was taken
+ */
+static void undo_to_mark(prop_engine engine, uint32_t mark) {
+  if (engine->trail_size <= mark) return;
+  undo_links(engine, engine->trail[mark].nb_links);
+  while (engine->trail_size > mark) {
+    engine->trail_size--;
+    trail_entry *entry = &engine->trail[engine->trail_size];
+    engine->domains[entry->cell] = entry->old_domain;
+  }
+}
+
+/**
+ * @brief Backtracks to the deepest decision with an orientation left to try
+ * and assigns it
+ *
+ * @param engine, the engine
+ * @return false if every decision was exhausted, true otherwise
+ */
+static bool next_branch(prop_engine engine) {
+  while (engine->depth > 0) {
+    decision *top = &engine->decisions[engine->depth - 1];
+    undo_to_mark(engine, top->mark);
+    if (top->remaining) {
+      top->chosen = (uint8_t)get_single_orientation(top->remaining);
+      top->remaining &= (uint8_t)~(1 << top->chosen);
+      if (restrict_domain(engine, top->cell, (uint8_t)(1 << top->chosen)))
+        return true;
+      engine->nb_backtracks++;
+      continue;
+    }
+    engine->depth--;
+  }
+  return false;
+}
+
+/**
+ * @brief Restores the domains the engine had before any search, or the ones of
+ * the loaded subproblem, builds their union-find and puts every cell in the
+ * worklist
+ *
+ * @param engine, the engine
+ * @return false if a domain is empty or the connections can't be part of a
+ * solution, so there is no solution at all
+ */
+static bool start_search(prop_engine engine) {
+  undo_to_mark(engine, 0);
+  engine->depth = 0;
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+    if (engine->domains[cell] == 0) return false;
+  }
+  if (!init_links(engine)) return false;
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++)
+    enqueue_cell(engine, cell);
+  return true;
+}
+
+/**
+ * @brief Explores the search space depth first: propagates the domains, takes
+ * a decision on the smallest domain when propagation stalls and backtracks to
+ * a mark of the trail on a dead end or after a solution
+ *
+ * @param engine, the engine, the cells to revise are in the worklist
+ * @param on_solution, the function called for each solution
+ * @param data, the pointer given to on_solution
+ * @param max_nodes, the number of fixed points the search may reach before it
+ * pauses, the worklist then holds the cells to revise when it is resumed
+ * @return the status of the search
+ */
+static prop_status search(prop_engine engine,
+                          prop_solution_callback on_solution, void *data,
+                          uint64_t max_nodes) {
+  do {
+    if (max_nodes == 0) return PROP_PAUSED;
+    max_nodes--;
+    if (!propagate(engine)) {
+      engine->nb_backtracks++;
+      continue;
+    }
+
+    uint32_t cell = choose_branching_cell(engine);
+    if (cell == NO_NEIGHBOUR) {
+      for (uint32_t i = 0; i < engine->nb_cells; i++)
+        engine->orientations[i] =
+            (direction)get_single_orientation(engine->domains[i]);
+      if (!on_solution(engine->orientations, data)) return PROP_STOPPED;
+      continue;
+    }
+    if (engine->on_node && !engine->on_node(engine, engine->node_data))
+      continue;
+
+    engine->nb_nodes++;
+    decision *top = &engine->decisions[engine->depth++];
+    top->cell = cell;
+    top->remaining = engine->domains[cell];
+    top->mark = engine->trail_size;
+  } while (next_branch(engine));
+  return PROP_FINISHED;
+}
+
+/**
+ * @brief Chooses the cell to branch on while counting: the first undecided one,
+ * so the decided cells grow as a sweep and subproblems recur
+ *
+ * @param engine, the engine
+ * @return the cell, or NO_NEIGHBOUR if every cell has a single orientation
+ */
+static uint32_t choose_counting_cell(prop_engine engine) {
+  for (uint32_t cell = 0; cell < engine->nb_cells; cell++) {
+    if (count_orientations(engine->domains[cell]) > 1) return cell;
+  }
+  return NO_NEIGHBOUR;
+}
+
+/**
+ * @brief Writes a number with 7 bits per byte, the high bit marking that more
+ * bytes follow
+ *
+ * @param key, where the bytes are written
+ * @param value, the number
+ * @return the number of bytes written
+ */
+static uint32_t write_varint(uint8_t *key, uint32_t value) {
+  uint32_t length = 0;
+  while (value >= 0x80) {
+    key[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  key[length++] = (uint8_t)value;
+  return length;
+}
+
+/**
+ * @brief Describes the current subproblem so that subproblems with the same
+ * solutions get the same key. Decided cells only matter through the components
+ * they make the undecided cells part of, so only the domains of the undecided
+ * cells and which of them share a component are kept
+ *
+ * @param engine, the engine, at a fixed point
+ * @param labels, scratch array of one label per cell
+ * @param key, where the key is written
+ * @return the number of bytes of the key
+ */
+static uint32_t build_key(prop_engine engine, uint32_t *labels, uint8_t *key) {
+  uint32_t nb_cells = engine->nb_cells;
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    if (count_orientations(engine->domains[cell]) > 1)
+      labels[find_root(engine, cell)] = 0;
+  }
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    if (count_orientations(engine->domains[cell]) > 1)
+      labels[find_root(engine, cell)]++;
+  }
+
+  // Labels above nb_cells are the ones given to the shared components, in the
+  // order they are met
+  uint32_t length = 0, next_label = 0, decided_run = 0;
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    uint8_t domain = engine->domains[cell];
+    if (count_orientations(domain) == 1) {
+      decided_run++;
+      continue;
+    }
+    if (decided_run) {
+      key[length++] = KEY_DECIDED_RUN;
+      length += write_varint(key + length, decided_run);
+      decided_run = 0;
+    }
+    uint32_t root = find_root(engine, cell);
+    if (labels[root] == 1) {
+      key[length++] = domain;
+      continue;
+    }
+    if (labels[root] <= nb_cells) labels[root] = nb_cells + 1 + next_label++;
+    key[length++] = (uint8_t)(KEY_GROUPED | domain);
+    length += write_varint(key + length, labels[root] - nb_cells - 1);
+  }
+  if (decided_run) {
+    key[length++] = KEY_DECIDED_RUN;
+    length += write_varint(key + length, decided_run);
+  }
+  return length;
+}
+
+/**
+ * @brief Hashes a key with FNV-1a
+ *
+ * @param key, the key
+ * @param length, the number of bytes of the key
+ * @return the hash
+ */
+static uint64_t hash_key(const uint8_t *key, uint32_t length) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (uint32_t i = 0; i < length; i++) {
+    hash ^= key[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+/**
+ * @brief Looks a subproblem up in the counting cache
+ *
+ * @param cache, the cache
+ * @param key, the key of the subproblem
+ * @param length, the number of bytes of the key
+ * @param hash, the hash of the key
+ * @return the entry of the subproblem, NULL if it isn't cached
+ */
+static count_entry *find_entry(count_cache *cache, const uint8_t *key,
+                               uint32_t length, uint64_t hash) {
+  count_entry *entry = cache->buckets[hash & (cache->nb_buckets - 1)];
+  for (; entry; entry = entry->next) {
+    if (entry->hash == hash && entry->length == length &&
+        memcmp(entry->key, key, length) == 0)
+      return entry;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Adds a subproblem to the counting cache, its count isn't known yet
+ *
+ * @param cache, the cache
+ * @param key, the key of the subproblem
+ * @param length, the number of bytes of the key
+ * @param hash, the hash of the key
+ * @param big, whether the count has arbitrary precision
+ * @return the new entry, NULL if the cache is full
+ */
+static count_entry *insert_entry(count_cache *cache, const uint8_t *key,
+                                 uint32_t length, uint64_t hash, bool big) {
+  size_t entry_size = sizeof(count_entry) + length;
+  if (cache->nb_bytes + entry_size > cache->max_bytes) return NULL;
+
+  if (cache->nb_entries >= cache->nb_buckets &&
+      cache->nb_buckets <= UINT32_MAX / 2) {
+    // The entries don't move, only the buckets are rebuilt
+    uint32_t nb_buckets = cache->nb_buckets * 2;
+    count_entry **buckets =
+        (count_entry **)calloc(nb_buckets, sizeof(count_entry *));
+    if (buckets) {
+      for (uint32_t i = 0; i < cache->nb_buckets; i++) {
+        count_entry *entry = cache->buckets[i];
+        while (entry) {
+          count_entry *next = entry->next;
+          entry->next = buckets[entry->hash & (nb_buckets - 1)];
+          buckets[entry->hash & (nb_buckets - 1)] = entry;
+          entry = next;
+        }
+      }
+      free(cache->buckets);
+      cache->buckets = buckets;
+      cache->nb_buckets = nb_buckets;
+    }
+  }
+
+  count_entry *entry = (count_entry *)malloc(entry_size);
+  if (!entry) return NULL;
+  entry->hash = hash;
+  sol_count_init(&entry->count, big);
+  entry->done = false;
+  entry->length = length;
+  memcpy(entry->key, key, length);
+  entry->next = cache->buckets[hash & (cache->nb_buckets - 1)];
+  cache->buckets[hash & (cache->nb_buckets - 1)] = entry;
+  cache->nb_entries++;
+  cache->nb_bytes += entry_size;
+  return entry;
+}
+
+/**
+ * @brief Frees the entries of the counting cache
+ *
+ * @param cache, the cache
+ */
+static void free_cache(count_cache *cache) {
+  if (!cache->buckets) return;
+  for (uint32_t i = 0; i < cache->nb_buckets; i++) {
+    count_entry *entry = cache->buckets[i];
+    while (entry) {
+      count_entry *next = entry->next;
+      sol_count_clear(&entry->count);
+      free(entry);
+      entry = next;
+    }
+  }
+  free(cache->buckets);
+}
+
+/**
+ * @brief Backtracks like next_branch, adding the count of every exhausted
+ * decision to its parent and to the cache
+ *
+ * @param engine, the engine
+ * @param frames, the counting frames of the decisions
+ * @param count, the total count
+ * @param failed, set to true if a count couldn't grow
+ * @return false if every decision was exhausted, true otherwise
+ */
+static bool count_next_branch(prop_engine engine, count_frame *frames,
+                              sol_count *count, bool *failed) {
+  while (engine->depth > 0) {
+    decision *top = &engine->decisions[engine->depth - 1];
+    undo_to_mark(engine, top->mark);
+    if (top->remaining) {
+      top->chosen = (uint8_t)get_single_orientation(top->remaining);
+      top->remaining &= (uint8_t)~(1 << top->chosen);
+      if (restrict_domain(engine, top->cell, (uint8_t)(1 << top->chosen)))
+        return true;
+      engine->nb_backtracks++;
+      continue;
+    }
+
+    count_frame *frame = &frames[engine->depth - 1];
+    sol_count *parent = engine->depth > 1 ? &frames[engine->depth - 2].subtotal
+                                          : count;
+    if (frame->entry) {
+      if (!sol_count_copy(&frame->entry->count, &frame->subtotal)) {
+        *failed = true;
+        return false;
+      }
+      frame->entry->done = true;
+    }
+    if (!sol_count_add(parent, &frame->subtotal)) {
+      *failed = true;
+      return false;
+    }
+    sol_count_reset(&frame->subtotal);
+    engine->depth--;
+  }
+  return false;
+}
+
+/**
+ * @brief Allocates the state of a new count
+ *
+ * @param engine, the engine
+ * @param big, whether the counts have arbitrary precision
+ * @return the state, NULL in case of error
+ */
+static count_state *create_count_state(prop_engine engine, bool big) {
+  uint32_t nb_cells = engine->nb_cells;
+  count_state *state = (count_state *)calloc(1, sizeof(count_state));
+  if (!state) {
+    FPRINTF(stderr,
+            "Error: create_count_state, can't allocate the counting state.\n");
+    return NULL;
+  }
+  state->frames = (count_frame *)malloc(nb_cells * sizeof(count_frame));
+  state->labels = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  state->key = (uint8_t *)malloc((size_t)nb_cells * (1 + VARINT_MAX_BYTES));
+  state->cache.nb_buckets = COUNT_CACHE_MIN_BUCKETS;
+  state->cache.max_bytes = engine->count_bytes;
+  state->cache.buckets =
+      (count_entry **)calloc(state->cache.nb_buckets, sizeof(count_entry *));
+  if (state->frames) {
+    for (uint32_t i = 0; i < nb_cells; i++)
+      sol_count_init(&state->frames[i].subtotal, big);
+  }
+  engine->counting = state;
+  if (!state->frames || !state->labels || !state->key ||
+      !state->cache.buckets) {
+    FPRINTF(stderr,
+            "Error: create_count_state, can't allocate the counting state.\n");
+    free_count_state(engine);
+    return NULL;
+  }
+  return state;
+}
+
+/**
+ * @brief Frees the state of the count of an engine
+ *
+ * @param engine, the engine, counting
+ */
+static void free_count_state(prop_engine engine) {
+  count_state *state = engine->counting;
+  if (state->frames) {
+    for (uint32_t i = 0; i < engine->nb_cells; i++)
+      sol_count_clear(&state->frames[i].subtotal);
+  }
+  free(state->frames);
+  free(state->labels);
+  free(state->key);
+  free_cache(&state->cache);
+  free(state);
+  engine->counting = NULL;
+}
+
+/**
+ * @brief Counts the solutions depth first without enumerating them: the count
+ * of a subproblem already met is taken from the cache instead of exploring it
+ * again
+ *
+ * @param engine, the engine, the cells to revise are in the worklist
+ * @param state, the state of the count
+ * @param count, where the solutions are counted
+ * @param max_nodes, the number of fixed points the count may reach before it
+ * pauses
+ * @return the status of the count
+ */
+static prop_status count_search(prop_engine engine, count_state *state,
+                                sol_count *count, uint64_t max_nodes) {
+  count_frame *frames = state->frames;
+  bool failed = false;
+  do {
+    if (max_nodes == 0) return PROP_PAUSED;
+    max_nodes--;
+    if (!propagate(engine)) {
+      engine->nb_backtracks++;
+      continue;
+    }
+
+    sol_count *target =
+        engine->depth > 0 ? &frames[engine->depth - 1].subtotal : count;
+    uint32_t cell = choose_counting_cell(engine);
+    if (cell == NO_NEIGHBOUR) {
+      if (!sol_count_add_uint(target, 1)) return PROP_ERROR;
+      continue;
+    }
+
+    uint32_t length = build_key(engine, state->labels, state->key);
+    uint64_t hash = hash_key(state->key, length);
+    count_entry *entry = find_entry(&state->cache, state->key, length, hash);
+    if (entry && entry->done) {
+      if (!sol_count_add(target, &entry->count)) return PROP_ERROR;
+      continue;
+    }
+    // A subproblem being counted can't be met again below itself, so an entry
+    // that isn't done can't be found here
+    frames[engine->depth].entry =
+        entry ? NULL
+              : insert_entry(&state->cache, state->key, length, hash,
+                             count->big);
+    engine->nb_nodes++;
+    decision *top = &engine->decisions[engine->depth++];
+    top->cell = cell;
+    top->remaining = engine->domains[cell];
+    top->mark = engine->trail_size;
+  } while (count_next_branch(engine, frames, count, &failed));
+  return failed ? PROP_ERROR : PROP_FINISHED;
+}
@@ -1,22 +1,121 @@
 #include <assert.h>
 
 #include "bool_array.h"
+#include "cross_time.h"
 #include "game.h"
-#include "game_io.h"
+#include "solve_smart.h"
 
 #define NB_DIR_SEGMENT 2
-#define FILENAME_MAX_SIZE 64
-#define SOL_NUM_SIZE 10
+#define NO_REGION UINT32_MAX  // Label of a cell not assigned to a region yet
+#define NO_CELL UINT32_MAX    // Neighbour of a cell on a non wrapping border
+#define FREE_STACK_SIZE 64  // Subtrees freed without allocating a stack
+#define SLAB_SIZE 512       // Possibilities allocated at once by the engine
+#define CLOCK_FINDS 16      // Calls of findPoss between readings of the clock
+// Memory of a possibility, its arrays of branches included
+#define POSS_BYTES sizeof(struct possibility_s)
 
-// Global variables to avoid copying them in each function call
-direction DIRS[] = {N, E, S, W};
-game g = NULL;
-bool **checked = NULL;
-bool **unmovable = NULL;
+static const direction DIRS[] = {N, E, S, W};
 
 //--------------------------------------------------------------------------------------
 //                                Structures
 typedef struct possibility_s *possibility;
+typedef struct poss_slab_s poss_slab;
+typedef struct search_frame_s search_frame;
+typedef struct region_set_s region_set;
+typedef struct deduction_s deduction;
+
+// this structure holds everything a smart solve works on, so that several
+// solves can run at the same time
+struct smart_engine_s {
+  game g;             // the private copy of the board being solved
+  uint16_t width;     // the dimensions of the board
+  uint16_t height;    //
+  bool **checked;     // the pieces already placed by the current possibility
+  bool **unmovable;   // the pieces that can only be in one direction
+  uint8_t *domains;   // the orientations each piece may still take, bit i
+                      // standing for DIRS[i], indexed by x + y * width
+  uint32_t rules;     // the deduction rules setUnmovable applies
+  smart_order order;  // the order in which the search places the pieces
+  uint8_t *degrees;   // the number of connections of each piece, indexed by
+                      // x + y * width
+  possibility *trees;  // the possibility tree of each independent region,
+                       // the solutions being all their combinations
+  uint32_t nbTrees;    // the number of trees, 0 if there are no solutions
+  region_set *regions;  // the regions being solved apart, NULL when the board
+                        // is solved as a whole
+  uint32_t *cells;        // the stack of the cells left to visit by
+                          // setUnmovable, 4 per cell at most
+  search_frame *frames;   // the stack of the calls of findPoss and propagate
+  uint32_t nbFrames;      // the number of frames the stack can hold
+  uint64_t nbFind;         // the number of calls of findPoss of the last solve
+  uint64_t nbPropagate;    // the number of calls of propagate
+  uint64_t nbDeleted;      // the number of leaves deleted from the trees
+  uint64_t nbFixed;        // the number of pieces set as unmovable
+  poss_slab *slabs;       // the slabs the possibilities are taken from
+  poss_slab *slab;        // the slab being filled, NULL before the first one
+  uint32_t nbTaken;       // the possibilities taken from this slab
+  possibility freePoss;   // the possibilities freed since the trees were
+                          // last reset, chained by their first branch
+  uint64_t treeBytes;      // the memory held by the possibility trees
+  uint64_t peakTreeBytes;  // the most memory they held during the last solve
+  uint64_t maxTreeBytes;   // the memory they may hold, 0 for no limit
+  bool outOfMemory;        // whether the last solve ran out of memory, the
+                           // search unwinding as soon as it is set
+  uint64_t maxFind;        // the calls of findPoss a solve may make, 0 for no
+                           // limit
+  uint32_t maxMs;          // the time a solve may take, 0 for no limit
+  uint64_t startMs;        // when the last solve started
+  bool outOfBudget;        // whether the last solve ran out of budget, the
+                           // search unwinding as soon as it is set
+};
+
+// this structure describes how the movable pieces left by setUnmovable split
+// into groups that can be solved apart. The unmovable pieces form components
+// linked by their connections, and a group is a set of regions of movable
+// pieces that has to be solved together. The groups and the components are
+// linked by the connections of the unmovable pieces, and the decomposition is
+// only used when these links form a tree: the solutions of the board are then
+// exactly the combinations of a solution of each group, a group having to form
+// a tree with the components around it
+struct region_set_s {
+  uint32_t nbGroups;     // the number of groups
+  uint32_t nbComps;      // the number of components
+  uint32_t *label;       // for each cell, its group if it is movable or
+                         // nbGroups plus its component otherwise
+  piece *pieces;         // the piece of each cell, indexed by x + y * width
+  direction *dirs;       // the direction of each cell, only read for the
+                         // unmovable ones
+  uint32_t *groupStart;  // the cells of group g are groupCells[groupStart[g]]
+  uint32_t *groupCells;  // to groupCells[groupStart[g + 1]] excluded
+  uint32_t *compStart;   // the same for the cells of each component
+  uint32_t *compCells;   //
+  uint32_t *adjStart;    // the components linked to group g are
+  uint32_t *adjComps;    // adjComps[adjStart[g]] to adjComps[adjStart[g + 1]]
+  uint32_t *home;        // the largest component linked to each group, taken
+                         // as already placed when the group is solved
+  uint32_t *compUser;    // the group allowed to go through each component
+  uint32_t current;      // the group being solved
+};
+
+// this structure holds what setUnmovable deduces the domains of the pieces
+// from. The cells joined by a connection every solution has form trees, whose
+// roots hold their size and a bound on the connections that may still leave
+// them. The trees are only rebuilt between the passes of the global rules,
+// which stays sound since they can only grow while the bounds shrink
+struct deduction_s {
+  uint32_t nbCells;     // the number of cells of the board
+  piece *pieces;        // the piece of each cell, indexed by x + y * width
+  direction *dirs;      // the direction of each cell
+  uint8_t shapes[NB_PIECE_TYPE + 1][NB_DIR];  // the connections of each piece,
+                                              // EMPTY first, in each
+                                              // orientation as a mask of DIRS
+  uint32_t *parent;     // the parent of each cell in its tree
+  uint32_t *size;       // the number of cells of each tree
+  uint32_t *open;       // the connections that may still leave each tree
+  bool *listed;         // whether each cell is in smart->cells, waiting for
+                        // the local rules
+  uint32_t nbListed;    // the number of cells waiting
+};
 
 // this structure is used as a chained list to save different dispositions of
 // pieces.
@@ -28,234 +127,422 @@ struct possibility_s {
   bool isLeaf;    // a boolean to indicate if this possibility is a leaf or not
   uint32_t nbNextPos;  // the number of deriving possibilities from this cell (0
                        // if it is a leaf)
-  uint32_t
-      *nbNextDerivPos;  // an array of the number of leaves we can access from
-                        // the deriving possibilities of this possibility
+  uint32_t nbNextDerivPos[NB_DIR];  // the number of leaves we can access
+                                    // from the deriving possibilities of this
+                                    // possibility
   uint32_t totalNextDerivPos;  // the number of leaves we can access from this
                                // possibility
-  possibility
-      *nextPos;  // an array of the deriving possibilities from this cell
+  possibility nextPos[NB_DIR];  // the deriving possibilities from this cell
 };
 
-//--------------------------------------------------------------------------------------
-//                                Game solving functions
-//                         These functions are solving the game accordingly to
-//                         the first argument given (FIND_ONE/NB_SOL/FIND_ALL)
-bool find_one(char *argv[]);
-bool nb_sol(char *argv[]);
-bool find_all(char *argv[]);
-
-bool find_one_sdl(game g);
+// this structure holds possibilities allocated together. The engine takes
+// them in the order the trees are built, so that the walks of loadPossibility
+// stay within a few slabs, and gives them all back at once with the trees
+struct poss_slab_s {
+  poss_slab *next;                          // the slab filled after this one
+  struct possibility_s poss[SLAB_SIZE];     // the possibilities of the slab
+};
 
-//--------------------------------------------------------------------------------------
-//                                Error handler functions
-//                         These functions are used by find_one/nb_sol/find_all
-//                         to handle errors and properly leave the function, to
-//                         tests if the arguments are valid, as well as to show
-//                         how to use the solver
-static bool gameLoadError();
-static bool solFileError(game board);
+// this structure holds the local state of a call of findPoss or propagate, the
+// two functions calling each other to a depth proportional to the board, so
+// they run on a stack allocated on the heap
+struct search_frame_s {
+  bool isFind;           // true for a call of findPoss, false for propagate
+  uint16_t x;            // the coordinates of the cell of the call
+  uint16_t y;            //
+  uint8_t dir;           // the index in DIRS of the direction being tested
+  uint8_t nbDir;         // findPoss: the number of directions to test
+  bool unmovable;        // findPoss: whether the piece can't be turned
+  uint32_t nbPoss;       // findPoss: the number of possibility trees found
+  uint32_t nbDerivPos;   // findPoss: the number of possibilities found
+  possibility possArray[NB_DIR];  // findPoss: the possibility trees found
+  possibility thisPoss;  // propagate: the possibility being built
+  bool inDir;            // propagate: whether the neighbour in DIRS[dir] is
+                         // being searched
+  uint16_t nextX;        // propagate: the coordinates of this neighbour
+  uint16_t nextY;        //
+  uint32_t nbPossToCheck;  // propagate: the number of leaves of thisPoss
+  uint32_t numPoss;        // propagate: the leaf being extended
+  uint8_t order[NB_DIR];   // propagate: the indexes in DIRS of the
+                           // neighbours, in the order they are searched
+};
 
 //--------------------------------------------------------------------------------------
 //                                Static functions
 //                         These functions are primitives used in the differents
 //                         solvers
-static possibility findSolution(uint16_t x, uint16_t y);
-static possibility allocPossibility();
-static void freePossibility(possibility pos);
-static void freeChainPossibility(possibility pos);
-static possibility createSinglePoss(uint16_t x, uint16_t y, direction dir);
+static possibility findSolution(smart_engine smart, uint16_t x,
+                                uint16_t y);
+static void freeTrees(smart_engine smart);
+static bool findRegions(smart_engine smart);
+static void freeRegions(region_set *regions);
+static uint32_t getNeighbour(smart_engine smart, uint32_t cell,
+                             direction dir);
+static bool labelComps(smart_engine smart, region_set *regions,
+                       uint32_t nbRegions, uint32_t *stack);
+static uint64_t *findLinks(smart_engine smart, const region_set *regions,
+                           uint32_t nbRegions, uint32_t *nbLinks);
+static uint32_t findRoot(uint32_t *parent, uint32_t node);
+static bool groupBlocks(uint32_t nbRegions, uint32_t nbNodes,
+                        const uint64_t *links, uint32_t nbLinks,
+                        uint32_t *group);
+static bool buildRegions(smart_engine smart, region_set *regions,
+                         uint32_t nbRegions, uint32_t *group, uint64_t *links,
+                         uint32_t nbLinks);
+static possibility solveRegion(smart_engine smart, uint32_t group);
+static bool isRegionPlaced(smart_engine smart, possibility tree,
+                           uint32_t numLeaf);
+static bool isInTree(smart_engine smart, uint16_t x, uint16_t y);
+static bool isOutside(smart_engine smart, uint16_t x, uint16_t y);
+static int compareLinks(const void *first, const void *second);
+static possibility allocPossibility(smart_engine smart);
+static void freePossibility(smart_engine smart, possibility pos);
+static void freeChainPossibility(smart_engine smart, possibility pos);
+static void resetPossibilities(smart_engine smart);
+static possibility createSinglePoss(smart_engine smart, uint16_t x, uint16_t y,
+                                    direction dir);
 static void addBranchPoss(possibility poss, possibility chainPoss);
 // static possibility getLeaf(possibility poss, uint32_t numLeaf); Commented
 // because not used
 static void spreadLeaf(possibility poss, uint32_t numLeaf, uint32_t nbPossToAdd,
                        possibility *possToAdd, uint32_t nbDerivPos);
-static possibility delLeaf(possibility poss, uint32_t numLeaf);
+static possibility delLeaf(smart_engine smart, possibility poss,
+                           uint32_t numLeaf);
 static void getCoordFromDir(direction dir, int32_t *x, int32_t *y);
-static bool setUnmovable();
-static bool setRecUnmovable(uint16_t x, uint16_t y);
-static possibility propagate(uint16_t x, uint16_t y);
-static void loadPossibility(possibility poss, uint32_t numPoss);
-static void unloadPossibility(possibility poss, uint32_t numPoss);
-static uint32_t findPoss(possibility *possArray, uint32_t *nbDerivPos,
-                         uint16_t x, uint16_t y);
-static bool isGoodDir(uint16_t x, uint16_t y);
+static bool setUnmovable(smart_engine smart);
+static bool initDeduction(smart_engine smart, deduction *state);
+static void freeDeduction(deduction *state);
+static bool deduce(smart_engine smart, deduction *state);
+static bool applyRules(smart_engine smart, deduction *state, uint32_t cell,
+                       bool global, bool *changed);
+static void listCell(smart_engine smart, deduction *state, uint32_t cell);
+static bool buildTrees(smart_engine smart, deduction *state);
+static uint8_t mustEdges(smart_engine smart, const deduction *state,
+                         uint32_t cell);
+static uint8_t mayEdges(smart_engine smart, const deduction *state,
+                        uint32_t cell);
+static uint8_t joinedEdges(smart_engine smart, const deduction *state,
+                           uint32_t cell);
+static uint8_t pendingEdges(smart_engine smart, const deduction *state,
+                            uint32_t cell);
+static bool joinOrientation(smart_engine smart, deduction *state,
+                            uint32_t cell, uint8_t shape, uint32_t *size,
+                            int64_t *open);
+static uint8_t countOrientations(uint8_t domain);
+static uint8_t ruleEdges(smart_engine smart, deduction *state, uint32_t cell,
+                         uint8_t domain);
+static uint8_t ruleLeaves(smart_engine smart, deduction *state, uint32_t cell,
+                          uint8_t domain);
+static uint8_t ruleLoops(smart_engine smart, deduction *state, uint32_t cell,
+                         uint8_t domain);
+static uint8_t ruleIsolation(smart_engine smart, deduction *state,
+                             uint32_t cell, uint8_t domain);
+static void loadPossibility(smart_engine smart, possibility poss,
+                            uint32_t numPoss);
+static void unloadPossibility(smart_engine smart, possibility poss,
+                              uint32_t numPoss);
+static uint32_t findPoss(smart_engine smart, possibility *possArray,
+                         uint32_t *nbDerivPos, uint16_t x, uint16_t y);
+static void pushFrame(smart_engine smart, uint32_t *depth, bool isFind,
+                      uint16_t x, uint16_t y);
+static bool stepFind(smart_engine smart, uint32_t *depth,
+                     search_frame *returned);
+static bool stepPropagate(smart_engine smart, uint32_t *depth,
+                          search_frame *returned);
+static bool isGoodDir(smart_engine smart, uint16_t x, uint16_t y);
+static uint32_t orderKey(smart_engine smart, uint32_t cell);
+static uint32_t findStart(smart_engine smart);
+static void sortNeighbours(smart_engine smart, search_frame *frame);
+
+// a deduction rule returns the domain of a cell without the orientations it
+// rules out
+typedef uint8_t (*deduction_rule)(smart_engine smart, deduction *state,
+                                  uint32_t cell, uint8_t domain);
+
+// the rules setUnmovable can apply. The local ones only read the neighbours of
+// a cell, and are run again on the neighbours of every cell they narrow. The
+// global ones read the trees, and are run in passes over the whole board until
+// a pass narrows nothing
+static const struct {
+  smart_rule flag;
+  deduction_rule apply;
+  bool global;
+} RULES[] = {{SMART_RULE_EDGES, ruleEdges, false},
+             {SMART_RULE_LEAVES, ruleLeaves, false},
+             {SMART_RULE_LOOPS, ruleLoops, true},
+             {SMART_RULE_ISOLATION, ruleIsolation, true}};
+
+#define NB_RULES (sizeof(RULES) / sizeof(RULES[0]))
+#define GLOBAL_RULES (SMART_RULE_LOOPS | SMART_RULE_ISOLATION)
 
 //--------------------------------------------------------------------------------------
-//                                Game solving functions bodies
+//                                Smart engine functions bodies
 
-/**
- * @brief Finds a single solution and writes it in a .sol file
- *
- * @param argv, an array of the arguments
- * @return false in case of error, true otherwise
- **/
-bool find_one(char *argv[]) {
-  g = load_game(argv[2]);
-  if (!g) return gameLoadError();
-
-  uint16_t width = game_width(g);
-  uint16_t height = game_height(g);
-  checked = alloc_double_bool_array(width, height);
-  unmovable = alloc_double_bool_array(width, height);
-  possibility solution = findSolution(0, 0);
-  char solution_fname[FILENAME_MAX_SIZE * 2];
-  STRCPY(solution_fname, argv[3], FILENAME_MAX_SIZE);
-  STRCAT(solution_fname, ".sol", FILENAME_MAX_SIZE);
-  if (solution != NULL) {
-    loadPossibility(solution, 0);
-    save_game(g, solution_fname);
-    freeChainPossibility(solution);
-  } else {
-    FILE *stream;
-    FOPEN(stream, solution_fname, "w");
-    FPRINTF(stream, "NO SOLUTION\n");
-    FCLOSE(stream);
-  }
-
-  free_double_bool_array(checked, width);
-  checked = NULL;
-  free_double_bool_array(unmovable, width);
-  unmovable = NULL;
-  delete_game(g);
-  g = NULL;
-  return true;
+smart_engine smart_create(cgame board) {
+  if (!board) {
+    FPRINTF(stderr, "Error: smart_create, game pointer is NULL.\n");
+    return NULL;
+  }
+
+  smart_engine smart = (smart_engine)malloc(sizeof(struct smart_engine_s));
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_create, can't allocate smart engine.\n");
+    return NULL;
+  }
+
+  smart->width = game_width(board);
+  smart->height = game_height(board);
+  smart->trees = NULL;
+  smart->nbTrees = 0;
+  smart->regions = NULL;
+  smart->nbFind = 0;
+  smart->nbPropagate = 0;
+  smart->nbDeleted = 0;
+  smart->nbFixed = 0;
+  smart->slabs = NULL;
+  smart->slab = NULL;
+  smart->nbTaken = 0;
+  smart->freePoss = NULL;
+  smart->treeBytes = 0;
+  smart->peakTreeBytes = 0;
+  smart->maxTreeBytes = 0;
+  smart->outOfMemory = false;
+  smart->maxFind = 0;
+  smart->maxMs = 0;
+  smart->startMs = 0;
+  smart->outOfBudget = false;
+  smart->g = copy_game(board);
+  smart->checked = alloc_double_bool_array(smart->width, smart->height);
+  smart->unmovable = alloc_double_bool_array(smart->width, smart->height);
+  uint32_t nbCells = (uint32_t)smart->width * smart->height;
+  smart->domains = (uint8_t *)malloc(nbCells * sizeof(uint8_t));
+  smart->rules = SMART_RULES_ALL;
+  smart->order = SMART_ORDER_FIXED;
+  smart->degrees = (uint8_t *)malloc(nbCells * sizeof(uint8_t));
+  smart->cells = (uint32_t *)malloc((NB_DIR * nbCells + 1) * sizeof(uint32_t));
+  smart->nbFrames = nbCells;
+  smart->frames = (search_frame *)malloc(nbCells * sizeof(search_frame));
+  if (!smart->g || !smart->checked || !smart->unmovable || !smart->domains ||
+      !smart->degrees || !smart->cells || !smart->frames) {
+    FPRINTF(stderr, "Error: smart_create, can't allocate solver state.\n");
+    smart_destroy(smart);
+    return NULL;
+  }
+  return smart;
 }
 
-/**
- * @brief Finds how many solution there are and write it in a .nbsol file
- *
- * @param argv, an array of the arguments
- * @return false in case of error, true otherwise
- **/
-bool nb_sol(char *argv[]) {
-  g = load_game(argv[2]);
-  if (!g) return gameLoadError();
-
-  char nb_solution_fname[FILENAME_MAX_SIZE * 2];
-  STRCPY(nb_solution_fname, argv[3], FILENAME_MAX_SIZE);
-  STRCAT(nb_solution_fname, ".nbsol", FILENAME_MAX_SIZE);
-  FILE *stream;
-  FOPEN(stream, nb_solution_fname, "w");
-  if (!stream) return solFileError(g);
-  uint32_t result = 0;
-
-  uint16_t width = game_width(g);
-  uint16_t height = game_height(g);
-  checked = alloc_double_bool_array(width, height);
-  unmovable = alloc_double_bool_array(width, height);
-  possibility solution = findSolution(0, 0);
-
-  if (solution != NULL) {
-    result = solution->totalNextDerivPos;
-    freeChainPossibility(solution);
-  }
-  FPRINTF(stream, "%u\n", result);
-
-  FCLOSE(stream);
-
-  free_double_bool_array(checked, width);
-  checked = NULL;
-  free_double_bool_array(unmovable, width);
-  unmovable = NULL;
-  delete_game(g);
-  g = NULL;
-  return true;
+void smart_set_rules(smart_engine smart, uint32_t rules) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_set_rules, smart engine is NULL.\n");
+    return;
+  }
+  smart->rules = rules;
 }
 
-/**
- * @brief Finds all the solutions and writes it in .solN files, with N ∈ [1,
- *NB_SOL]
- *
- * @param argv, an array of the arguments
- * @return false in case of error, true otherwise
- **/
-bool find_all(char *argv[]) {
-  g = load_game(argv[2]);
-  if (!g) return gameLoadError();
-
-  // Multiple solution files must be created here
-  uint16_t width = game_width(g);
-  uint16_t height = game_height(g);
-  checked = alloc_double_bool_array(width, height);
-  unmovable = alloc_double_bool_array(width, height);
-
-  possibility solution = findSolution(0, 0);
-
-  if (solution != NULL) {
-    for (uint32_t i = 0; i < solution->totalNextDerivPos; i++) {
-      loadPossibility(solution, i);
-      char sol_num[SOL_NUM_SIZE];
-      SPRINTF(sol_num, SOL_NUM_SIZE, "%u", i + 1);
-      char fNameCopy[FILENAME_MAX_SIZE * 2];
-      STRCPY(fNameCopy, argv[3], FILENAME_MAX_SIZE);
-      STRCAT(fNameCopy, ".sol", FILENAME_MAX_SIZE);
-      STRCAT(fNameCopy, sol_num, FILENAME_MAX_SIZE);
-      save_game(g, fNameCopy);
-    }
-    freeChainPossibility(solution);
-  }
-
-  free_double_bool_array(checked, width);
-  checked = NULL;
-  free_double_bool_array(unmovable, width);
-  unmovable = NULL;
-  delete_game(g);
-  g = NULL;
-  return true;
+void smart_set_order(smart_engine smart, smart_order order) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_set_order, smart engine is NULL.\n");
+    return;
+  }
+  smart->order = order;
 }
 
-/**
- * @brief Finds one solution and applies it to the given game (used for SDL)
- *
- * @param board, the game to solve
- * @return false in case of error, true otherwise
- **/
-bool find_one_sdl(game board) {
-  g = board;
-  uint16_t width = game_width(g);
-  uint16_t height = game_height(g);
-  checked = alloc_double_bool_array(width, height);
-  unmovable = alloc_double_bool_array(width, height);
-  possibility solution = findSolution(0, 0);
-
-  bool status = true;
-  if (solution != NULL) {
-    loadPossibility(solution, 0);
-    freeChainPossibility(solution);
-  } else
-    status = false;
-
-  free_double_bool_array(checked, width);
-  checked = NULL;
-  free_double_bool_array(unmovable, height);
-  unmovable = NULL;
-  g = NULL;
+void smart_set_memory_limit(smart_engine smart, uint64_t max_bytes) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_set_memory_limit, smart engine is NULL.\n");
+    return;
+  }
+  smart->maxTreeBytes = max_bytes;
+}
+
+void smart_set_budget(smart_engine smart, uint64_t max_nodes,
+                      uint32_t max_milliseconds) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_set_budget, smart engine is NULL.\n");
+    return;
+  }
+  smart->maxFind = max_nodes;
+  smart->maxMs = max_milliseconds;
+}
+
+bool smart_solve(smart_engine smart) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_solve, smart engine is NULL.\n");
+    return false;
+  }
+  freeTrees(smart);
+  smart->nbFind = 0;
+  smart->nbPropagate = 0;
+  smart->nbDeleted = 0;
+  smart->nbFixed = 0;
+  smart->peakTreeBytes = smart->treeBytes;
+  smart->outOfMemory = false;
+  smart->startMs = get_milliseconds();
+  smart->outOfBudget = false;
+  for (uint16_t x = 0; x < smart->width; x++) {
+    for (uint16_t y = 0; y < smart->height; y++) {
+      smart->checked[x][y] = false;
+      smart->unmovable[x][y] = false;
+    }
+  }
+  if (!setUnmovable(smart)) return false;
+
+  // The regions the unmovable pieces split the board into are solved apart
+  // when they can't constrain each other, so that the work adds up instead of
+  // multiplying
+  uint32_t nbTrees = findRegions(smart) ? smart->regions->nbGroups : 1;
+  smart->trees = (possibility *)malloc(nbTrees * sizeof(possibility));
+  if (!smart->trees) {
+    FPRINTF(stderr, "Error: smart_solve, can't allocate the trees.\n");
+    freeRegions(smart->regions);
+    smart->regions = NULL;
+    return false;
+  }
+  uint32_t start = smart->regions ? 0 : findStart(smart);
+  for (uint32_t i = 0; i < nbTrees; i++) {
+    possibility tree =
+        smart->regions ? solveRegion(smart, i)
+                       : findSolution(smart, (uint16_t)(start % smart->width),
+                                      (uint16_t)(start / smart->width));
+    if (tree != NULL && (tree->totalNextDerivPos == 0 || smart->outOfMemory ||
+                         smart->outOfBudget)) {
+      freeChainPossibility(smart, tree);
+      tree = NULL;
+    }
+    if (tree == NULL) {
+      // A region without solution leaves none to the board, and the trees
+      // left half built are dropped at once
+      freeTrees(smart);
+      break;
+    }
+    smart->trees[smart->nbTrees++] = tree;
+  }
+  freeRegions(smart->regions);
+  smart->regions = NULL;
+  return smart->nbTrees > 0;
+}
+
+bool smart_out_of_memory(smart_engine smart) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_out_of_memory, smart engine is NULL.\n");
+    return false;
+  }
+  return smart->outOfMemory;
+}
+
+bool smart_out_of_budget(smart_engine smart) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_out_of_budget, smart engine is NULL.\n");
+    return false;
+  }
+  return smart->outOfBudget;
+}
+
+uint32_t smart_nb_solutions(smart_engine smart) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_nb_solutions, smart engine is NULL.\n");
+    return 0;
+  }
+  if (smart->nbTrees == 0) return 0;
+  uint64_t nbSolutions = 1;
+  for (uint32_t i = 0; i < smart->nbTrees; i++) {
+    nbSolutions *= smart->trees[i]->totalNextDerivPos;
+    if (nbSolutions > UINT32_MAX) return UINT32_MAX;
+  }
+  return (uint32_t)nbSolutions;
+}
+
+bool smart_count_solutions(smart_engine smart, sol_count *count) {
+  if (!smart || !count) {
+    FPRINTF(stderr,
+            "Error: smart_count_solutions, smart engine or counter is NULL.\n");
+    return false;
+  }
+  if (smart->nbTrees == 0) return true;
+  sol_count product;
+  sol_count_init(&product, count->big);
+  bool status = sol_count_add_uint(&product, 1);
+  for (uint32_t i = 0; status && i < smart->nbTrees; i++)
+    status = sol_count_mul_uint(&product, smart->trees[i]->totalNextDerivPos);
+  status = status && sol_count_add(count, &product);
+  sol_count_clear(&product);
   return status;
 }
-//--------------------------------------------------------------------------------------
-//                                Error handler functions bodies
 
-/**
- * @brief Prints the error in stderr if a game couldn't be loaded
- * @return false
- **/
-static bool gameLoadError() {
-  FPRINTF(stderr, "Error when loading the game from file!\n");
-  return false;
+bool smart_load_solution(smart_engine smart, uint32_t index, game board) {
+  if (!smart || !board) {
+    FPRINTF(stderr,
+            "Error: smart_load_solution, smart engine or game pointer is "
+            "NULL.\n");
+    return false;
+  }
+  if (index >= smart_nb_solutions(smart)) {
+    FPRINTF(stderr,
+            "Error: smart_load_solution, solution %u doesn't exist.\n", index);
+    return false;
+  }
+  if (game_width(board) != smart->width ||
+      game_height(board) != smart->height) {
+    FPRINTF(stderr,
+            "Error: smart_load_solution, the board doesn't have the size of "
+            "the solved one.\n");
+    return false;
+  }
+
+  direction *dirs = (direction *)malloc((size_t)smart->width * smart->height *
+                                        sizeof(direction));
+  if (!dirs) {
+    FPRINTF(stderr,
+            "Error: smart_load_solution, can't allocate the directions.\n");
+    return false;
+  }
+  // The index is written in the mixed radix of the numbers of leaves of the
+  // trees, the first tree giving the lowest digit
+  for (uint32_t i = 0; i < smart->nbTrees; i++) {
+    uint32_t nbLeaves = smart->trees[i]->totalNextDerivPos;
+    loadPossibility(smart, smart->trees[i], index % nbLeaves);
+    unloadPossibility(smart, smart->trees[i], index % nbLeaves);
+    index /= nbLeaves;
+  }
+  get_cells(smart->g, NULL, dirs);
+  set_current_directions(board, dirs);
+  free(dirs);
+  return true;
 }
 
-/**
- * @brief Prints the error in stderr if a solution file couldn't be created and
- *delete the loaded game
- *
- * @param g, the game loaded before the file was created
- * @return false
- **/
-static bool solFileError(game board) {
-  if (board != NULL) delete_game(board);
-  FPRINTF(stderr, "Error when attempting to create the solution file(s)!\n");
-  return false;
+void smart_get_stats(smart_engine smart, solver_stats *stats) {
+  if (!smart || !stats) {
+    FPRINTF(stderr,
+            "Error: smart_get_stats, smart engine or stats pointer is NULL.\n");
+    return;
+  }
+  stats->nb_nodes = smart->nbFind;
+  stats->nb_propagations = smart->nbPropagate;
+  stats->nb_backtracks = smart->nbDeleted;
+  stats->nb_fixed_cells = smart->nbFixed;
+  stats->peak_tree_bytes = smart->peakTreeBytes;
+}
+
+void smart_destroy(smart_engine smart) {
+  if (!smart) {
+    FPRINTF(stderr, "Error: smart_destroy, smart engine is NULL.\n");
+    return;
+  }
+  freeTrees(smart);
+  freeRegions(smart->regions);
+  while (smart->slabs) {
+    poss_slab *next = smart->slabs->next;
+    free(smart->slabs);
+    smart->slabs = next;
+  }
+  if (smart->checked) free_double_bool_array(smart->checked, smart->width);
+  if (smart->unmovable) free_double_bool_array(smart->unmovable, smart->width);
+  if (smart->g) delete_game(smart->g);
+  free(smart->domains);
+  free(smart->degrees);
+  free(smart->cells);
+  free(smart->frames);
+  free(smart);
 }
 
 // functions for debugging
@@ -320,9 +607,9 @@ static void displayPossTree(possibility poss, uint32_t indice) {
 }*/
 /*
   FPRINTF(stderr, "displaying checked!\n");
-  displayBoolArray(checked, game_width(g), game_height(g));
+  displayBoolArray(smart->checked, smart->width, smart->height);
   FPRINTF(stderr, "displaying unmovable!\n");
-  displayBoolArray(unmovable, game_width(g), game_height(g));
+  displayBoolArray(smart->unmovable, smart->width, smart->height);
   */
 
 //**************************************************************************************
@@ -338,34 +625,42 @@ static void displayPossTree(possibility poss, uint32_t indice) {
  *
  *
  */
-static possibility findSolution(uint16_t x, uint16_t y) {
+static possibility findSolution(smart_engine smart, uint16_t x,
+                                uint16_t y) {
   possibility possFound[NB_DIR], thisPoss;
   uint32_t nbPossFound, nbDerivPos;
   thisPoss = NULL;
 
-  uint16_t width = game_width(g);
-  uint16_t height = game_height(g);
+  uint16_t width = game_width(smart->g);
+  uint16_t height = game_height(smart->g);
 
-  if (setUnmovable()) {
-    if (check_double_bool_array(unmovable, width, height)) {
-      thisPoss = createSinglePoss(0, 0, get_current_direction(g, 0, 0));
-      thisPoss->totalNextDerivPos = 1;
-    } else {
-      thisPoss = createSinglePoss(0, 0, 0);
-      nbPossFound = findPoss(possFound, &nbDerivPos, x, y);
-      spreadLeaf(thisPoss, 0, nbPossFound, possFound, nbDerivPos);
-      for (uint32_t i = 0; i < thisPoss->totalNextDerivPos; i++) {
-        loadPossibility(thisPoss, i);
-        if (!check_double_bool_array(checked, width, height)) {
-          unloadPossibility(thisPoss, i);
-          thisPoss = delLeaf(thisPoss, i);
-          i--;
-          if (thisPoss == NULL) {
-            break;
-          }
-        } else {
-          unloadPossibility(thisPoss, i);
+  if (check_double_bool_array(smart->unmovable, width, height)) {
+    // isGoodDir only sees loops closed next to checked pieces, a board
+    // forced entirely by setUnmovable may still hold a loop
+    if (is_game_over(smart->g)) {
+      thisPoss =
+          createSinglePoss(smart, 0, 0, get_current_direction(smart->g, 0, 0));
+      if (thisPoss != NULL) thisPoss->totalNextDerivPos = 1;
+    }
+  } else {
+    // The root only stands for the cell the search starts from, which its
+    // branches give a direction again
+    thisPoss = createSinglePoss(smart, x, y, 0);
+    if (thisPoss == NULL) return NULL;
+    nbPossFound = findPoss(smart, possFound, &nbDerivPos, x, y);
+    if (smart->outOfMemory || smart->outOfBudget) return thisPoss;
+    spreadLeaf(thisPoss, 0, nbPossFound, possFound, nbDerivPos);
+    for (uint32_t i = 0; i < thisPoss->totalNextDerivPos; i++) {
+      loadPossibility(smart, thisPoss, i);
+      if (!check_double_bool_array(smart->checked, width, height)) {
+        unloadPossibility(smart, thisPoss, i);
+        thisPoss = delLeaf(smart, thisPoss, i);
+        i--;
+        if (thisPoss == NULL) {
+          break;
         }
+      } else {
+        unloadPossibility(smart, thisPoss, i);
       }
     }
   }
@@ -373,215 +668,917 @@ static possibility findSolution(uint16_t x, uint16_t y) {
 }
 
 /**
- * @brief allocate space for a cell of a possibility tree and initialise its
- *main variables
+ * @brief Frees the possibility trees of the last solve
  *
- * @return the possibility (pointer to a possibility_s) created
+ * @param smart, the smart engine holding the game and its state
  **/
-static possibility allocPossibility() {
-  possibility poss = (possibility)malloc(sizeof(struct possibility_s));
-  assert(poss);
-  poss->nbNextDerivPos = (uint32_t *)malloc(NB_DIR * sizeof(uint32_t));
-  assert(poss->nbNextDerivPos);
-  poss->nextPos = (possibility *)malloc(NB_DIR * sizeof(possibility));
-  assert(poss->nextPos);
-  poss->nbNextPos = 0;
-  poss->x = 0;
-  poss->y = 0;
-  poss->dir = N;
-  poss->isLeaf = true;
-  poss->totalNextDerivPos = 0;
-  return poss;
+static void freeTrees(smart_engine smart) {
+  // The trees hold every possibility left, so they are freed at once
+  free(smart->trees);
+  smart->trees = NULL;
+  smart->nbTrees = 0;
+  resetPossibilities(smart);
 }
 
 /**
- * @brief free a possibility from the memory
+ * @brief Splits the movable pieces left by setUnmovable into groups that can
+ *be solved apart, and sets them as the regions of the engine
  *
- * @param pos, the possibility to free
- */
-static void freePossibility(possibility pos) {
-  if (pos != NULL) {
-    if (pos->nextPos != NULL) {
-      free(pos->nextPos);
-    }
-    if (pos->nbNextDerivPos != NULL) {
-      free(pos->nbNextDerivPos);
+ * @param smart, the smart engine holding the game and its state, its
+ *unmovable pieces being set
+ *
+ * @return true if the board splits into several groups, false if it has to be
+ *solved as a whole
+ **/
+static bool findRegions(smart_engine smart) {
+  uint32_t nbCells = (uint32_t)smart->width * smart->height;
+  region_set *regions = (region_set *)calloc(1, sizeof(region_set));
+  uint32_t *stack = (uint32_t *)malloc(nbCells * sizeof(uint32_t));
+  if (regions) {
+    regions->label = (uint32_t *)malloc(nbCells * sizeof(uint32_t));
+    regions->pieces = (piece *)malloc(nbCells * sizeof(piece));
+    regions->dirs = (direction *)malloc(nbCells * sizeof(direction));
+  }
+  if (!regions || !stack || !regions->label || !regions->pieces ||
+      !regions->dirs) {
+    FPRINTF(stderr, "Error: findRegions, can't allocate the regions.\n");
+    free(stack);
+    freeRegions(regions);
+    return false;
+  }
+  get_cells(smart->g, regions->pieces, regions->dirs);
+
+  // A region is a set of movable pieces next to each other
+  uint32_t nbRegions = 0;
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    regions->label[cell] = NO_REGION;
+  }
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    if (regions->label[cell] != NO_REGION ||
+        smart->unmovable[cell % smart->width][cell / smart->width])
+      continue;
+    uint32_t nbStacked = 0;
+    stack[nbStacked++] = cell;
+    regions->label[cell] = nbRegions;
+    while (nbStacked > 0) {
+      uint32_t current = stack[--nbStacked];
+      for (uint8_t i = 0; i < NB_DIR; i++) {
+        uint32_t next = getNeighbour(smart, current, DIRS[i]);
+        if (next != NO_CELL && regions->label[next] == NO_REGION &&
+            !smart->unmovable[next % smart->width][next / smart->width]) {
+          regions->label[next] = nbRegions;
+          stack[nbStacked++] = next;
+        }
+      }
     }
-    free(pos);
+    nbRegions++;
   }
-}
 
-/**
- * @brief free a tree of possibility
- *
- * @param pos, the possibility at the start of the tree to free
- **/
-static void freeChainPossibility(possibility pos) {
-  for (uint32_t i = 0; i < pos->nbNextPos; i++) {
-    freeChainPossibility(pos->nextPos[i]);
+  uint32_t nbLinks = 0;
+  uint64_t *links = NULL;
+  uint32_t *group = NULL;
+  bool split = nbRegions > 1 && labelComps(smart, regions, nbRegions, stack);
+  if (split) {
+    links = findLinks(smart, regions, nbRegions, &nbLinks);
+    group = (uint32_t *)malloc(nbRegions * sizeof(uint32_t));
+    split = links && group &&
+            groupBlocks(nbRegions, nbRegions + regions->nbComps, links,
+                        nbLinks, group) &&
+            buildRegions(smart, regions, nbRegions, group, links, nbLinks);
+  }
+  free(stack);
+  free(links);
+  free(group);
+  if (!split) {
+    freeRegions(regions);
+    return false;
   }
-  freePossibility(pos);
+  smart->regions = regions;
+  return true;
 }
 
 /**
- * @brief allocate and create a possibility (without any branches)
+ * @brief Frees a set of regions
  *
- * @param x, the x coordinate of the piece
- * @param y, the y coordinate of the piece
- * @param dir, the direction to save for this piece
- * @return the possibility created
+ * @param regions, the regions, NULL does nothing
  **/
-static possibility createSinglePoss(uint16_t x, uint16_t y, direction dir) {
-  possibility poss = allocPossibility();
-  poss->x = x;
-  poss->y = y;
-  poss->dir = dir;
-  return poss;
+static void freeRegions(region_set *regions) {
+  if (!regions) return;
+  free(regions->label);
+  free(regions->pieces);
+  free(regions->dirs);
+  free(regions->groupStart);
+  free(regions->groupCells);
+  free(regions->compStart);
+  free(regions->compCells);
+  free(regions->adjStart);
+  free(regions->adjComps);
+  free(regions->home);
+  free(regions->compUser);
+  free(regions);
 }
 
 /**
- * @brief add a possibility (or the start of a chain of possibilities) as a
- *branch of another one
+ * @brief Gives the neighbour of a cell in a direction
  *
- * @param poss, the possibility on which the branch will be added
- * @param chainPoss, the possibility which will be added as a branch of poss
+ * @param smart, the smart engine holding the game and its state
+ * @param cell, the cell, as x + y * width
+ * @param dir, the direction
+ *
+ * @return the neighbour, NO_CELL if it is out of a non wrapping board
  **/
-static void addBranchPoss(possibility poss, possibility chainPoss) {
-  assert(poss);
-  assert(chainPoss);
-  if (poss->nbNextPos >= NB_DIR) {
-    FPRINTF(stderr, "Not enough space to add branch of possibility\n");
-    exit(EXIT_FAILURE);
-  }
-
-  poss->nextPos[poss->nbNextPos] = chainPoss;
-  if (chainPoss->isLeaf) {
-    poss->nbNextDerivPos[poss->nbNextPos] = 1;
-    poss->totalNextDerivPos += 1;
-  } else {
-    poss->nbNextDerivPos[poss->nbNextPos] = chainPoss->totalNextDerivPos;
-    poss->totalNextDerivPos += chainPoss->totalNextDerivPos;
+static uint32_t getNeighbour(smart_engine smart, uint32_t cell,
+                             direction dir) {
+  int32_t x, y;
+  getCoordFromDir(dir, &x, &y);
+  x += (int32_t)(cell % smart->width);
+  y += (int32_t)(cell / smart->width);
+  if (is_wrapping(smart->g)) {
+    x = (x + smart->width) % smart->width;
+    y = (y + smart->height) % smart->height;
+  } else if (x < 0 || x >= smart->width || y < 0 || y >= smart->height) {
+    return NO_CELL;
   }
-  poss->nbNextPos++;
-  poss->isLeaf = false;
+  return (uint32_t)x + (uint32_t)y * smart->width;
 }
 
-///////////////////// Commented because unused /////////////////////
-
 /**
- * @brief search a leaf in a possibility tree and returns it
+ * @brief Labels the components of the unmovable pieces, linked by their
+ *connections, with nbRegions plus their index
  *
- * @param poss, the possibility at the start of the possibility tree
- * @param numLeaf, the leaf to search for
+ * @param smart, the smart engine holding the game and its state
+ * @param regions, the regions, the movable pieces being labelled
+ * @param nbRegions, the number of regions of movable pieces
+ * @param stack, a stack of one cell per cell
  *
- * @return the possibility corresponding to the leaf demanded
+ * @return false if a component holds a loop, the board is then left to the
+ *search as a whole, true otherwise
  **/
-
-/*
-static possibility getLeaf(possibility poss, uint32_t numLeaf) {
-  assert(poss);
-  if (poss->isLeaf)
-    return poss;  // we've reached the end of the possibility tree
-  uint32_t i = 0;
-  while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numLeaf) {
-    numLeaf -= poss->nbNextDerivPos[i];
-    i++;
-  }
-  if (i >= poss->nbNextPos) {
-    FPRINTF(stderr,
-            "error : wrong parameter given or malformed possibility tree!\n");
-    exit(EXIT_FAILURE);
+static bool labelComps(smart_engine smart, region_set *regions,
+                       uint32_t nbRegions, uint32_t *stack) {
+  uint32_t nbCells = (uint32_t)smart->width * smart->height;
+  regions->nbComps = 0;
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    if (regions->label[cell] != NO_REGION) continue;
+    uint32_t nbStacked = 0, size = 0, nbEnds = 0;
+    stack[nbStacked++] = cell;
+    regions->label[cell] = nbRegions + regions->nbComps;
+    while (nbStacked > 0) {
+      uint32_t current = stack[--nbStacked];
+      size++;
+      for (uint8_t i = 0; i < NB_DIR; i++) {
+        if (!is_edge(regions->pieces[current], regions->dirs[current],
+                     DIRS[i]))
+          continue;
+        uint32_t next = getNeighbour(smart, current, DIRS[i]);
+        if (next == NO_CELL ||
+            !smart->unmovable[next % smart->width][next / smart->width])
+          continue;
+        // Every connection between unmovable pieces is seen from both ends
+        nbEnds++;
+        if (regions->label[next] == NO_REGION) {
+          regions->label[next] = nbRegions + regions->nbComps;
+          stack[nbStacked++] = next;
+        }
+      }
+    }
+    if (nbEnds != 2 * (size - 1)) return false;
+    regions->nbComps++;
   }
-  return getLeaf(poss->nextPos[i], numLeaf);
-}*/
-
-////////////////////////////////////////////////////////////////////
+  return regions->nbComps > 0;
+}
 
 /**
- * @brief adds branches to a leaf (which wont be a leaf anymore) and update
- *accordingly the previous possibilies (nbDerivPoss, etc.)
+ * @brief Lists the pairs of a region and a component linked by a connection of
+ *an unmovable piece
  *
- * @param poss, the possibility at the start of the tree from which the leaf
- *want to be extended
- * @param numLeaf, the leaf to extend
- * @param nbPossToAdd, the number of deriving possibilities (branches) to add to
- *the leaf
- * @param possToAdd, an array containing the possibilities to add
+ * @param smart, the smart engine holding the game and its state
+ * @param regions, the regions, all the pieces being labelled
+ * @param nbRegions, the number of regions of movable pieces
+ * @param nbLinks, where the number of pairs is written
+ *
+ * @return the pairs, sorted and without duplicates, each one being the region
+ *in the high 32 bits and the component in the low ones, NULL in case of error
  **/
-static void spreadLeaf(possibility poss, uint32_t numLeaf, uint32_t nbPossToAdd,
-                       possibility *possToAdd, uint32_t nbDerivPos) {
-  if (poss->isLeaf) {
-    for (uint32_t j = 0; j < nbPossToAdd; j++) {
-      addBranchPoss(poss, possToAdd[j]);
-    }
-    return;
+static uint64_t *findLinks(smart_engine smart, const region_set *regions,
+                           uint32_t nbRegions, uint32_t *nbLinks) {
+  uint32_t nbCells = (uint32_t)smart->width * smart->height;
+  uint64_t *links = (uint64_t *)malloc(NB_DIR * nbCells * sizeof(uint64_t));
+  if (!links) {
+    FPRINTF(stderr, "Error: findLinks, can't allocate the links.\n");
+    return NULL;
   }
-
-  uint32_t i = 0;
-  while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numLeaf) {
-    numLeaf -= poss->nbNextDerivPos[i];
-    i++;
+  uint32_t nbFound = 0;
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    if (regions->label[cell] < nbRegions) continue;
+    for (uint8_t i = 0; i < NB_DIR; i++) {
+      if (!is_edge(regions->pieces[cell], regions->dirs[cell], DIRS[i]))
+        continue;
+      uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+      if (next != NO_CELL && regions->label[next] < nbRegions)
+        links[nbFound++] = (uint64_t)regions->label[next] << 32 |
+                           (regions->label[cell] - nbRegions);
+    }
   }
-  if (i >= poss->nbNextPos) {
-    FPRINTF(stderr,
-            "error : wrong parameter given or malformed possibility tree!\n");
-    exit(EXIT_FAILURE);
+  qsort(links, nbFound, sizeof(uint64_t), compareLinks);
+  *nbLinks = 0;
+  for (uint32_t i = 0; i < nbFound; i++) {
+    if (*nbLinks == 0 || links[*nbLinks - 1] != links[i])
+      links[(*nbLinks)++] = links[i];
   }
-
-  poss->nbNextDerivPos[i] += (nbDerivPos - 1);
-  poss->totalNextDerivPos += (nbDerivPos - 1);
-  spreadLeaf(poss->nextPos[i], numLeaf, nbPossToAdd, possToAdd, nbDerivPos);
+  return links;
 }
 
 /**
- * @brief delete a leaf and the previous branche from a tree and update
- *accordingly the previous possibilies (nbDerivPoss, etc.)
+ * @brief Finds the representative of a node in a union-find, halving the path
+ *to it
  *
- * @param poss, the possibility at the start of the tree from which the leaf
- *want to be removed
- * @param numLeaf, the leaf to delete
+ * @param parent, the parent of each node, a representative being its own
+ * @param node, the node
  *
- * @return poss if there is still other branches on the tree or NULL if it was
- *completely removed
+ * @return the representative of the node
  **/
-static possibility delLeaf(possibility poss, uint32_t numLeaf) {
-  if (poss->totalNextDerivPos <= 1) {
-    freeChainPossibility(poss);
-    return NULL;
-  }
-  uint32_t i = 0;
-  while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numLeaf) {
-    numLeaf -= poss->nbNextDerivPos[i];
-    i++;
-  }
-  if (i >= poss->nbNextPos) {
-    FPRINTF(stderr,
-            "error : wrong parameter given or malformed possibility tree!\n");
-    exit(EXIT_FAILURE);
-  }
-  delLeaf(poss->nextPos[i], numLeaf);
-  poss->totalNextDerivPos--;
-  poss->nbNextDerivPos[i]--;
-  if (poss->nbNextDerivPos[i] == 0) {
-    while (i < poss->nbNextPos - 1) {
-      poss->nbNextDerivPos[i] = poss->nbNextDerivPos[i + 1];
-      poss->nextPos[i] = poss->nextPos[i + 1];
-      i++;
-    }
-    poss->nbNextPos--;
+static uint32_t findRoot(uint32_t *parent, uint32_t node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
   }
-  if (poss->nbNextPos == 0) {
-    poss->isLeaf = true;
-  }
-  return poss;
+  return node;
 }
 
 /**
- * @brief Transform a direction into coordinates
+ * @brief Groups the regions that belong to the same biconnected block of the
+ *graph of the regions and the components, with an iterative version of
+ *Tarjan's algorithm. Two regions on a cycle of this graph can constrain each
+ *other, two regions only joined through a single component can't
  *
- * @param dir, the direction we want to convert
- * @param x, a pointer to the x value of the coordinates
- * @param y, a pointer to the y value of the coordinates
+ * @param nbRegions, the number of regions, which are the first nodes
+ * @param nbNodes, the number of nodes, the components following the regions
+ * @param links, the edges, as given by findLinks
+ * @param nbLinks, the number of edges
+ * @param group, where the union-find of the regions is written
+ *
+ * @return false if the graph isn't connected, the board having then no
+ *solution, or in case of error, true otherwise
+ **/
+static bool groupBlocks(uint32_t nbRegions, uint32_t nbNodes,
+                        const uint64_t *links, uint32_t nbLinks,
+                        uint32_t *group) {
+  uint32_t *adjStart = (uint32_t *)calloc(nbNodes + 1, sizeof(uint32_t));
+  uint32_t *adj = (uint32_t *)malloc(2 * nbLinks * sizeof(uint32_t) + 1);
+  uint32_t *disc = (uint32_t *)calloc(nbNodes, sizeof(uint32_t));
+  uint32_t *low = (uint32_t *)malloc(nbNodes * sizeof(uint32_t));
+  uint32_t *next = (uint32_t *)malloc(nbNodes * sizeof(uint32_t));
+  uint32_t *parent = (uint32_t *)malloc(nbNodes * sizeof(uint32_t));
+  uint32_t *calls = (uint32_t *)malloc(nbNodes * sizeof(uint32_t));
+  uint64_t *edges = (uint64_t *)malloc(nbLinks * sizeof(uint64_t) + 1);
+  bool status = adjStart && adj && disc && low && next && parent && calls &&
+                edges;
+  if (!status) {
+    FPRINTF(stderr, "Error: groupBlocks, can't allocate the search.\n");
+  } else {
+    for (uint32_t i = 0; i < nbLinks; i++) {
+      adjStart[(uint32_t)(links[i] >> 32) + 1]++;
+      adjStart[nbRegions + (uint32_t)links[i] + 1]++;
+    }
+    for (uint32_t node = 0; node < nbNodes; node++) {
+      adjStart[node + 1] += adjStart[node];
+      next[node] = adjStart[node];
+    }
+    for (uint32_t i = 0; i < nbLinks; i++) {
+      uint32_t region = (uint32_t)(links[i] >> 32);
+      uint32_t comp = nbRegions + (uint32_t)links[i];
+      adj[next[region]++] = comp;
+      adj[next[comp]++] = region;
+    }
+    for (uint32_t node = 0; node < nbNodes; node++) next[node] = adjStart[node];
+    for (uint32_t region = 0; region < nbRegions; region++)
+      group[region] = region;
+
+    uint32_t time = 0, nbCalls = 0, nbEdges = 0;
+    calls[nbCalls++] = 0;
+    disc[0] = low[0] = ++time;
+    parent[0] = NO_CELL;
+    while (nbCalls > 0) {
+      uint32_t node = calls[nbCalls - 1];
+      if (next[node] < adjStart[node + 1]) {
+        uint32_t other = adj[next[node]++];
+        if (!disc[other]) {
+          edges[nbEdges++] = (uint64_t)node << 32 | other;
+          parent[other] = node;
+          disc[other] = low[other] = ++time;
+          calls[nbCalls++] = other;
+        } else if (other != parent[node] && disc[other] < disc[node]) {
+          edges[nbEdges++] = (uint64_t)node << 32 | other;
+          if (disc[other] < low[node]) low[node] = disc[other];
+        }
+        continue;
+      }
+      nbCalls--;
+      if (nbCalls == 0) break;
+      uint32_t above = parent[node];
+      if (low[node] < low[above]) low[above] = low[node];
+      if (low[node] < disc[above]) continue;
+      // The edges pushed since the one to node form a block
+      uint32_t first = NO_REGION;
+      uint64_t edge;
+      do {
+        edge = edges[--nbEdges];
+        uint32_t ends[2] = {(uint32_t)(edge >> 32), (uint32_t)edge};
+        for (uint8_t i = 0; i < 2; i++) {
+          if (ends[i] >= nbRegions) continue;
+          if (first == NO_REGION)
+            first = findRoot(group, ends[i]);
+          else
+            group[findRoot(group, ends[i])] = first;
+        }
+      } while (edge != ((uint64_t)above << 32 | node));
+    }
+    status = time == nbNodes;
+  }
+  free(adjStart);
+  free(adj);
+  free(disc);
+  free(low);
+  free(next);
+  free(parent);
+  free(calls);
+  free(edges);
+  return status;
+}
+
+/**
+ * @brief Fills a set of regions from the groups of the regions, if the groups
+ *and the components they are linked to form a tree
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param regions, the regions, all the pieces being labelled
+ * @param nbRegions, the number of regions of movable pieces
+ * @param group, the union-find of the regions given by groupBlocks
+ * @param links, the links given by findLinks, they are overwritten
+ * @param nbLinks, the number of links
+ *
+ * @return true if the board splits into several groups, false otherwise or in
+ *case of error
+ **/
+static bool buildRegions(smart_engine smart, region_set *regions,
+                         uint32_t nbRegions, uint32_t *group, uint64_t *links,
+                         uint32_t nbLinks) {
+  uint32_t nbCells = (uint32_t)smart->width * smart->height;
+  uint32_t nbComps = regions->nbComps;
+  // The representatives of the groups are numbered in the order of the cells
+  uint32_t *number = (uint32_t *)malloc(nbRegions * sizeof(uint32_t));
+  if (!number) {
+    FPRINTF(stderr, "Error: buildRegions, can't allocate the groups.\n");
+    return false;
+  }
+  uint32_t nbGroups = 0;
+  for (uint32_t region = 0; region < nbRegions; region++)
+    number[region] = NO_REGION;
+  for (uint32_t region = 0; region < nbRegions; region++) {
+    uint32_t root = findRoot(group, region);
+    if (number[root] == NO_REGION) number[root] = nbGroups++;
+    number[region] = number[root];
+  }
+
+  // With the regions of a block together, the groups and the components form
+  // a tree unless a cycle goes through several blocks
+  for (uint32_t i = 0; i < nbLinks; i++)
+    links[i] = (uint64_t)number[links[i] >> 32] << 32 | (uint32_t)links[i];
+  qsort(links, nbLinks, sizeof(uint64_t), compareLinks);
+  uint32_t nbGroupLinks = 0;
+  for (uint32_t i = 0; i < nbLinks; i++) {
+    if (nbGroupLinks == 0 || links[nbGroupLinks - 1] != links[i])
+      links[nbGroupLinks++] = links[i];
+  }
+  if (nbGroups < 2 || nbGroupLinks != nbGroups + nbComps - 1) {
+    free(number);
+    return false;
+  }
+
+  regions->nbGroups = nbGroups;
+  regions->groupStart = (uint32_t *)calloc(nbGroups + 1, sizeof(uint32_t));
+  regions->groupCells = (uint32_t *)malloc(nbCells * sizeof(uint32_t));
+  regions->compStart = (uint32_t *)calloc(nbComps + 1, sizeof(uint32_t));
+  regions->compCells = (uint32_t *)malloc(nbCells * sizeof(uint32_t));
+  regions->adjStart = (uint32_t *)calloc(nbGroups + 1, sizeof(uint32_t));
+  regions->adjComps = (uint32_t *)malloc(nbGroupLinks * sizeof(uint32_t));
+  regions->home = (uint32_t *)malloc(nbGroups * sizeof(uint32_t));
+  regions->compUser = (uint32_t *)malloc(nbComps * sizeof(uint32_t));
+  if (!regions->groupStart || !regions->groupCells || !regions->compStart ||
+      !regions->compCells || !regions->adjStart || !regions->adjComps ||
+      !regions->home || !regions->compUser) {
+    FPRINTF(stderr, "Error: buildRegions, can't allocate the groups.\n");
+    free(number);
+    return false;
+  }
+
+  // The cells are relabelled and listed by group and by component
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    uint32_t label = regions->label[cell];
+    if (label < nbRegions) {
+      regions->label[cell] = number[label];
+      regions->groupStart[number[label] + 1]++;
+    } else {
+      regions->label[cell] = nbGroups + label - nbRegions;
+      regions->compStart[label - nbRegions + 1]++;
+    }
+  }
+  free(number);
+  for (uint32_t g = 0; g < nbGroups; g++)
+    regions->groupStart[g + 1] += regions->groupStart[g];
+  for (uint32_t comp = 0; comp < nbComps; comp++)
+    regions->compStart[comp + 1] += regions->compStart[comp];
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    uint32_t label = regions->label[cell];
+    if (label < nbGroups)
+      regions->groupCells[regions->groupStart[label]++] = cell;
+    else
+      regions->compCells[regions->compStart[label - nbGroups]++] = cell;
+  }
+  // Filling moved every start to the start of the next set
+  for (uint32_t g = nbGroups; g > 0; g--)
+    regions->groupStart[g] = regions->groupStart[g - 1];
+  regions->groupStart[0] = 0;
+  for (uint32_t comp = nbComps; comp > 0; comp--)
+    regions->compStart[comp] = regions->compStart[comp - 1];
+  regions->compStart[0] = 0;
+
+  for (uint32_t i = 0; i < nbGroupLinks; i++) {
+    uint32_t g = (uint32_t)(links[i] >> 32);
+    regions->adjComps[i] = (uint32_t)links[i];
+    regions->adjStart[g + 1]++;
+  }
+  for (uint32_t g = 0; g < nbGroups; g++) {
+    regions->adjStart[g + 1] += regions->adjStart[g];
+    uint32_t home = regions->adjComps[regions->adjStart[g]];
+    for (uint32_t i = regions->adjStart[g]; i < regions->adjStart[g + 1]; i++) {
+      uint32_t comp = regions->adjComps[i];
+      if (regions->compStart[comp + 1] - regions->compStart[comp] >
+          regions->compStart[home + 1] - regions->compStart[home])
+        home = comp;
+    }
+    regions->home[g] = home;
+  }
+  for (uint32_t comp = 0; comp < nbComps; comp++)
+    regions->compUser[comp] = NO_REGION;
+  return true;
+}
+
+/**
+ * @brief Builds the possibility tree of a group of the regions, the largest
+ *component linked to it being taken as already placed. Each piece this
+ *component is connected to starts a branch of the tree, the branches being
+ *chained like the connections of a piece in propagate
+ *
+ * @param smart, the smart engine holding the game and its state, with its
+ *regions
+ * @param group, the group to solve
+ *
+ * @return the possibility tree of the group, NULL if it has no solution
+ **/
+static possibility solveRegion(smart_engine smart, uint32_t group) {
+  region_set *regions = smart->regions;
+  uint32_t home = regions->nbGroups + regions->home[group];
+  regions->current = group;
+  for (uint32_t i = regions->adjStart[group]; i < regions->adjStart[group + 1];
+       i++) {
+    if (regions->adjComps[i] != regions->home[group])
+      regions->compUser[regions->adjComps[i]] = group;
+  }
+
+  possibility possFound[NB_DIR], thisPoss = NULL;
+  uint32_t nbPossFound, nbDerivPos;
+  for (uint32_t i = regions->groupStart[group];
+       i < regions->groupStart[group + 1]; i++) {
+    uint32_t cell = regions->groupCells[i];
+    bool isEntry = false;
+    for (uint8_t j = 0; j < NB_DIR && !isEntry; j++) {
+      uint32_t next = getNeighbour(smart, cell, DIRS[j]);
+      isEntry = next != NO_CELL && regions->label[next] == home &&
+                is_edge(regions->pieces[next], regions->dirs[next],
+                        opposite_direction(DIRS[j]));
+    }
+    if (!isEntry) continue;
+
+    uint16_t x = (uint16_t)(cell % smart->width);
+    uint16_t y = (uint16_t)(cell / smart->width);
+    if (thisPoss == NULL) {
+      thisPoss = createSinglePoss(smart, x, y, N);
+      if (thisPoss == NULL) return NULL;
+      nbPossFound = findPoss(smart, possFound, &nbDerivPos, x, y);
+      if (nbPossFound == 0) {
+        freeChainPossibility(smart, thisPoss);
+        return NULL;
+      }
+      spreadLeaf(thisPoss, 0, nbPossFound, possFound, nbDerivPos);
+      continue;
+    }
+    for (uint32_t numPoss = 0;
+         thisPoss != NULL && numPoss < thisPoss->totalNextDerivPos; numPoss++) {
+      loadPossibility(smart, thisPoss, numPoss);
+      // A piece already placed from another branch would close a loop
+      nbPossFound = smart->checked[x][y]
+                        ? 0
+                        : findPoss(smart, possFound, &nbDerivPos, x, y);
+      unloadPossibility(smart, thisPoss, numPoss);
+      if (smart->outOfMemory || smart->outOfBudget) return thisPoss;
+      if (nbPossFound == 0) {
+        thisPoss = delLeaf(smart, thisPoss, numPoss);
+        numPoss--;
+      } else {
+        spreadLeaf(thisPoss, numPoss, nbPossFound, possFound, nbDerivPos);
+        numPoss += nbDerivPos - 1;
+      }
+    }
+    if (thisPoss == NULL) return NULL;
+  }
+
+  for (uint32_t numPoss = 0;
+       thisPoss != NULL && numPoss < thisPoss->totalNextDerivPos; numPoss++) {
+    if (!isRegionPlaced(smart, thisPoss, numPoss)) {
+      thisPoss = delLeaf(smart, thisPoss, numPoss);
+      numPoss--;
+    }
+  }
+  return thisPoss;
+}
+
+/**
+ * @brief Tells whether a possibility of the group being solved places all its
+ *pieces and the ones of the components it goes through
+ *
+ * @param smart, the smart engine holding the game and its state, with its
+ *regions
+ * @param tree, the possibility tree of the group
+ * @param numLeaf, the possibility to check
+ *
+ * @return true if every piece is placed, false otherwise
+ **/
+static bool isRegionPlaced(smart_engine smart, possibility tree,
+                           uint32_t numLeaf) {
+  region_set *regions = smart->regions;
+  uint32_t group = regions->current;
+  bool placed = true;
+  loadPossibility(smart, tree, numLeaf);
+  for (uint32_t i = regions->groupStart[group];
+       placed && i < regions->groupStart[group + 1]; i++) {
+    uint32_t cell = regions->groupCells[i];
+    placed = smart->checked[cell % smart->width][cell / smart->width];
+  }
+  for (uint32_t i = regions->adjStart[group];
+       placed && i < regions->adjStart[group + 1]; i++) {
+    uint32_t comp = regions->adjComps[i];
+    if (comp == regions->home[group]) continue;
+    for (uint32_t j = regions->compStart[comp];
+         placed && j < regions->compStart[comp + 1]; j++) {
+      uint32_t cell = regions->compCells[j];
+      placed = smart->checked[cell % smart->width][cell / smart->width];
+    }
+  }
+  unloadPossibility(smart, tree, numLeaf);
+  return placed;
+}
+
+/**
+ * @brief Tells whether a piece belongs to the network being built: it is
+ *placed, or it is in the component taken as placed by the group being solved
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param x, the x coordinate of the piece
+ * @param y, the y coordinate of the piece
+ *
+ * @return true if the piece is part of the network, false otherwise
+ **/
+static bool isInTree(smart_engine smart, uint16_t x, uint16_t y) {
+  if (smart->checked[x][y]) return true;
+  region_set *regions = smart->regions;
+  return regions &&
+         regions->label[x + (uint32_t)y * smart->width] ==
+             regions->nbGroups + regions->home[regions->current];
+}
+
+/**
+ * @brief Tells whether a piece is out of the search of the group being solved:
+ *it belongs to another group, or to a component the group doesn't go through
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param x, the x coordinate of the piece
+ * @param y, the y coordinate of the piece
+ *
+ * @return true if the search mustn't go to this piece, false otherwise
+ **/
+static bool isOutside(smart_engine smart, uint16_t x, uint16_t y) {
+  region_set *regions = smart->regions;
+  if (!regions) return false;
+  uint32_t label = regions->label[x + (uint32_t)y * smart->width];
+  if (label < regions->nbGroups) return label != regions->current;
+  return regions->compUser[label - regions->nbGroups] != regions->current;
+}
+
+/**
+ * @brief Compares two links for qsort
+ *
+ * @param first, a pointer to the first link
+ * @param second, a pointer to the second link
+ *
+ * @return a negative, zero or positive value if the first link is lower,
+ *equal or greater than the second one
+ **/
+static int compareLinks(const void *first, const void *second) {
+  uint64_t a = *(const uint64_t *)first;
+  uint64_t b = *(const uint64_t *)second;
+  return (a > b) - (a < b);
+}
+
+/**
+ * @brief allocate space for a cell of a possibility tree and initialise its
+ *main variables. It is taken from the possibilities freed since the last
+ *reset, or else from the slabs of the engine
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @return the possibility (pointer to a possibility_s) created, NULL if the
+ *trees would hold more memory than allowed or if it can't be allocated, the
+ *engine being then out of memory
+ **/
+static possibility allocPossibility(smart_engine smart) {
+  if (smart->maxTreeBytes &&
+      smart->treeBytes + POSS_BYTES > smart->maxTreeBytes) {
+    smart->outOfMemory = true;
+    return NULL;
+  }
+  possibility poss = smart->freePoss;
+  if (poss) {
+    smart->freePoss = poss->nextPos[0];
+  } else {
+    if (!smart->slab || smart->nbTaken == SLAB_SIZE) {
+      // The slabs kept by the last reset are filled again before new ones
+      poss_slab *next = smart->slab ? smart->slab->next : smart->slabs;
+      if (!next) {
+        next = (poss_slab *)malloc(sizeof(poss_slab));
+        if (!next) {
+          FPRINTF(stderr, "Not enough memory to allocate a possibility\n");
+          smart->outOfMemory = true;
+          return NULL;
+        }
+        next->next = NULL;
+        if (smart->slab)
+          smart->slab->next = next;
+        else
+          smart->slabs = next;
+      }
+      smart->slab = next;
+      smart->nbTaken = 0;
+    }
+    poss = &smart->slab->poss[smart->nbTaken++];
+  }
+  poss->nbNextPos = 0;
+  poss->x = 0;
+  poss->y = 0;
+  poss->dir = N;
+  poss->isLeaf = true;
+  poss->totalNextDerivPos = 0;
+  smart->treeBytes += POSS_BYTES;
+  if (smart->treeBytes > smart->peakTreeBytes)
+    smart->peakTreeBytes = smart->treeBytes;
+  return poss;
+}
+
+/**
+ * @brief free a possibility from the memory, it is kept for the next
+ *allocations
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param pos, the possibility to free
+ */
+static void freePossibility(smart_engine smart, possibility pos) {
+  if (pos != NULL) {
+    smart->treeBytes -= POSS_BYTES;
+    pos->nextPos[0] = smart->freePoss;
+    smart->freePoss = pos;
+  }
+}
+
+/**
+ * @brief free every possibility at once, the slabs being kept for the next
+ *solve. No tree may be left when it is called
+ *
+ * @param smart, the smart engine holding the game and its state
+ **/
+static void resetPossibilities(smart_engine smart) {
+  smart->slab = NULL;
+  smart->nbTaken = 0;
+  smart->freePoss = NULL;
+  smart->treeBytes = 0;
+}
+
+/**
+ * @brief free a tree of possibility
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param pos, the possibility at the start of the tree to free
+ **/
+static void freeChainPossibility(smart_engine smart, possibility pos) {
+  // Small trees are freed with a stack on the call stack, larger ones move it
+  // to the heap
+  possibility localStack[FREE_STACK_SIZE];
+  possibility *stack = localStack;
+  uint32_t size = FREE_STACK_SIZE, nbPoss = 0;
+  stack[nbPoss++] = pos;
+  while (nbPoss > 0) {
+    pos = stack[--nbPoss];
+    if (nbPoss + pos->nbNextPos > size) {
+      possibility *bigger =
+          (possibility *)malloc(2 * size * sizeof(possibility));
+      if (!bigger) {
+        FPRINTF(stderr, "Not enough memory to free a possibility tree\n");
+        exit(EXIT_FAILURE);
+      }
+      memcpy(bigger, stack, nbPoss * sizeof(possibility));
+      if (stack != localStack) free(stack);
+      stack = bigger;
+      size *= 2;
+    }
+    for (uint32_t i = 0; i < pos->nbNextPos; i++)
+      stack[nbPoss++] = pos->nextPos[i];
+    freePossibility(smart, pos);
+  }
+  if (stack != localStack) free(stack);
+}
+
+/**
+ * @brief allocate and create a possibility (without any branches)
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param x, the x coordinate of the piece
+ * @param y, the y coordinate of the piece
+ * @param dir, the direction to save for this piece
+ * @return the possibility created, NULL if the engine is out of memory
+ **/
+static possibility createSinglePoss(smart_engine smart, uint16_t x, uint16_t y,
+                                    direction dir) {
+  possibility poss = allocPossibility(smart);
+  if (poss == NULL) return NULL;
+  poss->x = x;
+  poss->y = y;
+  poss->dir = dir;
+  return poss;
+}
+
+/**
+ * @brief add a possibility (or the start of a chain of possibilities) as a
+ *branch of another one
+ *
+ * @param poss, the possibility on which the branch will be added
+ * @param chainPoss, the possibility which will be added as a branch of poss
+ **/
+static void addBranchPoss(possibility poss, possibility chainPoss) {
+  assert(poss);
+  assert(chainPoss);
+  if (poss->nbNextPos >= NB_DIR) {
+    FPRINTF(stderr, "Not enough space to add branch of possibility\n");
+    exit(EXIT_FAILURE);
+  }
+
+  poss->nextPos[poss->nbNextPos] = chainPoss;
+  if (chainPoss->isLeaf) {
+    poss->nbNextDerivPos[poss->nbNextPos] = 1;
+    poss->totalNextDerivPos += 1;
+  } else {
+    poss->nbNextDerivPos[poss->nbNextPos] = chainPoss->totalNextDerivPos;
+    poss->totalNextDerivPos += chainPoss->totalNextDerivPos;
+  }
+  poss->nbNextPos++;
+  poss->isLeaf = false;
+}
+
+///////////////////// Commented because unused /////////////////////
+
+/**
+ * @brief search a leaf in a possibility tree and returns it
+ *
+ * @param poss, the possibility at the start of the possibility tree
+ * @param numLeaf, the leaf to search for
+ *
+ * @return the possibility corresponding to the leaf demanded
+ **/
+
+/*
+static possibility getLeaf(possibility poss, uint32_t numLeaf) {
+  assert(poss);
+  if (poss->isLeaf)
+    return poss;  // we've reached the end of the possibility tree
+  uint32_t i = 0;
+  while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numLeaf) {
+    numLeaf -= poss->nbNextDerivPos[i];
+    i++;
+  }
+  if (i >= poss->nbNextPos) {
+    FPRINTF(stderr,
+            "error : wrong parameter given or malformed possibility tree!\n");
+    exit(EXIT_FAILURE);
+  }
+  return getLeaf(poss->nextPos[i], numLeaf);
+}*/
+
+////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief adds branches to a leaf (which wont be a leaf anymore) and update
+ *accordingly the previous possibilies (nbDerivPoss, etc.)
+ *
+ * @param poss, the possibility at the start of the tree from which the leaf
+ *want to be extended
+ * @param numLeaf, the leaf to extend
+ * @param nbPossToAdd, the number of deriving possibilities (branches) to add to
+ *the leaf
+ * @param possToAdd, an array containing the possibilities to add
+ **/
+static void spreadLeaf(possibility poss, uint32_t numLeaf, uint32_t nbPossToAdd,
+                       possibility *possToAdd, uint32_t nbDerivPos) {
+  while (!poss->isLeaf) {
+    uint32_t i = 0;
+    while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numLeaf) {
+      numLeaf -= poss->nbNextDerivPos[i];
+      i++;
+    }
+    if (i >= poss->nbNextPos) {
+      FPRINTF(stderr,
+              "error : wrong parameter given or malformed possibility tree!\n");
+      exit(EXIT_FAILURE);
+    }
+
+    poss->nbNextDerivPos[i] += (nbDerivPos - 1);
+    poss->totalNextDerivPos += (nbDerivPos - 1);
+    poss = poss->nextPos[i];
+  }
+
+  for (uint32_t j = 0; j < nbPossToAdd; j++) {
+    addBranchPoss(poss, possToAdd[j]);
+  }
+}
+
+/**
+ * @brief delete a leaf and the previous branche from a tree and update
+ *accordingly the previous possibilies (nbDerivPoss, etc.)
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param poss, the possibility at the start of the tree from which the leaf
+ *want to be removed
+ * @param numLeaf, the leaf to delete
+ *
+ * @return poss if there is still other branches on the tree or NULL if it was
+ *completely removed
+ **/
+static possibility delLeaf(smart_engine smart, possibility poss,
+                           uint32_t numLeaf) {
+  smart->nbDeleted++;
+  if (poss->totalNextDerivPos <= 1) {
+    freeChainPossibility(smart, poss);
+    return NULL;
+  }
+  // Every possibility on the way to the leaf loses it, until the branch
+  // holding nothing but the leaf, which is removed
+  possibility current = poss;
+  while (true) {
+    uint32_t i = 0;
+    while (i < current->nbNextPos && current->nbNextDerivPos[i] <= numLeaf) {
+      numLeaf -= current->nbNextDerivPos[i];
+      i++;
+    }
+    if (i >= current->nbNextPos) {
+      FPRINTF(stderr,
+              "error : wrong parameter given or malformed possibility tree!\n");
+      exit(EXIT_FAILURE);
+    }
+    possibility next = current->nextPos[i];
+    current->totalNextDerivPos--;
+    current->nbNextDerivPos[i]--;
+    if (current->nbNextDerivPos[i] > 0) {
+      current = next;
+      continue;
+    }
+
+    freeChainPossibility(smart, next);
+    while (i < current->nbNextPos - 1) {
+      current->nbNextDerivPos[i] = current->nbNextDerivPos[i + 1];
+      current->nextPos[i] = current->nextPos[i + 1];
+      i++;
+    }
+    current->nbNextPos--;
+    if (current->nbNextPos == 0) {
+      current->isLeaf = true;
+    }
+    return poss;
+  }
+}
+
+/**
+ * @brief Transform a direction into coordinates
+ *
+ * @param dir, the direction we want to convert
+ * @param x, a pointer to the x value of the coordinates
+ * @param y, a pointer to the y value of the coordinates
  */
 static void getCoordFromDir(direction dir, int32_t *x, int32_t *y) {
   if (!x || !y) {
@@ -612,157 +1609,509 @@ static void getCoordFromDir(direction dir, int32_t *x, int32_t *y) {
 }
 
 /**
- * @brief Set the unmovable double array : check if some pieces (CROSS, or TEE
- *next to a non warping border for example) can be set as unmovable before
- *lauching the solving algorithm
+ * @brief Set the unmovable double array : narrows the domains of the pieces
+ *with the deduction rules of the engine until none of them can remove an
+ *orientation, then fixes the pieces left with a single one (CROSS, or TEE next
+ *to a non warping border for example) before lauching the solving algorithm
  *
- * @param g, the game on which the double array must be initialized
- * @param unmovable, a double array of boolean used to know which piece can be
- *moved to search for possible solutions
+ * @param smart, the smart engine holding the game and its state
  *
  * @return false if a piece has no direction possible, true otherwise
  **/
-static bool setUnmovable() {
-  uint16_t width = game_width(g);
-  uint16_t height = game_height(g);
-  for (uint16_t y = 0; y < height; y++) {
-    for (uint16_t x = 0; x < width; x++) {
-      if (!unmovable[x][y]) {
-        if (!setRecUnmovable(x, y)) {
-          free_double_bool_array(checked, width);
-          return false;
-        }
-      }
+static bool setUnmovable(smart_engine smart) {
+  deduction state;
+  if (!initDeduction(smart, &state)) return false;
+  bool status = deduce(smart, &state);
+  if (status) {
+    for (uint32_t cell = 0; cell < state.nbCells; cell++) {
+      uint8_t domain = smart->domains[cell];
+      if (countOrientations(domain) != 1) continue;
+      uint8_t orientation = 0;
+      while (!(domain & (1 << orientation))) orientation++;
+      state.dirs[cell] = DIRS[orientation];
+      smart->unmovable[cell % smart->width][cell / smart->width] = true;
+      smart->nbFixed++;
     }
+    set_current_directions(smart->g, state.dirs);
   }
-  return true;
+  freeDeduction(&state);
+  return status;
 }
 
 /**
+ * @brief Allocates the state of the deductions and gives every piece all the
+ *orientations in which it looks different
  *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state to initialize
  *
- */
-static bool setRecUnmovable(uint16_t x, uint16_t y) {
-  if (unmovable[x][y]) {
-    return true;
+ * @return false in case of error, true otherwise
+ **/
+static bool initDeduction(smart_engine smart, deduction *state) {
+  state->nbCells = (uint32_t)smart->width * smart->height;
+  state->nbListed = 0;
+  state->pieces = (piece *)malloc(state->nbCells * sizeof(piece));
+  state->dirs = (direction *)malloc(state->nbCells * sizeof(direction));
+  state->parent = (uint32_t *)malloc(state->nbCells * sizeof(uint32_t));
+  state->size = (uint32_t *)malloc(state->nbCells * sizeof(uint32_t));
+  state->open = (uint32_t *)malloc(state->nbCells * sizeof(uint32_t));
+  state->listed = (bool *)calloc(state->nbCells, sizeof(bool));
+  if (!state->pieces || !state->dirs || !state->parent || !state->size ||
+      !state->open || !state->listed) {
+    FPRINTF(stderr, "Error: initDeduction, can't allocate the deductions.\n");
+    freeDeduction(state);
+    return false;
   }
+  get_cells(smart->g, state->pieces, state->dirs);
 
-  uint8_t nbDir;
-  if (get_piece(g, x, y) == SEGMENT) {
-    nbDir = NB_DIR_SEGMENT;
-  } else {
-    nbDir = NB_DIR;
+  for (int8_t p = EMPTY; p <= CROSS; p++) {
+    for (uint8_t i = 0; i < NB_DIR; i++) {
+      uint8_t shape = 0;
+      for (uint8_t j = 0; j < NB_DIR; j++) {
+        if (is_edge((piece)p, DIRS[i], DIRS[j])) shape |= (uint8_t)(1 << j);
+      }
+      state->shapes[p + 1][i] = shape;
+    }
+  }
+  for (uint32_t cell = 0; cell < state->nbCells; cell++) {
+    smart->degrees[cell] =
+        countOrientations(state->shapes[state->pieces[cell] + 1][0]);
+    switch (state->pieces[cell]) {
+      case EMPTY:
+      case CROSS:
+        smart->domains[cell] = 1;
+        break;
+      case SEGMENT:
+        smart->domains[cell] = (1 << NB_DIR_SEGMENT) - 1;
+        break;
+      default:
+        smart->domains[cell] = (1 << NB_DIR) - 1;
+        break;
+    }
   }
+  return true;
+}
 
-  bool positions[NB_DIR] = {false, false, false, false};
-  uint32_t nbPosition = 0;
-  int32_t x2, y2;
-  uint16_t x3, y3;
+/**
+ * @brief Frees the arrays of the state of the deductions
+ *
+ * @param state, the state
+ **/
+static void freeDeduction(deduction *state) {
+  free(state->pieces);
+  free(state->dirs);
+  free(state->parent);
+  free(state->size);
+  free(state->open);
+  free(state->listed);
+}
 
-  if (get_piece(g, x, y) == CROSS) {
-    unmovable[x][y] = true;
+/**
+ * @brief Applies the deduction rules of the engine until none of them narrows
+ *a domain: the local rules as long as cells are waiting for them, then a pass
+ *of the global ones over the cells that can still turn
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ *
+ * @return false if a piece has no direction possible, true otherwise
+ **/
+static bool deduce(smart_engine smart, deduction *state) {
+  for (uint32_t cell = state->nbCells; cell-- > 0;) {
+    listCell(smart, state, cell);
   }
+  while (true) {
+    while (state->nbListed > 0) {
+      uint32_t cell = smart->cells[--state->nbListed];
+      state->listed[cell] = false;
+      bool changed = false;
+      if (!applyRules(smart, state, cell, false, &changed)) return false;
+    }
+    if (!(smart->rules & GLOBAL_RULES)) return true;
 
-  for (uint32_t i = 0; i < nbDir; i++) {
-    set_piece_current_direction(g, x, y, DIRS[i]);
-    if (isGoodDir(x, y)) {
-      nbPosition++;
-      positions[i] = true;
+    if (!buildTrees(smart, state)) return false;
+    bool changed = false;
+    for (uint32_t cell = 0; cell < state->nbCells; cell++) {
+      if (countOrientations(smart->domains[cell]) > 1 &&
+          !applyRules(smart, state, cell, true, &changed))
+        return false;
     }
+    if (!changed) return true;
   }
+}
 
-  if (nbPosition == 0) {
-    return false;
-  } else if (nbPosition == 1) {
-    for (uint8_t i = 0; i < nbDir; i++) {
-      if (positions[i]) {
-        set_piece_current_direction(g, x, y, DIRS[i]);
-        unmovable[x][y] = true;
+/**
+ * @brief Applies the local or the global rules of the engine to a cell, the
+ *neighbours of the cell waiting for the local rules if its domain is narrowed
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ * @param global, whether the global rules are applied instead of the local ones
+ * @param changed, set to true if the domain is narrowed
+ *
+ * @return false if the cell has no orientation left, true otherwise
+ **/
+static bool applyRules(smart_engine smart, deduction *state, uint32_t cell,
+                       bool global, bool *changed) {
+  uint8_t domain = smart->domains[cell];
+  for (uint8_t i = 0; i < NB_RULES; i++) {
+    if (RULES[i].global == global && (smart->rules & RULES[i].flag))
+      domain = RULES[i].apply(smart, state, cell, domain);
+  }
+  if (domain == smart->domains[cell]) return true;
+  smart->domains[cell] = domain;
+  *changed = true;
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next != NO_CELL) listCell(smart, state, next);
+  }
+  return domain != 0;
+}
+
+/**
+ * @brief Makes a cell wait for the local rules, unless it already does
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ **/
+static void listCell(smart_engine smart, deduction *state, uint32_t cell) {
+  if (state->listed[cell]) return;
+  state->listed[cell] = true;
+  smart->cells[state->nbListed++] = cell;
+}
+
+/**
+ * @brief Builds the trees of the cells joined by the connections every
+ *solution has, with their size and the connections that may still leave them
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ *
+ * @return false if the known connections close a loop or a tree that can't
+ *reach the rest of the board, when the matching rules are applied, true
+ *otherwise
+ **/
+static bool buildTrees(smart_engine smart, deduction *state) {
+  for (uint32_t cell = 0; cell < state->nbCells; cell++) {
+    state->parent[cell] = cell;
+    state->size[cell] = 1;
+    state->open[cell] = 0;
+  }
+  for (uint32_t cell = 0; cell < state->nbCells; cell++) {
+    uint8_t joined = joinedEdges(smart, state, cell);
+    // Every connection is the north or the east one of a cell
+    for (uint8_t i = 0; i < 2; i++) {
+      if (!(joined & (1 << i))) continue;
+      uint32_t root = findRoot(state->parent, cell);
+      uint32_t nextRoot =
+          findRoot(state->parent, getNeighbour(smart, cell, DIRS[i]));
+      if (root == nextRoot) {
+        if (smart->rules & SMART_RULE_LOOPS) return false;
+        continue;
+      }
+      if (state->size[root] < state->size[nextRoot]) {
+        uint32_t swap = root;
+        root = nextRoot;
+        nextRoot = swap;
       }
+      state->parent[nextRoot] = root;
+      state->size[root] += state->size[nextRoot];
     }
   }
-
-  if (unmovable[x][y]) {
+  // A connection back to the same tree would close a loop, so it can't leave
+  for (uint32_t cell = 0; cell < state->nbCells; cell++) {
+    uint32_t root = findRoot(state->parent, cell);
+    uint8_t pending = pendingEdges(smart, state, cell);
     for (uint8_t i = 0; i < NB_DIR; i++) {
-      getCoordFromDir(DIRS[i], &x2, &y2);
-      x3 = (uint16_t)(x + x2 + game_width(g)) % game_width(g);
-      y3 = (uint16_t)(y + y2 + game_height(g)) % game_height(g);
-      if (!(x3 - x2 == x && y3 - y2 == y) && !is_wrapping(g)) {
-        // If we're out of bounds and there are no wrapping
-      } else if (!setRecUnmovable(x3, y3)) {
+      if ((pending & (1 << i)) &&
+          findRoot(state->parent, getNeighbour(smart, cell, DIRS[i])) != root)
+        state->open[root]++;
+    }
+  }
+  if (smart->rules & SMART_RULE_ISOLATION) {
+    for (uint32_t cell = 0; cell < state->nbCells; cell++) {
+      if (state->parent[cell] == cell && state->open[cell] == 0 &&
+          state->size[cell] < state->nbCells)
         return false;
-      }
     }
   }
   return true;
 }
 
 /**
- * @brief a function (working recursively with findPoss) that propagate the
- *research of solution to all the connections of the current piece
+ * @brief Gives the connections a cell has in every orientation of its domain
  *
- * @param g, the game on which the function is working
- * @param x, the coordinate x of the cell that is currently tested in the
- *function
- * @param y, the coordinate y of the cell that is currently tested in the
- *function
- * @param checked, a double array of boolean used to verify which piece has
- *already been checked
- * @param unmovable, a double array of boolean used to know which piece can be
- *moved to search for possible solutions
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
  *
- * @return a possibility tree starting with the current piece in the position it
- *has just been tested or NULL if no coherent possibility has been found
+ * @return the connections, as a mask of DIRS
  **/
-static possibility propagate(uint16_t x, uint16_t y) {
-  int32_t x2, y2;
-  possibility thisPoss = createSinglePoss(x, y, get_current_direction(g, x, y));
-  // The possibility we're going to return at the end of the function
-  possibility possFound[NB_DIR];
-  // Trees of possibilites will be stored in this array
-  uint32_t nbPossToCheck = 1, nbPossFound, nbDerivPos;
-  // By setting nbPossToCheck to 1 instead of 0 by default, we're allowed to
-  // test the first direction without actually loading a proposition because
-  // thissPoss is still a leaf
+static uint8_t mustEdges(smart_engine smart, const deduction *state,
+                         uint32_t cell) {
+  uint8_t domain = smart->domains[cell];
+  uint8_t edges = domain ? (1 << NB_DIR) - 1 : 0;
   for (uint8_t i = 0; i < NB_DIR; i++) {
-    getCoordFromDir(DIRS[i], &x2, &y2);
-    x2 = (x + x2 + game_width(g)) % game_width(g);
-    y2 = (y + y2 + game_height(g)) % game_height(g);
-    if (is_edge_coordinates(g, x, y, DIRS[i]) && (!checked[x2][y2])) {
-      // For each direction where this piece is connected except the one it's
-      // coming from
-      for (uint32_t j = 0; j < nbPossToCheck; j++) {
-        loadPossibility(thisPoss, j);
-        // For every possibility found before on the other connections of this
-        // piece
-        nbPossFound =
-            findPoss(possFound, &nbDerivPos, (uint16_t)x2, (uint16_t)y2);
-        // We look up the possibilities with findPoss()
-        unloadPossibility(thisPoss, j);
-        if (nbPossFound == 0) {
-          // If we cannot find a solution with the loaded possibility, it is
-          // invalid thus will be deleted
-          thisPoss = delLeaf(thisPoss, j);
-          nbPossToCheck--;
-          // Corresponds to : nbPossToCheck = thisPoss->totalNextDerivPos; (if
-          // thisPoss != NULL)
-          j--;
-        } else {
-          // Otherwise we append the solutions found at the end of the
-          // possibility
-          spreadLeaf(thisPoss, j, nbPossFound, possFound, nbDerivPos);
-          nbPossToCheck += (nbDerivPos - 1);
-          // Corresponds to : nbPossToCheck = thisPoss->totalNextDerivPos;
-          j += (nbDerivPos - 1);
-        }
-      }
-      // If after testing all the solutions there is none left, it means that
-      // this piece cannot be placed this way, then the last call to delLeaf
-      // deleted thisPoss (Which has been set to NULL). Since nbPossToCheck is
-      // equal to 0, the last For loop won't iterate.
+    if (domain & (1 << i)) edges &= state->shapes[state->pieces[cell] + 1][i];
+  }
+  return edges;
+}
+
+/**
+ * @brief Gives the connections a cell has in at least one orientation of its
+ *domain
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ *
+ * @return the connections, as a mask of DIRS
+ **/
+static uint8_t mayEdges(smart_engine smart, const deduction *state,
+                        uint32_t cell) {
+  uint8_t domain = smart->domains[cell];
+  uint8_t edges = 0;
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    if (domain & (1 << i)) edges |= state->shapes[state->pieces[cell] + 1][i];
+  }
+  return edges;
+}
+
+/**
+ * @brief Gives the connections of a cell that every solution has, because one
+ *of their two ends has them in all its orientations
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ *
+ * @return the connections, as a mask of DIRS
+ **/
+static uint8_t joinedEdges(smart_engine smart, const deduction *state,
+                           uint32_t cell) {
+  uint8_t must = mustEdges(smart, state, cell);
+  uint8_t joined = 0;
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next == NO_CELL) continue;
+    if ((must & (1 << i)) ||
+        (mustEdges(smart, state, next) & (1 << opposite_direction(DIRS[i]))))
+      joined |= (uint8_t)(1 << i);
+  }
+  return joined;
+}
+
+/**
+ * @brief Gives the connections of a cell that aren't known yet, both of their
+ *ends having them in some of their orientations
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ *
+ * @return the connections, as a mask of DIRS
+ **/
+static uint8_t pendingEdges(smart_engine smart, const deduction *state,
+                            uint32_t cell) {
+  uint8_t may = mayEdges(smart, state, cell) &
+                (uint8_t)~joinedEdges(smart, state, cell);
+  uint8_t pending = 0;
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    if (!(may & (1 << i))) continue;
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next != NO_CELL &&
+        (mayEdges(smart, state, next) & (1 << opposite_direction(DIRS[i]))))
+      pending |= (uint8_t)(1 << i);
+  }
+  return pending;
+}
+
+/**
+ * @brief Joins the tree of a cell to the trees its new connections lead to
+ *when it takes an orientation
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ * @param shape, the connections of the cell in the orientation
+ * @param size, where the number of cells of the joined tree is written
+ * @param open, where a bound on the connections that may still leave the
+ *joined tree is written
+ *
+ * @return false if a connection leaves the board or two of them lead to the
+ *same tree, which closes a loop, true otherwise
+ **/
+static bool joinOrientation(smart_engine smart, deduction *state,
+                            uint32_t cell, uint8_t shape, uint32_t *size,
+                            int64_t *open) {
+  uint8_t joined = joinedEdges(smart, state, cell);
+  uint32_t roots[NB_DIR + 1];
+  uint8_t nbRoots = 0;
+  roots[nbRoots++] = findRoot(state->parent, cell);
+  *size = state->size[roots[0]];
+  // The orientation settles all the connections of the cell, the ones leading
+  // to other trees being the only ones counted by buildTrees
+  *open = state->open[roots[0]];
+  uint8_t pending = pendingEdges(smart, state, cell);
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    if ((pending & (1 << i)) &&
+        findRoot(state->parent, getNeighbour(smart, cell, DIRS[i])) !=
+            roots[0])
+      (*open)--;
+  }
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    if (!(shape & (1 << i)) || (joined & (1 << i))) continue;
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next == NO_CELL) return false;
+    uint32_t root = findRoot(state->parent, next);
+    for (uint8_t j = 0; j < nbRoots; j++) {
+      if (roots[j] == root) return false;
     }
+    roots[nbRoots++] = root;
+    *size += state->size[root];
+    *open += state->open[root];
+    if (pendingEdges(smart, state, next) & (1 << opposite_direction(DIRS[i])))
+      (*open)--;
   }
-  return thisPoss;
+  // The neighbours in the trees joined to the one of the cell lose the
+  // connections the cell lacks
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    if ((shape & (1 << i)) || (joined & (1 << i))) continue;
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next == NO_CELL ||
+        !(pendingEdges(smart, state, next) &
+          (1 << opposite_direction(DIRS[i]))))
+      continue;
+    uint32_t root = findRoot(state->parent, next);
+    for (uint8_t j = 1; j < nbRoots; j++) {
+      if (roots[j] == root) (*open)--;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Counts the bits of a mask, the orientations of a domain or the
+ *connections of a cell
+ *
+ * @param domain, the mask
+ *
+ * @return the number of bits set
+ **/
+static uint8_t countOrientations(uint8_t domain) {
+  uint8_t count = 0;
+  for (; domain; domain &= (uint8_t)(domain - 1)) count++;
+  return count;
+}
+
+/**
+ * @brief Rules out the orientations of a cell that disagree with a connection
+ *its neighbour has in all its orientations or lacks in all of them, or that
+ *connect to the outside of a non wrapping board. This is the test isGoodDir
+ *does against the unmovable pieces, made on domains
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ * @param domain, the orientations the cell may still take
+ *
+ * @return the orientations left
+ **/
+static uint8_t ruleEdges(smart_engine smart, deduction *state, uint32_t cell,
+                         uint8_t domain) {
+  uint8_t required = 0;
+  uint8_t allowed = 0;
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next == NO_CELL) continue;
+    uint8_t opposite = (uint8_t)(1 << opposite_direction(DIRS[i]));
+    if (mustEdges(smart, state, next) & opposite)
+      required |= (uint8_t)(1 << i);
+    if (mayEdges(smart, state, next) & opposite) allowed |= (uint8_t)(1 << i);
+  }
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint8_t shape = state->shapes[state->pieces[cell] + 1][i];
+    if ((shape & ~allowed) || (required & ~shape))
+      domain &= (uint8_t)~(1 << i);
+  }
+  return domain;
+}
+
+/**
+ * @brief Rules out the orientations of a leaf pointing to another leaf, since
+ *the two would form a network of two pieces while a board holds at least
+ *MIN_GAME_WIDTH * MIN_GAME_HEIGHT
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ * @param domain, the orientations the cell may still take
+ *
+ * @return the orientations left
+ **/
+static uint8_t ruleLeaves(smart_engine smart, deduction *state, uint32_t cell,
+                          uint8_t domain) {
+  if (state->pieces[cell] != LEAF) return domain;
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    if (next != NO_CELL && state->pieces[next] == LEAF)
+      domain &= (uint8_t)~(1 << i);
+  }
+  return domain;
+}
+
+/**
+ * @brief Rules out the orientations of a cell connecting it twice to the same
+ *tree, which would close a loop
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ * @param domain, the orientations the cell may still take
+ *
+ * @return the orientations left
+ **/
+static uint8_t ruleLoops(smart_engine smart, deduction *state, uint32_t cell,
+                         uint8_t domain) {
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t size;
+    int64_t open;
+    if ((domain & (1 << i)) &&
+        !joinOrientation(smart, state, cell,
+                         state->shapes[state->pieces[cell] + 1][i], &size,
+                         &open))
+      domain &= (uint8_t)~(1 << i);
+  }
+  return domain;
+}
+
+/**
+ * @brief Rules out the orientations of a cell closing its tree while it
+ *doesn't hold every cell of the board, the network then being cut from the
+ *rest
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param state, the state of the deductions
+ * @param cell, the cell, as x + y * width
+ * @param domain, the orientations the cell may still take
+ *
+ * @return the orientations left
+ **/
+static uint8_t ruleIsolation(smart_engine smart, deduction *state,
+                             uint32_t cell, uint8_t domain) {
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t size;
+    int64_t open;
+    if ((domain & (1 << i)) &&
+        joinOrientation(smart, state, cell,
+                        state->shapes[state->pieces[cell] + 1][i], &size,
+                        &open) &&
+        open <= 0 && size < state->nbCells)
+      domain &= (uint8_t)~(1 << i);
+  }
+  return domain;
 }
 
 /**
@@ -774,26 +2123,28 @@ static possibility propagate(uint16_t x, uint16_t y) {
  *nothing
  * @param numPoss, the possibility to load (because several possibilities exists
  *in one tree), corresponds to the number of the leaf that is targetted
- * @param g, the game to modify
- * @param checked, a double array of boolean used to verify which piece has
- *already been checked
- **/
-static void loadPossibility(possibility poss, uint32_t numPoss) {
-  if (poss == NULL) return;  // we're trying to load an unexisting possibility
-  set_piece_current_direction(g, poss->x, poss->y, poss->dir);
-  checked[poss->x][poss->y] = true;
-  if (poss->isLeaf) return;  // we've reached the end of the possibility to load
-  uint32_t i = 0;
-  while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numPoss) {
-    numPoss -= poss->nbNextDerivPos[i];
-    i++;
-  }
-  if (i >= poss->nbNextPos) {
-    FPRINTF(stderr,
-            "error : wrong parameter given or malformed possibility tree!\n");
-    exit(EXIT_FAILURE);
+ * @param smart, the smart engine holding the game and its state
+ **/
+static void loadPossibility(smart_engine smart, possibility poss,
+                            uint32_t numPoss) {
+  // if NULL, we're trying to load an unexisting possibility
+  while (poss != NULL) {
+    set_piece_current_direction(smart->g, poss->x, poss->y, poss->dir);
+    smart->checked[poss->x][poss->y] = true;
+    if (poss->isLeaf)
+      return;  // we've reached the end of the possibility to load
+    uint32_t i = 0;
+    while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numPoss) {
+      numPoss -= poss->nbNextDerivPos[i];
+      i++;
+    }
+    if (i >= poss->nbNextPos) {
+      FPRINTF(stderr,
+              "error : wrong parameter given or malformed possibility tree!\n");
+      exit(EXIT_FAILURE);
+    }
+    poss = poss->nextPos[i];
   }
-  loadPossibility(poss->nextPos[i], numPoss);
 }
 
 /**
@@ -804,132 +2155,288 @@ static void loadPossibility(possibility poss, uint32_t numPoss) {
  *nothing
  * @param numPoss, the possibility to load (because several possibilities exists
  *in one tree), corresponds to the number of the leaf that is targetted
- * @param checked, a double array of boolean used to verify which piece has
- *already been checked
+ * @param smart, the smart engine holding the game and its state
  **/
-static void unloadPossibility(possibility poss, uint32_t numPoss) {
-  if (poss == NULL) return;  // we're trying to unload an unexisting possibility
-  checked[poss->x][poss->y] = false;
-  if (poss->isLeaf)
-    return;  // we've reached the end of the possibility to unload
-  uint32_t i = 0;
-  while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numPoss) {
-    numPoss -= poss->nbNextDerivPos[i];
-    i++;
-  }
-  if (i >= poss->nbNextPos) {
-    FPRINTF(stderr,
-            "error : wrong parameter given or malformed possibility tree!\n");
-    exit(EXIT_FAILURE);
+static void unloadPossibility(smart_engine smart, possibility poss,
+                              uint32_t numPoss) {
+  // if NULL, we're trying to unload an unexisting possibility
+  while (poss != NULL) {
+    smart->checked[poss->x][poss->y] = false;
+    if (poss->isLeaf)
+      return;  // we've reached the end of the possibility to unload
+    uint32_t i = 0;
+    while (i < poss->nbNextPos && poss->nbNextDerivPos[i] <= numPoss) {
+      numPoss -= poss->nbNextDerivPos[i];
+      i++;
+    }
+    if (i >= poss->nbNextPos) {
+      FPRINTF(stderr,
+              "error : wrong parameter given or malformed possibility tree!\n");
+      exit(EXIT_FAILURE);
+    }
+    poss = poss->nextPos[i];
   }
-  unloadPossibility(poss->nextPos[i], numPoss);
 }
 
 /**
- * @brief A recursive function which search for possibilities of solution
- *(working recursively with propagate)
+ * @brief A function which search for possibilities of solution, by trying each
+ *direction of the piece and propagating the search from it. The calls of
+ *findPoss and propagate it leads to are run on a stack of frames allocated on
+ *the heap, since they can nest as deep as the board is large
  *
  * @param possArray, an array containing the different possibilities the
  *function has found (do not access it if the function return 0)
- * @param g, the game on which the function has to found possibilities
+ * @param smart, the smart engine holding the game and its state
  * @param x, the coordinate x of the cell that is currently tested in the
  *function
  * @param y, the coordinate y of the cell that is currently tested in the
  *function
- * @param checked, a double array of boolean used to verify which piece has
- *already been checked
- * @param unmovable, a double array of boolean used to know which piece can be
- *moved to search for possible solutions
  *
  * @return the number of possibility tree the function has found (different than
  *the total number of possibilities)
  **/
-static uint32_t findPoss(possibility *possArray, uint32_t *nbDerivPos,
-                         uint16_t x, uint16_t y) {
-  uint8_t nbDir;
-  *nbDerivPos = 0;
-  if (get_piece(g, x, y) == SEGMENT) {
-    nbDir = NB_DIR_SEGMENT;
-  } else {
-    nbDir = NB_DIR;
-  }
-  uint32_t nbPoss = 0;
-  if (unmovable[x][y]) {
-    // If this piece cannot be in another direction
-    possArray[0] = propagate(x, y);
-    if (possArray[0] == NULL) {
-      return 0;
+static uint32_t findPoss(smart_engine smart, possibility *possArray,
+                         uint32_t *nbDerivPos, uint16_t x, uint16_t y) {
+  uint32_t depth = 0;
+  pushFrame(smart, &depth, true, x, y);
+  search_frame *returned = NULL;
+  while (true) {
+    bool over = smart->frames[depth - 1].isFind
+                    ? stepFind(smart, &depth, returned)
+                    : stepPropagate(smart, &depth, returned);
+    // Without memory or budget the half built trees of the frames are dropped
+    // with the others by smart_solve
+    if (smart->outOfMemory || smart->outOfBudget) return 0;
+    returned = NULL;
+    if (over) {
+      // The frame stays readable by its caller until another one is pushed
+      depth--;
+      if (depth == 0) break;
+      returned = &smart->frames[depth];
+    }
+  }
+
+  const search_frame *first = &smart->frames[0];
+  for (uint32_t i = 0; i < first->nbPoss; i++) {
+    possArray[i] = first->possArray[i];
+  }
+  *nbDerivPos = first->nbDerivPos;
+  return first->nbPoss;
+}
+
+/**
+ * @brief Pushes the frame of a call of findPoss or propagate on the stack of
+ *the engine, growing it if needed
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param depth, the number of frames on the stack, incremented
+ * @param isFind, true for a call of findPoss, false for propagate
+ * @param x, the x coordinate of the cell of the call
+ * @param y, the y coordinate of the cell of the call
+ **/
+static void pushFrame(smart_engine smart, uint32_t *depth, bool isFind,
+                      uint16_t x, uint16_t y) {
+  if (*depth == smart->nbFrames) {
+    search_frame *frames = (search_frame *)realloc(
+        smart->frames, 2 * smart->nbFrames * sizeof(search_frame));
+    if (!frames) {
+      FPRINTF(stderr, "Not enough memory to search the possibilities\n");
+      exit(EXIT_FAILURE);
+    }
+    smart->frames = frames;
+    smart->nbFrames *= 2;
+  }
+
+  search_frame *frame = &smart->frames[(*depth)++];
+  frame->isFind = isFind;
+  frame->x = x;
+  frame->y = y;
+  frame->dir = 0;
+  if (isFind) {
+    smart->nbFind++;
+    if ((smart->maxFind && smart->nbFind > smart->maxFind) ||
+        (smart->maxMs && smart->nbFind % CLOCK_FINDS == 0 &&
+         get_milliseconds() - smart->startMs >= smart->maxMs))
+      smart->outOfBudget = true;
+    // A piece that cannot be in another direction is only propagated once
+    frame->unmovable = smart->unmovable[x][y];
+    if (frame->unmovable) {
+      frame->nbDir = 1;
+    } else if (get_piece(smart->g, x, y) == SEGMENT) {
+      frame->nbDir = NB_DIR_SEGMENT;
     } else {
-      if (possArray[nbPoss]->isLeaf) {
-        *nbDerivPos += 1;
-      } else {
-        *nbDerivPos += possArray[nbPoss]->totalNextDerivPos;
-      }
-      return 1;
+      frame->nbDir = NB_DIR;
     }
+    frame->nbPoss = 0;
+    frame->nbDerivPos = 0;
   } else {
-    for (uint8_t i = 0; i < nbDir; i++) {
-      // For each direction this piece can be in
-      set_piece_current_direction(g, x, y, DIRS[i]);
-      if (isGoodDir(x, y)) {
-        // If it's suitable with the rest of the game.
-        possArray[nbPoss] = propagate(x, y);
-        // We propagate the solution search
-        if (possArray[nbPoss] != NULL) {
-          // If we found a possibility of a solution, we add it to the array of
-          // possibilities found and return it, we just need to increment the
-          // corresponding uint32_t size
-          if (possArray[nbPoss]->isLeaf) {
-            *nbDerivPos += 1;
-          } else {
-            *nbDerivPos += possArray[nbPoss]->totalNextDerivPos;
-          }
-          nbPoss++;
-        }
+    smart->nbPropagate++;
+    frame->thisPoss =
+        createSinglePoss(smart, x, y, get_current_direction(smart->g, x, y));
+    frame->inDir = false;
+    sortNeighbours(smart, frame);
+    // By setting nbPossToCheck to 1 instead of 0 by default, we're allowed to
+    // test the first direction without actually loading a proposition because
+    // thisPoss is still a leaf
+    frame->nbPossToCheck = 1;
+  }
+}
+
+/**
+ * @brief Runs a call of findPoss until it calls propagate or returns
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param depth, the number of frames on the stack, the call being the last one
+ * @param returned, the frame of the call of propagate that just returned, NULL
+ *when the call starts
+ *
+ * @return true if the call returned, false if it pushed a call of propagate
+ **/
+static bool stepFind(smart_engine smart, uint32_t *depth,
+                     search_frame *returned) {
+  search_frame *frame = &smart->frames[*depth - 1];
+  if (returned) {
+    if (returned->thisPoss != NULL) {
+      // If we found a possibility of a solution, we add it to the array of
+      // possibilities found
+      possibility poss = returned->thisPoss;
+      frame->possArray[frame->nbPoss++] = poss;
+      frame->nbDerivPos += poss->isLeaf ? 1 : poss->totalNextDerivPos;
+    }
+    frame->dir++;
+  }
+
+  while (frame->dir < frame->nbDir) {
+    // For each direction this piece can be in
+    if (!frame->unmovable) {
+      // The orientations setUnmovable ruled out are in no solution
+      uint32_t cell = frame->x + (uint32_t)frame->y * smart->width;
+      if (!(smart->domains[cell] & (1 << frame->dir))) {
+        frame->dir++;
+        continue;
       }
+      set_piece_current_direction(smart->g, frame->x, frame->y,
+                                  DIRS[frame->dir]);
+    }
+    // An unmovable piece is checked as well, since it may close a loop with
+    // the pieces already placed
+    if (!isGoodDir(smart, frame->x, frame->y)) {
+      frame->dir++;
+      continue;
+    }
+    // If it's suitable with the rest of the game, we propagate the solution
+    // search
+    pushFrame(smart, depth, false, frame->x, frame->y);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Runs a call of propagate until it calls findPoss or returns.
+ *propagate extends the search to all the connections of a piece, in the
+ *direction it has just been given, and returns in thisPoss a possibility tree
+ *starting with this piece or NULL if no coherent possibility has been found
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param depth, the number of frames on the stack, the call being the last one
+ * @param returned, the frame of the call of findPoss that just returned, NULL
+ *when the call starts
+ *
+ * @return true if the call returned, false if it pushed a call of findPoss
+ **/
+static bool stepPropagate(smart_engine smart, uint32_t *depth,
+                          search_frame *returned) {
+  search_frame *frame = &smart->frames[*depth - 1];
+  if (returned) {
+    unloadPossibility(smart, frame->thisPoss, frame->numPoss);
+    if (returned->nbPoss == 0) {
+      // If we cannot find a solution with the loaded possibility, it is
+      // invalid thus will be deleted
+      frame->thisPoss = delLeaf(smart, frame->thisPoss, frame->numPoss);
+      frame->nbPossToCheck--;
+      frame->numPoss--;
+    } else {
+      // Otherwise we append the solutions found at the end of the possibility
+      spreadLeaf(frame->thisPoss, frame->numPoss, returned->nbPoss,
+                 returned->possArray, returned->nbDerivPos);
+      frame->nbPossToCheck += (returned->nbDerivPos - 1);
+      frame->numPoss += (returned->nbDerivPos - 1);
+    }
+    frame->numPoss++;
+  }
+
+  uint16_t width = game_width(smart->g);
+  uint16_t height = game_height(smart->g);
+  while (frame->dir < NB_DIR) {
+    if (!frame->inDir) {
+      direction dir = DIRS[frame->order[frame->dir]];
+      int32_t x2, y2;
+      getCoordFromDir(dir, &x2, &y2);
+      x2 = (frame->x + x2 + width) % width;
+      y2 = (frame->y + y2 + height) % height;
+      if (!is_edge_coordinates(smart->g, frame->x, frame->y, dir) ||
+          smart->checked[x2][y2] ||
+          isOutside(smart, (uint16_t)x2, (uint16_t)y2)) {
+        frame->dir++;
+        continue;
+      }
+      // For each direction where this piece is connected except the one it's
+      // coming from
+      frame->inDir = true;
+      frame->nextX = (uint16_t)x2;
+      frame->nextY = (uint16_t)y2;
+      frame->numPoss = 0;
+    }
+    if (frame->numPoss < frame->nbPossToCheck) {
+      // For every possibility found before on the other connections of this
+      // piece, we look up the possibilities with findPoss()
+      loadPossibility(smart, frame->thisPoss, frame->numPoss);
+      pushFrame(smart, depth, true, frame->nextX, frame->nextY);
+      return false;
     }
+    // If after testing all the solutions there is none left, the last call to
+    // delLeaf set thisPoss to NULL and nbPossToCheck is 0
+    frame->inDir = false;
+    frame->dir++;
   }
-  return nbPoss;
+  return true;
 }
 
 /**
  * @brief test if a piece in this direction would fit well in the game (would
  *not cause impossible connection with neighbouring pieces and no loop either)
  *
- * @param g, the game on which the function has to verify the positions
+ * @param smart, the smart engine holding the game and its state
  * @param x, the x coordinate of the piece
  * @param y, the y coordinate of the piece
- * @param checked, a double array of boolean used to know which piece as already
- *been placed by the algorithm (used to check on loops)
- * @param unmovable, a double array of boolean used to know which piece can
- *still be moved to find a solution.
  *
  * @return true if the piece can be placed in this position without problem,
  *false otherwise.
  **/
-bool isGoodDir(uint16_t x, uint16_t y) {
+static bool isGoodDir(smart_engine smart, uint16_t x, uint16_t y) {
   int32_t x2, y2;
   uint16_t x3, y3;
   bool foundChecked = false;
   for (uint16_t i = 0; i < NB_DIR; i++) {
     getCoordFromDir(DIRS[i], &x2, &y2);
-    x3 = (uint16_t)(x + x2 + game_width(g)) % game_width(g);
-    y3 = (uint16_t)(y + y2 + game_height(g)) % game_height(g);
-    if (is_edge_coordinates(g, x, y, DIRS[i])) {
-      if (!(x3 - x2 == x && y3 - y2 == y) && !is_wrapping(g)) {
+    x3 = (uint16_t)(x + x2 + game_width(smart->g)) % game_width(smart->g);
+    y3 = (uint16_t)(y + y2 + game_height(smart->g)) % game_height(smart->g);
+    if (is_edge_coordinates(smart->g, x, y, DIRS[i])) {
+      if (!(x3 - x2 == x && y3 - y2 == y) && !is_wrapping(smart->g)) {
         // If we are out of bounds and wrapping is disabled, this piece cannot
         // be in this position
         return false;
       }
 
-      if ((checked[x3][y3] || unmovable[x3][y3]) &&
-          !is_edge_coordinates(g, x3, y3, opposite_direction(DIRS[i]))) {
+      if ((smart->checked[x3][y3] || smart->unmovable[x3][y3]) &&
+          !is_edge_coordinates(smart->g, x3, y3, opposite_direction(DIRS[i]))) {
         // The piece to which it is connected cannot move and is not connected
         return false;
       }
 
-      if (checked[x3][y3] &&
-          is_edge_coordinates(g, x3, y3, opposite_direction(DIRS[i]))) {
+      if (isInTree(smart, x3, y3) &&
+          is_edge_coordinates(smart->g, x3, y3, opposite_direction(DIRS[i]))) {
         if (foundChecked) {
           // We already found a pieced that is connected and checked : place the
           // piece this way would create a loop
@@ -937,8 +2444,9 @@ bool isGoodDir(uint16_t x, uint16_t y) {
         }
         foundChecked = true;
       }
-    } else if ((checked[x3][y3] || unmovable[x3][y3]) &&
-               is_edge_coordinates(g, x3, y3, opposite_direction(DIRS[i]))) {
+    } else if ((smart->checked[x3][y3] || smart->unmovable[x3][y3]) &&
+               is_edge_coordinates(smart->g, x3, y3,
+                                   opposite_direction(DIRS[i]))) {
       // The piece to which it is not connected cannot move and has to be
       // connected in return
       return false;
@@ -946,3 +2454,90 @@ bool isGoodDir(uint16_t x, uint16_t y) {
   }
   return true;
 }
+
+/**
+ * @brief Gives the rank of a cell in the order of the engine, the cells of
+ *lowest rank being searched first
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param cell, the cell, indexed by x + y * width
+ *
+ * @return the rank of the cell
+ **/
+static uint32_t orderKey(smart_engine smart, uint32_t cell) {
+  uint32_t nbOrientations = countOrientations(smart->domains[cell]);
+  switch (smart->order) {
+    case SMART_ORDER_CONSTRAINED: {
+      // The borders of a non wrapping board constrain a piece as much as the
+      // pieces already placed
+      uint32_t nbFree = 0;
+      for (uint8_t i = 0; i < NB_DIR; i++) {
+        uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+        if (next != NO_CELL &&
+            !smart->checked[next % smart->width][next / smart->width] &&
+            !smart->unmovable[next % smart->width][next / smart->width])
+          nbFree++;
+      }
+      return nbFree * (NB_DIR + 1) + nbOrientations;
+    }
+    case SMART_ORDER_DEGREE:
+      // 12 is a multiple of every degree, so the ranks stay exact
+      if (smart->degrees[cell] == 0) return UINT32_MAX;
+      return nbOrientations * 12 / smart->degrees[cell];
+    default:
+      return nbOrientations;
+  }
+}
+
+/**
+ * @brief Chooses the cell findSolution starts from: (0,0) in the fixed order,
+ *the movable cell of lowest rank otherwise
+ *
+ * @param smart, the smart engine holding the game and its state, its
+ *unmovable pieces being set
+ *
+ * @return the cell, indexed by x + y * width
+ **/
+static uint32_t findStart(smart_engine smart) {
+  if (smart->order == SMART_ORDER_FIXED) return 0;
+  uint32_t nbCells = (uint32_t)smart->width * smart->height;
+  uint32_t start = 0, bestKey = UINT32_MAX;
+  for (uint32_t cell = 0; cell < nbCells; cell++) {
+    if (smart->unmovable[cell % smart->width][cell / smart->width] ||
+        smart->degrees[cell] == 0)
+      continue;
+    uint32_t key = orderKey(smart, cell);
+    if (key < bestKey) {
+      start = cell;
+      bestKey = key;
+    }
+  }
+  return start;
+}
+
+/**
+ * @brief Sets the order in which a call of propagate searches the neighbours
+ *of its piece, DIRS order being kept between neighbours of the same rank
+ *
+ * @param smart, the smart engine holding the game and its state
+ * @param frame, the frame of the call
+ **/
+static void sortNeighbours(smart_engine smart, search_frame *frame) {
+  for (uint8_t i = 0; i < NB_DIR; i++) frame->order[i] = i;
+  if (smart->order == SMART_ORDER_FIXED) return;
+
+  uint32_t cell = frame->x + (uint32_t)frame->y * smart->width;
+  uint32_t keys[NB_DIR];
+  for (uint8_t i = 0; i < NB_DIR; i++) {
+    uint32_t next = getNeighbour(smart, cell, DIRS[i]);
+    keys[i] = next == NO_CELL ? UINT32_MAX : orderKey(smart, next);
+  }
+  // An insertion sort, stable on the 4 neighbours
+  for (uint8_t i = 1; i < NB_DIR; i++) {
+    uint8_t moved = frame->order[i];
+    uint8_t j = i;
+    for (; j > 0 && keys[frame->order[j - 1]] > keys[moved]; j--)
+      frame->order[j] = frame->order[j - 1];
+    frame->order[j] = moved;
+  }
+}
@@ -0,0 +1,415 @@
+#include "solve_transfer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cross_time.h"
+
+// Key of an unused slot, the labels of a state never set all the bits
+#define NO_STATE UINT64_MAX
+#define LABEL_BITS 4
+#define LABEL_MASK 0xF
+// Label of the component started by a piece linked to no placed cell, the
+// labels of a state never reach it
+#define NEW_LABEL LABEL_MASK
+#define NB_POSITIONS (TRANSFER_MAX_WIDTH + 1)
+#define MIN_SLOTS 64
+#define SLOT_BYTES (sizeof(uint64_t) + sizeof(sol_count))
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for the states reached after placing a number of cells, in
+ * an open-addressing hash table
+ */
+typedef struct state_table_s {
+  uint64_t *keys;     /**< the state in each slot, NO_STATE if unused */
+  sol_count *counts;  /**< number of ways the placed cells reach each state */
+  uint32_t nb_slots;  /**< number of slots, a power of 2 */
+  uint32_t nb_states; /**< number of slots used */
+} state_table;
+
+/**
+ * @brief Structure for a counter. A state has a label per position: position
+ * col is the connection going up from the last cell placed in column col, and
+ * position width the connection going right from the last cell placed. 0 means
+ * no connection, and the connections with the same label are linked by the
+ * placed pieces
+ */
+typedef struct transfer_s {
+  uint16_t width;         /**< number of cells in a row, the narrow side */
+  uint16_t height;        /**< number of rows */
+  uint8_t *masks;         /**< the distinct connections each cell can take,
+                             NB_DIR per cell in the order they are placed */
+  uint8_t *nb_masks;      /**< number of distinct connections of each cell */
+  bool big;               /**< whether the counts have arbitrary precision */
+  uint64_t max_bytes;     /**< memory the tables may use, 0 for no limit */
+  bool out_of_memory;     /**< whether the tables outgrew max_bytes */
+  state_table tables[2];  /**< states before and after placing a cell */
+  solver_stats stats;     /**< work done so far */
+} transfer;
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static bool read_masks(transfer *counter, cgame board);
+static bool place_cell(transfer *counter, uint16_t row, uint16_t col,
+                       const state_table *from, state_table *to);
+static uint64_t encode_state(const uint8_t *labels, uint16_t nb_positions);
+static bool init_table(state_table *table, uint32_t nb_slots);
+static bool add_state(transfer *counter, state_table *table, uint64_t key,
+                      const sol_count *term);
+static bool grow_table(transfer *counter, state_table *table);
+static uint32_t find_slot(const state_table *table, uint64_t key);
+static void reset_table(state_table *table);
+static void free_table(state_table *table);
+
+//--------------------------------------------------------------------------------------
+//                                Transfer functions bodies
+
+bool transfer_suits(cgame board) {
+  if (!board || is_wrapping(board)) return false;
+  return game_width(board) <= TRANSFER_MAX_WIDTH ||
+         game_height(board) <= TRANSFER_MAX_WIDTH;
+}
+
+solver_status transfer_count(cgame board, bool big, uint64_t max_bytes,
+                             uint64_t max_nodes, uint32_t max_milliseconds,
+                             sol_count *count, solver_stats *stats) {
+  if (!board || !count) {
+    FPRINTF(stderr,
+            "Error: transfer_count, game or counter pointer is NULL.\n");
+    return SOLVER_ERROR;
+  }
+  sol_count_init(count, big);
+  if (!transfer_suits(board)) {
+    FPRINTF(stderr,
+            "Error: transfer_count, the board wraps or is too wide.\n");
+    return SOLVER_ERROR;
+  }
+
+  transfer counter;
+  memset(&counter, 0, sizeof(transfer));
+  counter.big = big;
+  counter.max_bytes = max_bytes;
+  counter.out_of_memory = max_bytes && 2 * MIN_SLOTS * SLOT_BYTES > max_bytes;
+  sol_count one;
+  sol_count_init(&one, big);
+  bool status = !counter.out_of_memory && read_masks(&counter, board) &&
+                init_table(&counter.tables[0], MIN_SLOTS) &&
+                init_table(&counter.tables[1], MIN_SLOTS) &&
+                sol_count_add_uint(&one, 1) &&
+                add_state(&counter, &counter.tables[0], 0, &one);
+  if (!status && !counter.out_of_memory)
+    FPRINTF(stderr, "Error: transfer_count, can't allocate the count.\n");
+  sol_count_clear(&one);
+
+  // The states are passed from one table to the other as the cells are placed
+  uint64_t start = get_milliseconds();
+  bool out_of_budget = false;
+  uint32_t current = 0;
+  for (uint16_t row = 0; status && row < counter.height; row++) {
+    for (uint16_t col = 0; status && col < counter.width; col++) {
+      out_of_budget =
+          (max_nodes && counter.stats.nb_nodes >= max_nodes) ||
+          (max_milliseconds && get_milliseconds() - start >= max_milliseconds);
+      reset_table(&counter.tables[1 - current]);
+      status = !out_of_budget &&
+               place_cell(&counter, row, col, &counter.tables[current],
+                          &counter.tables[1 - current]);
+      current = 1 - current;
+    }
+  }
+
+  // A solution ends without any connection left
+  if (status) {
+    uint32_t slot = find_slot(&counter.tables[current], 0);
+    if (counter.tables[current].keys[slot] == 0)
+      status = sol_count_add(count, &counter.tables[current].counts[slot]);
+  }
+  if (stats) {
+    stats->nb_nodes = counter.stats.nb_nodes;
+    stats->nb_propagations = counter.stats.nb_propagations;
+    stats->nb_backtracks = counter.stats.nb_backtracks;
+  }
+  free_table(&counter.tables[0]);
+  free_table(&counter.tables[1]);
+  free(counter.masks);
+  free(counter.nb_masks);
+  if (status) return SOLVER_DONE;
+  if (out_of_budget) return SOLVER_UNFINISHED;
+  return counter.out_of_memory ? SOLVER_OUT_OF_MEMORY : SOLVER_ERROR;
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Reads the connections every cell of a board can take. Rows are laid
+ * along the narrow side, so a board higher than wide is placed as it is and
+ * the others are transposed, their north and east swapped as well as their
+ * south and west
+ *
+ * @param counter, the counter, its size is set
+ * @param board, the board to count the solutions of
+ * @return false in case of error, true otherwise
+ */
+static bool read_masks(transfer *counter, cgame board) {
+  const direction transposed[NB_DIR] = {E, N, W, S};
+  uint16_t board_width = game_width(board);
+  uint16_t board_height = game_height(board);
+  bool transpose = board_width > TRANSFER_MAX_WIDTH ||
+                   (board_height <= TRANSFER_MAX_WIDTH &&
+                    board_height < board_width);
+  counter->width = transpose ? board_height : board_width;
+  counter->height = transpose ? board_width : board_height;
+  size_t nb_cells = (size_t)board_width * board_height;
+  piece *pieces = (piece *)malloc(nb_cells * sizeof(piece));
+  counter->masks = (uint8_t *)malloc(nb_cells * NB_DIR);
+  counter->nb_masks = (uint8_t *)malloc(nb_cells);
+  if (!pieces || !counter->masks || !counter->nb_masks) {
+    free(pieces);
+    return false;
+  }
+  get_cells(board, pieces, NULL);
+
+  for (uint16_t row = 0; row < counter->height; row++) {
+    for (uint16_t col = 0; col < counter->width; col++) {
+      size_t cell = (size_t)col + (size_t)row * counter->width;
+      size_t board_cell = transpose ? (size_t)row + (size_t)col * board_width
+                                    : cell;
+      uint8_t *masks = counter->masks + cell * NB_DIR;
+      uint8_t nb_masks = 0;
+      for (direction orientation = N;
+           pieces[board_cell] != EMPTY && orientation < NB_DIR;
+           orientation++) {
+        uint8_t mask = 0;
+        for (direction dir = N; dir < NB_DIR; dir++) {
+          if (is_edge(pieces[board_cell], orientation, dir))
+            mask |= (uint8_t)(1 << (transpose ? transposed[dir] : dir));
+        }
+        bool known = false;
+        for (uint8_t i = 0; i < nb_masks; i++)
+          known = known || masks[i] == mask;
+        if (!known) masks[nb_masks++] = mask;
+      }
+      counter->nb_masks[cell] = nb_masks;
+    }
+  }
+  free(pieces);
+  return true;
+}
+
+/**
+ * @brief Places a cell in every state of a table. A piece must take the
+ * connections coming from below and from the left, can't point off the board
+ * and can't link two connections already linked, which would close a loop. A
+ * group of placed cells left without any connection can't be linked to the
+ * others any more, so it only ends a solution on the last cell
+ *
+ * @param counter, the counter
+ * @param row, the row of the cell
+ * @param col, the column of the cell
+ * @param from, the states before placing the cell
+ * @param to, where the states after placing the cell are added
+ * @return false if the tables outgrew the memory or in case of error, true
+ * otherwise
+ */
+static bool place_cell(transfer *counter, uint16_t row, uint16_t col,
+                       const state_table *from, state_table *to) {
+  uint16_t width = counter->width;
+  size_t cell = (size_t)col + (size_t)row * width;
+  const uint8_t *masks = counter->masks + cell * NB_DIR;
+  bool last = row + 1 == counter->height && col + 1 == width;
+  uint8_t labels[NB_POSITIONS];
+  for (uint32_t slot = 0; slot < from->nb_slots; slot++) {
+    uint64_t key = from->keys[slot];
+    if (key == NO_STATE) continue;
+    counter->stats.nb_nodes++;
+    for (uint16_t pos = 0; pos <= width; pos++)
+      labels[pos] = (uint8_t)((key >> (LABEL_BITS * pos)) & LABEL_MASK);
+    uint8_t below = labels[col];
+    uint8_t left = labels[width];
+
+    for (uint8_t i = 0; i < counter->nb_masks[cell]; i++) {
+      uint8_t mask = masks[i];
+      bool up = mask & (1 << N);
+      bool right = mask & (1 << E);
+      if (((mask & (1 << S)) != 0) != (below != 0) ||
+          ((mask & (1 << W)) != 0) != (left != 0) ||
+          (up && row + 1 == counter->height) || (right && col + 1 == width) ||
+          (below && below == left)) {
+        counter->stats.nb_backtracks++;
+        continue;
+      }
+      // The piece joins the groups of its connections into one
+      uint8_t next[NB_POSITIONS];
+      uint8_t label = below ? below : left ? left : NEW_LABEL;
+      bool linked = false;
+      for (uint16_t pos = 0; pos <= width; pos++) {
+        next[pos] = labels[pos] == left && left ? label : labels[pos];
+        if (pos != col && pos != width && next[pos] == label) linked = true;
+      }
+      next[col] = up ? label : 0;
+      next[width] = right ? label : 0;
+      if (!up && !right && !linked && !last) {
+        counter->stats.nb_backtracks++;
+        continue;
+      }
+      counter->stats.nb_propagations++;
+      if (!add_state(counter, to, encode_state(next, width + 1),
+                     &from->counts[slot]))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Builds the key of a state, its labels renumbered in the order they
+ * first appear so that the same links always give the same key
+ *
+ * @param labels, the label of every position
+ * @param nb_positions, the number of positions
+ * @return the key
+ */
+static uint64_t encode_state(const uint8_t *labels, uint16_t nb_positions) {
+  uint8_t renamed[LABEL_MASK + 1] = {0};
+  uint8_t nb_labels = 0;
+  uint64_t key = 0;
+  for (uint16_t pos = 0; pos < nb_positions; pos++) {
+    if (!labels[pos]) continue;
+    if (!renamed[labels[pos]]) renamed[labels[pos]] = ++nb_labels;
+    key |= (uint64_t)renamed[labels[pos]] << (LABEL_BITS * pos);
+  }
+  return key;
+}
+
+/**
+ * @brief Allocates an empty table
+ *
+ * @param table, the table
+ * @param nb_slots, the number of slots, a power of 2
+ * @return false in case of error, true otherwise
+ */
+static bool init_table(state_table *table, uint32_t nb_slots) {
+  table->keys = (uint64_t *)malloc(nb_slots * sizeof(uint64_t));
+  table->counts = (sol_count *)malloc(nb_slots * sizeof(sol_count));
+  table->nb_slots = nb_slots;
+  table->nb_states = 0;
+  if (!table->keys || !table->counts) {
+    free(table->keys);
+    free(table->counts);
+    table->keys = NULL;
+    table->counts = NULL;
+    table->nb_slots = 0;
+    return false;
+  }
+  for (uint32_t slot = 0; slot < nb_slots; slot++) table->keys[slot] = NO_STATE;
+  return true;
+}
+
+/**
+ * @brief Adds a number of ways to reach a state to a table, the table grows
+ * once it is half full
+ *
+ * @param counter, the counter
+ * @param table, the table
+ * @param key, the state
+ * @param term, the number of ways to add
+ * @return false if the table outgrew the memory or in case of error, true
+ * otherwise
+ */
+static bool add_state(transfer *counter, state_table *table, uint64_t key,
+                      const sol_count *term) {
+  uint32_t slot = find_slot(table, key);
+  if (table->keys[slot] == NO_STATE) {
+    if (2 * (table->nb_states + 1) > table->nb_slots) {
+      if (!grow_table(counter, table)) return false;
+      slot = find_slot(table, key);
+    }
+    table->keys[slot] = key;
+    sol_count_init(&table->counts[slot], counter->big);
+    table->nb_states++;
+  }
+  return sol_count_add(&table->counts[slot], term);
+}
+
+/**
+ * @brief Doubles the number of slots of a table
+ *
+ * @param counter, the counter, whose memory limit the two tables share
+ * @param table, the table
+ * @return false if the table outgrew the memory or in case of error, true
+ * otherwise
+ */
+static bool grow_table(transfer *counter, state_table *table) {
+  uint64_t nb_slots = (uint64_t)counter->tables[0].nb_slots +
+                      counter->tables[1].nb_slots + table->nb_slots;
+  if (table->nb_slots > UINT32_MAX / 2 ||
+      (counter->max_bytes && nb_slots * SLOT_BYTES > counter->max_bytes)) {
+    counter->out_of_memory = true;
+    return false;
+  }
+  state_table grown;
+  if (!init_table(&grown, 2 * table->nb_slots)) {
+    FPRINTF(stderr, "Error: transfer_count, can't allocate the states.\n");
+    return false;
+  }
+  for (uint32_t slot = 0; slot < table->nb_slots; slot++) {
+    if (table->keys[slot] == NO_STATE) continue;
+    uint32_t new_slot = find_slot(&grown, table->keys[slot]);
+    grown.keys[new_slot] = table->keys[slot];
+    grown.counts[new_slot] = table->counts[slot];
+  }
+  grown.nb_states = table->nb_states;
+  free(table->keys);
+  free(table->counts);
+  *table = grown;
+  return true;
+}
+
+/**
+ * @brief Finds the slot of a state in a table
+ *
+ * @param table, the table, with at least one unused slot
+ * @param key, the state
+ * @return the slot holding the state, or the unused slot where it goes
+ */
+static uint32_t find_slot(const state_table *table, uint64_t key) {
+  uint32_t slot = (uint32_t)((key * HASH_MULTIPLIER) >> 32) &
+                  (table->nb_slots - 1);
+  while (table->keys[slot] != NO_STATE && table->keys[slot] != key)
+    slot = (slot + 1) & (table->nb_slots - 1);
+  return slot;
+}
+
+/**
+ * @brief Empties a table, keeping its slots
+ *
+ * @param table, the table
+ */
+static void reset_table(state_table *table) {
+  for (uint32_t slot = 0; slot < table->nb_slots; slot++) {
+    if (table->keys[slot] == NO_STATE) continue;
+    sol_count_clear(&table->counts[slot]);
+    table->keys[slot] = NO_STATE;
+  }
+  table->nb_states = 0;
+}
+
+/**
+ * @brief Frees the memory of a table
+ *
+ * @param table, the table
+ */
+static void free_table(state_table *table) {
+  if (!table->keys) return;
+  reset_table(table);
+  free(table->keys);
+  free(table->counts);
+  table->keys = NULL;
+  table->counts = NULL;
+}
@@ -0,0 +1,1671 @@
+#include "solver.h"
+
+#include "cross_thread.h"
+#include "cross_time.h"
+#include "game_io.h"
+#include "solve_cdcl.h"
+#include "solve_pack.h"
+#include "solve_parallel.h"
+#include "solve_prop.h"
+#include "solve_smart.h"
+#include "solve_transfer.h"
+
+#define FILENAME_MAX_SIZE 64
+#define SOL_NUM_SIZE 11
+// Number of nodes explored between two readings of the clock
+#define STEP_SLICE_NODES 16
+
+//--------------------------------------------------------------------------------------
+//                                Structures
+
+/**
+ * @brief Structure for a solver context
+ */
+struct solver_ctx_s {
+  game board;           /**< private copy of the board to solve */
+  solver_engine engine; /**< engine used by solver_solve */
+  solver_mode mode;     /**< what solver_solve has to find */
+  uint16_t nb_threads;  /**< number of threads of the prop engine, 0 for one
+                           per processor */
+  uint32_t rules;       /**< deduction rules of the smart engine */
+  uint32_t order;       /**< order in which the smart engine places pieces */
+  smart_engine smart;   /**< state of the smart engine, NULL if not used */
+  prop_engine prop;     /**< engine of an unfinished solve, NULL otherwise */
+  bool big_count;       /**< whether counts have arbitrary precision */
+  sol_count count;      /**< number of solutions found by the last solve */
+  uint32_t nb_solutions; /**< number of solutions found by the prop engine */
+  uint32_t nb_stored;    /**< number of solutions kept by the prop engine */
+  uint32_t capacity;     /**< number of solutions the array can hold */
+  direction *solutions;  /**< orientations of the kept solutions, one block of
+                            width * height directions per solution */
+  uint32_t max_solutions; /**< number of solutions after which the search
+                             stops, 0 for no limit */
+  solver_solution_callback on_solution; /**< sink of the solutions, NULL to
+                                           keep them in the context */
+  void *solution_data; /**< pointer given to on_solution */
+  game streamed;       /**< board given to on_solution */
+  solver_stats stats;  /**< statistics of the last solve */
+  solve_cache cache;   /**< cache checked before solving, NULL for none */
+  bool stopped;        /**< whether on_solution stopped the last solve */
+  uint64_t max_memory; /**< bytes the growing state of a solve may use, 0 for
+                          no limit */
+  bool out_of_memory;  /**< whether the memory limit stopped the last solve */
+  uint8_t *locks;      /**< orientations each locked piece keeps, 0xF for the
+                          others, NULL if no piece is locked */
+  solver_engine used_engine; /**< engine that ran the last solve */
+  uint16_t used_threads;     /**< threads that ran the last solve, 0 if it was
+                                answered without searching */
+};
+
+/**
+ * @brief Structure for a check of the locked pieces of a board
+ */
+struct lock_check_s {
+  prop_engine engine; /**< propagation engine of the board */
+  uint32_t nb_cells;  /**< number of cells of the board */
+  uint8_t *domains;   /**< domains of the board */
+  uint8_t *locks;     /**< orientations each piece keeps when it is locked */
+  uint8_t *loaded;    /**< domains of the current search */
+  uint64_t deadline;  /**< time at which the searches give up, 0 for none */
+};
+
+//--------------------------------------------------------------------------------------
+//                                Static functions
+
+static void startSolve(solver_ctx ctx);
+static solver_status startEngine(solver_ctx ctx, uint64_t max_nodes,
+                                 uint32_t max_milliseconds);
+static bool loadCached(solver_ctx ctx);
+static void storeCached(solver_ctx ctx);
+static solve_cache openCache(const solver_options *options);
+static solver_status solveSmart(solver_ctx ctx, uint64_t max_nodes,
+                                uint32_t max_milliseconds);
+static solver_status solveCdcl(solver_ctx ctx, uint64_t max_nodes,
+                               uint32_t max_milliseconds);
+static solver_status solveTransfer(solver_ctx ctx, uint64_t max_nodes,
+                                   uint32_t max_milliseconds);
+static solver_status solveParallel(solver_ctx ctx, uint16_t nb_threads,
+                                   uint64_t max_nodes,
+                                   uint32_t max_milliseconds);
+static solver_status stepProp(solver_ctx ctx, uint64_t max_nodes,
+                              uint32_t max_milliseconds);
+static solver_status solveWithin(solver_ctx ctx,
+                                 const solver_options *options);
+static bool writeReport(solver_ctx ctx, const solver_options *options,
+                        const char *prefix, solver_status status,
+                        uint64_t load_ms, uint64_t write_ms);
+static bool storeSolution(const direction *orientations, void *data);
+static void applyOrientations(game board, const direction *orientations);
+static bool findDeducedMove(cgame board, const uint8_t *domains,
+                            solver_move *move);
+static bool findSolutionMove(cgame board, cgame solution, solver_move *move);
+static bool getLocks(cgame board, const bool *locked, uint8_t *locks);
+static void narrowDomains(prop_engine engine, const uint8_t *locks,
+                          uint8_t *domains, uint32_t nb_cells);
+static solver_locks searchLocked(const struct lock_check_s *check,
+                                 const bool *locked);
+static void shrinkConflict(const struct lock_check_s *check, bool *core,
+                           const uint32_t *cells, uint32_t nb_cells);
+static bool stopSearch(const direction *orientations, void *data);
+static bool sameEdges(piece cell_piece, direction first, direction second);
+static bool isSolution(cgame board, const direction *orientations);
+static void streamSmart(solver_ctx ctx);
+static bool saveSolution(cgame solution, uint32_t index, void *data);
+static bool packSolution(cgame solution, uint32_t index, void *data);
+static bool gameLoadError();
+static bool solFileError(game board);
+
+//--------------------------------------------------------------------------------------
+//                                Solver context functions bodies
+
+solver_ctx solver_create(cgame board) {
+  if (!board) {
+    FPRINTF(stderr, "Error: solver_create, game pointer is NULL.\n");
+    return NULL;
+  }
+
+  solver_ctx ctx = (solver_ctx)malloc(sizeof(struct solver_ctx_s));
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_create, can't allocate solver context.\n");
+    return NULL;
+  }
+
+  ctx->board = copy_game(board);
+  if (!ctx->board) {
+    FPRINTF(stderr, "Error: solver_create, can't copy the board.\n");
+    free(ctx);
+    return NULL;
+  }
+  ctx->engine = SOLVER_ENGINE_PROP;
+  ctx->mode = SOLVER_FIND_ALL;
+  ctx->nb_threads = 1;
+  ctx->rules = SMART_RULES_ALL;
+  ctx->order = SMART_ORDER_FIXED;
+  ctx->big_count = false;
+  sol_count_init(&ctx->count, false);
+  ctx->smart = NULL;
+  ctx->prop = NULL;
+  ctx->nb_solutions = 0;
+  ctx->nb_stored = 0;
+  ctx->capacity = 0;
+  ctx->solutions = NULL;
+  ctx->max_solutions = 0;
+  ctx->on_solution = NULL;
+  ctx->solution_data = NULL;
+  ctx->streamed = NULL;
+  memset(&ctx->stats, 0, sizeof(solver_stats));
+  ctx->cache = NULL;
+  ctx->stopped = false;
+  ctx->max_memory = 0;
+  ctx->out_of_memory = false;
+  ctx->locks = NULL;
+  ctx->used_engine = ctx->engine;
+  ctx->used_threads = 0;
+  return ctx;
+}
+
+bool solver_set_board(solver_ctx ctx, cgame board) {
+  if (!ctx || !board) {
+    FPRINTF(stderr,
+            "Error: solver_set_board, solver context or game pointer is "
+            "NULL.\n");
+    return false;
+  }
+  game copy = copy_game(board);
+  game streamed = ctx->streamed ? copy_game(board) : NULL;
+  if (!copy || (ctx->streamed && !streamed)) {
+    FPRINTF(stderr, "Error: solver_set_board, can't copy the board.\n");
+    if (copy) delete_game(copy);
+    return false;
+  }
+  if (ctx->prop) {
+    prop_destroy(ctx->prop);
+    ctx->prop = NULL;
+  }
+  startSolve(ctx);
+  // The solutions array is kept, its capacity is counted in boards
+  uint64_t old_cells =
+      (uint64_t)game_width(ctx->board) * game_height(ctx->board);
+  uint64_t new_cells = (uint64_t)game_width(copy) * game_height(copy);
+  ctx->capacity = new_cells ? (uint32_t)(ctx->capacity * old_cells / new_cells)
+                            : 0;
+  delete_game(ctx->board);
+  ctx->board = copy;
+  // The locks were taken on the pieces of the old board
+  free(ctx->locks);
+  ctx->locks = NULL;
+  if (ctx->streamed) {
+    delete_game(ctx->streamed);
+    ctx->streamed = streamed;
+  }
+  return true;
+}
+
+void solver_set_engine(solver_ctx ctx, solver_engine engine) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_engine, solver context is NULL.\n");
+    return;
+  }
+  ctx->engine = engine;
+}
+
+void solver_set_mode(solver_ctx ctx, solver_mode mode) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_mode, solver context is NULL.\n");
+    return;
+  }
+  ctx->mode = mode;
+}
+
+void solver_set_threads(solver_ctx ctx, uint16_t nb_threads) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_threads, solver context is NULL.\n");
+    return;
+  }
+  ctx->nb_threads = nb_threads;
+}
+
+void solver_set_rules(solver_ctx ctx, uint32_t rules) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_rules, solver context is NULL.\n");
+    return;
+  }
+  ctx->rules = rules;
+}
+
+void solver_set_order(solver_ctx ctx, uint32_t order) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_order, solver context is NULL.\n");
+    return;
+  }
+  ctx->order = order;
+}
+
+void solver_set_memory_limit(solver_ctx ctx, uint64_t max_bytes) {
+  if (!ctx) {
+    FPRINTF(stderr,
+            "Error: solver_set_memory_limit, solver context is NULL.\n");
+    return;
+  }
+  ctx->max_memory = max_bytes;
+}
+
+void solver_set_big_count(solver_ctx ctx, bool big) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_big_count, solver context is NULL.\n");
+    return;
+  }
+  ctx->big_count = big;
+}
+
+void solver_set_limit(solver_ctx ctx, uint32_t max_solutions) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_limit, solver context is NULL.\n");
+    return;
+  }
+  ctx->max_solutions = max_solutions;
+}
+
+bool solver_set_solution_callback(solver_ctx ctx,
+                                  solver_solution_callback on_solution,
+                                  void *data) {
+  if (!ctx) {
+    FPRINTF(stderr,
+            "Error: solver_set_solution_callback, solver context is NULL.\n");
+    return false;
+  }
+  if (on_solution && !ctx->streamed) {
+    ctx->streamed = copy_game(ctx->board);
+    if (!ctx->streamed) return false;
+  }
+  ctx->on_solution = on_solution;
+  ctx->solution_data = data;
+  return true;
+}
+
+void solver_set_cache(solver_ctx ctx, solve_cache cache) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_cache, solver context is NULL.\n");
+    return;
+  }
+  ctx->cache = cache;
+}
+
+bool solver_set_locks(solver_ctx ctx, const bool *locked) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_set_locks, solver context is NULL.\n");
+    return false;
+  }
+  uint8_t *locks = NULL;
+  if (locked) {
+    size_t nb_cells = (size_t)game_width(ctx->board) * game_height(ctx->board);
+    locks = (uint8_t *)malloc(nb_cells);
+    if (!locks || !getLocks(ctx->board, locked, locks)) {
+      FPRINTF(stderr, "Error: solver_set_locks, can't allocate the locks.\n");
+      free(locks);
+      return false;
+    }
+  }
+  free(ctx->locks);
+  ctx->locks = locks;
+  return true;
+}
+
+void solver_set_options(solver_ctx ctx, const solver_options *options) {
+  if (!ctx || !options) {
+    FPRINTF(stderr,
+            "Error: solver_set_options, solver context or options pointer is "
+            "NULL.\n");
+    return;
+  }
+  ctx->engine = options->engine;
+  ctx->nb_threads = options->nb_threads;
+  ctx->big_count = options->big_count;
+  ctx->max_solutions = options->max_solutions;
+  ctx->max_memory = options->max_memory;
+}
+
+bool solver_solve(solver_ctx ctx) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_solve, solver context is NULL.\n");
+    return false;
+  }
+  if (ctx->prop) {
+    prop_destroy(ctx->prop);
+    ctx->prop = NULL;
+  }
+  return solver_step(ctx, 0, 0) == SOLVER_DONE &&
+         solver_nb_solutions(ctx) > 0;
+}
+
+solver_status solver_step(solver_ctx ctx, uint64_t max_nodes,
+                          uint32_t max_milliseconds) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_step, solver context is NULL.\n");
+    return SOLVER_ERROR;
+  }
+
+  solver_status status;
+  if (ctx->prop) {
+    status = stepProp(ctx, max_nodes, max_milliseconds);
+  } else {
+    startSolve(ctx);
+    // Screening and looking the board up are part of preparing the solve, a
+    // board failing the screen has no solution to search for
+    uint64_t start = get_milliseconds();
+    // The cache knows the solutions of the boards, not the ones keeping locks
+    bool answered = !may_have_solution(ctx->board) ||
+                    (ctx->cache && !ctx->locks && loadCached(ctx));
+    ctx->stats.setup_ms = get_milliseconds() - start;
+    if (answered) return SOLVER_DONE;
+    status = startEngine(ctx, max_nodes, max_milliseconds);
+  }
+  if (status == SOLVER_DONE && ctx->out_of_memory)
+    status = SOLVER_OUT_OF_MEMORY;
+  if (status == SOLVER_DONE && ctx->cache && !ctx->locks) storeCached(ctx);
+  return status;
+}
+
+uint32_t solver_nb_solutions(solver_ctx ctx) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_nb_solutions, solver context is NULL.\n");
+    return 0;
+  }
+  if (!ctx->smart) return ctx->nb_solutions;
+
+  uint32_t nb_solutions = smart_nb_solutions(ctx->smart);
+  if (ctx->mode == SOLVER_FIND_ONE && nb_solutions > 1) return 1;
+  if (ctx->mode == SOLVER_FIND_ALL && ctx->max_solutions &&
+      nb_solutions > ctx->max_solutions)
+    return ctx->max_solutions;
+  return nb_solutions;
+}
+
+const solver_stats *solver_get_stats(solver_ctx ctx) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_get_stats, solver context is NULL.\n");
+    return NULL;
+  }
+  return &ctx->stats;
+}
+
+const sol_count *solver_get_count(solver_ctx ctx) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_get_count, solver context is NULL.\n");
+    return NULL;
+  }
+  return &ctx->count;
+}
+
+bool solver_load_solution(solver_ctx ctx, uint32_t index, game board) {
+  if (!ctx || !board) {
+    FPRINTF(stderr,
+            "Error: solver_load_solution, solver context or game pointer is "
+            "NULL.\n");
+    return false;
+  }
+  if (ctx->smart && index >= solver_nb_solutions(ctx)) {
+    FPRINTF(stderr,
+            "Error: solver_load_solution, solution %u wasn't found.\n", index);
+    return false;
+  }
+  if (ctx->smart) return smart_load_solution(ctx->smart, index, board);
+
+  uint16_t width = game_width(ctx->board);
+  uint16_t height = game_height(ctx->board);
+  if (index >= ctx->nb_stored) {
+    FPRINTF(stderr,
+            "Error: solver_load_solution, solution %u hasn't been kept.\n",
+            index);
+    return false;
+  }
+  if (game_width(board) != width || game_height(board) != height) {
+    FPRINTF(stderr,
+            "Error: solver_load_solution, the board doesn't have the size of "
+            "the solved one.\n");
+    return false;
+  }
+
+  applyOrientations(board, ctx->solutions + (size_t)index * width * height);
+  return true;
+}
+
+void solver_destroy(solver_ctx ctx) {
+  if (!ctx) {
+    FPRINTF(stderr, "Error: solver_destroy, solver context is NULL.\n");
+    return;
+  }
+  if (ctx->smart) smart_destroy(ctx->smart);
+  if (ctx->prop) prop_destroy(ctx->prop);
+  sol_count_clear(&ctx->count);
+  free(ctx->solutions);
+  free(ctx->locks);
+  if (ctx->streamed) delete_game(ctx->streamed);
+  delete_game(ctx->board);
+  free(ctx);
+}
+
+//--------------------------------------------------------------------------------------
+//                                Game solving functions bodies
+
+void solver_options_init(solver_options *options) {
+  if (!options) {
+    FPRINTF(stderr, "Error: solver_options_init, options pointer is NULL.\n");
+    return;
+  }
+  options->engine = SOLVER_ENGINE_PROP;
+  options->nb_threads = 1;
+  options->big_count = false;
+  options->max_solutions = 0;
+  options->time_limit = 0;
+  options->report = SOLVER_REPORT_NONE;
+  options->cache_dir = NULL;
+  options->packed = false;
+  options->max_memory = 0;
+}
+
+bool find_one(char *game_file, char *prefix, const solver_options *options) {
+  uint64_t start = get_milliseconds();
+  game board = load_game(game_file);
+  if (!board) return gameLoadError();
+  uint64_t load_ms = get_milliseconds() - start;
+
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) {
+    delete_game(board);
+    return false;
+  }
+  solver_set_options(ctx, options);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+
+  char solution_fname[FILENAME_MAX_SIZE * 2];
+  STRCPY(solution_fname, prefix, FILENAME_MAX_SIZE);
+  STRCAT(solution_fname, ".sol", FILENAME_MAX_SIZE);
+  solver_status status = solveWithin(ctx, options);
+  if (status != SOLVER_DONE) {
+    writeReport(ctx, options, prefix, status, load_ms, 0);
+    solver_destroy(ctx);
+    delete_game(board);
+    return false;
+  }
+  start = get_milliseconds();
+  if (solver_nb_solutions(ctx) > 0) {
+    solver_load_solution(ctx, 0, board);
+    save_game(board, solution_fname);
+  } else {
+    FILE *stream;
+    FOPEN(stream, solution_fname, "w");
+    if (!stream) {
+      solver_destroy(ctx);
+      return solFileError(board);
+    }
+    FPRINTF(stream, "NO SOLUTION\n");
+    FCLOSE(stream);
+  }
+
+  bool reported = writeReport(ctx, options, prefix, status, load_ms,
+                              get_milliseconds() - start);
+  solver_destroy(ctx);
+  delete_game(board);
+  return reported;
+}
+
+bool nb_sol(char *game_file, char *prefix, const solver_options *options) {
+  uint64_t start = get_milliseconds();
+  game board = load_game(game_file);
+  if (!board) return gameLoadError();
+  uint64_t load_ms = get_milliseconds() - start;
+
+  char nb_solution_fname[FILENAME_MAX_SIZE * 2];
+  STRCPY(nb_solution_fname, prefix, FILENAME_MAX_SIZE);
+  STRCAT(nb_solution_fname, ".nbsol", FILENAME_MAX_SIZE);
+  FILE *stream;
+  FOPEN(stream, nb_solution_fname, "w");
+  if (!stream) return solFileError(board);
+
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) {
+    FCLOSE(stream);
+    delete_game(board);
+    return false;
+  }
+  solver_set_options(ctx, options);
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  // Narrow boards are counted row by row, however many solutions they have
+  if (options->engine == SOLVER_ENGINE_PROP && transfer_suits(board))
+    solver_set_engine(ctx, SOLVER_ENGINE_TRANSFER);
+
+  solver_status solve_status = solveWithin(ctx, options);
+  bool status = solve_status == SOLVER_DONE;
+  start = get_milliseconds();
+  const sol_count *count = solver_get_count(ctx);
+  if (status && !count->big && count->overflow) {
+    FPRINTF(stderr,
+            "Error: nb_sol, the number of solutions doesn't fit in 64 bits, "
+            "arbitrary-precision counting is needed.\n");
+    status = false;
+  }
+  status = status && sol_count_fprint(stream, count);
+  if (status) FPRINTF(stream, "\n");
+  FCLOSE(stream);
+
+  status = writeReport(ctx, options, prefix, solve_status, load_ms,
+                       get_milliseconds() - start) &&
+           status;
+  solver_destroy(ctx);
+  delete_game(board);
+  return status;
+}
+
+bool find_all(char *game_file, char *prefix, const solver_options *options) {
+  uint64_t start = get_milliseconds();
+  game board = load_game(game_file);
+  if (!board) return gameLoadError();
+  uint64_t load_ms = get_milliseconds() - start;
+
+  solver_ctx ctx = solver_create(board);
+  pack_writer pack = NULL;
+  if (ctx && options && options->packed) {
+    char pack_fname[FILENAME_MAX_SIZE * 2];
+    STRCPY(pack_fname, prefix, FILENAME_MAX_SIZE);
+    STRCAT(pack_fname, ".pack", FILENAME_MAX_SIZE);
+    pack = pack_create(pack_fname, board);
+  }
+  delete_game(board);
+  if (!ctx) return false;
+  solver_set_options(ctx, options);
+
+  // Multiple solution files must be created here, each one as soon as its
+  // solution is found, so writing them is part of the search
+  bool status = options && options->packed
+                    ? pack && solver_set_solution_callback(ctx, packSolution,
+                                                           pack)
+                    : solver_set_solution_callback(ctx, saveSolution, prefix);
+  if (!status) {
+    if (pack) pack_finish(pack);
+    solver_destroy(ctx);
+    return false;
+  }
+  solver_status solve_status = solveWithin(ctx, options);
+  if (pack) status = pack_finish(pack);
+  bool reported = writeReport(ctx, options, prefix, solve_status, load_ms, 0);
+
+  solver_destroy(ctx);
+  return status && solve_status == SOLVER_DONE && reported;
+}
+
+bool solve_one(cgame board, game solution) {
+  if (!board || !solution) {
+    FPRINTF(stderr,
+            "Error: solve_one, game or solution pointer is NULL.\n");
+    return false;
+  }
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) return false;
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+  bool status = solver_solve(ctx) && solver_load_solution(ctx, 0, solution);
+  solver_destroy(ctx);
+  return status;
+}
+
+bool count_solutions(cgame board, bool big, sol_count *count) {
+  if (!board || !count) {
+    FPRINTF(stderr,
+            "Error: count_solutions, game or counter pointer is NULL.\n");
+    return false;
+  }
+  sol_count_init(count, big);
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) return false;
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  solver_set_big_count(ctx, big);
+  bool status = solver_step(ctx, 0, 0) == SOLVER_DONE &&
+                sol_count_copy(count, solver_get_count(ctx));
+  solver_destroy(ctx);
+  return status;
+}
+
+bool enumerate_solutions(cgame board, solver_solution_callback on_solution,
+                         void *data) {
+  if (!board || !on_solution) {
+    FPRINTF(stderr,
+            "Error: enumerate_solutions, game or callback pointer is NULL.\n");
+    return false;
+  }
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) return false;
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_FIND_ALL);
+  bool status = solver_set_solution_callback(ctx, on_solution, data) &&
+                solver_step(ctx, 0, 0) == SOLVER_DONE;
+  solver_destroy(ctx);
+  return status;
+}
+
+bool find_one_sdl(game board) {
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) return false;
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+  solve_cache cache = cache_open_env();
+  solver_set_cache(ctx, cache);
+
+  bool status = solver_solve(ctx) && solver_load_solution(ctx, 0, board);
+  solver_destroy(ctx);
+  if (cache) cache_close(cache);
+  return status;
+}
+
+bool find_hint(cgame board, const bool *locked, uint32_t max_milliseconds,
+               solver_move *move) {
+  if (!board || !move) {
+    FPRINTF(stderr, "Error: find_hint, game or move pointer is NULL.\n");
+    return false;
+  }
+  if (is_game_over(board)) return false;
+
+  // The orientations forced by propagation alone are tried first
+  prop_engine engine = prop_create(board);
+  if (!engine) return false;
+  uint32_t nb_cells = (uint32_t)game_width(board) * game_height(board);
+  uint8_t *domains = (uint8_t *)malloc(2 * nb_cells);
+  if (!domains) {
+    FPRINTF(stderr, "Error: find_hint, can't allocate the domains.\n");
+    prop_destroy(engine);
+    return false;
+  }
+  // The locked pieces keep their orientations, so no move turns them
+  uint8_t *locks = domains + nb_cells;
+  bool solvable = !locked || getLocks(board, locked, locks);
+  if (solvable && locked) narrowDomains(engine, locks, domains, nb_cells);
+  solvable = solvable && prop_deduce(engine);
+  bool found = false;
+  if (solvable) {
+    prop_get_domains(engine, domains);
+    found = findDeducedMove(board, domains, move);
+  }
+  free(domains);
+  prop_destroy(engine);
+  if (found || !solvable) return found;
+
+  // Otherwise a piece is taken from the first solution found within the budget
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) return false;
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+  game solution = copy_game(board);
+  if (solution && solver_set_locks(ctx, locked) &&
+      solver_step(ctx, 0, max_milliseconds) == SOLVER_DONE &&
+      solver_load_solution(ctx, 0, solution))
+    found = findSolutionMove(board, solution, move);
+  if (solution) delete_game(solution);
+  solver_destroy(ctx);
+  return found;
+}
+
+solver_locks check_locks(cgame board, const bool *locked,
+                         uint32_t max_milliseconds, bool *conflicts) {
+  if (!board || !locked) {
+    FPRINTF(stderr, "Error: check_locks, game or locks pointer is NULL.\n");
+    return SOLVER_LOCKS_ERROR;
+  }
+  struct lock_check_s check;
+  check.deadline = max_milliseconds ? get_milliseconds() + max_milliseconds
+                                    : 0;
+  check.nb_cells = (uint32_t)game_width(board) * game_height(board);
+  uint32_t nb_cells = check.nb_cells;
+  if (conflicts) memset(conflicts, 0, nb_cells * sizeof(bool));
+  check.engine = prop_create(board);
+  check.domains = (uint8_t *)malloc(3 * nb_cells);
+  bool *core = (bool *)malloc(nb_cells * sizeof(bool));
+  uint32_t *cells = (uint32_t *)malloc(nb_cells * sizeof(uint32_t));
+  check.locks = check.domains ? check.domains + nb_cells : NULL;
+  if (!check.engine || !check.domains || !core || !cells ||
+      !getLocks(board, NULL, check.locks)) {
+    FPRINTF(stderr, "Error: check_locks, can't allocate the check.\n");
+    if (check.engine) prop_destroy(check.engine);
+    free(check.domains);
+    free(core);
+    free(cells);
+    return SOLVER_LOCKS_ERROR;
+  }
+  check.loaded = check.locks + nb_cells;
+  prop_get_domains(check.engine, check.domains);
+
+  solver_locks status = searchLocked(&check, locked);
+  if (status == SOLVER_LOCKS_CONFLICT && conflicts) {
+    memset(core, 0, nb_cells * sizeof(bool));
+    if (searchLocked(&check, core) != SOLVER_LOCKS_CONFLICT) {
+      uint32_t nb_locked = 0;
+      for (uint32_t cell = 0; cell < nb_cells; cell++) {
+        core[cell] = locked[cell];
+        if (locked[cell]) cells[nb_locked++] = cell;
+      }
+      shrinkConflict(&check, core, cells, nb_locked);
+      memcpy(conflicts, core, nb_cells * sizeof(bool));
+    }
+  }
+  prop_destroy(check.engine);
+  free(check.domains);
+  free(core);
+  free(cells);
+  return status;
+}
+
+bool may_have_solution(cgame board) {
+  if (!board) {
+    FPRINTF(stderr, "Error: may_have_solution, game pointer is NULL.\n");
+    return false;
+  }
+  const int32_t delta_x[NB_DIR] = {0, 1, 0, -1};
+  const int32_t delta_y[NB_DIR] = {1, 0, -1, 0};
+  int32_t width = game_width(board);
+  int32_t height = game_height(board);
+  bool wrapping = is_wrapping(board);
+  size_t nb_cells = (size_t)width * (size_t)height;
+  piece *pieces = (piece *)malloc(nb_cells * sizeof(piece));
+  if (!pieces) {
+    // The search decides what the screen couldn't
+    FPRINTF(stderr, "Error: may_have_solution, can't allocate the pieces.\n");
+    return true;
+  }
+  get_cells(board, pieces, NULL);
+
+  // The connections of each piece in each orientation, bit dir set when the
+  // piece points to dir
+  uint8_t shapes[NB_PIECE_TYPE][NB_DIR];
+  uint8_t degrees[NB_PIECE_TYPE] = {0};
+  for (piece shape = LEAF; shape < NB_PIECE_TYPE; shape++) {
+    for (direction orientation = N; orientation < NB_DIR; orientation++) {
+      shapes[shape][orientation] = 0;
+      for (direction dir = N; dir < NB_DIR; dir++) {
+        if (!is_edge(shape, orientation, dir)) continue;
+        shapes[shape][orientation] |= (uint8_t)(1 << dir);
+        if (orientation == N) degrees[shape]++;
+      }
+    }
+  }
+
+  // A solution links the cells in a tree, so every piece is connected, every
+  // piece turns without pointing off the board, two leaves can't only be
+  // linked to each other and the connections sum up to twice the links
+  bool possible = true;
+  size_t nb_half_edges = 0;
+  for (size_t cell = 0; possible && cell < nb_cells; cell++) {
+    piece cell_piece = pieces[cell];
+    if (cell_piece == EMPTY) {
+      possible = false;
+      break;
+    }
+    int32_t x = (int32_t)(cell % (size_t)width);
+    int32_t y = (int32_t)(cell / (size_t)width);
+    uint8_t open = 0;
+    bool leaf_only = true;
+    for (direction dir = N; dir < NB_DIR; dir++) {
+      int32_t next_x = x + delta_x[dir];
+      int32_t next_y = y + delta_y[dir];
+      if (wrapping) {
+        next_x = (next_x + width) % width;
+        next_y = (next_y + height) % height;
+      }
+      if (next_x < 0 || width <= next_x || next_y < 0 || height <= next_y)
+        continue;
+      open |= (uint8_t)(1 << dir);
+      size_t next = (size_t)next_x + (size_t)next_y * (size_t)width;
+      if (pieces[next] != LEAF) leaf_only = false;
+    }
+    bool fits = false;
+    for (direction orientation = N; orientation < NB_DIR; orientation++) {
+      if ((shapes[cell_piece][orientation] & ~open) == 0) fits = true;
+    }
+    possible = fits && !(cell_piece == LEAF && leaf_only);
+    nb_half_edges += degrees[cell_piece];
+  }
+  free(pieces);
+  return possible && nb_half_edges == 2 * (nb_cells - 1);
+}
+
+//--------------------------------------------------------------------------------------
+//                                Static functions bodies
+
+/**
+ * @brief Forgets the results of the last solve of a context
+ *
+ * @param ctx, the solver context
+ */
+static void startSolve(solver_ctx ctx) {
+  if (ctx->smart) {
+    smart_destroy(ctx->smart);
+    ctx->smart = NULL;
+  }
+  ctx->nb_solutions = 0;
+  ctx->nb_stored = 0;
+  ctx->stopped = false;
+  ctx->out_of_memory = false;
+  ctx->used_engine = ctx->engine;
+  ctx->used_threads = 0;
+  memset(&ctx->stats, 0, sizeof(solver_stats));
+  sol_count_clear(&ctx->count);
+  sol_count_init(&ctx->count, ctx->big_count);
+}
+
+/**
+ * @brief Starts a new solve with the engine of a context
+ *
+ * @param ctx, the solver context, the results of its last solve are forgotten
+ * @param max_nodes, the number of nodes the step may explore, 0 for no limit
+ * @param max_milliseconds, the time the step may take, 0 for no limit
+ * @return the status of the solve
+ */
+static solver_status startEngine(solver_ctx ctx, uint64_t max_nodes,
+                                 uint32_t max_milliseconds) {
+  // Only a single prop engine narrows its domains to the locks
+  solver_engine engine = ctx->locks ? SOLVER_ENGINE_PROP : ctx->engine;
+  uint16_t nb_threads = ctx->nb_threads ? ctx->nb_threads : get_nb_cpus();
+  if (ctx->locks) nb_threads = 1;
+  // The report gives the engine that ran, whatever fell back to prop
+  ctx->used_engine = engine;
+  ctx->used_threads = 1;
+  if (engine == SOLVER_ENGINE_CDCL)
+    return solveCdcl(ctx, max_nodes, max_milliseconds);
+  if (engine == SOLVER_ENGINE_TRANSFER) {
+    // The prop engine finds the solutions of the boards the counter can't
+    // handle, and counts them when the states don't fit
+    if (ctx->mode == SOLVER_NB_SOL && transfer_suits(ctx->board)) {
+      solver_status status = solveTransfer(ctx, max_nodes, max_milliseconds);
+      if (status == SOLVER_DONE || status == SOLVER_UNFINISHED) return status;
+    }
+    memset(&ctx->stats, 0, sizeof(solver_stats));
+  } else if (engine != SOLVER_ENGINE_PROP) {
+    solver_status status = solveSmart(ctx, max_nodes, max_milliseconds);
+    if (status != SOLVER_OUT_OF_MEMORY) return status;
+    // The trees don't fit, the prop engine finds the same solutions without
+    // building them
+    smart_destroy(ctx->smart);
+    ctx->smart = NULL;
+  }
+  // The workers keep the solutions until they are all done, so a stream
+  // without limit is only given in order as it goes by a single engine
+  bool streamed = ctx->on_solution && ctx->mode == SOLVER_FIND_ALL &&
+                  !ctx->max_solutions;
+  ctx->used_engine = SOLVER_ENGINE_PROP;
+  if (nb_threads > 1 && !streamed) {
+    ctx->used_threads = nb_threads;
+    return solveParallel(ctx, nb_threads, max_nodes, max_milliseconds);
+  }
+  uint64_t start = get_milliseconds();
+  ctx->prop = prop_create(ctx->board);
+  if (!ctx->prop) return SOLVER_ERROR;
+  prop_set_memory_limit(ctx->prop, ctx->max_memory);
+  if (ctx->locks) {
+    uint32_t nb_cells =
+        (uint32_t)game_width(ctx->board) * game_height(ctx->board);
+    uint8_t *domains = (uint8_t *)malloc(nb_cells);
+    if (!domains) {
+      FPRINTF(stderr, "Error: startEngine, can't allocate the domains.\n");
+      prop_destroy(ctx->prop);
+      ctx->prop = NULL;
+      return SOLVER_ERROR;
+    }
+    narrowDomains(ctx->prop, ctx->locks, domains, nb_cells);
+    free(domains);
+  }
+  ctx->stats.setup_ms += get_milliseconds() - start;
+  return stepProp(ctx, max_nodes, max_milliseconds);
+}
+
+/**
+ * @brief Gives the results of a solve from the cache of a context, if the
+ * cache knows enough about the board for the mode of the context
+ *
+ * @param ctx, the solver context, with a cache, at the start of a solve
+ * @return true if the solve is over, false if the board has to be searched
+ */
+static bool loadCached(solver_ctx ctx) {
+  size_t nb_cells = (size_t)game_width(ctx->board) * game_height(ctx->board);
+  cache_entry entry;
+  entry.solution = (direction *)malloc(nb_cells * sizeof(direction));
+  if (!entry.solution || !cache_lookup(ctx->cache, ctx->board, &entry)) {
+    free(entry.solution);
+    return false;
+  }
+
+  // A solution from the disk is only trusted once it is checked
+  if (entry.has_solution)
+    entry.has_solution = isSolution(ctx->board, entry.solution);
+  bool none = entry.has_count && entry.nb_solutions == 0;
+  bool usable;
+  if (ctx->mode == SOLVER_NB_SOL)
+    usable = entry.has_count;
+  else if (ctx->mode == SOLVER_FIND_ONE)
+    usable = none || entry.has_solution;
+  else
+    usable = none || (entry.has_count && entry.nb_solutions == 1 &&
+                      entry.has_solution);
+
+  if (usable && ctx->mode == SOLVER_NB_SOL) {
+    usable = sol_count_add_uint(&ctx->count, entry.nb_solutions);
+    ctx->nb_solutions = sol_count_to_uint32(&ctx->count);
+  } else if (usable && !none) {
+    storeSolution(entry.solution, ctx);
+    usable = sol_count_add_uint(&ctx->count, ctx->nb_solutions);
+  }
+  free(entry.solution);
+  return usable;
+}
+
+/**
+ * @brief Adds the results of a finished solve to the cache of a context
+ *
+ * @param ctx, the solver context, with a cache
+ */
+static void storeCached(solver_ctx ctx) {
+  uint32_t nb_solutions = solver_nb_solutions(ctx);
+  cache_entry entry;
+  entry.solution = NULL;
+  entry.has_solution = false;
+  // The count is complete unless the search was cut short, and a solution
+  // is only at hand if it was kept
+  bool complete =
+      ctx->mode == SOLVER_NB_SOL || nb_solutions == 0 ||
+      (ctx->mode == SOLVER_FIND_ALL && !ctx->stopped &&
+       (!ctx->max_solutions || nb_solutions < ctx->max_solutions));
+  entry.has_count =
+      complete && sol_count_to_uint64(&ctx->count, &entry.nb_solutions);
+  if (ctx->mode != SOLVER_NB_SOL && nb_solutions > 0 &&
+      (ctx->smart || ctx->nb_stored > 0)) {
+    game solved_board = copy_game(ctx->board);
+    size_t nb_cells = (size_t)game_width(ctx->board) * game_height(ctx->board);
+    entry.solution = (direction *)malloc(nb_cells * sizeof(direction));
+    if (solved_board && entry.solution &&
+        solver_load_solution(ctx, 0, solved_board)) {
+      get_cells(solved_board, NULL, entry.solution);
+      entry.has_solution = true;
+    }
+    if (solved_board) delete_game(solved_board);
+  }
+  if (entry.has_count || entry.has_solution)
+    cache_store(ctx->cache, ctx->board, &entry);
+  free(entry.solution);
+}
+
+/**
+ * @brief Opens the cache of the file functions
+ *
+ * @param options, the settings of the solve
+ * @return the cache, NULL if there is none or if it couldn't be opened, the
+ * solve then goes on without it
+ */
+static solve_cache openCache(const solver_options *options) {
+  if (!options->cache_dir) return NULL;
+  solve_cache cache = cache_open(options->cache_dir);
+  if (!cache)
+    FPRINTF(stderr, "Error: the cache can't be used, solving without it.\n");
+  return cache;
+}
+
+/**
+ * @brief Solves the board of a context with the smart engine
+ *
+ * @param ctx, the solver context
+ * @param max_nodes, the number of nodes the solve may explore, 0 for no limit
+ * @param max_milliseconds, the time the solve may take, 0 for no limit
+ * @return the status of the solve, SOLVER_OUT_OF_MEMORY if the trees ran out
+ * of memory
+ */
+static solver_status solveSmart(solver_ctx ctx, uint64_t max_nodes,
+                                uint32_t max_milliseconds) {
+  uint64_t start = get_milliseconds();
+  ctx->smart = smart_create(ctx->board);
+  if (!ctx->smart) return SOLVER_ERROR;
+  smart_set_rules(ctx->smart, ctx->rules);
+  smart_set_order(ctx->smart, (smart_order)ctx->order);
+  smart_set_memory_limit(ctx->smart, ctx->max_memory);
+  smart_set_budget(ctx->smart, max_nodes, max_milliseconds);
+  uint64_t created = get_milliseconds();
+  ctx->stats.setup_ms += created - start;
+  bool found = smart_solve(ctx->smart);
+  smart_get_stats(ctx->smart, &ctx->stats);
+  ctx->stats.search_ms = get_milliseconds() - created;
+  if (!found && smart_out_of_memory(ctx->smart)) return SOLVER_OUT_OF_MEMORY;
+  if (!found && smart_out_of_budget(ctx->smart)) return SOLVER_UNFINISHED;
+  if (found && ctx->on_solution && ctx->mode != SOLVER_NB_SOL)
+    streamSmart(ctx);
+  // The regions of the board multiply their counts, which may not fit in 32
+  // bits
+  bool counted =
+      ctx->mode == SOLVER_NB_SOL
+          ? smart_count_solutions(ctx->smart, &ctx->count)
+          : sol_count_add_uint(&ctx->count, solver_nb_solutions(ctx));
+  return counted ? SOLVER_DONE : SOLVER_ERROR;
+}
+
+/**
+ * @brief Solves the board of a context with the clause-learning engine
+ *
+ * @param ctx, the solver context
+ * @param max_nodes, the number of nodes the solve may explore, 0 for no limit
+ * @param max_milliseconds, the time the solve may take, 0 for no limit
+ * @return the status of the solve
+ */
+static solver_status solveCdcl(solver_ctx ctx, uint64_t max_nodes,
+                               uint32_t max_milliseconds) {
+  uint64_t start = get_milliseconds();
+  cdcl_engine engine = cdcl_create(ctx->board);
+  if (!engine) return SOLVER_ERROR;
+  cdcl_set_budget(engine, max_nodes, max_milliseconds);
+  uint64_t created = get_milliseconds();
+  ctx->stats.setup_ms += created - start;
+  bool done = cdcl_search(engine, storeSolution, ctx);
+  bool out_of_budget = cdcl_out_of_budget(engine);
+  cdcl_get_stats(engine, &ctx->stats);
+  ctx->stats.search_ms = get_milliseconds() - created;
+  cdcl_destroy(engine);
+  if (!done) return SOLVER_ERROR;
+  // The solutions found so far can be read, but they aren't counted
+  if (out_of_budget) return SOLVER_UNFINISHED;
+  return sol_count_add_uint(&ctx->count, ctx->nb_solutions) ? SOLVER_DONE
+                                                            : SOLVER_ERROR;
+}
+
+/**
+ * @brief Counts the solutions of the board of a context row by row
+ *
+ * @param ctx, the solver context, in SOLVER_NB_SOL mode with a board suiting
+ * the counter
+ * @param max_nodes, the number of states the count may expand, 0 for no limit
+ * @param max_milliseconds, the time the count may take, 0 for no limit
+ * @return the status of the count
+ */
+static solver_status solveTransfer(solver_ctx ctx, uint64_t max_nodes,
+                                   uint32_t max_milliseconds) {
+  uint64_t start = get_milliseconds();
+  // The counter initializes the count again
+  sol_count_clear(&ctx->count);
+  solver_status status =
+      transfer_count(ctx->board, ctx->big_count, ctx->max_memory, max_nodes,
+                     max_milliseconds, &ctx->count, &ctx->stats);
+  ctx->stats.search_ms = get_milliseconds() - start;
+  if (status == SOLVER_DONE)
+    ctx->nb_solutions = sol_count_to_uint32(&ctx->count);
+  return status;
+}
+
+/**
+ * @brief Solves the board of a context with the propagation engine on several
+ * threads
+ *
+ * @param ctx, the solver context
+ * @param nb_threads, the number of threads
+ * @param max_nodes, the number of nodes the workers may explore, 0 for no limit
+ * @param max_milliseconds, the time the search may take, 0 for no limit
+ * @return the status of the search
+ */
+static solver_status solveParallel(solver_ctx ctx, uint16_t nb_threads,
+                                   uint64_t max_nodes,
+                                   uint32_t max_milliseconds) {
+  uint64_t start = get_milliseconds();
+  if (ctx->mode == SOLVER_NB_SOL) {
+    // Each thread counts its subproblems with the cache of its own engine
+    solver_status status = parallel_count(
+        ctx->board, nb_threads, ctx->big_count, ctx->max_memory, max_nodes,
+        max_milliseconds, &ctx->count, &ctx->stats);
+    ctx->stats.search_ms = get_milliseconds() - start;
+    ctx->nb_solutions = sol_count_to_uint32(&ctx->count);
+    return status;
+  }
+  uint64_t nb_solutions;
+  uint32_t max_solutions =
+      ctx->mode == SOLVER_FIND_ALL ? ctx->max_solutions : 0;
+  solver_status status = parallel_search(
+      ctx->board, nb_threads, ctx->mode, max_solutions, ctx->max_memory,
+      max_nodes, max_milliseconds, storeSolution, ctx, &nb_solutions,
+      &ctx->stats);
+  // The engines of the workers are prepared as part of the search
+  ctx->stats.search_ms = get_milliseconds() - start;
+  if (status == SOLVER_ERROR || status == SOLVER_UNFINISHED) return status;
+  ctx->out_of_memory = status == SOLVER_OUT_OF_MEMORY;
+  // The solutions reported are already counted by storeSolution
+  if (ctx->mode != SOLVER_NB_SOL) nb_solutions = ctx->nb_solutions;
+  if (!sol_count_add_uint(&ctx->count, nb_solutions)) return SOLVER_ERROR;
+  ctx->nb_solutions = sol_count_to_uint32(&ctx->count);
+  return SOLVER_DONE;
+}
+
+/**
+ * @brief Runs the solve of a context with the propagation engine of the
+ * context until it is over or a budget runs out
+ *
+ * @param ctx, the solver context, its prop engine is set
+ * @param max_nodes, the number of nodes the step may explore, 0 for no limit
+ * @param max_milliseconds, the time the step may take, 0 for no limit
+ * @return the status of the solve
+ */
+static solver_status stepProp(solver_ctx ctx, uint64_t max_nodes,
+                              uint32_t max_milliseconds) {
+  uint64_t start = get_milliseconds();
+  uint64_t nodes_left = max_nodes ? max_nodes : UINT64_MAX;
+  prop_status status;
+  do {
+    // The clock is only read between slices of nodes
+    uint64_t slice = nodes_left;
+    if (max_milliseconds && slice > STEP_SLICE_NODES) slice = STEP_SLICE_NODES;
+    nodes_left -= slice;
+    if (ctx->mode == SOLVER_NB_SOL) {
+      status = prop_count_step(ctx->prop, ctx->big_count, &ctx->count, slice);
+      ctx->nb_solutions = sol_count_to_uint32(&ctx->count);
+    } else {
+      status = prop_search_step(ctx->prop, storeSolution, ctx, slice);
+    }
+  } while (status == PROP_PAUSED && nodes_left > 0 &&
+           (!max_milliseconds ||
+            get_milliseconds() - start < max_milliseconds));
+  prop_get_stats(ctx->prop, &ctx->stats);
+  ctx->stats.search_ms += get_milliseconds() - start;
+  if (status == PROP_PAUSED) return SOLVER_UNFINISHED;
+
+  prop_destroy(ctx->prop);
+  ctx->prop = NULL;
+  if (status == PROP_ERROR) return SOLVER_ERROR;
+  if (ctx->mode != SOLVER_NB_SOL &&
+      !sol_count_add_uint(&ctx->count, ctx->nb_solutions))
+    return SOLVER_ERROR;
+  return SOLVER_DONE;
+}
+
+/**
+ * @brief Runs a whole solve for the file functions, with the cache of the
+ * options, giving up after their time limit
+ *
+ * @param ctx, the solver context
+ * @param options, the settings of the solve
+ * @return the status of the solve, SOLVER_UNFINISHED if it ran out of time
+ */
+static solver_status solveWithin(solver_ctx ctx,
+                                 const solver_options *options) {
+  solve_cache cache = openCache(options);
+  solver_set_cache(ctx, cache);
+  solver_status status = solver_step(ctx, 0, options->time_limit);
+  solver_set_cache(ctx, NULL);
+  if (cache) cache_close(cache);
+  if (status == SOLVER_UNFINISHED) {
+    FPRINTF(stderr, "Error: the solve didn't finish within %u ms.\n",
+            options->time_limit);
+  } else if (status == SOLVER_OUT_OF_MEMORY) {
+    FPRINTF(stderr,
+            "Error: the solve needed more than %llu bytes, only %u solutions "
+            "were kept.\n",
+            (unsigned long long)options->max_memory,
+            solver_nb_solutions(ctx));
+  }
+  return status;
+}
+
+/**
+ * @brief Writes the JSON report of a solve run by a file function, if the
+ * options ask for one
+ *
+ * @param ctx, the solver context, after the solve
+ * @param options, the settings of the solve
+ * @param prefix, the prefix of the solution files, the report is written in
+ * <prefix>.json
+ * @param status, how the solve ended
+ * @param load_ms, the time spent loading the board
+ * @param write_ms, the time spent writing the results after the search
+ * @return false if the report couldn't be written, true otherwise
+ */
+static bool writeReport(solver_ctx ctx, const solver_options *options,
+                        const char *prefix, solver_status status,
+                        uint64_t load_ms, uint64_t write_ms) {
+  if (options->report == SOLVER_REPORT_NONE) return true;
+  FILE *stream = stderr;
+  if (options->report == SOLVER_REPORT_FILE) {
+    char report_fname[FILENAME_MAX_SIZE * 2];
+    STRCPY(report_fname, prefix, FILENAME_MAX_SIZE);
+    STRCAT(report_fname, ".json", FILENAME_MAX_SIZE);
+    FOPEN(stream, report_fname, "w");
+    if (!stream) {
+      FPRINTF(stderr, "Error: writeReport, couldn't create the report file.\n");
+      return false;
+    }
+  }
+
+  const char *const mode_names[] = {"FIND_ALL", "FIND_ONE", "NB_SOL"};
+  const char *const engine_names[] = {"smart", "prop", "cdcl",
+                                      "transfer"};
+  const char *const status_names[] = {"done", "unfinished", "error",
+                                      "out_of_memory"};
+  const solver_stats *stats = &ctx->stats;
+  FPRINTF(stream, "{\n  \"mode\": \"%s\",\n  \"engine\": \"%s\",\n",
+          mode_names[ctx->mode], engine_names[ctx->used_engine]);
+  FPRINTF(stream, "  \"threads\": %u,\n", ctx->used_threads);
+  FPRINTF(stream,
+          "  \"board\": {\"width\": %u, \"height\": %u, \"wrapping\": %s},\n",
+          game_width(ctx->board), game_height(ctx->board),
+          is_wrapping(ctx->board) ? "true" : "false");
+  FPRINTF(stream, "  \"status\": \"%s\",\n  \"solutions\": ",
+          status_names[status]);
+  // A finished count is exact, otherwise the solutions found so far are given
+  const sol_count *count = &ctx->count;
+  if (status != SOLVER_DONE)
+    FPRINTF(stream, "%u", solver_nb_solutions(ctx));
+  else if (!count->big && count->overflow)
+    FPRINTF(stream, "null");
+  else
+    sol_count_fprint(stream, count);
+  FPRINTF(stream, ",\n  \"nodes\": %llu,\n  \"propagations\": %llu,\n",
+          (unsigned long long)stats->nb_nodes,
+          (unsigned long long)stats->nb_propagations);
+  FPRINTF(stream, "  \"backtracks\": %llu,\n  \"fixed_cells\": %llu,\n",
+          (unsigned long long)stats->nb_backtracks,
+          (unsigned long long)stats->nb_fixed_cells);
+  FPRINTF(stream, "  \"peak_tree_bytes\": %llu,\n",
+          (unsigned long long)stats->peak_tree_bytes);
+  FPRINTF(stream,
+          "  \"time_ms\": {\"load\": %llu, \"setup\": %llu, \"search\": %llu, "
+          "\"write\": %llu, \"total\": %llu}\n}\n",
+          (unsigned long long)load_ms, (unsigned long long)stats->setup_ms,
+          (unsigned long long)stats->search_ms, (unsigned long long)write_ms,
+          (unsigned long long)(load_ms + stats->setup_ms + stats->search_ms +
+                               write_ms));
+  if (stream != stderr) FCLOSE(stream);
+  return true;
+}
+
+/**
+ * @brief Solution callback of the propagation engine, counts the solution and
+ * keeps it if the mode of the context needs it
+ *
+ * @param orientations, the direction of every cell of the solution
+ * @param data, the solver context
+ * @return false when the search can stop, true otherwise
+ */
+static bool storeSolution(const direction *orientations, void *data) {
+  solver_ctx ctx = (solver_ctx)data;
+  ctx->nb_solutions++;
+  if (ctx->mode == SOLVER_NB_SOL) return true;
+  bool more = ctx->mode != SOLVER_FIND_ONE &&
+              ctx->nb_solutions != ctx->max_solutions;
+  if (ctx->on_solution) {
+    applyOrientations(ctx->streamed, orientations);
+    if (!ctx->on_solution(ctx->streamed, ctx->nb_solutions - 1,
+                          ctx->solution_data))
+      ctx->stopped = true;
+    return !ctx->stopped && more;
+  }
+
+  size_t nb_cells = (size_t)game_width(ctx->board) * game_height(ctx->board);
+  if (ctx->nb_stored == ctx->capacity) {
+    uint32_t new_capacity = ctx->capacity ? 2 * ctx->capacity : 1;
+    uint64_t solution_bytes = nb_cells * sizeof(direction);
+    if (ctx->max_memory && new_capacity * solution_bytes > ctx->max_memory)
+      new_capacity = (uint32_t)(ctx->max_memory / solution_bytes);
+    direction *new_solutions =
+        new_capacity > ctx->capacity
+            ? (direction *)realloc(ctx->solutions,
+                                   new_capacity * nb_cells * sizeof(direction))
+            : NULL;
+    if (!new_solutions) {
+      // The search ends there, with the solutions kept so far
+      FPRINTF(stderr, "Error: storeSolution, can't keep more solutions.\n");
+      ctx->nb_solutions--;
+      ctx->out_of_memory = true;
+      return false;
+    }
+    ctx->solutions = new_solutions;
+    ctx->capacity = new_capacity;
+  }
+  memcpy(ctx->solutions + ctx->nb_stored * nb_cells, orientations,
+         nb_cells * sizeof(direction));
+  ctx->nb_stored++;
+  return more;
+}
+
+/**
+ * @brief Sets the direction of every cell of a board
+ *
+ * @param board, the board, it has the size of the solved one
+ * @param orientations, the direction of every cell, indexed by x + y * width
+ */
+static void applyOrientations(game board, const direction *orientations) {
+  set_current_directions(board, orientations);
+}
+
+/**
+ * @brief Finds a piece whose direction is forced by the domains of a deduction
+ * but isn't its current one
+ *
+ * @param board, the board the deduction was made on
+ * @param domains, the domains after the deduction, indexed by x + y * width
+ * @param move, where the move is written
+ * @return true if a move was found, false otherwise
+ */
+static bool findDeducedMove(cgame board, const uint8_t *domains,
+                            solver_move *move) {
+  uint16_t width = game_width(board);
+  uint16_t height = game_height(board);
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      uint8_t domain = domains[x + (uint32_t)y * width];
+      if (domain & (domain - 1)) continue;  // Not forced yet
+      direction forced = N;
+      while (!(domain & (1 << forced))) forced++;
+      if (!sameEdges(get_piece(board, x, y),
+                     get_current_direction(board, x, y), forced)) {
+        move->x = x;
+        move->y = y;
+        move->dir = forced;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Gets the orientations each piece of a board keeps when it is locked:
+ *the ones giving the connections it has now
+ *
+ * @param board, the board
+ * @param locked, whether each piece is locked, NULL to get the orientations of
+ *every piece
+ * @param locks, where the orientations are written as domains, 0xF for the
+ *pieces that aren't locked
+ * @return false in case of error, true otherwise
+ */
+static bool getLocks(cgame board, const bool *locked, uint8_t *locks) {
+  uint32_t nb_cells = (uint32_t)game_width(board) * game_height(board);
+  piece *pieces = (piece *)malloc(nb_cells * sizeof(piece));
+  direction *dirs = (direction *)malloc(nb_cells * sizeof(direction));
+  if (!pieces || !dirs) {
+    free(pieces);
+    free(dirs);
+    return false;
+  }
+  get_cells(board, pieces, dirs);
+  for (uint32_t cell = 0; cell < nb_cells; cell++) {
+    if ((locked && !locked[cell]) || pieces[cell] == CROSS ||
+        pieces[cell] == EMPTY)
+      locks[cell] = 0xF;
+    else if (pieces[cell] == SEGMENT)
+      locks[cell] = (uint8_t)(1 << (dirs[cell] % 2));
+    else
+      locks[cell] = (uint8_t)(1 << dirs[cell]);
+  }
+  free(pieces);
+  free(dirs);
+  return true;
+}
+
+/**
+ * @brief Narrows the domains of an engine to the orientations of the locked
+ *pieces, before its next search
+ *
+ * @param engine, the propagation engine, not searching
+ * @param locks, the orientations each piece keeps, see getLocks
+ * @param domains, a buffer holding one domain per cell
+ * @param nb_cells, the number of cells of the board
+ */
+static void narrowDomains(prop_engine engine, const uint8_t *locks,
+                          uint8_t *domains, uint32_t nb_cells) {
+  prop_get_domains(engine, domains);
+  for (uint32_t cell = 0; cell < nb_cells; cell++) domains[cell] &= locks[cell];
+  prop_load(engine, domains, NULL, 0);
+}
+
+/**
+ * @brief Searches a solution of a board keeping some pieces in their
+ *orientations
+ *
+ * @param check, the check of the board
+ * @param locked, whether each piece is locked
+ * @return whether a solution keeps the locked pieces. The first fixed point
+ *is always reached, so that a lock contradicting the propagation is seen even
+ *once the time is over
+ */
+static solver_locks searchLocked(const struct lock_check_s *check,
+                                 const bool *locked) {
+  for (uint32_t cell = 0; cell < check->nb_cells; cell++)
+    check->loaded[cell] = locked[cell]
+                              ? check->domains[cell] & check->locks[cell]
+                              : check->domains[cell];
+  prop_load(check->engine, check->loaded, NULL, 0);
+  prop_status status = prop_search_step(check->engine, stopSearch, NULL, 1);
+  while (status == PROP_PAUSED &&
+         (!check->deadline || get_milliseconds() < check->deadline))
+    status =
+        prop_search_step(check->engine, stopSearch, NULL, STEP_SLICE_NODES);
+  switch (status) {
+    case PROP_STOPPED:
+      return SOLVER_LOCKS_SOLVABLE;
+    case PROP_FINISHED:
+      return SOLVER_LOCKS_CONFLICT;
+    case PROP_PAUSED:
+      return SOLVER_LOCKS_UNKNOWN;
+    default:
+      return SOLVER_LOCKS_ERROR;
+  }
+}
+
+/**
+ * @brief Unlocks the pieces of a conflict that the others don't need to
+ *conflict. A group of pieces is unlocked at once if the conflict stays,
+ *otherwise its halves are tried one after the other, so that a small conflict
+ *among many locks is found in a few searches
+ *
+ * @param check, the check of the board
+ * @param core, whether each piece is locked, the locks conflict
+ * @param cells, the locked pieces to try
+ * @param nb_cells, the number of pieces to try
+ */
+static void shrinkConflict(const struct lock_check_s *check, bool *core,
+                           const uint32_t *cells, uint32_t nb_cells) {
+  for (uint32_t i = 0; i < nb_cells; i++) core[cells[i]] = false;
+  if (searchLocked(check, core) == SOLVER_LOCKS_CONFLICT) return;
+  for (uint32_t i = 0; i < nb_cells; i++) core[cells[i]] = true;
+  if (nb_cells == 1) return;
+  uint32_t half = nb_cells / 2;
+  shrinkConflict(check, core, cells, half);
+  shrinkConflict(check, core, cells + half, nb_cells - half);
+}
+
+/**
+ * @brief Stops a search at its first solution
+ *
+ * @param orientations, the solution, unused
+ * @param data, unused
+ * @return false
+ */
+static bool stopSearch(const direction *orientations, void *data) {
+  (void)orientations;
+  (void)data;
+  return false;
+}
+
+/**
+ * @brief Finds a piece whose connections differ from the ones of a solution
+ *
+ * @param board, the board to give a move for
+ * @param solution, a solution of the board
+ * @param move, where the move is written
+ * @return true if a move was found, false if the board is the solution
+ */
+static bool findSolutionMove(cgame board, cgame solution, solver_move *move) {
+  uint16_t width = game_width(board);
+  uint16_t height = game_height(board);
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      direction target = get_current_direction(solution, x, y);
+      if (!sameEdges(get_piece(board, x, y),
+                     get_current_direction(board, x, y), target)) {
+        move->x = x;
+        move->y = y;
+        move->dir = target;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Checks that orientations solve a board: every connection is matched
+ * by the neighbouring piece and the connections link all the cells without any
+ * loop, like is_game_over but without touching the board
+ *
+ * @param board, the board
+ * @param orientations, the direction of every cell, indexed by x + y * width
+ * @return true if the orientations are a solution, false otherwise or in case
+ * of error
+ */
+static bool isSolution(cgame board, const direction *orientations) {
+  const int32_t delta_x[NB_DIR] = {0, 1, 0, -1};
+  const int32_t delta_y[NB_DIR] = {1, 0, -1, 0};
+  int32_t width = game_width(board);
+  int32_t height = game_height(board);
+  bool wrapping = is_wrapping(board);
+  size_t nb_cells = (size_t)width * (size_t)height;
+  piece *pieces = (piece *)malloc(nb_cells * sizeof(piece));
+  size_t *stack = (size_t *)malloc(nb_cells * sizeof(size_t));
+  bool *reached = (bool *)calloc(nb_cells, sizeof(bool));
+  bool solved = pieces && stack && reached;
+  if (!solved)
+    FPRINTF(stderr, "Error: isSolution, can't allocate the check.\n");
+  else
+    get_cells(board, pieces, NULL);
+
+  // A depth-first walk from the origin counts the connections it crosses, the
+  // cells form a tree if they are all reached through nb_cells - 1 of them
+  size_t nb_reached = 0;
+  size_t nb_edges = 0;
+  size_t top = 0;
+  if (solved) {
+    stack[top++] = 0;
+    reached[0] = true;
+    nb_reached = 1;
+  }
+  while (solved && top > 0) {
+    size_t cell = stack[--top];
+    int32_t x = (int32_t)(cell % (size_t)width);
+    int32_t y = (int32_t)(cell / (size_t)width);
+    for (direction dir = N; solved && dir < NB_DIR; dir++) {
+      if (!is_edge(pieces[cell], orientations[cell], dir)) continue;
+      int32_t next_x = x + delta_x[dir];
+      int32_t next_y = y + delta_y[dir];
+      if (wrapping) {
+        next_x = (next_x + width) % width;
+        next_y = (next_y + height) % height;
+      }
+      if (next_x < 0 || width <= next_x || next_y < 0 || height <= next_y) {
+        solved = false;
+        break;
+      }
+      size_t next = (size_t)next_x + (size_t)next_y * (size_t)width;
+      solved = is_edge(pieces[next], orientations[next],
+                       opposite_direction(dir));
+      nb_edges++;
+      if (solved && !reached[next]) {
+        reached[next] = true;
+        nb_reached++;
+        stack[top++] = next;
+      }
+    }
+  }
+  // Every connection was crossed from both of its cells
+  solved = solved && nb_reached == nb_cells && nb_edges == 2 * (nb_cells - 1);
+  free(pieces);
+  free(stack);
+  free(reached);
+  return solved;
+}
+
+/**
+ * @brief Tells whether a piece has the same connections in two directions,
+ * like a segment facing north or south
+ *
+ * @param cell_piece, the piece
+ * @param first, the first direction
+ * @param second, the second direction
+ * @return true if the connections are the same, false otherwise
+ */
+static bool sameEdges(piece cell_piece, direction first, direction second) {
+  for (direction dir = N; dir < NB_DIR; dir++) {
+    if (is_edge(cell_piece, first, dir) != is_edge(cell_piece, second, dir))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Gives the solutions of the smart engine to the sink of a context, the
+ * tree has to be built first so nothing is given during the search
+ *
+ * @param ctx, the solver context, solved with the smart engine
+ */
+static void streamSmart(solver_ctx ctx) {
+  uint32_t nb_solutions = solver_nb_solutions(ctx);
+  for (uint32_t i = 0; i < nb_solutions; i++) {
+    smart_load_solution(ctx->smart, i, ctx->streamed);
+    if (!ctx->on_solution(ctx->streamed, i, ctx->solution_data)) {
+      ctx->stopped = true;
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Solution sink of find_all, writes a solution in its .solN file
+ *
+ * @param solution, the solved board
+ * @param index, the index of the solution, N is index + 1
+ * @param data, the prefix of the solution files
+ * @return true, the search goes on
+ */
+static bool saveSolution(cgame solution, uint32_t index, void *data) {
+  char sol_num[SOL_NUM_SIZE];
+  SPRINTF(sol_num, SOL_NUM_SIZE, "%u", index + 1);
+  char fNameCopy[FILENAME_MAX_SIZE * 2];
+  STRCPY(fNameCopy, (char *)data, FILENAME_MAX_SIZE);
+  STRCAT(fNameCopy, ".sol", FILENAME_MAX_SIZE);
+  STRCAT(fNameCopy, sol_num, FILENAME_MAX_SIZE);
+  save_game(solution, fNameCopy);
+  return true;
+}
+
+/**
+ * @brief Solution sink of find_all with the packed option, adds a solution to
+ *the pack
+ *
+ * @param solution, the solved board
+ * @param index, the index of the solution, unused
+ * @param data, the pack
+ * @return false if the solution couldn't be written, which stops the search
+ */
+static bool packSolution(cgame solution, uint32_t index, void *data) {
+  (void)index;
+  return pack_add((pack_writer)data, solution);
+}
+
+/**
+ * @brief Prints the error in stderr if a game couldn't be loaded
+ * @return false
+ **/
+static bool gameLoadError() {
+  FPRINTF(stderr, "Error when loading the game from file!\n");
+  return false;
+}
+
+/**
+ * @brief Prints the error in stderr if a solution file couldn't be created and
+ *delete the loaded game
+ *
+ * @param g, the game loaded before the file was created
+ * @return false
+ **/
+static bool solFileError(game board) {
+  if (board != NULL) delete_game(board);
+  FPRINTF(stderr, "Error when attempting to create the solution file(s)!\n");
+  return false;
+}
@@ -4,6 +4,9 @@
 #include "game.h"
 #include "game_io.h"
 #include "game_rand.h"
+#include "solver.h"
+
+#define HINT_TIME 1000  // Milliseconds a hint may search for a solution
 
 // Prototypes:
 void usage();
@@ -75,27 +78,42 @@ int main(int argc, char* argv[]) {
 
     // Fetch the move
     bool rightValue = false;
+    bool hint = false;
     while (!rightValue) {  // Stays in this loop as long as the user doesn't
                            // enter a correct value
-      PRINTF("   Enter your move (<x> <y>) : ");
-      char c;
+      PRINTF("   Enter your move (<x> <y>) or h for a hint : ");
+      int c;
       uint16_t* adress[] = {&x, &y};
-      for (int i = 0; i < 2;
+      for (int i = 0; i < 2 && !hint;
            i++) {  // Security to make sure given coordinates are valid
 
-        while (!SCANF("%hu", adress[i])) {
-          do {
-            c = (char)getchar();
-          } while (c != ' ' && c != '\n');
+        int read;
+        while (!hint && (read = SCANF("%hu", adress[i])) != 1) {
+          if (read == EOF) {  // No more input, the player left
+            delete_game(mainGame);
+            return EXIT_SUCCESS;
+          }
+          c = getchar();
+          hint = i == 0 && c == 'h';  // Asks for a hint instead of a move
+          while (c != ' ' && c != '\n' && c != EOF) c = getchar();
         }
       }
 
-      if (x < game_width(mainGame) && y < game_height(mainGame))
+      if (hint || (x < game_width(mainGame) && y < game_height(mainGame)))
         rightValue = true;
     }
 
     // Apply the move
-    rotate_piece_one(mainGame, x, y);
+    if (hint) {
+      solver_move move;
+      if (find_hint(mainGame, NULL, HINT_TIME, &move)) {
+        PRINTF("\n   Hint: the piece (%hu %hu) faces %c\n", move.x, move.y,
+               "NESW"[move.dir]);
+        set_piece_current_direction(mainGame, move.x, move.y, move.dir);
+      } else
+        PRINTF("\n   No hint found\n");
+    } else
+      rotate_piece_one(mainGame, x, y);
 
     PRINTF("\n________________________________\n\n");
     turn++;
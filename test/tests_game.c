@@ -486,6 +486,62 @@ static int test_get_piece_out_of_bounds() {
   return EXIT_SUCCESS;
 }
 
+/**
+ * @brief Reads every square of a wrapping rectangular game in a single pass and
+ * compares them with the pieces and directions it was created with
+ */
+static int test_get_cells_valid() {
+  const piece pieces[] = {LEAF,   SEGMENT, CORNER, TEE,   CROSS, EMPTY,
+                          CORNER, TEE,     LEAF,   CROSS, LEAF,  SEGMENT};
+  const direction dirs[] = {N, E, S, W, N, E, S, W, W, S, E, N};
+  piece read_pieces[12];
+  direction read_dirs[12];
+
+  game board = new_game_ext(4, 3, pieces, dirs, true);
+  get_cells(board, read_pieces, NULL);
+  get_cells(board, NULL, read_dirs);
+  for (uint8_t i = 0; i < 12; i++) {
+    if (read_pieces[i] != pieces[i] || read_dirs[i] != dirs[i]) {
+      FPRINTF(stderr,
+              "Error: test_get_cells_valid, square %hhu is (%d, %d) while "
+              "(%d, %d) was expected.\n",
+              i, read_pieces[i], read_dirs[i], pieces[i], dirs[i]);
+      delete_game(board);
+      return EXIT_FAILURE;
+    }
+  }
+  delete_game(board);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Sets every direction of a rectangular game in a single pass and checks
+ * them square by square
+ */
+static int test_set_current_directions_valid() {
+  const piece pieces[] = {LEAF,   SEGMENT, CORNER, TEE,   CROSS, EMPTY,
+                          CORNER, TEE,     LEAF,   CROSS, LEAF,  SEGMENT};
+  const direction dirs[] = {N, E, S, W, N, E, S, W, W, S, E, N};
+
+  game board = new_game_empty_ext(4, 3, false);
+  for (uint8_t i = 0; i < 12; i++)
+    set_piece(board, i % 4, i / 4, pieces[i], N);
+  set_current_directions(board, dirs);
+  for (uint8_t i = 0; i < 12; i++) {
+    if (get_current_direction(board, i % 4, i / 4) != dirs[i] ||
+        get_piece(board, i % 4, i / 4) != pieces[i]) {
+      FPRINTF(stderr,
+              "Error: test_set_current_directions_valid, square %hhu has the "
+              "direction %d while %d was expected.\n",
+              i, get_current_direction(board, i % 4, i / 4), dirs[i]);
+      delete_game(board);
+      return EXIT_FAILURE;
+    }
+  }
+  delete_game(board);
+  return EXIT_SUCCESS;
+}
+
 /**
  * @brief Tests all valid parameters of is_edge for an EMPTY piece
  */
@@ -1588,6 +1644,10 @@ int main(int argc, char* argv[]) {
     status = test_get_piece_null_game();
   else if (strcmp("get_piece_out_of_bounds", argv[1]) == 0)
     status = test_get_piece_out_of_bounds();
+  else if (strcmp("get_cells_valid", argv[1]) == 0)
+    status = test_get_cells_valid();
+  else if (strcmp("set_current_directions_valid", argv[1]) == 0)
+    status = test_set_current_directions_valid();
   else if (strcmp("is_edge_EMPTY", argv[1]) == 0)
     status = test_is_edge_EMPTY();
   else if (strcmp("is_edge_LEAF", argv[1]) == 0)
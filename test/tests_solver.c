@@ -0,0 +1,1646 @@
+#include "cross_thread.h"
+#include "game.h"
+#include "game_io.h"
+#include "solve_batch.h"
+#include "solve_pack.h"
+#include "solve_smart.h"
+#include "solve_transfer.h"
+#include "solver.h"
+
+static const piece default_pieces[] = {
+    LEAF,    TEE,  LEAF, LEAF, LEAF, LEAF, TEE, TEE,    CORNER,
+    SEGMENT, LEAF, LEAF, TEE,  LEAF, SEGMENT, TEE, TEE, TEE,
+    TEE,     TEE,  CORNER, LEAF, LEAF, CORNER, LEAF};
+static const direction default_directions[] = {E, W, S, E, S, S, S, N, W,
+                                               S, E, N, W, W, E, S, W, N,
+                                               E, E, W, N, W, N, S};
+
+/**
+ * @brief Creates the default 5x5 game of net_text
+ *
+ * @param wrapping, whether the created board wraps around its edges
+ * @return the created game
+ */
+static game create_default_game(bool wrapping) {
+  return new_game_ext(DEFAULT_SIZE, DEFAULT_SIZE, default_pieces,
+                      default_directions, wrapping);
+}
+
+/**
+ * @brief Solves a board with a new context and checks the number of solutions
+ * and that every solution ends the game.
+ *
+ * @param board, the board to solve
+ * @param expected_nb_solutions, the number of solutions the board has
+ * @param engine, the engine to solve with
+ * @return true if the solver behaved as expected
+ */
+static bool check_solutions(cgame board, uint32_t expected_nb_solutions,
+                            solver_engine engine) {
+  solver_ctx ctx = solver_create(board);
+  if (!ctx) {
+    FPRINTF(stderr, "Error: check_solutions, context creation failed.\n");
+    return false;
+  }
+  solver_set_engine(ctx, engine);
+
+  bool found = solver_solve(ctx);
+  uint32_t nb_solutions = solver_nb_solutions(ctx);
+  if (found != (expected_nb_solutions != 0) ||
+      nb_solutions != expected_nb_solutions) {
+    FPRINTF(stderr,
+            "Error: check_solutions, found %u solutions while %u were "
+            "expected.\n",
+            nb_solutions, expected_nb_solutions);
+    solver_destroy(ctx);
+    return false;
+  }
+
+  game solved_board = copy_game(board);
+  for (uint32_t i = 0; i < nb_solutions; i++) {
+    if (!solver_load_solution(ctx, i, solved_board) ||
+        !is_game_over(solved_board)) {
+      FPRINTF(stderr,
+              "Error: check_solutions, solution %u doesn't end the game.\n", i);
+      delete_game(solved_board);
+      solver_destroy(ctx);
+      return false;
+    }
+  }
+  delete_game(solved_board);
+  solver_destroy(ctx);
+  return true;
+}
+
+/**
+ * @brief Creates a board whose fixed pieces split the movable ones into
+ * independent regions, it has 2 solutions
+ *
+ * @return the created game
+ */
+static game create_regions_game() {
+  const piece pieces[7][14] = {
+      {LEAF, CORNER, LEAF, LEAF, LEAF, LEAF, LEAF, LEAF, TEE, SEGMENT, SEGMENT,
+       TEE, TEE, LEAF},
+      {CORNER, TEE, LEAF, TEE, TEE, TEE, TEE, CORNER, TEE, CORNER, LEAF, LEAF,
+       CORNER, CORNER},
+      {LEAF, TEE, TEE, TEE, CORNER, CORNER, CORNER, CORNER, SEGMENT, TEE, LEAF,
+       CORNER, CORNER, LEAF},
+      {LEAF, LEAF, SEGMENT, CORNER, LEAF, TEE, SEGMENT, TEE, TEE, TEE, CORNER,
+       TEE, CORNER, LEAF},
+      {TEE, LEAF, CORNER, SEGMENT, CORNER, LEAF, CORNER, TEE, LEAF, TEE, CORNER,
+       CORNER, SEGMENT, LEAF},
+      {CORNER, CORNER, LEAF, LEAF, SEGMENT, CORNER, TEE, LEAF, SEGMENT, TEE,
+       TEE, TEE, TEE, CORNER},
+      {LEAF, TEE, SEGMENT, TEE, TEE, CORNER, CORNER, SEGMENT, SEGMENT, LEAF,
+       LEAF, LEAF, LEAF, LEAF},
+  };
+  game board = new_game_empty_ext(14, 7, false);
+  for (uint16_t y = 0; y < 7; y++) {
+    for (uint16_t x = 0; x < 14; x++) set_piece(board, x, y, pieces[y][x], N);
+  }
+  return board;
+}
+
+/**
+ * @brief Creates a wrapping square board made of corners around two leaves,
+ * it has 32 solutions with 4 cells a side and 608 with 8
+ *
+ * @param size, the number of cells of a side, at least 2
+ * @return the created game
+ */
+static game create_corners_game(uint16_t size) {
+  game board = new_game_empty_ext(size, size, true);
+  for (uint16_t y = 0; y < size; y++) {
+    for (uint16_t x = 0; x < size; x++) set_piece(board, x, y, CORNER, N);
+  }
+  set_piece(board, size / 2 - 1, size / 2, LEAF, N);
+  set_piece(board, size / 2, size / 2, LEAF, N);
+  return board;
+}
+
+static int test_solver_create_null_game() {
+  if (solver_create(NULL) != NULL) {
+    FPRINTF(stderr,
+            "Error: test_solver_create_null_game, a context was created for a "
+            "NULL game. (Expected NULL)\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+static int test_solver_solve_valid() {
+  game board = create_default_game(false);
+  bool status = check_solutions(board, 1, SOLVER_ENGINE_SMART);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_solve_wrapped() {
+  game board = create_default_game(true);
+  bool status = check_solutions(board, 2, SOLVER_ENGINE_SMART);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_solve_no_solution() {
+  game board = new_game_empty_ext(MIN_GAME_WIDTH, MIN_GAME_HEIGHT, false);
+  for (uint16_t x = 0; x < MIN_GAME_WIDTH; x++) {
+    for (uint16_t y = 0; y < MIN_GAME_HEIGHT; y++) {
+      set_piece(board, x, y, LEAF, N);
+    }
+  }
+  bool status = check_solutions(board, 0, SOLVER_ENGINE_SMART);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_forced_loop() {
+  // Every piece is forced, and the middle row closes a loop around the board
+  const piece pieces[3][3] = {{CORNER, LEAF, TEE},
+                              {CROSS, SEGMENT, TEE},
+                              {TEE, TEE, TEE}};
+  game board = new_game_empty_ext(3, 3, true);
+  for (uint16_t y = 0; y < 3; y++) {
+    for (uint16_t x = 0; x < 3; x++) set_piece(board, x, y, pieces[y][x], N);
+  }
+  bool status = check_solutions(board, 0, SOLVER_ENGINE_SMART) &&
+                check_solutions(board, 0, SOLVER_ENGINE_PROP) &&
+                check_solutions(board, 0, SOLVER_ENGINE_CDCL);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_smart_snake() {
+  // A single path winds through every row, so the search and the check of the
+  // solution go as deep as the board is large
+  const uint16_t size = 100;
+  game board = new_game_empty_ext(size, size, false);
+  for (uint16_t y = 0; y < size; y++) {
+    bool east = y % 2 == 0;  // whether the path runs east along the row
+    for (uint16_t x = 0; x < size; x++) {
+      bool first = east ? x == 0 : x == size - 1;
+      bool last = east ? x == size - 1 : x == 0;
+      piece cell_piece = SEGMENT;
+      direction dir = E;
+      if ((first && y == 0) || (last && y == size - 1)) {
+        cell_piece = LEAF;
+        dir = first ? (east ? E : W) : (east ? W : E);
+      } else if (first) {
+        cell_piece = CORNER;  // Comes from the south
+        dir = east ? E : S;
+      } else if (last) {
+        cell_piece = CORNER;  // Goes to the north
+        dir = east ? W : N;
+      }
+      set_piece(board, x, y, cell_piece, (dir + 1) % NB_DIR);
+    }
+  }
+  bool status = check_solutions(board, 1, SOLVER_ENGINE_SMART);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_smart_regions() {
+  // The fixed pieces split the movable ones into independent regions, which
+  // the smart engine solves apart and combines
+  game board = create_regions_game();
+  bool status = check_solutions(board, 2, SOLVER_ENGINE_SMART) &&
+                check_solutions(board, 2, SOLVER_ENGINE_PROP);
+
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_SMART);
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  if (status && (!solver_solve(ctx) || solver_get_count(ctx)->value != 2)) {
+    FPRINTF(stderr,
+            "Error: test_solver_smart_regions, the smart engine didn't count "
+            "2 solutions.\n");
+    status = false;
+  }
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_smart_rules() {
+  // The edges alone only fix a few pieces of this wrapping board, all the
+  // rules solve it without branching
+  const piece pieces[6][6] = {{LEAF, CORNER, LEAF, LEAF, CORNER, LEAF},
+                              {CORNER, SEGMENT, CORNER, SEGMENT, TEE, TEE},
+                              {LEAF, CORNER, SEGMENT, CORNER, CORNER, CORNER},
+                              {CORNER, LEAF, LEAF, TEE, TEE, TEE},
+                              {CORNER, CORNER, CORNER, CROSS, CORNER, SEGMENT},
+                              {LEAF, SEGMENT, SEGMENT, TEE, LEAF, LEAF}};
+  const uint32_t rules[] = {0, SMART_RULE_EDGES,
+                            SMART_RULE_EDGES | SMART_RULE_LOOPS,
+                            SMART_RULES_ALL};
+  game board = new_game_empty_ext(6, 6, true);
+  for (uint16_t y = 0; y < 6; y++) {
+    for (uint16_t x = 0; x < 6; x++) set_piece(board, x, y, pieces[y][x], N);
+  }
+  game solved_board = copy_game(board);
+
+  bool status = true;
+  for (uint32_t i = 0; status && i < sizeof(rules) / sizeof(rules[0]); i++) {
+    solver_ctx ctx = solver_create(board);
+    solver_set_engine(ctx, SOLVER_ENGINE_SMART);
+    solver_set_rules(ctx, rules[i]);
+    status = solver_solve(ctx) && solver_nb_solutions(ctx) == 1 &&
+             solver_load_solution(ctx, 0, solved_board) &&
+             is_game_over(solved_board);
+    if (!status) {
+      FPRINTF(stderr,
+              "Error: test_solver_smart_rules, rules %u didn't find the "
+              "solution.\n",
+              rules[i]);
+    }
+    const solver_stats *stats = solver_get_stats(ctx);
+    if (status && rules[i] == SMART_RULES_ALL &&
+        (stats->nb_nodes != 0 || stats->nb_fixed_cells != 36)) {
+      FPRINTF(stderr,
+              "Error: test_solver_smart_rules, the rules left %llu nodes to "
+              "search.\n",
+              (unsigned long long)stats->nb_nodes);
+      status = false;
+    }
+    solver_destroy(ctx);
+  }
+  delete_game(solved_board);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_smart_order() {
+  // Every order finds the same solutions, with the rules off so that the
+  // search branches on the whole board
+  const smart_order orders[] = {SMART_ORDER_FIXED, SMART_ORDER_FEWEST,
+                                SMART_ORDER_CONSTRAINED, SMART_ORDER_DEGREE};
+  bool status = true;
+  for (uint8_t wrapping = 0; status && wrapping < 2; wrapping++) {
+    game board = create_default_game(wrapping);
+    game solved_board = copy_game(board);
+    uint32_t nb_solutions = 0;
+    for (uint32_t i = 0; status && i < sizeof(orders) / sizeof(orders[0]);
+         i++) {
+      solver_ctx ctx = solver_create(board);
+      solver_set_engine(ctx, SOLVER_ENGINE_SMART);
+      solver_set_rules(ctx, 0);
+      solver_set_order(ctx, orders[i]);
+      status = solver_solve(ctx);
+      if (i == 0) nb_solutions = solver_nb_solutions(ctx);
+      status = status && solver_nb_solutions(ctx) == nb_solutions;
+      for (uint32_t j = 0; status && j < nb_solutions; j++) {
+        status = solver_load_solution(ctx, j, solved_board) &&
+                 is_game_over(solved_board);
+      }
+      if (!status) {
+        FPRINTF(stderr,
+                "Error: test_solver_smart_order, order %d didn't find the %u "
+                "solutions.\n",
+                orders[i], nb_solutions);
+      }
+      solver_destroy(ctx);
+    }
+    delete_game(solved_board);
+    delete_game(board);
+  }
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_valid() {
+  game board = create_default_game(false);
+  bool status = check_solutions(board, 1, SOLVER_ENGINE_PROP);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_wrapped() {
+  game board = create_default_game(true);
+  bool status = check_solutions(board, 2, SOLVER_ENGINE_PROP);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_no_solution() {
+  game board = new_game_empty_ext(MIN_GAME_WIDTH, MIN_GAME_HEIGHT, true);
+  for (uint16_t x = 0; x < MIN_GAME_WIDTH; x++) {
+    for (uint16_t y = 0; y < MIN_GAME_HEIGHT; y++) {
+      set_piece(board, x, y, CROSS, N);
+    }
+  }
+  // A wrapping board of crosses is fully connected but full of loops
+  bool status = check_solutions(board, 0, SOLVER_ENGINE_PROP);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_cdcl_valid() {
+  game board = create_default_game(false);
+  game wrapped_board = create_default_game(true);
+  bool status = check_solutions(board, 1, SOLVER_ENGINE_CDCL) &&
+                check_solutions(wrapped_board, 2, SOLVER_ENGINE_CDCL);
+  delete_game(board);
+  delete_game(wrapped_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_cdcl_no_solution() {
+  game crosses = new_game_empty_ext(MIN_GAME_WIDTH, MIN_GAME_HEIGHT, true);
+  game leaves = new_game_empty_ext(MIN_GAME_WIDTH, MIN_GAME_HEIGHT, false);
+  for (uint16_t x = 0; x < MIN_GAME_WIDTH; x++) {
+    for (uint16_t y = 0; y < MIN_GAME_HEIGHT; y++) {
+      set_piece(crosses, x, y, CROSS, N);
+      set_piece(leaves, x, y, LEAF, N);
+    }
+  }
+  // The crosses only make loops, the leaves only make pairs
+  bool status = check_solutions(crosses, 0, SOLVER_ENGINE_CDCL) &&
+                check_solutions(leaves, 0, SOLVER_ENGINE_CDCL);
+  delete_game(crosses);
+  delete_game(leaves);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_find_one() {
+  game board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+
+  // The search must stop at the first of the two solutions
+  bool status = solver_solve(ctx) && solver_nb_solutions(ctx) == 1 &&
+                solver_load_solution(ctx, 0, board) && is_game_over(board);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_prop_find_one, the search didn't stop at a "
+            "single valid solution.\n");
+  }
+
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_threads() {
+  game board = create_default_game(true);
+  game threaded_board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+  solver_ctx threaded_ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_engine(threaded_ctx, SOLVER_ENGINE_PROP);
+  solver_set_threads(threaded_ctx, 4);
+
+  // The solutions must come in the order of the sequential search
+  bool status = solver_solve(ctx) && solver_solve(threaded_ctx) &&
+                solver_nb_solutions(threaded_ctx) == solver_nb_solutions(ctx);
+  for (uint32_t i = 0; status && i < solver_nb_solutions(ctx); i++) {
+    solver_load_solution(ctx, i, board);
+    solver_load_solution(threaded_ctx, i, threaded_board);
+    status = is_game_over(threaded_board);
+    for (uint16_t x = 0; status && x < DEFAULT_SIZE; x++) {
+      for (uint16_t y = 0; status && y < DEFAULT_SIZE; y++) {
+        status = get_current_direction(board, x, y) ==
+                 get_current_direction(threaded_board, x, y);
+      }
+    }
+  }
+  // Counts are split between the threads, which must find the same total
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  solver_set_mode(threaded_ctx, SOLVER_NB_SOL);
+  status = status && solver_solve(ctx) && solver_solve(threaded_ctx) &&
+           solver_nb_solutions(ctx) == 2 &&
+           solver_nb_solutions(threaded_ctx) == 2;
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_prop_threads, the threaded search didn't find "
+            "the solutions of the sequential one.\n");
+  }
+
+  solver_destroy(ctx);
+  solver_destroy(threaded_ctx);
+  delete_game(board);
+  delete_game(threaded_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_threads_limit() {
+  game board = create_corners_game(4);
+  game threaded_board = create_corners_game(4);
+  solver_ctx ctx = solver_create(board);
+  solver_ctx threaded_ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_engine(threaded_ctx, SOLVER_ENGINE_PROP);
+  solver_set_threads(threaded_ctx, 4);
+  solver_set_limit(threaded_ctx, 5);
+
+  // The workers only keep the first solutions of the sequential search
+  bool status = solver_solve(ctx) && solver_nb_solutions(ctx) == 32 &&
+                solver_solve(threaded_ctx) &&
+                solver_nb_solutions(threaded_ctx) == 5;
+  for (uint32_t i = 0; status && i < 5; i++) {
+    solver_load_solution(ctx, i, board);
+    solver_load_solution(threaded_ctx, i, threaded_board);
+    status = is_game_over(threaded_board);
+    for (uint16_t x = 0; status && x < 4; x++) {
+      for (uint16_t y = 0; status && y < 4; y++) {
+        status = get_current_direction(board, x, y) ==
+                 get_current_direction(threaded_board, x, y);
+      }
+    }
+  }
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_prop_threads_limit, the threaded search didn't "
+            "keep the first 5 solutions of the sequential one.\n");
+  }
+
+  solver_destroy(ctx);
+  solver_destroy(threaded_ctx);
+  delete_game(board);
+  delete_game(threaded_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_count_threads() {
+  game boards[] = {create_corners_game(4), create_corners_game(8),
+                   create_regions_game(), create_default_game(true)};
+  const uint32_t nb_solutions[] = {32, 608, 2, 2};
+  bool status = true;
+  for (uint8_t i = 0; i < 4; i++) {
+    // The threads split the board and sum up their counts
+    solver_ctx ctx = solver_create(boards[i]);
+    solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+    solver_set_mode(ctx, SOLVER_NB_SOL);
+    for (uint16_t nb_threads = 2; status && nb_threads <= 4; nb_threads++) {
+      solver_set_threads(ctx, nb_threads);
+      status = solver_solve(ctx) &&
+               solver_nb_solutions(ctx) == nb_solutions[i] &&
+               solver_get_stats(ctx)->nb_propagations > 0;
+    }
+    solver_set_big_count(ctx, true);
+    status = status && solver_solve(ctx) &&
+             solver_nb_solutions(ctx) == nb_solutions[i];
+    // A count cut short by its budget starts over, the small boards are
+    // counted without any decision
+    if (nb_solutions[i] > 2)
+      status = status && solver_step(ctx, 1, 0) == SOLVER_UNFINISHED &&
+               solver_step(ctx, 0, 0) == SOLVER_DONE &&
+               solver_nb_solutions(ctx) == nb_solutions[i];
+    if (!status)
+      FPRINTF(stderr,
+              "Error: test_solver_count_threads, wrong count on board %u.\n",
+              i);
+    solver_destroy(ctx);
+    delete_game(boards[i]);
+  }
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prop_count() {
+  game board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+
+  bool status = solver_solve(ctx) && solver_nb_solutions(ctx) == 2 &&
+                solver_get_count(ctx)->value == 2 &&
+                !solver_get_count(ctx)->overflow;
+  solver_set_big_count(ctx, true);
+  status = status && solver_solve(ctx) &&
+           sol_count_to_uint32(solver_get_count(ctx)) == 2;
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_prop_count, the wrapped board doesn't have 2 "
+            "solutions.\n");
+  }
+
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_transfer() {
+  // The board is wider than the counter accepts, so its columns are placed as
+  // rows
+  game board = create_regions_game();
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_TRANSFER);
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  bool status = transfer_suits(board) && solver_solve(ctx) &&
+                solver_nb_solutions(ctx) == 2 &&
+                solver_get_count(ctx)->value == 2 &&
+                solver_get_stats(ctx)->nb_propagations > 0;
+  solver_set_big_count(ctx, true);
+  status = status && solver_solve(ctx) &&
+           sol_count_to_uint32(solver_get_count(ctx)) == 2;
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_transfer, the regions board doesn't have 2 "
+            "solutions.\n");
+  }
+
+  // The prop engine takes over outside of counts, and when the states don't
+  // fit
+  solver_set_big_count(ctx, false);
+  solver_set_memory_limit(ctx, 1);
+  if (status && (!solver_solve(ctx) || solver_get_count(ctx)->value != 2)) {
+    FPRINTF(stderr,
+            "Error: test_solver_transfer, the count outgrowing the memory "
+            "wasn't handed over.\n");
+    status = false;
+  }
+  solver_destroy(ctx);
+  status = status && check_solutions(board, 2, SOLVER_ENGINE_TRANSFER);
+  delete_game(board);
+
+  // Only the boards that don't wrap are counted
+  board = create_default_game(false);
+  game wrapped_board = create_default_game(true);
+  sol_count count;
+  if (status && (!transfer_suits(board) || transfer_suits(wrapped_board) ||
+                 transfer_count(board, false, 0, 0, 0, &count, NULL) !=
+                     SOLVER_DONE ||
+                 count.value != 1)) {
+    FPRINTF(stderr,
+            "Error: test_solver_transfer, the default boards were "
+            "misjudged.\n");
+    status = false;
+  }
+  sol_count_clear(&count);
+  delete_game(wrapped_board);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_sol_count_big() {
+  sol_count count, small;
+  sol_count_init(&count, true);
+  sol_count_init(&small, false);
+  sol_count_add_uint(&count, UINT64_MAX);
+  sol_count_add_uint(&count, UINT64_MAX);
+  sol_count_add_uint(&small, UINT64_MAX);
+  sol_count_add_uint(&small, 1);
+
+  char digits[32] = "";
+  FILE *stream = tmpfile();
+  bool status = stream && sol_count_fprint(stream, &count);
+  if (status) {
+    rewind(stream);
+    status = fgets(digits, sizeof(digits), stream) != NULL &&
+             strcmp(digits, "36893488147419103230") == 0;
+  }
+  if (stream) FCLOSE(stream);
+  status = status && sol_count_to_uint32(&count) == UINT32_MAX &&
+           small.overflow;
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_sol_count_big, 2 * UINT64_MAX was printed as %s.\n",
+            digits);
+  }
+  sol_count_clear(&count);
+  sol_count_clear(&small);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Solution callback counting the solved boards it receives
+ *
+ * @param solution, the solved board
+ * @param index, the index of the solution
+ * @param data, the number of valid solutions received so far
+ * @return true, the search goes on
+ */
+static bool count_streamed(cgame solution, uint32_t index, void *data) {
+  uint32_t *nb_streamed = (uint32_t *)data;
+  if (index == *nb_streamed && is_game_over(solution)) (*nb_streamed)++;
+  return true;
+}
+
+static int test_solver_stream_limit() {
+  game board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  uint32_t nb_streamed = 0;
+  solver_set_solution_callback(ctx, count_streamed, &nb_streamed);
+
+  bool status = solver_solve(ctx) && nb_streamed == 2 &&
+                !solver_load_solution(ctx, 0, board);
+  nb_streamed = 0;
+  solver_set_limit(ctx, 1);
+  status = status && solver_solve(ctx) && nb_streamed == 1 &&
+           solver_nb_solutions(ctx) == 1;
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_stream_limit, %u solutions were streamed.\n",
+            nb_streamed);
+  }
+
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_in_memory() {
+  game board = create_default_game(true);
+  game solved_board = copy_game(board);
+  sol_count count;
+  uint64_t nb_solutions = 0;
+  uint32_t nb_streamed = 0;
+  bool status = solve_one(board, solved_board) && is_game_over(solved_board) &&
+                count_solutions(board, true, &count) &&
+                sol_count_to_uint64(&count, &nb_solutions) &&
+                nb_solutions == 2 &&
+                enumerate_solutions(board, count_streamed, &nb_streamed) &&
+                nb_streamed == 2;
+  sol_count_clear(&count);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_in_memory, the wrapping board wasn't "
+            "solved.\n");
+  }
+
+  // A board without solution leaves the game untouched
+  game no_solution = new_game_empty_ext(MIN_GAME_WIDTH, MIN_GAME_HEIGHT, false);
+  for (uint16_t x = 0; x < MIN_GAME_WIDTH; x++) {
+    for (uint16_t y = 0; y < MIN_GAME_HEIGHT; y++)
+      set_piece(no_solution, x, y, LEAF, N);
+  }
+  game untouched = copy_game(no_solution);
+  nb_streamed = 0;
+  if (status && (solve_one(no_solution, untouched) ||
+                 !count_solutions(no_solution, false, &count) ||
+                 count.value != 0 ||
+                 !enumerate_solutions(no_solution, count_streamed,
+                                      &nb_streamed) ||
+                 nb_streamed != 0 ||
+                 get_current_direction(untouched, 0, 0) != N)) {
+    FPRINTF(stderr,
+            "Error: test_solver_in_memory, a board without solution was "
+            "solved.\n");
+    status = false;
+  }
+  sol_count_clear(&count);
+
+  delete_game(untouched);
+  delete_game(no_solution);
+  delete_game(solved_board);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_memory_limit() {
+  // The wrapping default board has 2 solutions. With room for a single one,
+  // the smart engine hands over to prop, which keeps the first one and stops
+  game board = create_default_game(true);
+  game solved_board = copy_game(board);
+  uint64_t solution_bytes = DEFAULT_SIZE * DEFAULT_SIZE * sizeof(direction);
+
+  smart_engine smart = smart_create(board);
+  smart_set_memory_limit(smart, solution_bytes);
+  bool status = !smart_solve(smart) && smart_out_of_memory(smart) &&
+                smart_nb_solutions(smart) == 0;
+  smart_destroy(smart);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_memory_limit, the smart trees outgrew the "
+            "limit.\n");
+  }
+
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_SMART);
+  solver_set_memory_limit(ctx, solution_bytes);
+  if (status && (solver_step(ctx, 0, 0) != SOLVER_OUT_OF_MEMORY ||
+                 solver_nb_solutions(ctx) != 1 ||
+                 !solver_load_solution(ctx, 0, solved_board) ||
+                 !is_game_over(solved_board))) {
+    FPRINTF(stderr,
+            "Error: test_solver_memory_limit, the first solution wasn't "
+            "kept.\n");
+    status = false;
+  }
+  // Counting and streaming keep no solution
+  uint32_t nb_streamed = 0;
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  status = status && solver_step(ctx, 0, 0) == SOLVER_DONE &&
+           solver_get_count(ctx)->value == 2;
+  solver_set_mode(ctx, SOLVER_FIND_ALL);
+  solver_set_solution_callback(ctx, count_streamed, &nb_streamed);
+  status = status && solver_step(ctx, 0, 0) == SOLVER_DONE && nb_streamed == 2;
+  solver_set_solution_callback(ctx, NULL, NULL);
+  solver_set_memory_limit(ctx, 0);
+  status = status && solver_step(ctx, 0, 0) == SOLVER_DONE &&
+           solver_nb_solutions(ctx) == 2;
+  if (!status)
+    FPRINTF(stderr, "Error: test_solver_memory_limit, a solve failed.\n");
+
+  solver_destroy(ctx);
+  delete_game(solved_board);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_memory_limit_threads() {
+  // The workers keep the first solutions of the sequential search that fit
+  game board = create_corners_game(4);
+  game threaded_board = create_corners_game(4);
+  solver_ctx ctx = solver_create(board);
+  solver_ctx threaded_ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_engine(threaded_ctx, SOLVER_ENGINE_PROP);
+  solver_set_threads(threaded_ctx, 4);
+  solver_set_memory_limit(threaded_ctx, 4 * 16 * sizeof(direction));
+
+  bool status = solver_step(ctx, 0, 0) == SOLVER_DONE &&
+                solver_step(threaded_ctx, 0, 0) == SOLVER_OUT_OF_MEMORY &&
+                solver_nb_solutions(threaded_ctx) > 0 &&
+                solver_nb_solutions(threaded_ctx) < solver_nb_solutions(ctx);
+  for (uint32_t i = 0; status && i < solver_nb_solutions(threaded_ctx); i++) {
+    solver_load_solution(ctx, i, board);
+    solver_load_solution(threaded_ctx, i, threaded_board);
+    status = is_game_over(threaded_board);
+    for (uint16_t x = 0; status && x < 4; x++) {
+      for (uint16_t y = 0; status && y < 4; y++) {
+        status = get_current_direction(board, x, y) ==
+                 get_current_direction(threaded_board, x, y);
+      }
+    }
+  }
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_memory_limit_threads, the threaded search "
+            "didn't keep the first solutions that fit.\n");
+  }
+
+  solver_destroy(ctx);
+  solver_destroy(threaded_ctx);
+  delete_game(board);
+  delete_game(threaded_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_prescreen() {
+  game board = create_default_game(false);
+  game wrapped_board = create_default_game(true);
+  bool status = may_have_solution(board) && may_have_solution(wrapped_board);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_prescreen, a default board was rejected.\n");
+  }
+
+  // One more connection than a tree has
+  set_piece(board, 0, 0, CORNER, N);
+  game empty_board = new_game_empty_ext(MIN_GAME_WIDTH, MIN_GAME_HEIGHT, false);
+  if (status && (may_have_solution(board) || may_have_solution(empty_board) ||
+                 may_have_solution(NULL))) {
+    FPRINTF(stderr,
+            "Error: test_solver_prescreen, a board with the wrong number of "
+            "connections was accepted.\n");
+    status = false;
+  }
+  delete_game(empty_board);
+  delete_game(wrapped_board);
+  delete_game(board);
+
+  // The connections add up, but the cross points off the board unless it
+  // wraps
+  const piece pieces[3][3] = {{LEAF, SEGMENT, LEAF},
+                              {CROSS, SEGMENT, SEGMENT},
+                              {LEAF, SEGMENT, LEAF}};
+  board = new_game_empty_ext(3, 3, false);
+  wrapped_board = new_game_empty_ext(3, 3, true);
+  for (uint16_t y = 0; y < 3; y++) {
+    for (uint16_t x = 0; x < 3; x++) {
+      set_piece(board, x, y, pieces[y][x], N);
+      set_piece(wrapped_board, x, y, pieces[y][x], N);
+    }
+  }
+  if (status &&
+      (may_have_solution(board) || !may_have_solution(wrapped_board))) {
+    FPRINTF(stderr,
+            "Error: test_solver_prescreen, the cross on the border was "
+            "misjudged.\n");
+    status = false;
+  }
+
+  // A rejected board is answered without searching
+  solver_ctx ctx = solver_create(board);
+  for (solver_engine engine = SOLVER_ENGINE_SMART;
+       status && engine <= SOLVER_ENGINE_CDCL; engine++) {
+    solver_set_engine(ctx, engine);
+    if (solver_step(ctx, 0, 0) != SOLVER_DONE ||
+        solver_nb_solutions(ctx) != 0 || solver_get_stats(ctx)->nb_nodes != 0) {
+      FPRINTF(stderr,
+              "Error: test_solver_prescreen, engine %d searched a rejected "
+              "board.\n",
+              engine);
+      status = false;
+    }
+  }
+  solver_destroy(ctx);
+  delete_game(wrapped_board);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_step() {
+  game board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+
+  bool status = true;
+  for (solver_mode mode = SOLVER_FIND_ALL; mode <= SOLVER_NB_SOL; mode++) {
+    solver_set_mode(ctx, mode);
+    uint32_t nb_steps = 0;
+    solver_status step_status;
+    do {
+      step_status = solver_step(ctx, 1, 0);
+      nb_steps++;
+    } while (step_status == SOLVER_UNFINISHED);
+    uint32_t expected = mode == SOLVER_FIND_ONE ? 1 : 2;
+    if (step_status != SOLVER_DONE || nb_steps < 2 ||
+        solver_nb_solutions(ctx) != expected ||
+        sol_count_to_uint32(solver_get_count(ctx)) != expected) {
+      FPRINTF(stderr,
+              "Error: test_solver_step, mode %d found %u solutions in %u "
+              "steps.\n",
+              mode, solver_nb_solutions(ctx), nb_steps);
+      status = false;
+    }
+  }
+  game solved_board = copy_game(board);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+  status = status && solver_step(ctx, 0, 0) == SOLVER_DONE &&
+           solver_load_solution(ctx, 0, solved_board) &&
+           is_game_over(solved_board);
+
+  delete_game(solved_board);
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_step_budget() {
+  // The engines that can't be resumed give up and start over. The smart engine
+  // is slow on the larger board, the threads check their budget every few
+  // nodes only
+  const solver_engine engines[] = {SOLVER_ENGINE_SMART, SOLVER_ENGINE_CDCL,
+                                   SOLVER_ENGINE_PROP};
+  const uint16_t sizes[] = {4, 8, 8};
+  const uint32_t nb_solutions[] = {32, 608, 608};
+  bool status = true;
+  for (uint8_t i = 0; status && i < 3; i++) {
+    game board = create_corners_game(sizes[i]);
+    solver_ctx ctx = solver_create(board);
+    solver_set_engine(ctx, engines[i]);
+    solver_set_threads(ctx, 4);
+    status = solver_step(ctx, 1, 0) == SOLVER_UNFINISHED &&
+             solver_step(ctx, 0, 0) == SOLVER_DONE &&
+             solver_nb_solutions(ctx) == nb_solutions[i];
+    if (!status) {
+      FPRINTF(stderr,
+              "Error: test_solver_step_budget, engine %d didn't stop within "
+              "its budget.\n",
+              engines[i]);
+    }
+    solver_destroy(ctx);
+    delete_game(board);
+  }
+
+  game board = create_regions_game();
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_TRANSFER);
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  if (status && (solver_step(ctx, 1, 0) != SOLVER_UNFINISHED ||
+                 solver_step(ctx, 0, 0) != SOLVER_DONE ||
+                 solver_nb_solutions(ctx) != 2)) {
+    FPRINTF(stderr,
+            "Error: test_solver_step_budget, the transfer count didn't stop "
+            "within its budget.\n");
+    status = false;
+  }
+
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_stats() {
+  game board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+
+  // The wrapped board needs a search with every engine
+  bool status = true;
+  for (solver_engine engine = SOLVER_ENGINE_SMART; engine <= SOLVER_ENGINE_CDCL;
+       engine++) {
+    solver_set_engine(ctx, engine);
+    const solver_stats *stats =
+        solver_solve(ctx) ? solver_get_stats(ctx) : NULL;
+    if (!stats || stats->nb_nodes == 0 || stats->nb_propagations == 0 ||
+        stats->nb_backtracks == 0 ||
+        (stats->peak_tree_bytes != 0) != (engine == SOLVER_ENGINE_SMART)) {
+      FPRINTF(stderr,
+              "Error: test_solver_stats, engine %d reported wrong "
+              "statistics.\n",
+              engine);
+      status = false;
+    }
+  }
+  solver_destroy(ctx);
+  delete_game(board);
+
+  // The smart engine solves the unwrapped board by fixing every cell
+  board = create_default_game(false);
+  ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_SMART);
+  if (!solver_solve(ctx) ||
+      solver_get_stats(ctx)->nb_fixed_cells != DEFAULT_SIZE * DEFAULT_SIZE) {
+    FPRINTF(stderr,
+            "Error: test_solver_stats, the smart engine didn't fix every "
+            "cell.\n");
+    status = false;
+  }
+  solver_destroy(ctx);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Tells whether a line of a file holds a text
+ *
+ * @param fname, the name of the file
+ * @param text, the text to look for
+ * @return true if the text was found, false otherwise
+ */
+static bool file_contains(const char* fname, const char* text) {
+  FILE* stream;
+  FOPEN(stream, fname, "r");
+  char line[512];
+  bool found = false;
+  while (!found && stream && fgets(line, sizeof(line), stream))
+    found = strstr(line, text) != NULL;
+  if (stream) FCLOSE(stream);
+  return found;
+}
+
+static int test_solver_report() {
+  game board = create_corners_game(4);
+  save_game(board, "test_report.sav");
+  solver_options options;
+  solver_options_init(&options);
+  options.report = SOLVER_REPORT_FILE;
+
+  // The counter doesn't take wrapping boards, prop runs in its place
+  options.engine = SOLVER_ENGINE_TRANSFER;
+  bool status = find_one("test_report.sav", "test_report", &options) &&
+                file_contains("test_report.json", "\"engine\": \"prop\"") &&
+                file_contains("test_report.json", "\"threads\": 1,");
+
+  // The smart engine runs on its own thread whatever is asked
+  options.engine = SOLVER_ENGINE_SMART;
+  options.nb_threads = 4;
+  status = status && find_one("test_report.sav", "test_report", &options) &&
+           file_contains("test_report.json", "\"engine\": \"smart\"") &&
+           file_contains("test_report.json", "\"threads\": 1,");
+
+  // The workers of the prop engine are all given
+  options.engine = SOLVER_ENGINE_PROP;
+  status = status && find_one("test_report.sav", "test_report", &options) &&
+           file_contains("test_report.json", "\"engine\": \"prop\"") &&
+           file_contains("test_report.json", "\"threads\": 4,");
+  if (!status)
+    FPRINTF(stderr,
+            "Error: test_solver_report, the report doesn't give what ran.\n");
+  remove("test_report.sav");
+  remove("test_report.sol");
+  remove("test_report.json");
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_concurrent_contexts() {
+  game board = create_default_game(false);
+  game wrapped_board = create_default_game(true);
+  solver_ctx ctx = solver_create(board);
+  solver_ctx wrapped_ctx = solver_create(wrapped_board);
+
+  // Both contexts are alive at the same time and must not share any state
+  solver_solve(wrapped_ctx);
+  solver_solve(ctx);
+  bool status = solver_nb_solutions(ctx) == 1 &&
+                solver_nb_solutions(wrapped_ctx) == 2 &&
+                solver_load_solution(ctx, 0, board) &&
+                solver_load_solution(wrapped_ctx, 1, wrapped_board) &&
+                is_game_over(board) && is_game_over(wrapped_board);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_concurrent_contexts, interleaved contexts "
+            "returned wrong solutions.\n");
+  }
+
+  solver_destroy(ctx);
+  solver_destroy(wrapped_ctx);
+  delete_game(board);
+  delete_game(wrapped_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_set_board() {
+  game board = create_default_game(false);
+  game wrapped_board = create_default_game(true);
+  // A 3x3 snake, smaller than the other boards
+  game small_board = new_game_ext(
+      3, 3,
+      (piece[]){LEAF, SEGMENT, CORNER, CORNER, SEGMENT, CORNER, CORNER, SEGMENT,
+                LEAF},
+      (direction[]){N, N, N, N, N, N, N, N, N}, false);
+  solver_ctx ctx = solver_create(wrapped_board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+
+  // The kept solutions must follow the size of the new board
+  bool status = solver_solve(ctx) && solver_nb_solutions(ctx) == 2 &&
+                solver_set_board(ctx, small_board) && solver_solve(ctx) &&
+                solver_load_solution(ctx, 0, small_board) &&
+                is_game_over(small_board) && solver_set_board(ctx, board) &&
+                solver_solve(ctx) && solver_nb_solutions(ctx) == 1 &&
+                solver_load_solution(ctx, 0, board) && is_game_over(board);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solver_set_board, a reused context returned wrong "
+            "solutions.\n");
+  }
+
+  solver_destroy(ctx);
+  delete_game(board);
+  delete_game(wrapped_board);
+  delete_game(small_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_batch_solve() {
+  game board = create_default_game(false);
+  game wrapped_board = create_default_game(true);
+  save_game(board, "batch_unwrapped.sav");
+  save_game(wrapped_board, "batch_wrapped.sav");
+  FILE* manifest;
+  FOPEN(manifest, "batch_manifest.txt", "w");
+  if (!manifest) {
+    delete_game(board);
+    delete_game(wrapped_board);
+    return EXIT_FAILURE;
+  }
+  FPRINTF(manifest, "# puzzles\nbatch_unwrapped.sav\n\nbatch_wrapped.sav\n");
+  FCLOSE(manifest);
+
+  solver_options options;
+  solver_options_init(&options);
+  options.nb_threads = 2;
+  bool status = batch_solve("batch_manifest.txt", "batch_results.txt",
+                            SOLVER_NB_SOL, &options);
+
+  // Each puzzle has its own line, in any order
+  FILE* results;
+  FOPEN(results, "batch_results.txt", "r");
+  char line[512];
+  uint32_t nb_lines = 0;
+  while (status && results && fgets(line, sizeof(line), results)) {
+    nb_lines++;
+    const char* expected =
+        strstr(line, "\"batch_wrapped.sav\"")
+            ? "\"status\": \"done\", \"solutions\": 2, \"solution\": null"
+            : "\"status\": \"done\", \"solutions\": 1, \"solution\": null";
+    status = strstr(line, expected) != NULL;
+  }
+  if (results) FCLOSE(results);
+  if (!status || nb_lines != 2) {
+    FPRINTF(stderr, "Error: test_batch_solve, wrong results for %u lines.\n",
+            nb_lines);
+    status = false;
+  }
+
+  // A missing puzzle is reported without stopping the others
+  FOPEN(manifest, "batch_manifest.txt", "w");
+  if (manifest) {
+    FPRINTF(manifest, "batch_missing.sav\nbatch_unwrapped.sav\n");
+    FCLOSE(manifest);
+  }
+  status = status && manifest &&
+           !batch_solve("batch_manifest.txt", "batch_results.txt",
+                        SOLVER_FIND_ONE, &options);
+  FOPEN(results, "batch_results.txt", "r");
+  nb_lines = 0;
+  while (status && results && fgets(line, sizeof(line), results)) {
+    nb_lines++;
+    char* solution = strstr(line, "\"solution\": \"");
+    if (strstr(line, "batch_missing.sav")) {
+      status = strstr(line, "\"status\": \"error\"") != NULL;
+    } else {
+      status = solution != NULL;
+      if (status) solution += strlen("\"solution\": \"");
+      for (uint16_t i = 0; status && i < DEFAULT_SIZE * DEFAULT_SIZE; i++) {
+        status = solution[i] >= '0' && solution[i] <= '3';
+        if (status)
+          set_piece_current_direction(board, i % DEFAULT_SIZE,
+                                      i / DEFAULT_SIZE,
+                                      (direction)(solution[i] - '0'));
+      }
+      status = status && is_game_over(board);
+    }
+  }
+  if (results) FCLOSE(results);
+  if (!status || nb_lines != 2) {
+    FPRINTF(stderr,
+            "Error: test_batch_solve, the missing puzzle wasn't reported "
+            "apart.\n");
+    status = false;
+  }
+
+  remove("batch_unwrapped.sav");
+  remove("batch_wrapped.sav");
+  remove("batch_manifest.txt");
+  remove("batch_results.txt");
+  delete_game(board);
+  delete_game(wrapped_board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Creates a 3x3 board whose pieces spell a number, so that every number
+ * gives another board
+ *
+ * @param number, the number
+ * @return the created game
+ */
+static game create_numbered_game(uint32_t number) {
+  piece pieces[9];
+  direction directions[9] = {N, N, N, N, N, N, N, N, N};
+  for (uint8_t i = 0; i < 9; i++, number /= 5) pieces[i] = (piece)(number % 5);
+  return new_game_ext(3, 3, pieces, directions, false);
+}
+
+static int test_solve_cache() {
+  const char* files[] = {"test_cache/index", "test_cache/data"};
+  for (uint8_t i = 0; i < 2; i++) remove(files[i]);
+  solve_cache cache = cache_open("test_cache");
+  if (!cache) return EXIT_FAILURE;
+
+  // Enough boards for the index to grow, then read back once reopened
+  const uint32_t nb_boards = 2000;
+  bool status = true;
+  cache_entry entry = {true, 0, false, NULL};
+  for (uint32_t i = 0; status && i < nb_boards; i++) {
+    game board = create_numbered_game(i);
+    entry.nb_solutions = i;
+    status = cache_store(cache, board, &entry);
+    delete_game(board);
+  }
+  cache_close(cache);
+  cache = cache_open("test_cache");
+  direction solution[DEFAULT_SIZE * DEFAULT_SIZE];
+  entry.solution = solution;
+  for (uint32_t i = 0; status && cache && i < nb_boards; i++) {
+    game board = create_numbered_game(i);
+    status = cache_lookup(cache, board, &entry) && entry.has_count &&
+             entry.nb_solutions == i && !entry.has_solution;
+    delete_game(board);
+  }
+  if (!status) {
+    FPRINTF(stderr, "Error: test_solve_cache, stored counts were lost.\n");
+  }
+
+  // A solve adds to what the cache knows, the next one is answered by it
+  game board = create_default_game(false);
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_cache(ctx, cache);
+  solver_set_mode(ctx, SOLVER_FIND_ONE);
+  status = status && cache && !cache_lookup(cache, board, &entry) &&
+           solver_solve(ctx) && solver_get_stats(ctx)->nb_propagations > 0;
+  solver_set_mode(ctx, SOLVER_NB_SOL);
+  status = status && solver_solve(ctx) &&
+           cache_lookup(cache, board, &entry) && entry.has_count &&
+           entry.nb_solutions == 1 && entry.has_solution;
+  solver_set_mode(ctx, SOLVER_FIND_ALL);
+  game solved_board = copy_game(board);
+  status = status && solver_solve(ctx) &&
+           solver_get_stats(ctx)->nb_propagations == 0 &&
+           solver_nb_solutions(ctx) == 1 &&
+           solver_load_solution(ctx, 0, solved_board) &&
+           is_game_over(solved_board);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solve_cache, solves didn't use the cache.\n");
+  }
+
+  delete_game(solved_board);
+  solver_destroy(ctx);
+  delete_game(board);
+  if (cache) cache_close(cache);
+  for (uint8_t i = 0; i < 2; i++) remove(files[i]);
+  remove("test_cache");
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Structure for a thread storing boards in its own handle of a cache
+ */
+typedef struct cache_writer_s {
+  const char *directory; /**< the directory of the cache */
+  game *boards;          /**< the boards to store, with their number as count */
+  uint32_t nb_boards;    /**< number of boards */
+  bool status;           /**< whether every board was stored */
+} cache_writer;
+
+/**
+ * @brief Main function of the threads of test_solve_cache_shared
+ *
+ * @param arg, the cache_writer
+ */
+static THREAD_FUNCTION(store_boards, arg) {
+  cache_writer *writer = (cache_writer *)arg;
+  solve_cache cache = cache_open(writer->directory);
+  writer->status = cache != NULL;
+  cache_entry entry = {true, 0, false, NULL};
+  for (uint32_t i = 0; writer->status && i < writer->nb_boards; i++) {
+    entry.nb_solutions = i;
+    writer->status = cache_store(cache, writer->boards[i], &entry);
+  }
+  if (cache) cache_close(cache);
+  THREAD_RETURN;
+}
+
+/**
+ * @brief Gets the size of a file
+ *
+ * @param path, the file
+ * @return the size, -1 if it couldn't be read
+ */
+static int64_t file_size(const char *path) {
+  FILE *file;
+  FOPEN(file, path, "rb");
+  if (!file) return -1;
+  int64_t size = FSEEK64(file, 0, SEEK_END) == 0 ? FTELL64(file) : -1;
+  FCLOSE(file);
+  return size;
+}
+
+static int test_solve_cache_shared() {
+  const char *files[] = {"test_cache_shared/index", "test_cache_shared/data"};
+  for (uint8_t i = 0; i < 2; i++) remove(files[i]);
+
+  // Two handles of the same cache act as two processes: they store the same
+  // boards at once, and each board has to be recorded once
+  const uint32_t nb_boards = 2000;
+  game *boards = (game *)malloc(nb_boards * sizeof(game));
+  if (!boards) return EXIT_FAILURE;
+  for (uint32_t i = 0; i < nb_boards; i++) boards[i] = create_numbered_game(i);
+  cache_writer writers[2];
+  THREAD threads[2];
+  uint8_t nb_started = 0;
+  for (; nb_started < 2; nb_started++) {
+    cache_writer *writer = &writers[nb_started];
+    writer->directory = "test_cache_shared";
+    writer->boards = boards;
+    writer->nb_boards = nb_boards;
+    writer->status = false;
+    if (!THREAD_CREATE(threads[nb_started], store_boards, writer)) break;
+  }
+  for (uint8_t i = 0; i < nb_started; i++) THREAD_JOIN(threads[i]);
+  bool status = nb_started == 2 && writers[0].status && writers[1].status;
+  int64_t size = file_size(files[1]);
+
+  // Every record has the same size, the one of a single board
+  for (uint8_t i = 0; i < 2; i++) remove(files[i]);
+  solve_cache cache = cache_open("test_cache_shared");
+  cache_entry entry = {true, 0, false, NULL};
+  status = status && cache && cache_store(cache, boards[0], &entry);
+  if (cache) cache_close(cache);
+  status = status && size == (int64_t)nb_boards * file_size(files[1]);
+  if (!status) {
+    FPRINTF(stderr,
+            "Error: test_solve_cache_shared, the boards stored at once were "
+            "recorded %lld bytes instead of once each.\n",
+            (long long)size);
+  }
+
+  for (uint32_t i = 0; i < nb_boards; i++) delete_game(boards[i]);
+  free(boards);
+  for (uint8_t i = 0; i < 2; i++) remove(files[i]);
+  remove("test_cache_shared");
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solve_pack() {
+  // Boards drifting one piece at a time, with a few jumps of every piece, over
+  // more than three blocks of the pack
+  const uint32_t nb_boards = 4 * PACK_BLOCK_SIZE - 30;
+  const uint32_t nb_cells = DEFAULT_SIZE * DEFAULT_SIZE;
+  direction(*expected)[DEFAULT_SIZE * DEFAULT_SIZE] =
+      malloc(nb_boards * sizeof(*expected));
+  game board = create_default_game(true);
+  game variant = copy_game(board);
+  pack_writer writer = pack_create("test_pack.pack", board);
+  bool status = expected && writer;
+  for (uint32_t i = 0; status && i < nb_boards; i++) {
+    if (i % 50 == 49) {
+      for (uint16_t y = 0; y < DEFAULT_SIZE; y++)
+        for (uint16_t x = 0; x < DEFAULT_SIZE; x++)
+          rotate_piece_one(variant, x, y);
+    } else {
+      uint32_t cell = (i * 7) % nb_cells;
+      rotate_piece(variant, (uint16_t)(cell % DEFAULT_SIZE),
+                   (uint16_t)(cell / DEFAULT_SIZE), (int32_t)(i % 3 + 1));
+    }
+    get_cells(variant, NULL, expected[i]);
+    status = pack_add(writer, variant);
+  }
+  if (writer) status = pack_finish(writer) && status;
+
+  // Read in order, then jumping between the blocks
+  pack_reader reader = status ? pack_open("test_pack.pack") : NULL;
+  direction orientations[DEFAULT_SIZE * DEFAULT_SIZE];
+  status = reader && pack_nb_solutions(reader) == nb_boards &&
+           game_width(pack_get_board(reader)) == DEFAULT_SIZE &&
+           is_wrapping(pack_get_board(reader)) &&
+           get_current_direction(pack_get_board(reader), 1, 0) ==
+               default_directions[1];
+  for (uint32_t i = 0; status && i < 2 * nb_boards; i++) {
+    uint32_t index = i < nb_boards ? i : (i * 37) % nb_boards;
+    status = pack_read(reader, index, orientations) &&
+             memcmp(orientations, expected[index], sizeof(orientations)) == 0;
+  }
+  status = status && pack_load(reader, 5, variant) &&
+           get_current_direction(variant, 0, 1) == expected[5][DEFAULT_SIZE] &&
+           !pack_read(reader, nb_boards, orientations);
+  if (reader) pack_close(reader);
+  if (!status)
+    FPRINTF(stderr, "Error: test_solve_pack, the pack was read wrong.\n");
+
+  // find_all packs the solutions it finds
+  save_game(board, "test_pack.sav");
+  solver_options options;
+  solver_options_init(&options);
+  options.packed = true;
+  status = status && find_all("test_pack.sav", "test_pack", &options);
+  reader = status ? pack_open("test_pack.pack") : NULL;
+  status = reader && pack_nb_solutions(reader) == 2;
+  for (uint64_t i = 0; status && i < 2; i++)
+    status = pack_load(reader, i, variant) && is_game_over(variant);
+  if (reader) pack_close(reader);
+  if (!status)
+    FPRINTF(stderr,
+            "Error: test_solve_pack, find_all didn't pack 2 solutions.\n");
+
+  free(expected);
+  delete_game(variant);
+  delete_game(board);
+  remove("test_pack.pack");
+  remove("test_pack.sav");
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_find_hint() {
+  game board = create_default_game(false);
+
+  // The board has a single solution, so following the hints must solve it
+  bool status = true;
+  solver_move move;
+  uint32_t nb_moves = 0;
+  while (status && !is_game_over(board)) {
+    status = find_hint(board, NULL, 0, &move) && move.x < DEFAULT_SIZE &&
+             move.y < DEFAULT_SIZE &&
+             move.dir != get_current_direction(board, move.x, move.y) &&
+             ++nb_moves <= DEFAULT_SIZE * DEFAULT_SIZE;
+    if (status) set_piece_current_direction(board, move.x, move.y, move.dir);
+  }
+  if (!status || find_hint(board, NULL, 0, &move)) {
+    FPRINTF(stderr,
+            "Error: test_find_hint, the hints didn't solve the board in %u "
+            "moves.\n",
+            nb_moves);
+    status = false;
+  }
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_find_one_sdl() {
+  game board = create_default_game(false);
+  if (!find_one_sdl(board) || !is_game_over(board)) {
+    FPRINTF(stderr,
+            "Error: test_find_one_sdl, the board wasn't solved in place.\n");
+    delete_game(board);
+    return EXIT_FAILURE;
+  }
+  delete_game(board);
+  return EXIT_SUCCESS;
+}
+
+static int test_check_locks() {
+  game board = create_default_game(false);
+  game solved_board = copy_game(board);
+  bool locked[DEFAULT_SIZE * DEFAULT_SIZE] = {false};
+  bool conflicts[DEFAULT_SIZE * DEFAULT_SIZE];
+  bool status = find_one_sdl(solved_board) &&
+                check_locks(board, locked, 0, conflicts) ==
+                    SOLVER_LOCKS_SOLVABLE;
+
+  // Every piece locked in the solution still fits it
+  for (uint32_t cell = 0; cell < DEFAULT_SIZE * DEFAULT_SIZE; cell++)
+    locked[cell] = true;
+  status = status && check_locks(solved_board, locked, 0, conflicts) ==
+                         SOLVER_LOCKS_SOLVABLE;
+
+  // A leaf locked the wrong way conflicts with the rest of the solution
+  uint32_t wrong = 0;
+  while (default_pieces[wrong] != LEAF) wrong++;
+  uint16_t x = (uint16_t)(wrong % DEFAULT_SIZE);
+  uint16_t y = (uint16_t)(wrong / DEFAULT_SIZE);
+  rotate_piece_one(solved_board, x, y);
+  status = status && check_locks(solved_board, locked, 0, conflicts) ==
+                         SOLVER_LOCKS_CONFLICT &&
+           conflicts[wrong];
+
+  // Unlocking any of the conflicting pieces lets the others fit
+  bool core[DEFAULT_SIZE * DEFAULT_SIZE];
+  for (uint32_t cell = 0; status && cell < DEFAULT_SIZE * DEFAULT_SIZE;
+       cell++) {
+    if (!conflicts[cell]) continue;
+    memcpy(core, conflicts, sizeof(core));
+    core[cell] = false;
+    status =
+        check_locks(solved_board, core, 0, NULL) == SOLVER_LOCKS_SOLVABLE;
+  }
+  if (!status)
+    FPRINTF(stderr, "Error: test_check_locks, wrong answer on the locks.\n");
+  delete_game(solved_board);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int test_solver_locks() {
+  game board = create_regions_game();
+  game first = copy_game(board);
+  game second = copy_game(board);
+  uint16_t width = game_width(board);
+  uint16_t height = game_height(board);
+  solver_ctx ctx = solver_create(board);
+  solver_set_engine(ctx, SOLVER_ENGINE_PROP);
+  solver_set_mode(ctx, SOLVER_FIND_ALL);
+  bool status = solver_solve(ctx) && solver_nb_solutions(ctx) == 2 &&
+                solver_load_solution(ctx, 0, first) &&
+                solver_load_solution(ctx, 1, second);
+
+  // A piece the two solutions turn apart, locked as in the second one
+  uint32_t cell = 0;
+  uint16_t x = 0, y = 0;
+  for (; status && cell < (uint32_t)width * height; cell++) {
+    x = (uint16_t)(cell % width);
+    y = (uint16_t)(cell / width);
+    if (get_piece(board, x, y) != SEGMENT &&
+        get_current_direction(first, x, y) !=
+            get_current_direction(second, x, y))
+      break;
+  }
+  status = status && cell < (uint32_t)width * height;
+  bool *locked = (bool *)calloc((size_t)width * height, sizeof(bool));
+  status = status && locked;
+  if (status) {
+    set_piece_current_direction(board, x, y,
+                                get_current_direction(second, x, y));
+    locked[cell] = true;
+  }
+
+  // Whatever the settings, the solve only finds the solution keeping it
+  solver_set_engine(ctx, SOLVER_ENGINE_SMART);
+  solver_set_threads(ctx, 4);
+  status = status && solver_set_board(ctx, board) &&
+           solver_set_locks(ctx, locked) && solver_solve(ctx) &&
+           solver_nb_solutions(ctx) == 1 &&
+           solver_load_solution(ctx, 0, first) &&
+           get_current_direction(first, x, y) ==
+               get_current_direction(second, x, y);
+
+  // The hints leave it alone and still lead to that solution
+  solver_move move;
+  uint32_t nb_moves = 0;
+  while (status && !is_game_over(board)) {
+    status = find_hint(board, locked, 0, &move) &&
+             (move.x != x || move.y != y) &&
+             ++nb_moves <= (uint32_t)width * height;
+    if (status) set_piece_current_direction(board, move.x, move.y, move.dir);
+  }
+  status = status && get_current_direction(board, x, y) ==
+                         get_current_direction(second, x, y);
+  if (!status)
+    FPRINTF(stderr,
+            "Error: test_solver_locks, a locked piece was turned.\n");
+  free(locked);
+  if (ctx) solver_destroy(ctx);
+  delete_game(second);
+  delete_game(first);
+  delete_game(board);
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void usage(char* program_name) {
+  FPRINTF(stderr, "Usage: %s <testname>\n", program_name);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc == 1) usage(argv[0]);
+
+  PRINTF("=> RUN TEST \"%s\"\n", argv[1]);
+
+  int status;
+  if (strcmp("solver_create_null_game", argv[1]) == 0)
+    status = test_solver_create_null_game();
+  else if (strcmp("solver_solve_valid", argv[1]) == 0)
+    status = test_solver_solve_valid();
+  else if (strcmp("solver_solve_wrapped", argv[1]) == 0)
+    status = test_solver_solve_wrapped();
+  else if (strcmp("solver_solve_no_solution", argv[1]) == 0)
+    status = test_solver_solve_no_solution();
+  else if (strcmp("solver_forced_loop", argv[1]) == 0)
+    status = test_solver_forced_loop();
+  else if (strcmp("solver_smart_snake", argv[1]) == 0)
+    status = test_solver_smart_snake();
+  else if (strcmp("solver_smart_regions", argv[1]) == 0)
+    status = test_solver_smart_regions();
+  else if (strcmp("solver_smart_rules", argv[1]) == 0)
+    status = test_solver_smart_rules();
+  else if (strcmp("solver_smart_order", argv[1]) == 0)
+    status = test_solver_smart_order();
+  else if (strcmp("solver_prop_valid", argv[1]) == 0)
+    status = test_solver_prop_valid();
+  else if (strcmp("solver_prop_wrapped", argv[1]) == 0)
+    status = test_solver_prop_wrapped();
+  else if (strcmp("solver_prop_no_solution", argv[1]) == 0)
+    status = test_solver_prop_no_solution();
+  else if (strcmp("solver_prop_find_one", argv[1]) == 0)
+    status = test_solver_prop_find_one();
+  else if (strcmp("solver_prop_threads", argv[1]) == 0)
+    status = test_solver_prop_threads();
+  else if (strcmp("solver_prop_threads_limit", argv[1]) == 0)
+    status = test_solver_prop_threads_limit();
+  else if (strcmp("solver_prop_count", argv[1]) == 0)
+    status = test_solver_prop_count();
+  else if (strcmp("solver_cdcl_valid", argv[1]) == 0)
+    status = test_solver_cdcl_valid();
+  else if (strcmp("solver_cdcl_no_solution", argv[1]) == 0)
+    status = test_solver_cdcl_no_solution();
+  else if (strcmp("solver_transfer", argv[1]) == 0)
+    status = test_solver_transfer();
+  else if (strcmp("sol_count_big", argv[1]) == 0)
+    status = test_sol_count_big();
+  else if (strcmp("solver_stream_limit", argv[1]) == 0)
+    status = test_solver_stream_limit();
+  else if (strcmp("solver_in_memory", argv[1]) == 0)
+    status = test_solver_in_memory();
+  else if (strcmp("solver_memory_limit", argv[1]) == 0)
+    status = test_solver_memory_limit();
+  else if (strcmp("solver_memory_limit_threads", argv[1]) == 0)
+    status = test_solver_memory_limit_threads();
+  else if (strcmp("solver_prescreen", argv[1]) == 0)
+    status = test_solver_prescreen();
+  else if (strcmp("solver_step", argv[1]) == 0)
+    status = test_solver_step();
+  else if (strcmp("solver_step_budget", argv[1]) == 0)
+    status = test_solver_step_budget();
+  else if (strcmp("solver_stats", argv[1]) == 0)
+    status = test_solver_stats();
+  else if (strcmp("solver_concurrent_contexts", argv[1]) == 0)
+    status = test_solver_concurrent_contexts();
+  else if (strcmp("solver_set_board", argv[1]) == 0)
+    status = test_solver_set_board();
+  else if (strcmp("batch_solve", argv[1]) == 0)
+    status = test_batch_solve();
+  else if (strcmp("solve_cache", argv[1]) == 0)
+    status = test_solve_cache();
+  else if (strcmp("solve_cache_shared", argv[1]) == 0)
+    status = test_solve_cache_shared();
+  else if (strcmp("solve_pack", argv[1]) == 0)
+    status = test_solve_pack();
+  else if (strcmp("find_hint", argv[1]) == 0)
+    status = test_find_hint();
+  else if (strcmp("find_one_sdl", argv[1]) == 0)
+    status = test_find_one_sdl();
+  else if (strcmp("check_locks", argv[1]) == 0)
+    status = test_check_locks();
+  else if (strcmp("solver_count_threads", argv[1]) == 0)
+    status = test_solver_count_threads();
+  else if (strcmp("solver_report", argv[1]) == 0)
+    status = test_solver_report();
+  else if (strcmp("solver_locks", argv[1]) == 0)
+    status = test_solver_locks();
+  else {
+    FPRINTF(stderr, "Error: test %s not found!\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  if (status != EXIT_SUCCESS)
+    PRINTF("FAILURE (status %d)\n", status);
+  else
+    PRINTF("SUCCESS (status %d)\n", status);
+  return status;
+}